@@ -173,6 +173,7 @@ static void runCommands(SerialTsChannelBase* tsChannel) {
 	}
 
 	/* restart with a working baud, then change settings */
+	tsChannel->resetSession();
 	tsChannel->stop();
 	chThdSleepMilliseconds(10);	// safety
 
@@ -233,6 +234,7 @@ cmdFailed:
 uint8_t findBaudIndex(SerialTsChannelBase* tsChannel) {
 	// find current baudrate
 	for(uint8_t baudIdx=0; baudIdx < efi::size(baudRates); baudIdx++) {
+		tsChannel->resetSession();
 		tsChannel->stop();
 		chThdSleepMilliseconds(10);	// safety
 
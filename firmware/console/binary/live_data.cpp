@@ -158,13 +158,7 @@ const trigger_state_s* getLiveData(size_t idx) {
 template<>
 const vvt_s* getLiveData(size_t idx) {
 #if EFI_VVT_PID
-	switch (idx) {
-		case 0: return &engine->module<VvtController1>().unmock();
-		case 1: return &engine->module<VvtController2>().unmock();
-		case 2: return &engine->module<VvtController3>().unmock();
-		case 3: return &engine->module<VvtController4>().unmock();
-		default: return nullptr;
-	}
+	return getVvtController(idx);
 #else
 	return nullptr;
 #endif
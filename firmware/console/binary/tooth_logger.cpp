@@ -67,7 +67,8 @@ void DisableToothLogger() {
 
 #else // not EFI_UNIT_TEST
 
-static constexpr size_t BUFFER_COUNT = BIG_BUFFER_SIZE / sizeof(CompositeBuffer);
+// Half of the big buffer so that a perf trace of the same event can be captured alongside
+static constexpr size_t BUFFER_COUNT = (BIG_BUFFER_SIZE / 2) / sizeof(CompositeBuffer);
 static_assert(BUFFER_COUNT >= 2);
 
 static CompositeBuffer* buffers = nullptr;
@@ -85,13 +86,19 @@ static void setToothLogReady(bool value) {
 static BigBufferHandle bufferHandle;
 
 void EnableToothLogger() {
-	chibios_rt::CriticalSectionLocker csl;
+	// Drop the previous lease if we are restarting
+	DisableToothLogger();
 
-	bufferHandle = getBigBuffer(BigBufferUser::ToothLogger);
-	if (!bufferHandle) {
+	// getBigBuffer may have to reclaim space from other users, do not hold the lock for that
+	BigBufferHandle newHandle = getBigBuffer(BigBufferUser::ToothLogger, BUFFER_COUNT * sizeof(CompositeBuffer));
+	if (!newHandle) {
 		return;
 	}
 
+	chibios_rt::CriticalSectionLocker csl;
+
+	bufferHandle = efi::move(newHandle);
+
 	buffers = bufferHandle.get<CompositeBuffer>();
 
 	// Reset all buffers
@@ -5,10 +5,19 @@
 #include "trigger_scope.h"
 #include "trigger_scope_config.h"
 
+// Two 8 bit channels, half of the big buffer so that a tooth log fits next to it
+#ifndef TRIGGER_SCOPE_BUFFER_SIZE
+#define TRIGGER_SCOPE_BUFFER_SIZE (BIG_BUFFER_SIZE / 2)
+#endif
+
 static BigBufferHandle buffer;
 
 static bool isRunning = false;
 
+// TS is sending the buffer, it must stay ours until it is returned
+static bool isReadOut = false;
+static bool isReleasePending = false;
+
 static void completionCallback(ADCDriver* adcp) {
 	if (isRunning && adcp->state == ADC_COMPLETE) {
 		engine->outputChannels.triggerScopeReady = true;
@@ -51,7 +60,7 @@ static const ADCConversionGroup adcConvGroupCh1 = { FALSE, 2, &completionCallbac
 	ADC_SQR3_SQ1_N(TRIGGER_SCOPE_ADC_CH1) | ADC_SQR3_SQ2_N(TRIGGER_SCOPE_ADC_CH2)
 };
 
-static constexpr size_t sampleCount = BIG_BUFFER_SIZE / (2 * sizeof(uint8_t));
+static constexpr size_t sampleCount = TRIGGER_SCOPE_BUFFER_SIZE / (2 * sizeof(uint8_t));
 
 static void startSampling(void* = nullptr) {
 	chibios_rt::CriticalSectionLocker csl;
@@ -71,33 +80,78 @@ static void startSampling(void* = nullptr) {
 
 // Enable one buffer's worth of perf tracing, and retrieve the buffer size in bytes
 void triggerScopeEnable() {
-	buffer = getBigBuffer(BigBufferUser::TriggerScope);
+	// Drop the previous lease if we are restarting
+	triggerScopeDisable();
+
+	// getBigBuffer may have to reclaim space from other users, do not hold the lock for that
+	BigBufferHandle newBuffer = getBigBuffer(BigBufferUser::TriggerScope, TRIGGER_SCOPE_BUFFER_SIZE, triggerScopeDisable);
+	if (!newBuffer) {
+		return;
+	}
 
-	isRunning = true;
+	{
+		chibios_rt::CriticalSectionLocker csl;
+		buffer = efi::move(newBuffer);
+		isRunning = true;
+	}
 
 	startSampling();
 }
 
+// also invoked when a higher priority big buffer user needs the space
 void triggerScopeDisable() {
-	// we're done with the buffer - let somebody else have it
-	buffer = {};
+	chibios_rt::CriticalSectionLocker csl;
 
 	isRunning = false;
 	engine->outputChannels.triggerScopeReady = false;
+
+	if (isReadOut) {
+		// triggerScopeReturnBuffer releases the buffer, a big buffer user asking for it now has to try again
+		isReleasePending = true;
+		return;
+	}
+
+	// DMA must be done with the buffer before anybody else gets it
+	if (TRIGGER_SCOPE_ADC.state == ADC_ACTIVE) {
+		adcStopConversionI(&TRIGGER_SCOPE_ADC);
+	}
+
+	// we're done with the buffer - let somebody else have it
+	buffer = {};
 }
 
 static scheduling_s restartTimer;
 
 // Retrieve the trace buffer
 const BigBufferHandle& triggerScopeGetBuffer() {
+	chibios_rt::CriticalSectionLocker csl;
+
 	engine->outputChannels.triggerScopeReady = false;
 
+	if (buffer) {
+		isReadOut = true;
+	}
+
+	return buffer;
+}
+
+void triggerScopeReturnBuffer() {
+	{
+		chibios_rt::CriticalSectionLocker csl;
+
+		isReadOut = false;
+
+		if (isReleasePending) {
+			isReleasePending = false;
+			triggerScopeDisable();
+			return;
+		}
+	}
+
 	// Start the next sample once we've read out this one
 	if (isRunning) {
 		engine->scheduler.schedule("trigger scope", &restartTimer, getTimeNowNt() + MS2NT(10), startSampling);
 	}
-
-	return buffer;
 }
 
 void initTriggerScope() {
@@ -2,6 +2,8 @@
 
 void triggerScopeEnable();
 void triggerScopeDisable();
+// the buffer is held until triggerScopeReturnBuffer
 const BigBufferHandle& triggerScopeGetBuffer();
+void triggerScopeReturnBuffer();
 
 void initTriggerScope();
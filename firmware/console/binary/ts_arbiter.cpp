@@ -0,0 +1,149 @@
+/**
+ * @file ts_arbiter.cpp
+ *
+ * @date Oct 18, 2026
+ */
+
+#include "pch.h"
+
+#include "ts_arbiter.h"
+
+TsConfigLock tsConfigLock;
+
+TsCommandAccess getTsCommandAccess(char command) {
+	switch (command) {
+	case TS_READ_COMMAND:
+	case TS_CRC_CHECK_COMMAND:
+		return TsCommandAccess::ConfigRead;
+	case TS_CHUNK_WRITE_COMMAND:
+	case TS_SINGLE_WRITE_COMMAND:
+	case TS_BURN_COMMAND:
+	// console commands and IO tests may change anything
+	case TS_EXECUTE:
+	case TS_IO_TEST_COMMAND:
+		return TsCommandAccess::ConfigWrite;
+	// logger and text buffers are a single shared resource
+	case TS_GET_TEXT:
+	case TS_SET_LOGGER_SWITCH:
+	case TS_GET_COMPOSITE_BUFFER_DONE_DIFFERENTLY:
+	case TS_PERF_TRACE_BEGIN:
+	case TS_PERF_TRACE_GET_BUFFER:
+		return TsCommandAccess::SharedBuffer;
+	default:
+		return TsCommandAccess::LiveData;
+	}
+}
+
+#if EFI_PROD_CODE || EFI_SIMULATOR
+
+void TsConfigLock::lockShared() {
+	chibios_rt::MutexLocker lock(m_mutex);
+	while (m_writerActive || m_writersWaiting > 0) {
+		m_cond.wait();
+	}
+	m_readers++;
+}
+
+void TsConfigLock::unlockShared() {
+	chibios_rt::MutexLocker lock(m_mutex);
+	m_readers--;
+	if (m_readers == 0) {
+		m_cond.broadcast();
+	}
+}
+
+void TsConfigLock::lock() {
+	chibios_rt::MutexLocker lock(m_mutex);
+	m_writersWaiting++;
+	while (m_writerActive || m_readers > 0) {
+		m_cond.wait();
+	}
+	m_writersWaiting--;
+	m_writerActive = true;
+}
+
+void TsConfigLock::unlock() {
+	chibios_rt::MutexLocker lock(m_mutex);
+	m_writerActive = false;
+	m_cond.broadcast();
+}
+
+void TsConfigLock::lockBuffers() {
+	m_bufferMutex.lock();
+	m_bufferOwned = true;
+}
+
+void TsConfigLock::unlockBuffers() {
+	m_bufferOwned = false;
+	m_bufferMutex.unlock();
+}
+
+#else
+
+// unit tests are single threaded, just keep the bookkeeping
+void TsConfigLock::lockShared() {
+	m_readers++;
+}
+
+void TsConfigLock::unlockShared() {
+	m_readers--;
+}
+
+void TsConfigLock::lock() {
+	m_writerActive = true;
+}
+
+void TsConfigLock::unlock() {
+	m_writerActive = false;
+}
+
+void TsConfigLock::lockBuffers() {
+	m_bufferOwned = true;
+}
+
+void TsConfigLock::unlockBuffers() {
+	m_bufferOwned = false;
+}
+
+#endif // EFI_PROD_CODE || EFI_SIMULATOR
+
+TsCommandGuard::TsCommandGuard(TsConfigLock& lock, TsCommandAccess access)
+	: m_lock(lock)
+	, m_access(access)
+{
+	switch (m_access) {
+	case TsCommandAccess::ConfigRead:
+		m_lock.lockShared();
+		break;
+	case TsCommandAccess::ConfigWrite:
+		m_lock.lock();
+		break;
+	case TsCommandAccess::SharedBuffer:
+		m_lock.lockBuffers();
+		break;
+	default:
+		break;
+	}
+}
+
+TsCommandGuard::~TsCommandGuard() {
+	release();
+}
+
+void TsCommandGuard::release() {
+	switch (m_access) {
+	case TsCommandAccess::ConfigRead:
+		m_lock.unlockShared();
+		break;
+	case TsCommandAccess::ConfigWrite:
+		m_lock.unlock();
+		break;
+	case TsCommandAccess::SharedBuffer:
+		m_lock.unlockBuffers();
+		break;
+	default:
+		break;
+	}
+
+	m_access = TsCommandAccess::LiveData;
+}
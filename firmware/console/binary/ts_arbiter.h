@@ -0,0 +1,85 @@
+/**
+ * @file ts_arbiter.h
+ *
+ * Every TS transport (USB, UARTs, CAN, Wi-Fi, Ethernet) runs its own thread but all of them
+ * share one command engine and one tune. Live data commands need no arbitration, config page
+ * reads may run concurrently with each other, config writes are serialized and exclude readers.
+ * Logger and text buffers exist once, commands using them are serialized by a lock of their own
+ * so that a slow client reading a log does not hold up tune access on other channels.
+ *
+ * Writers are preferred: once a tuning client asks to write, new readers wait, so a dash
+ * logger polling on another port can not starve the interactive client.
+ *
+ * @date Oct 18, 2026
+ */
+
+#pragma once
+
+#include <cstdint>
+
+enum class TsCommandAccess : uint8_t {
+	// output channels, signature, version - nothing from the tune is touched
+	LiveData,
+	// reads the tune
+	ConfigRead,
+	// modifies the tune or has other side effects
+	ConfigWrite,
+	// uses a single shared logger or text buffer, the tune is not touched
+	SharedBuffer,
+};
+
+TsCommandAccess getTsCommandAccess(char command);
+
+class TsConfigLock {
+public:
+	void lockShared();
+	void unlockShared();
+
+	void lock();
+	void unlock();
+
+	void lockBuffers();
+	void unlockBuffers();
+
+	int getReaderCount() const {
+		return m_readers;
+	}
+
+	bool isWriterActive() const {
+		return m_writerActive;
+	}
+
+	bool isBufferOwned() const {
+		return m_bufferOwned;
+	}
+
+private:
+#if EFI_PROD_CODE || EFI_SIMULATOR
+	chibios_rt::Mutex m_mutex;
+	chibios_rt::CondVar m_cond;
+	chibios_rt::Mutex m_bufferMutex;
+#endif // EFI_PROD_CODE || EFI_SIMULATOR
+
+	int m_readers = 0;
+	int m_writersWaiting = 0;
+	bool m_writerActive = false;
+	bool m_bufferOwned = false;
+};
+
+/**
+ * Scoped access to the tune for the duration of one TS command
+ */
+class TsCommandGuard {
+public:
+	TsCommandGuard(TsConfigLock& lock, TsCommandAccess access);
+	~TsCommandGuard();
+
+	// Command is done with the tune, only its response is left to send
+	void release();
+
+private:
+	TsConfigLock& m_lock;
+	TsCommandAccess m_access;
+};
+
+extern TsConfigLock tsConfigLock;
@@ -69,11 +69,14 @@
 #include "flash_main.h"
 
 #include "tunerstudio_io.h"
+#include "ts_arbiter.h"
 #include "malfunction_central.h"
 #include "console_io.h"
 #include "bluetooth.h"
 #include "tunerstudio_io.h"
 #include "trigger_scope.h"
+#include "sensor_chart.h"
+#include "log_histogram.h"
 #include "electronic_throttle.h"
 #include "live_data.h"
 #include "efi_quote.h"
@@ -130,6 +133,10 @@ static void printTsStats(void) {
 	efiPrintf("Primary UART TX %s", hwPortname(EFI_CONSOLE_TX_BRAIN_PIN));
 #endif /* EFI_CONSOLE_RX_BRAIN_PIN */
 
+#if EFI_PROD_CODE || EFI_SIMULATOR
+	printSerialChannelsStats();
+#endif // EFI_PROD_CODE || EFI_SIMULATOR
+
 #if EFI_USB_SERIAL
     printUsbConnectorStats();
 #endif // EFI_USB_SERIAL
@@ -195,6 +202,22 @@ bool validateOffsetCount(size_t offset, size_t count, TsChannelBase* tsChannel);
 
 extern bool rebootForPresetPending;
 
+/**
+ * Writes which land on highSpeedOffsets are also captured as the live data subscription of the writing channel
+ */
+static void updateChannelScatterList(TsChannelBase* tsChannel, size_t offset, size_t count, const uint8_t* content) {
+	constexpr size_t listStart = offsetof(engine_configuration_s, highSpeedOffsets);
+	constexpr size_t listEnd = listStart + sizeof(TsChannelBase::highSpeedOffsets);
+
+	size_t from = std::max(offset, listStart);
+	size_t to = std::min(offset + count, listEnd);
+	if (from >= to) {
+		return;
+	}
+
+	memcpy(reinterpret_cast<uint8_t*>(tsChannel->highSpeedOffsets) + (from - listStart), content + (from - offset), to - from);
+}
+
 /**
  * This command is needed to make the whole transfer a bit faster
  */
@@ -214,6 +237,8 @@ void TunerStudio::handleWriteChunkCommand(TsChannelBase* tsChannel, uint16_t off
 		return;
 	}
 
+	updateChannelScatterList(tsChannel, offset, count, reinterpret_cast<const uint8_t*>(content));
+
 	// Skip the write if a preset was just loaded - we don't want to overwrite it
 	if (!rebootForPresetPending) {
 		uint8_t * addr = (uint8_t *) (getWorkingPageAddr() + offset);
@@ -248,6 +273,7 @@ void TunerStudio::handleCrc32Check(TsChannelBase *tsChannel, uint16_t offset, ui
 	 * Support settings pages!
 	 */
 	memset(engineConfiguration->highSpeedOffsets, 0x00, sizeof(engineConfiguration->highSpeedOffsets));
+	memset(tsChannel->highSpeedOffsets, 0x00, sizeof(tsChannel->highSpeedOffsets));
 #endif // EFI_TS_SCATTER
 
 	const uint8_t* start = getWorkingPageAddr() + offset;
@@ -261,7 +287,7 @@ void TunerStudio::handleCrc32Check(TsChannelBase *tsChannel, uint16_t offset, ui
 void TunerStudio::handleScatteredReadCommand(TsChannelBase* tsChannel) {
 	int totalResponseSize = 0;
 	for (int i = 0; i < HIGH_SPEED_COUNT; i++) {
-		uint16_t packed = engineConfiguration->highSpeedOffsets[i];
+		uint16_t packed = tsChannel->highSpeedOffsets[i];
 		uint16_t type = packed >> 13;
 
 		size_t size = type == 0 ? 0 : 1 << (type - 1);
@@ -280,7 +306,7 @@ void TunerStudio::handleScatteredReadCommand(TsChannelBase* tsChannel) {
 
 	uint8_t dataBuffer[8];
 	for (int i = 0; i < HIGH_SPEED_COUNT; i++) {
-		uint16_t packed = engineConfiguration->highSpeedOffsets[i];
+		uint16_t packed = tsChannel->highSpeedOffsets[i];
 		uint16_t type = packed >> 13;
 		uint16_t offset = packed & 0x1FFF;
 
@@ -388,7 +414,12 @@ static bool isKnownCommand(char command) {
 			|| command == TS_PERF_TRACE_BEGIN
 			|| command == TS_PERF_TRACE_GET_BUFFER
 			|| command == TS_GET_CONFIG_ERROR
-			|| command == TS_QUERY_BOOTLOADER;
+			|| command == TS_GET_HISTOGRAM
+			|| command == TS_QUERY_BOOTLOADER
+#if EFI_FILE_LOGGING
+			|| command == TS_LOG_STREAM_COMMAND
+#endif // EFI_FILE_LOGGING
+			;
 }
 
 /**
@@ -477,18 +508,35 @@ static int tsProcessOne(TsChannelBase* tsChannel) {
 	assertStack("communication", ObdCode::STACK_USAGE_COMMUNICATION, EXPECTED_REMAINING_STACK, -1);
 
 	if (!tsChannel->isReady()) {
+		// USB unplugged and the like
+		tsChannel->resetSession();
 		chThdSleepMilliseconds(10);
 		return -1;
 	}
 
 	tsState.totalCounter++;
 
+	int firstByteTimeout = TS_COMMUNICATION_TIMEOUT;
+#if EFI_FILE_LOGGING
+	if (tsChannel->logStream.isActive()) {
+		// while streaming only wait for commands until the next record is due
+		firstByteTimeout = TIME_US2I(NT2US(tsChannel->logStream.getTimeToNextRecordNt(getTimeNowNt())));
+	}
+#endif // EFI_FILE_LOGGING
+
 	uint8_t firstByte;
-	size_t received = tsChannel->readTimeout(&firstByte, 1, TS_COMMUNICATION_TIMEOUT);
+	size_t received = tsChannel->readTimeout(&firstByte, 1, firstByteTimeout);
 #if EFI_SIMULATOR
 		logMsg("received %d\r\n", received);
 #endif // EFI_SIMULATOR
 
+#if EFI_FILE_LOGGING
+	if (received != 1 && tsChannel->logStream.isActive()) {
+		// silence is expected while the host is only listening to the stream
+		return -1;
+	}
+#endif // EFI_FILE_LOGGING
+
 	if (received != 1) {
 //			tunerStudioError("ERROR: no command");
 #if EFI_BLUETOOTH_SETUP
@@ -498,7 +546,7 @@ static int tsProcessOne(TsChannelBase* tsChannel) {
 			bluetoothSoftwareDisconnectNotify(getBluetoothChannel());
 		}
 #endif  /* EFI_BLUETOOTH_SETUP */
-		tsChannel->in_sync = false;
+		tsChannel->resetSession();
 		return -1;
 	}
 
@@ -511,7 +559,7 @@ static int tsProcessOne(TsChannelBase* tsChannel) {
 	received = tsChannel->readTimeout(&secondByte, 1, TS_COMMUNICATION_TIMEOUT_SHORT);
 	if (received != 1) {
 		tunerStudioError(tsChannel, "TS: ERROR: no second byte");
-		tsChannel->in_sync = false;
+		tsChannel->resetSession();
 		return -1;
 	}
 
@@ -525,7 +573,7 @@ static int tsProcessOne(TsChannelBase* tsChannel) {
 			/* send error only if previously we were in sync */
 			sendErrorCode(tsChannel, TS_RESPONSE_OUT_OF_RANGE, "invalid size");
 		}
-		tsChannel->in_sync = false;
+		tsChannel->resetSession();
 		return -1;
 	}
 
@@ -543,7 +591,7 @@ static int tsProcessOne(TsChannelBase* tsChannel) {
 			tunerStudioError(tsChannel, "ERROR: not enough bytes in stream");
 			// MS serial protocol spec: There was a timeout before all data was received. (25ms per character.)
 			sendErrorCode(tsChannel, TS_RESPONSE_UNDERRUN, "underrun");
-			tsChannel->in_sync = false;
+			tsChannel->resetSession();
 			return -1;
 		}
 
@@ -551,7 +599,7 @@ static int tsProcessOne(TsChannelBase* tsChannel) {
 			/* print and send error as we were in sync */
 			efiPrintf("unexpected command %x", command);
 			sendErrorCode(tsChannel, TS_RESPONSE_UNRECOGNIZED_COMMAND, "unknown");
-			tsChannel->in_sync = false;
+			tsChannel->resetSession();
 			return -1;
 		}
 	} else {
@@ -587,7 +635,7 @@ static int tsProcessOne(TsChannelBase* tsChannel) {
 					(unsigned int)actualCrc, (unsigned int)expectedCrc);
 			tunerStudioError(tsChannel, "ERROR: CRC issue");
 			sendErrorCode(tsChannel, TS_RESPONSE_CRC_FAILURE, "crc_issue");
-			tsChannel->in_sync = false;
+			tsChannel->resetSession();
 		}
 		return -1;
 	}
@@ -615,6 +663,10 @@ void TunerstudioThread::ThreadTask() {
 
 	// Until the end of time, process incoming messages.
 	while (true) {
+#if EFI_FILE_LOGGING
+		serviceLogStream(channel);
+#endif // EFI_FILE_LOGGING
+
 		if (tsProcessOne(channel) == 0) {
 			onDataArrived(true);
 		} else {
@@ -644,6 +696,20 @@ static void handleGetVersion(TsChannelBase* tsChannel) {
 	tsChannel->sendResponse(TS_CRC, (const uint8_t *) versionBuffer, strlen(versionBuffer) + 1);
 }
 
+static void handleGetHistogram(TsChannelBase* tsChannel, char *data, int incomingPacketSize) {
+	uint8_t index = data[0];
+	if (incomingPacketSize < 2 || index >= (uint8_t)LatencyHistogram::Count) {
+		sendErrorCode(tsChannel, TS_RESPONSE_OUT_OF_RANGE, "histogram");
+		return;
+	}
+
+	static_assert(TS_PACKET_HEADER_SIZE + sizeof(LatencyHistogramReport) + TS_PACKET_TAIL_SIZE <= sizeof(tsChannel->scratchBuffer));
+	auto report = reinterpret_cast<LatencyHistogramReport*>(tsChannel->scratchBuffer + TS_PACKET_HEADER_SIZE);
+	fillLatencyHistogramReport(static_cast<LatencyHistogram>(index), *report);
+
+	tsChannel->crcAndWriteBuffer(TS_RESPONSE_OK, sizeof(LatencyHistogramReport));
+}
+
 #if EFI_TEXT_LOGGING
 static void handleGetText(TsChannelBase* tsChannel) {
 	tsState.textCommandCounter++;
@@ -670,8 +736,6 @@ void TunerStudio::handleExecuteCommand(TsChannelBase* tsChannel, char *data, int
 			logMsg("execute [%s]\r\n", trimmed);
 #endif // EFI_SIMULATOR
 	(console_line_callback)(trimmed);
-
-	tsChannel->writeCrcResponse(TS_RESPONSE_OK);
 }
 
 int TunerStudio::handleCrcCommand(TsChannelBase* tsChannel, char *data, int incomingPacketSize) {
@@ -680,6 +744,9 @@ int TunerStudio::handleCrcCommand(TsChannelBase* tsChannel, char *data, int inco
 	char command = data[0];
 	data++;
 
+	// all channels share this engine: serialize tune writes, let reads run side by side
+	TsCommandGuard guard(tsConfigLock, getTsCommandAccess(command));
+
 	const uint16_t* data16 = reinterpret_cast<uint16_t*>(data);
 
 	uint16_t offset = 0;
@@ -724,6 +791,9 @@ int TunerStudio::handleCrcCommand(TsChannelBase* tsChannel, char *data, int inco
 #endif // EFI_TEXT_LOGGING
 	case TS_EXECUTE:
 		handleExecuteCommand(tsChannel, data, incomingPacketSize - 1);
+		// a slow client must not hold up tune access on other channels while it receives the response
+		guard.release();
+		tsChannel->writeCrcResponse(TS_RESPONSE_OK);
 		break;
 	case TS_CHUNK_WRITE_COMMAND:
 		handleWriteChunkCommand(tsChannel, offset, count, data + sizeof(TunerStudioWriteChunkRequest));
@@ -768,6 +838,7 @@ int TunerStudio::handleCrcCommand(TsChannelBase* tsChannel, char *data, int inco
 
 			executeTSCommand(subsystem, index);
 #endif /* EFI_PROD_CODE */
+			guard.release();
 			sendOkResponse(tsChannel);
 		}
 		break;
@@ -807,6 +878,8 @@ int TunerStudio::handleCrcCommand(TsChannelBase* tsChannel, char *data, int inco
 
 				if (buffer) {
 					tsChannel->sendResponse(TS_CRC, buffer.get<uint8_t>(), buffer.size(), true);
+
+					triggerScopeReturnBuffer();
 				} else {
 					// TS asked for a tooth logger buffer, but we don't have one to give it.
 					sendErrorCode(tsChannel, TS_RESPONSE_OUT_OF_RANGE, DO_NOT_LOG);
@@ -814,6 +887,22 @@ int TunerStudio::handleCrcCommand(TsChannelBase* tsChannel, char *data, int inco
 			}
 			break;
 #endif // TRIGGER_SCOPE
+#if EFI_SENSOR_CHART
+		case TS_SENSOR_CHART_READ:
+			{
+				auto capture = sensorChartGetCapture();
+
+				if (capture) {
+					tsChannel->sendResponse(TS_CRC, reinterpret_cast<const uint8_t*>(capture), sizeof(*capture), true);
+
+					sensorChartReturnCapture();
+				} else {
+					// sensorChartMode is off or somebody else has the big buffer
+					sendErrorCode(tsChannel, TS_RESPONSE_OUT_OF_RANGE, DO_NOT_LOG);
+				}
+			}
+			break;
+#endif // EFI_SENSOR_CHART
 		default:
 			// dunno what that was, send NAK
 			return false;
@@ -857,11 +946,37 @@ int TunerStudio::handleCrcCommand(TsChannelBase* tsChannel, char *data, int inco
 
 		break;
 #endif /* ENABLE_PERF_TRACE */
+	case TS_GET_HISTOGRAM:
+		handleGetHistogram(tsChannel, data, incomingPacketSize);
+		break;
 	case TS_GET_CONFIG_ERROR: {
 		const char* configError = getCriticalErrorMessage();
 		tsChannel->sendResponse(TS_CRC, reinterpret_cast<const uint8_t*>(configError), strlen(configError), true);
 		break;
 	}
+#if EFI_FILE_LOGGING
+	case TS_LOG_STREAM_COMMAND:
+		if (data[0] == TS_LOG_STREAM_START && incomingPacketSize >= 4) {
+			// rate in Hz, little endian like offset/count
+			uint16_t rateHz = (uint8_t)data[1] | ((uint8_t)data[2] << 8);
+			startLogStream(tsChannel, rateHz);
+		} else {
+			tsChannel->logStream.stop();
+			sendOkResponse(tsChannel);
+		}
+		break;
+#endif // EFI_FILE_LOGGING
+#if EFI_ENGINE_CONTROL
+	case TS_GET_CUT_TIMELINE: {
+		// several channels run commands at once, the reply is built in this channel's own buffer
+		static_assert(TS_PACKET_HEADER_SIZE + sizeof(LimpCutHistory) + TS_PACKET_TAIL_SIZE <= sizeof(tsChannel->scratchBuffer));
+		auto cutHistory = reinterpret_cast<LimpCutHistory*>(tsChannel->scratchBuffer + TS_PACKET_HEADER_SIZE);
+		getLimpManager()->getCutHistory(*cutHistory);
+
+		tsChannel->crcAndWriteBuffer(TS_RESPONSE_OK, sizeof(LimpCutHistory));
+		break;
+	}
+#endif // EFI_ENGINE_CONTROL
 	case TS_QUERY_BOOTLOADER: {
 		uint8_t bldata = TS_QUERY_BOOTLOADER_NONE;
 #if EFI_USE_OPENBLT
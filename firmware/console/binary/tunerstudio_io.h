@@ -9,6 +9,7 @@
 #pragma once
 #include "global.h"
 #include "tunerstudio_impl.h"
+#include "log_stream.h"
 
 #if EFI_USB_SERIAL
 #include "usbconsole.h"
@@ -79,6 +80,24 @@ public:
 	 * command and check if it is supported. */
 	bool in_sync = false;
 
+	/**
+	 * Live data subscription of this client, see TS_GET_SCATTERED_GET_COMMAND.
+	 * Each client keeps its own list so that a dash logger and a laptop do not overwrite each other's.
+	 */
+	uint16_t highSpeedOffsets[HIGH_SPEED_COUNT] = {};
+
+	// Push-based log, see TS_LOG_STREAM_COMMAND
+	LogStream logStream;
+
+	/**
+	 * Client is gone or the byte stream can not be trusted anymore: wait for the next valid packet,
+	 * and do not keep pushing the log stream into a dead channel
+	 */
+	void resetSession() {
+		in_sync = false;
+		logStream.stop();
+	}
+
 private:
 	bool isBigPacket(size_t size);
 	void writeCrcPacketLarge(uint8_t responseCode, const uint8_t* buf, size_t size);
@@ -134,6 +153,7 @@ protected:
 #define SR5_READ_TIMEOUT TIME_MS2I(1000)
 
 void startSerialChannels();
+void printSerialChannelsStats();
 SerialTsChannelBase* getBluetoothChannel();
 
 void startCanConsole();
@@ -103,6 +103,16 @@ void startSerialChannels() {
 #endif
 }
 
+void printSerialChannelsStats() {
+#if defined(TS_PRIMARY_UxART_PORT) && !EFI_TS_PRIMARY_IS_SERIAL && EFI_USE_UART_DMA
+	primaryChannel.printStats();
+#endif
+
+#if defined(TS_SECONDARY_UxART_PORT) && !EFI_TS_SECONDARY_IS_SERIAL && EFI_USE_UART_DMA
+	secondaryChannel.printStats();
+#endif
+}
+
 SerialTsChannelBase* getBluetoothChannel() {
 #if defined(TS_SECONDARY_UxART_PORT)
 	// Prefer secondary channel for bluetooth
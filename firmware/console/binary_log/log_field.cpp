@@ -63,3 +63,98 @@ size_t LogField::writeData(char* buffer) const {
 
 	return size;
 }
+
+uint16_t getMlgRecordLength(const LogField* fields, size_t fieldCount) {
+	uint16_t recLength = 0;
+	for (size_t i = 0; i < fieldCount; i++) {
+		recLength += fields[i].getSize();
+	}
+
+	return recLength;
+}
+
+size_t getMlgHeaderSize(size_t fieldCount) {
+	return MLQ_HEADER_SIZE + fieldCount * MLQ_FIELD_HEADER_SIZE;
+}
+
+size_t getMlgDataBlockSize(const LogField* fields, size_t fieldCount) {
+	// 4 bytes block header, 1 byte checksum footer
+	return 4 + getMlgRecordLength(fields, fieldCount) + 1;
+}
+
+void writeMlgHeader(Writer& outBuffer, const LogField* fields, size_t fieldCount) {
+	char buffer[MLQ_HEADER_SIZE];
+	// File format: MLVLG\0
+	strncpy(buffer, "MLVLG", 6);
+
+	// Format version = 02
+	buffer[6] = 0;
+	buffer[7] = 2;
+
+	// Timestamp
+	buffer[8] = 0;
+	buffer[9] = 0;
+	buffer[10] = 0;
+	buffer[11] = 0;
+
+	// Info data start
+	buffer[12] = 0;
+	buffer[13] = 0;
+	buffer[14] = 0;
+	buffer[15] = 0;
+
+	size_t headerSize = getMlgHeaderSize(fieldCount);
+
+	// Data begin index: begins immediately after the header
+	buffer[16] = 0;
+	buffer[17] = 0;
+	buffer[18] = (headerSize >> 8) & 0xFF;
+	buffer[19] = headerSize & 0xFF;
+
+	// Record length - length of a single data record: sum size of all fields
+	uint16_t recordLength = getMlgRecordLength(fields, fieldCount);
+	buffer[20] = recordLength >> 8;
+	buffer[21] = recordLength & 0xFF;
+
+	// Number of logger fields
+	buffer[22] = fieldCount >> 8;
+	buffer[23] = fieldCount;
+
+	outBuffer.write(buffer, MLQ_HEADER_SIZE);
+
+	// Write the actual logger fields, offset 22
+	for (size_t i = 0; i < fieldCount; i++) {
+		fields[i].writeHeader(outBuffer);
+	}
+}
+
+void writeMlgDataBlock(Writer& outBuffer, const LogField* fields, size_t fieldCount, uint8_t rollCounter, uint16_t timestamp) {
+	char buffer[16];
+
+	// Offset 0 = Block type, standard data block in this case
+	buffer[0] = 0;
+
+	// Offset 1 = rolling counter sequence number
+	buffer[1] = rollCounter;
+
+	// Offset 2, size 2 = Timestamp at 10us resolution
+	buffer[2] = timestamp >> 8;
+	buffer[3] = timestamp & 0xFF;
+
+	outBuffer.write(buffer, 4);
+
+	uint8_t sum = 0;
+	for (size_t fieldIndex = 0; fieldIndex < fieldCount; fieldIndex++) {
+		size_t entrySize = fields[fieldIndex].writeData(buffer);
+
+		for (size_t byteIndex = 0; byteIndex < entrySize; byteIndex++) {
+			// "CRC" at the end is just the sum of all bytes
+			sum += buffer[byteIndex];
+		}
+		outBuffer.write(buffer, entrySize);
+	}
+
+	buffer[0] = sum;
+	// 1 byte checksum footer
+	outBuffer.write(buffer, 1);
+}
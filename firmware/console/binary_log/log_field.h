@@ -132,3 +132,17 @@ template<>
 constexpr LogField::Type LogField::resolveType<float>() {
 	return Type::F32;
 }
+
+/**
+ * MLG (MegaLogViewer binary) framing shared by the SD card log and the log stream.
+ * See also mlq_file_format.txt
+ */
+// Sum of all field sizes
+uint16_t getMlgRecordLength(const LogField* fields, size_t fieldCount);
+// Total size of the file header including field descriptions
+size_t getMlgHeaderSize(size_t fieldCount);
+// Size of one data block as written by writeMlgDataBlock
+size_t getMlgDataBlockSize(const LogField* fields, size_t fieldCount);
+
+void writeMlgHeader(Writer& outBuffer, const LogField* fields, size_t fieldCount);
+void writeMlgDataBlock(Writer& outBuffer, const LogField* fields, size_t fieldCount, uint8_t rollCounter, uint16_t timestamp);
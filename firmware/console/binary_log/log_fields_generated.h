@@ -337,6 +337,8 @@ static const LogField fields[] = {
 	{engine->outputChannels.rtcUnixEpochTime, "rtcUnixEpochTime", "", 0},
 	{engine->outputChannels.sparkCutReasonBlinker, "sparkCutReasonBlinker", "", 0},
 	{engine->outputChannels.fuelCutReasonBlinker, "fuelCutReasonBlinker", "", 0},
+	{engine->outputChannels.fuelCutReasonMask, "Fuel: Cut Reasons", "", 0},
+	{engine->outputChannels.sparkCutReasonMask, "Ign: Cut Reasons", "", 0},
 #if EFI_ENGINE_CONTROL
 	{engine->fuelComputer.totalFuelCorrection, "Fuel: Total correction", "mult", 2, "Fuel: math"},
 #endif
@@ -0,0 +1,102 @@
+/**
+ * @file log_stream.cpp
+ *
+ * @date Oct 18, 2026
+ */
+
+#include "pch.h"
+
+#include "log_stream.h"
+#include "log_field.h"
+#include "buffered_writer.h"
+#include "tunerstudio_io.h"
+
+/**
+ * Writes one CRC framed TS packet of known size without assembling it in memory first
+ */
+class TsPacketWriter final : public BufferedWriter<256> {
+public:
+	TsPacketWriter(TsChannelBase& channel, uint8_t responseCode, size_t size)
+		: m_channel(channel)
+	{
+		m_crc = m_channel.writePacketHeader(responseCode, size);
+	}
+
+	void finish() {
+		flush();
+
+		uint8_t crcBuffer[4];
+		*(uint32_t*)crcBuffer = SWAP_UINT32(m_crc);
+		m_channel.write(crcBuffer, sizeof(crcBuffer), /*isEndOfPacket*/true);
+		m_channel.flush();
+	}
+
+protected:
+	size_t writeInternal(const char* buffer, size_t count) override {
+		m_crc = crc32inc((void*)buffer, m_crc, count);
+		m_channel.write(reinterpret_cast<const uint8_t*>(buffer), count, /*isEndOfPacket*/false);
+		return count;
+	}
+
+private:
+	TsChannelBase& m_channel;
+	uint32_t m_crc;
+};
+
+void LogStream::start(uint16_t rateHz, efitick_t nowNt) {
+	rateHz = std::clamp<uint16_t>(rateHz, 1, LOG_STREAM_MAX_RATE_HZ);
+
+	m_periodNt = US2NT(US_PER_SECOND / rateHz);
+	m_nextRecordNt = nowNt;
+	m_sequence = 0;
+	m_skippedCount = 0;
+}
+
+void LogStream::stop() {
+	m_periodNt = 0;
+}
+
+bool LogStream::isRecordDue(efitick_t nowNt) const {
+	return isActive() && nowNt >= m_nextRecordNt;
+}
+
+efidur_t LogStream::getTimeToNextRecordNt(efitick_t nowNt) const {
+	if (isRecordDue(nowNt)) {
+		return 0;
+	}
+
+	return m_nextRecordNt - nowNt;
+}
+
+void LogStream::writeHeader(TsChannelBase& channel, const LogField* fields, size_t fieldCount) {
+	TsPacketWriter writer(channel, TS_RESPONSE_OK, getMlgHeaderSize(fieldCount));
+	writeMlgHeader(writer, fields, fieldCount);
+	writer.finish();
+}
+
+void LogStream::writeRecord(TsChannelBase& channel, const LogField* fields, size_t fieldCount, efitick_t nowNt) {
+	// if we fell behind by more than a period, skip the slots we missed so that
+	// the host sees the gap in sequence numbers instead of a burst of late records
+	efidur_t lateNt = nowNt - m_nextRecordNt;
+	if (lateNt >= m_periodNt) {
+		uint32_t missed = lateNt / m_periodNt;
+		m_sequence += missed;
+		m_skippedCount += missed;
+		m_nextRecordNt += missed * m_periodNt;
+	}
+	m_nextRecordNt += m_periodNt;
+
+	size_t size = sizeof(m_sequence) + getMlgDataBlockSize(fields, fieldCount);
+	TsPacketWriter writer(channel, TS_RESPONSE_LOG_STREAM_RECORD, size);
+
+	uint32_t sequence = SWAP_UINT32(m_sequence);
+	writer.write(reinterpret_cast<const char*>(&sequence), sizeof(sequence));
+
+	// Timestamp at 10us resolution
+	uint16_t timestamp = NT2US(nowNt) / 10;
+	writeMlgDataBlock(writer, fields, fieldCount, (uint8_t)m_sequence, timestamp);
+
+	writer.finish();
+
+	m_sequence++;
+}
@@ -0,0 +1,59 @@
+/**
+ * @file log_stream.h
+ *
+ * Push-based binary log: once started by TS_LOG_STREAM_COMMAND the ECU sends MLG data blocks
+ * at a fixed rate without per-record requests, see TunerstudioThread.
+ *
+ * Each record goes out as a regular CRC framed TS packet with TS_RESPONSE_LOG_STREAM_RECORD code:
+ *   offset 0, size 4: sequence number (big endian), one per rate period, gaps mean dropped records
+ *   offset 4: MLG data block, see writeMlgDataBlock
+ *
+ * The response to the start command is the MLG file header describing the fields.
+ *
+ * @date Oct 18, 2026
+ */
+
+#pragma once
+
+#include "rusefi_types.h"
+
+class TsChannelBase;
+class LogField;
+
+#define LOG_STREAM_MAX_RATE_HZ 1000
+
+class LogStream {
+public:
+	void start(uint16_t rateHz, efitick_t nowNt);
+	void stop();
+
+	bool isActive() const {
+		return m_periodNt != 0;
+	}
+
+	bool isRecordDue(efitick_t nowNt) const;
+	// How long the channel thread may wait for incoming commands before the next record is due
+	efidur_t getTimeToNextRecordNt(efitick_t nowNt) const;
+
+	void writeHeader(TsChannelBase& channel, const LogField* fields, size_t fieldCount);
+	void writeRecord(TsChannelBase& channel, const LogField* fields, size_t fieldCount, efitick_t nowNt);
+
+	uint32_t getSequence() const {
+		return m_sequence;
+	}
+
+	// records which were not sent because the channel could not keep up
+	uint32_t getSkippedCount() const {
+		return m_skippedCount;
+	}
+
+private:
+	efidur_t m_periodNt = 0;
+	efitick_t m_nextRecordNt = 0;
+	uint32_t m_sequence = 0;
+	uint32_t m_skippedCount = 0;
+};
+
+// Implemented next to the SD card log field list
+void startLogStream(TsChannelBase* tsChannel, uint16_t rateHz);
+void serviceLogStream(TsChannelBase* tsChannel);
@@ -5,31 +5,86 @@
  * @author Andrey Belomutskiy, (c) 2012-2020
  */
 
+#include "pch.h"
 #include "connector_uart_dma.h"
 
 #if HAL_USE_UART && EFI_USE_UART_DMA
 
+/**
+ * Same as iqPutI but for a whole span: memcpy into the queue storage in at most two pieces
+ * and wake the reader once.
+ */
+void UartDmaTsChannel::pushToQueueI(const uint8_t* data, size_t size) {
+	if (size == 0) {
+		return;
+	}
+
+	size_t freeSpace = iqGetEmptyI(&fifoRxQueue);
+	if (size > freeSpace) {
+		rxQueueOverrunCounter += size - freeSpace;
+		size = freeSpace;
+	}
+
+	size_t remaining = size;
+	while (remaining > 0) {
+		// copy up to the end of the queue storage, then wrap
+		size_t chunk = std::min(remaining, (size_t)(fifoRxQueue.q_top - fifoRxQueue.q_wrptr));
+		memcpy(fifoRxQueue.q_wrptr, data, chunk);
+		fifoRxQueue.q_wrptr += chunk;
+		if (fifoRxQueue.q_wrptr >= fifoRxQueue.q_top) {
+			fifoRxQueue.q_wrptr = fifoRxQueue.q_buffer;
+		}
+		fifoRxQueue.q_counter += chunk;
+		data += chunk;
+		remaining -= chunk;
+	}
+
+	if (size > 0) {
+		osalThreadDequeueNextI(&fifoRxQueue.q_waiting, MSG_OK);
+	}
+}
+
 /* Common function for all DMA-UART IRQ handlers. */
 void UartDmaTsChannel::copyDataFromDMA() {
 	chSysLockFromISR();
 	// get 0-based DMA buffer position
-	int dmaPos = TS_DMA_BUFFER_SIZE - dmaStreamGetTransactionSize(m_driver->dmarx);
-	// if the position is wrapped (circular DMA-mode enabled)
-	if (dmaPos < readPos)
-		dmaPos += TS_DMA_BUFFER_SIZE;
-	// we need to update the current readPos
-	int newReadPos = readPos;
-	for (int i = newReadPos; i < dmaPos; ) {
-		if (iqPutI(&fifoRxQueue, dmaBuffer[newReadPos]) != Q_OK) {
-			break; // todo: ignore overflow?
-		}
-		// the read position should always stay inside the buffer range
-		newReadPos = (++i) & (TS_DMA_BUFFER_SIZE - 1);
+	size_t dmaPos = TS_DMA_BUFFER_SIZE - dmaStreamGetTransactionSize(m_driver->dmarx);
+	// if the position is wrapped (circular DMA-mode enabled) take the tail of the ring first
+	if (dmaPos < readPos) {
+		pushToQueueI(&dmaBuffer[readPos], TS_DMA_BUFFER_SIZE - readPos);
+		readPos = 0;
 	}
-	readPos = newReadPos;
+	pushToQueueI(&dmaBuffer[readPos], dmaPos - readPos);
+	// the read position should always stay inside the buffer range
+	readPos = dmaPos & (TS_DMA_BUFFER_SIZE - 1);
+	chSysUnlockFromISR();
+}
+
+void UartDmaTsChannel::onRxIdle() {
+	// idle line means the peer has finished sending a packet - hand it over right away
+	// instead of waiting for the next half-buffer interrupt
+	idleFrameCounter++;
+	copyDataFromDMA();
+}
+
+void UartDmaTsChannel::onTxBufferDone() {
+	chSysLockFromISR();
+	chBSemSignalI(&txIdle);
 	chSysUnlockFromISR();
 }
 
+void UartDmaTsChannel::onRxError(uartflags_t flags) {
+	if (flags & UART_OVERRUN_ERROR) {
+		rxUartOverrunCounter++;
+	}
+	if (flags & UART_FRAMING_ERROR) {
+		framingErrorCounter++;
+	}
+	if (flags & UART_NOISE_ERROR) {
+		noiseErrorCounter++;
+	}
+}
+
 /* We use the same handler code for both halves. */
 static void tsRxIRQHalfHandler(UARTDriver *uartp, uartflags_t full) {
 	UNUSED(full);
@@ -38,8 +93,16 @@ static void tsRxIRQHalfHandler(UARTDriver *uartp, uartflags_t full) {
 
 /* This handler is called right after the UART receiver has finished its work. */
 static void tsRxIRQIdleHandler(UARTDriver *uartp) {
-	UNUSED(uartp);
-	reinterpret_cast<UartDmaTsChannel*>(uartp->dmaAdapterInstance)->copyDataFromDMA();
+	reinterpret_cast<UartDmaTsChannel*>(uartp->dmaAdapterInstance)->onRxIdle();
+}
+
+static void tsRxErrorHandler(UARTDriver *uartp, uartflags_t e) {
+	reinterpret_cast<UartDmaTsChannel*>(uartp->dmaAdapterInstance)->onRxError(e);
+}
+
+/* TX DMA has finished reading the buffer, it can be reused. */
+static void tsTxIRQEndHandler(UARTDriver *uartp) {
+	reinterpret_cast<UartDmaTsChannel*>(uartp->dmaAdapterInstance)->onTxBufferDone();
 }
 
 UartDmaTsChannel::UartDmaTsChannel(UARTDriver& driver)
@@ -49,15 +112,16 @@ UartDmaTsChannel::UartDmaTsChannel(UARTDriver& driver)
 	driver.dmaAdapterInstance = this;
 
 	iqObjectInit(&fifoRxQueue, buffer, sizeof(buffer), nullptr, nullptr);
+	chBSemObjectInit(&txIdle, false);
 }
 
 void UartDmaTsChannel::start(uint32_t baud) {
 	m_config = {
-		.txend1_cb		= NULL,
+		.txend1_cb		= tsTxIRQEndHandler,
 		.txend2_cb		= NULL,
 		.rxend_cb		= NULL,
 		.rxchar_cb		= NULL,
-		.rxerr_cb		= NULL,
+		.rxerr_cb		= tsRxErrorHandler,
 		.timeout_cb		= tsRxIRQIdleHandler,
 		.speed			= baud,
 		.cr1			= 0,
@@ -68,6 +132,10 @@ void UartDmaTsChannel::start(uint32_t baud) {
 
 	uartStart(m_driver, &m_config);
 
+	// nothing is in flight after (re)start
+	txIndex = 0;
+	chBSemReset(&txIdle, false);
+
 	// Start the buffered read process
 	readPos = 0;
 	uartStartReceive(m_driver, sizeof(dmaBuffer), dmaBuffer);
@@ -80,4 +148,43 @@ size_t UartDmaTsChannel::readTimeout(uint8_t* p_buffer, size_t size, int timeout
     return transferred;
 }
 
+void UartDmaTsChannel::write(const uint8_t* p_buffer, size_t size, bool) {
+	while (size > 0) {
+		size_t chunk = std::min(size, sizeof(txBuffer[0]));
+		uint8_t* txBuf = txBuffer[txIndex];
+
+		// at most one transfer is in flight and it uses the other half, so we can fill this one now
+		memcpy(txBuf, p_buffer, chunk);
+
+		if (chBSemWaitTimeout(&txIdle, BINARY_IO_TIMEOUT) != MSG_OK) {
+			// previous transfer is stuck, drop the rest of this packet
+			txTimeoutCounter++;
+			uartStopSend(m_driver);
+			chBSemReset(&txIdle, false);
+			return;
+		}
+
+		uartStartSend(m_driver, chunk, txBuf);
+		txIndex ^= 1;
+
+		bytesOut += chunk;
+		p_buffer += chunk;
+		size -= chunk;
+	}
+}
+
+void UartDmaTsChannel::flush() {
+	// wait for the last transfer to leave the buffer
+	if (chBSemWaitTimeout(&txIdle, BINARY_IO_TIMEOUT) == MSG_OK) {
+		chBSemSignal(&txIdle);
+	}
+}
+
+void UartDmaTsChannel::printStats() const {
+	efiPrintf("%s DMA ring=%d in=%d out=%d frames=%lu",
+		name, TS_DMA_BUFFER_SIZE, bytesIn, bytesOut, idleFrameCounter);
+	efiPrintf("%s DMA errors: queue overrun=%lu / uart overrun=%lu / framing=%lu / noise=%lu / tx timeout=%lu",
+		name, rxQueueOverrunCounter, rxUartOverrunCounter, framingErrorCounter, noiseErrorCounter, txTimeoutCounter);
+}
+
 #endif // HAL_USE_UART && EFI_USE_UART_DMA
@@ -13,8 +13,20 @@
 
 // See uart_dma_s
 #define TS_FIFO_BUFFER_SIZE (BLOCKING_FACTOR + 30)
+
+// Circular RX DMA ring. 921600 baud bluetooth/telemetry links need more than 32 bytes
+// of headroom between half/idle interrupts, so boards can override this.
 // This must be a power of 2!
-#define TS_DMA_BUFFER_SIZE 32
+#ifndef TS_DMA_BUFFER_SIZE
+#define TS_DMA_BUFFER_SIZE 128
+#endif
+
+// Size of each of the two TX DMA buffers
+#ifndef TS_DMA_TX_BUFFER_SIZE
+#define TS_DMA_TX_BUFFER_SIZE 128
+#endif
+
+static_assert((TS_DMA_BUFFER_SIZE & (TS_DMA_BUFFER_SIZE - 1)) == 0, "TS_DMA_BUFFER_SIZE must be a power of 2");
 
 class UartDmaTsChannel final : public UartTsChannel {
 public:
@@ -22,21 +34,46 @@ public:
 
 	void start(uint32_t baud) override;
 
-	// Override only read from UartTsChannel
 	size_t readTimeout(uint8_t* buffer, size_t size, int timeout) override;
+	void write(const uint8_t* buffer, size_t size, bool isEndOfPacket) override;
+	void flush() override;
+
+	void printStats() const;
 
+	// ISR handlers
 	void copyDataFromDMA();
+	void onRxIdle();
+	void onTxBufferDone();
+	void onRxError(uartflags_t flags);
 
 private:
+	void pushToQueueI(const uint8_t* data, size_t size);
+
 	// RX FIFO implementation
 	// circular DMA buffer
 	uint8_t dmaBuffer[TS_DMA_BUFFER_SIZE];
 	// current read position for the DMA buffer
-	volatile int readPos;
+	volatile size_t readPos;
 	// secondary FIFO buffer for async. transfer
 	uint8_t buffer[TS_FIFO_BUFFER_SIZE];
 	// input FIFO Rx queue
 	input_queue_t fifoRxQueue;
+
+	// TX double buffer: one half is on the wire while the other one is being filled
+	uint8_t txBuffer[2][TS_DMA_TX_BUFFER_SIZE];
+	uint8_t txIndex = 0;
+	// taken while a TX DMA transfer is in flight
+	binary_semaphore_t txIdle;
+
+	// bytes dropped because the reader did not drain fifoRxQueue in time
+	volatile uint32_t rxQueueOverrunCounter = 0;
+	// bytes lost in UART hardware (DMA did not keep up)
+	volatile uint32_t rxUartOverrunCounter = 0;
+	volatile uint32_t framingErrorCounter = 0;
+	volatile uint32_t noiseErrorCounter = 0;
+	// number of idle-line events, each one closes a received frame
+	volatile uint32_t idleFrameCounter = 0;
+	uint32_t txTimeoutCounter = 0;
 };
 
 #endif // HAL_USE_UART && EFI_USE_UART_DMA
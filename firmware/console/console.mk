@@ -1,5 +1,6 @@
 CONSOLE_COMMON_SRC_CPP = 	$(PROJECT_DIR)/console/binary/tooth_logger.cpp \
                          	$(PROJECT_DIR)/console/binary_log/log_field.cpp \
+                         	$(PROJECT_DIR)/console/binary_log/log_stream.cpp \
                          	$(PROJECT_DIR)/console/status_loop.cpp \
 
 
@@ -43,7 +43,24 @@ public:
 		lwip_send(connectionSocket, buffer, size, flags);
 	}
 
-	size_t readTimeout(uint8_t* buffer, size_t size, int /*timeout*/) override {
+	size_t readTimeout(uint8_t* buffer, size_t size, int timeout) override {
+		if (logStream.isActive()) {
+			// the log stream needs the thread back when the next record is due, do not block in recv
+			fd_set readSet;
+			FD_ZERO(&readSet);
+			FD_SET(connectionSocket, &readSet);
+
+			uint32_t timeoutUs = TIME_I2US(timeout);
+			timeval tv;
+			tv.tv_sec = timeoutUs / US_PER_SECOND;
+			tv.tv_usec = timeoutUs % US_PER_SECOND;
+
+			if (lwip_select(connectionSocket + 1, &readSet, nullptr, nullptr, &tv) == 0) {
+				// nothing arrived in time
+				return 0;
+			}
+		}
+
 		auto result = lwip_recv(connectionSocket, buffer, size, /*flags =*/ 0);
 
 		if (result == -1) {
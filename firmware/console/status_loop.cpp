@@ -150,7 +150,7 @@ void printOverallStatus() {
 #endif /* EFI_ENGINE_SNIFFER */
 
 #if EFI_SENSOR_CHART
-	publishSensorChartIfFull();
+	updateSensorChart();
 #endif // EFI_SENSOR_CHART
 
 	/**
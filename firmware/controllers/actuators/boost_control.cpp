@@ -102,7 +102,7 @@ expected<float> BoostController::getSetpoint() {
 #if EFI_ENGINE_CONTROL
 	// Add any blends if configured
 	for (size_t i = 0; i < efi::size(config->boostClosedLoopBlends); i++) {
-		auto result = calculateBlend(config->boostClosedLoopBlends[i], rpm, driverIntent.Value);
+		auto result = engine->module<BlendEvaluator>()->get(BlendSet::BoostClosedLoop, i, rpm, driverIntent.Value);
 
 		engine->outputChannels.boostClosedLoopBlendParameter[i] = result.BlendParameter;
 		engine->outputChannels.boostClosedLoopBlendBias[i] = result.Bias;
@@ -143,7 +143,7 @@ expected<percent_t> BoostController::getOpenLoop(float target) {
 #if EFI_ENGINE_CONTROL
 	// Add any blends if configured
 	for (size_t i = 0; i < efi::size(config->boostOpenLoopBlends); i++) {
-		auto result = calculateBlend(config->boostOpenLoopBlends[i], rpm, driverIntent.Value);
+		auto result = engine->module<BlendEvaluator>()->get(BlendSet::BoostOpenLoop, i, rpm, driverIntent.Value);
 
 		engine->outputChannels.boostOpenLoopBlendParameter[i] = result.BlendParameter;
 		engine->outputChannels.boostOpenLoopBlendBias[i] = result.Bias;
@@ -158,10 +158,34 @@ expected<percent_t> BoostController::getOpenLoop(float target) {
 	float gearAdder = engineConfiguration->gearBasedOpenLoopBoostAdder[static_cast<int>(gear) + 1];
 	openLoop += gearAdder;
 
+	openLoop += getSpoolFeedForward(target);
+
 	openLoopPart = openLoop;
 	return openLoop;
 }
 
+percent_t BoostController::getSpoolFeedForward(float target) {
+	if (engineConfiguration->boostType != CLOSED_LOOP || !engineConfiguration->boostSpoolFeedForward) {
+		m_spoolModel.resetLearned();
+		return 0;
+	}
+
+	auto map = Sensor::get(SensorType::Map);
+	if (!map) {
+		// A sensor glitch doesn't change the turbo, keep what was learned about it
+		m_spoolModel.reset();
+		return 0;
+	}
+
+	float baro = Sensor::get(SensorType::BarometricPressure).value_or(101.325f);
+	float exhaustPower = BoostSpoolModel::getExhaustPower(engine->engineState.airflowEstimate, getBoostSpoolExhaustTemperature());
+
+	// boostOutput is still what we did last time
+	m_spoolModel.update(map.Value - baro, exhaustPower, boostOutput, FAST_CALLBACK_PERIOD_MS / 1000.0f);
+
+	return m_spoolModel.getFeedForward(target - baro);
+}
+
 percent_t BoostController::getClosedLoopImpl(float target, float manifoldPressure) {
 	// If we're in open loop only mode, make no closed loop correction.
 	isNotClosedLoop = engineConfiguration->boostType != CLOSED_LOOP;
@@ -189,6 +213,16 @@ percent_t BoostController::getClosedLoopImpl(float target, float manifoldPressur
 		return 0;
 	}
 
+	if (m_spoolModel.isSpooling()) {
+		// Spool feed-forward is taking care of the rise, don't wind up on it
+		float iTerm = m_pid.iTerm;
+		float output = m_pid.getOutput(target, manifoldPressure, FAST_CALLBACK_PERIOD_MS / 1000.0f);
+		m_pid.iTerm = iTerm;
+		return output;
+	}
+
+	m_pid.iTerm = clampF(m_pid.iTermMin, m_pid.iTerm + m_spoolModel.getIntegratorHandover(), m_pid.iTermMax);
+
 	return m_pid.getOutput(target, manifoldPressure, FAST_CALLBACK_PERIOD_MS / 1000.0f);
 }
 
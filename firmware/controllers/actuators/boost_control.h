@@ -9,6 +9,7 @@
 #include "closed_loop_controller.h"
 #include "efi_pid.h"
 #include "boost_control_generated.h"
+#include "boost_spool_model.h"
 
 #include "Map2D.h"
 
@@ -43,8 +44,13 @@ public:
 
 	void setOutput(expected<percent_t> outputValue) override;
 
+	const BoostSpoolModel& getSpoolModel() const {
+		return m_spoolModel;
+	}
+
 private:
 	percent_t getClosedLoopImpl(float target, float manifoldPressure);
+	percent_t getSpoolFeedForward(float target);
 
     float getBoostControlDutyCycleWithTemperatureCorrections(const float rpm, const float driverIntent) const;
     std::optional<float> getBoostControlTargetTemperatureAdder() const;
@@ -54,6 +60,7 @@ private:
     ) const;
 
 	Pid m_pid;
+	BoostSpoolModel m_spoolModel;
 
 	const ValueProvider3D* m_openLoopMap = nullptr;
 	const ValueProvider3D* m_closedLoopTargetMap = nullptr;
@@ -0,0 +1,134 @@
+/**
+ * @file boost_spool_model.cpp
+ *
+ * See boost_spool_model.h for the model.
+ */
+
+#include "pch.h"
+
+#include "boost_spool_model.h"
+#include "thermistors.h"
+
+PUBLIC_API_WEAK float getBoostSpoolExhaustTemperature() {
+	return Sensor::get(SensorType::EGT1).value_or(BOOST_SPOOL_DEFAULT_EGT);
+}
+
+float BoostSpoolModel::getExhaustPower(float airflow, float exhaustTemperature) {
+	return airflow * convertCelsiusToKelvin(exhaustTemperature) / 1000;
+}
+
+void BoostSpoolModel::resetLearned() {
+	m_gain = BOOST_SPOOL_DEFAULT_GAIN;
+
+	reset();
+}
+
+void BoostSpoolModel::reset() {
+	m_boost = 0;
+	m_exhaustPower = 0;
+	m_duty = 0;
+	m_feedForward = 0;
+	m_integratorHandover = 0;
+	m_boostRate = 0;
+	m_exhaustPowerRate = 0;
+
+	m_hasHistory = false;
+	m_isSpooling = false;
+}
+
+float BoostSpoolModel::getWastegateOpening(float boost, float duty) {
+	float opening = (boost * (1 - duty / 100) - BOOST_SPOOL_WASTEGATE_PRELOAD) / BOOST_SPOOL_WASTEGATE_SPAN;
+
+	return clampF(0, opening, 1);
+}
+
+float BoostSpoolModel::getBoostRate(float boost, float exhaustPower, float duty) const {
+	float turbineDrive = exhaustPower * (1 - getWastegateOpening(boost, duty) * BOOST_SPOOL_WASTEGATE_BYPASS);
+
+	// more exhaust power spins the turbo up quicker, don't let that go to infinity near idle
+	float timeConstant = BOOST_SPOOL_TIME_CONSTANT * BOOST_SPOOL_REFERENCE_POWER
+		/ std::max(exhaustPower, BOOST_SPOOL_REFERENCE_POWER / 4.0f);
+
+	return (m_gain * turbineDrive - boost) / timeConstant;
+}
+
+void BoostSpoolModel::update(float boost, float exhaustPower, float duty, float dt) {
+	if (m_hasHistory) {
+		m_boostRate += BOOST_SPOOL_RATE_FILTER_ALPHA * ((boost - m_boost) / dt - m_boostRate);
+		m_exhaustPowerRate += BOOST_SPOOL_POWER_RATE_FILTER_ALPHA * ((exhaustPower - m_exhaustPower) / dt - m_exhaustPowerRate);
+	}
+
+	m_hasHistory = true;
+
+	m_boost = boost;
+	m_exhaustPower = exhaustPower;
+	m_duty = duty;
+
+	// Settled boost is all turbo gain, the rest of the model doesn't matter there
+	bool isSettled = std::abs(m_boostRate) < BOOST_SPOOL_LEARN_MAX_RATE
+		&& boost > BOOST_SPOOL_LEARN_MIN_BOOST
+		&& !m_isSpooling;
+
+	if (isSettled) {
+		float turbineDrive = exhaustPower * (1 - getWastegateOpening(boost, duty) * BOOST_SPOOL_WASTEGATE_BYPASS);
+
+		if (turbineDrive > 0) {
+			m_gain += BOOST_SPOOL_LEARN_RATE * (boost / turbineDrive - m_gain);
+		}
+	}
+}
+
+float BoostSpoolModel::predict(float duty) const {
+	float boost = m_boost;
+	float exhaustPower = m_exhaustPower;
+	// exhaust power dropping is a shift or a lift, that's not going to overshoot;
+	// and a snapped throttle isn't going to keep going up like that for the whole horizon
+	float exhaustPowerRate = clampF(0, m_exhaustPowerRate, m_exhaustPower / BOOST_SPOOL_HORIZON);
+
+	for (float t = 0; t < BOOST_SPOOL_HORIZON; t += BOOST_SPOOL_STEP) {
+		boost += getBoostRate(boost, exhaustPower, duty) * BOOST_SPOOL_STEP;
+		exhaustPower += exhaustPowerRate * BOOST_SPOOL_STEP;
+	}
+
+	return boost;
+}
+
+float BoostSpoolModel::getFeedForward(float target) {
+	bool wasSpooling = m_isSpooling;
+	float previousFeedForward = m_feedForward;
+
+	m_feedForward = getFeedForwardImpl(target);
+
+	// Spool is over, closed loop takes over from where feed-forward left the duty
+	m_integratorHandover = wasSpooling && !m_isSpooling ? previousFeedForward : 0;
+
+	return m_feedForward;
+}
+
+float BoostSpoolModel::getFeedForwardImpl(float target) {
+	// Boost that has settled above the target is closed loop's business
+	if (m_boostRate < BOOST_SPOOL_MIN_RATE) {
+		m_isSpooling = false;
+		return 0;
+	}
+
+	float baseDuty = getBaseDuty();
+	float predicted = predict(baseDuty);
+
+	m_isSpooling = predicted > target && predicted - m_boost > BOOST_SPOOL_MIN_RISE;
+
+	if (!m_isSpooling) {
+		return 0;
+	}
+
+	// Duty it takes to land on the target, from how much less duty changes the prediction
+	constexpr float dutyStep = 10;
+	float sensitivity = (predicted - predict(baseDuty - dutyStep)) / dutyStep;
+
+	if (sensitivity < 0.01f) {
+		// wastegate hasn't cracked open yet, as much as we can
+		return -BOOST_SPOOL_MAX_FEED_FORWARD;
+	}
+
+	return std::max(-(predicted - target) / sensitivity, -(float)BOOST_SPOOL_MAX_FEED_FORWARD);
+}
@@ -0,0 +1,146 @@
+/**
+ * @file boost_spool_model.h
+ * @brief Short horizon boost prediction from a turbo spool model
+ *
+ * Boost b (kPa above baro) follows the exhaust power p driving the turbine with a lag from turbo inertia:
+ *   tau(p) * b' = K * p * (1 - g * bypass) - b
+ * where the spin-up time tau gets shorter as p grows, and the wastegate opening g starts once the
+ * boost pushing on the actuator, less what the solenoid duty bleeds off, beats the spring preload:
+ *   g = clamp((b * (1 - duty) - preload) / springSpan, 0, 1)
+ *
+ * Exhaust power is airflow times exhaust temperature. Turbo gain K is learned whenever boost holds still,
+ * the rest of the model is fixed and boards which know their turbo better can override it.
+ *
+ * While the turbo is spooling, the model predicts where boost is going to be a moment from now; if that is past
+ * the target the duty is backed off ahead of time, and closed loop leaves the rise alone rather than winding up
+ * its integrator on an error that is about to go away. Once boost stops rising closed loop picks up from there.
+ */
+
+#pragma once
+
+// kPa of boost that start opening the wastegate with no duty
+#ifndef BOOST_SPOOL_WASTEGATE_PRELOAD
+#define BOOST_SPOOL_WASTEGATE_PRELOAD 50
+#endif
+
+// kPa from the wastegate cracking open to fully open
+#ifndef BOOST_SPOOL_WASTEGATE_SPAN
+#define BOOST_SPOOL_WASTEGATE_SPAN 30
+#endif
+
+// fraction of the exhaust power a fully open wastegate takes away from the turbine
+#ifndef BOOST_SPOOL_WASTEGATE_BYPASS
+#define BOOST_SPOOL_WASTEGATE_BYPASS 0.8f
+#endif
+
+// turbo spin-up time at the reference exhaust power, seconds
+#ifndef BOOST_SPOOL_TIME_CONSTANT
+#define BOOST_SPOOL_TIME_CONSTANT 0.5f
+#endif
+#define BOOST_SPOOL_REFERENCE_POWER 300
+
+// kPa of boost per unit of exhaust power before anything is learned
+#ifndef BOOST_SPOOL_DEFAULT_GAIN
+#define BOOST_SPOOL_DEFAULT_GAIN 0.25f
+#endif
+
+// Exhaust temperature assumed without an EGT sensor, C
+#ifndef BOOST_SPOOL_DEFAULT_EGT
+#define BOOST_SPOOL_DEFAULT_EGT 800
+#endif
+
+// how far ahead boost is predicted, and the integration step for that, seconds
+#define BOOST_SPOOL_HORIZON 0.3f
+#define BOOST_SPOOL_STEP 0.01f
+
+// predicted rise smaller than this (kPa), or boost rising slower than this (kPa/s), is not spooling,
+// closed loop takes care of it
+#define BOOST_SPOOL_MIN_RISE 5
+#define BOOST_SPOOL_MIN_RATE 20
+// most duty the feed-forward takes away
+#define BOOST_SPOOL_MAX_FEED_FORWARD 30
+
+// gain is learned while boost moves slower than this, kPa/s
+#define BOOST_SPOOL_LEARN_MAX_RATE 5
+#define BOOST_SPOOL_LEARN_MIN_BOOST 10
+// per update
+#define BOOST_SPOOL_LEARN_RATE 0.01f
+#define BOOST_SPOOL_RATE_FILTER_ALPHA 0.1f
+#define BOOST_SPOOL_POWER_RATE_FILTER_ALPHA 0.2f
+
+/**
+ * Exhaust temperature for the spool model, C
+ * Default is EGT1 if we have it, boards without EGT which know their engine can do better than a constant
+ */
+float getBoostSpoolExhaustTemperature();
+
+class BoostSpoolModel {
+public:
+	BoostSpoolModel() {
+		resetLearned();
+	}
+
+	// Forgets the state of the turbo, what has been learned about it is kept
+	void reset();
+	// Back to the default gain as well
+	void resetLearned();
+
+	/**
+	 * Called once per boost control loop.
+	 * @param boost kPa above baro
+	 * @param exhaustPower see getExhaustPower
+	 * @param duty output of the last loop, 0 to 100
+	 */
+	void update(float boost, float exhaustPower, float duty, float dt);
+
+	// Negative duty adder for this loop, also decides isSpooling
+	float getFeedForward(float target);
+
+	// The model is handling the rise to the target, closed loop should not integrate
+	bool isSpooling() const {
+		return m_isSpooling;
+	}
+
+	// Non-zero on the loop spooling ends: closed loop adds it to its integrator so that the duty doesn't jump back
+	float getIntegratorHandover() const {
+		return m_integratorHandover;
+	}
+
+	// Boost after BOOST_SPOOL_HORIZON with this duty, assuming exhaust power keeps its current trend
+	float predict(float duty) const;
+
+	// Duty of the last loop less what getFeedForward took away, what closed loop and open loop ask for
+	float getBaseDuty() const {
+		return m_duty - m_feedForward;
+	}
+
+	float getGain() const {
+		return m_gain;
+	}
+
+	/**
+	 * @param airflow kg/h
+	 * @param exhaustTemperature C
+	 */
+	static float getExhaustPower(float airflow, float exhaustTemperature);
+
+private:
+	float getFeedForwardImpl(float target);
+	static float getWastegateOpening(float boost, float duty);
+	float getBoostRate(float boost, float exhaustPower, float duty) const;
+
+	float m_gain;
+
+	float m_boost;
+	float m_exhaustPower;
+	float m_duty;
+	float m_feedForward;
+	float m_integratorHandover;
+
+	// filtered, per second
+	float m_boostRate;
+	float m_exhaustPowerRate;
+
+	bool m_hasHistory;
+	bool m_isSpooling;
+};
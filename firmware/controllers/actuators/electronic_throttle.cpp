@@ -436,7 +436,20 @@ expected<percent_t> EtbController::getClosedLoopAutotune(percent_t target, perce
 		float kd = 0.08f * ku * m_tu;
 
 		// Every 5 cycles (of the throttle), cycle to the next value
-		if (m_autotuneCounter >= 5) {
+		uint8_t cyclesPerParam = 5;
+
+		// Once the throttle model has seen enough motion its gains are better, and they don't need
+		// several cycles to settle
+		if (m_plantEstimator.isValid()) {
+			pid_s modelGains;
+			m_plantEstimator.getPidGains(m_plantEstimator.getRecommendedBandwidth(), modelGains);
+			kp = modelGains.pFactor;
+			ki = modelGains.iFactor;
+			kd = modelGains.dFactor;
+			cyclesPerParam = 1;
+		}
+
+		if (m_autotuneCounter >= cyclesPerParam) {
 			m_autotuneCounter = 0;
 			m_autotuneCurrentParam = (m_autotuneCurrentParam + 1) % 3; // three ETB calibs: P-I-D
 		}
@@ -525,12 +538,48 @@ void EtbController::setOutput(expected<percent_t> outputValue) {
 		&& !engineConfiguration->pauseEtbControl)) {
 		m_motor->enable();
 		m_motor->set(ETB_PERCENT_TO_DUTY(outputValue.Value));
+
+		if (isEtbMode()) {
+			updatePlantEstimator(outputValue.Value);
+		}
 	} else {
 		// Otherwise disable the motor.
 		m_motor->disable("no-ETB");
+		m_plantEstimator.interrupt();
 	}
 }
 
+void EtbController::updatePlantEstimator(percent_t output) {
+	auto position = Sensor::get(m_positionSensor);
+	if (!position) {
+		m_plantEstimator.interrupt();
+		return;
+	}
+
+	// What the motor actually gets
+	m_plantEstimator.update(position.Value, 100 * ETB_PERCENT_TO_DUTY(output));
+
+#if EFI_TUNER_STUDIO
+	// Outside of autotune the autotune debug fields show what has been learned while driving
+	if (m_function == DC_Throttle1
+		&& engineConfiguration->debugMode == DBG_ETB_AUTOTUNE
+		&& !m_isAutotune
+		&& m_plantEstimator.isValid()) {
+		EtbPlantModel model = m_plantEstimator.getModel();
+		pid_s gains;
+		m_plantEstimator.getPidGains(m_plantEstimator.getRecommendedBandwidth(), gains);
+
+		engine->outputChannels.debugFloatField1 = model.gain;
+		engine->outputChannels.debugFloatField2 = model.timeConstant;
+		engine->outputChannels.debugFloatField3 = model.springPreload;
+		engine->outputChannels.debugFloatField4 = model.friction;
+		engine->outputChannels.debugFloatField5 = gains.pFactor;
+		engine->outputChannels.debugFloatField6 = gains.iFactor;
+		engine->outputChannels.debugFloatField7 = gains.dFactor;
+	}
+#endif // EFI_TUNER_STUDIO
+}
+
 bool EtbController::checkStatus() {
 #if EFI_TUNER_STUDIO
 	// Only debug throttle #1
@@ -615,6 +664,7 @@ void EtbController::update() {
 	if (!std::isnan(directPwmValue)) {
 		m_motor->set(directPwmValue);
 		etbErrorCode = (int8_t)TpsState::Manual;
+		m_plantEstimator.interrupt();
 		return;
 	}
 
@@ -624,6 +674,7 @@ void EtbController::update() {
 		// If engine is stopped and so configured, skip the ETB update entirely
 		// This is quieter and pulls less power than leaving it on all the time
 		m_motor->disable("etb status");
+		m_plantEstimator.interrupt();
 		return;
 	}
 
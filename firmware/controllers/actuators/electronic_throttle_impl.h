@@ -13,6 +13,7 @@
 #include "sensor.h"
 #include "efi_pid.h"
 #include "electronic_throttle_generated.h"
+#include "etb_plant_estimator.h"
 
 /**
  * Hard code ETB update speed.
@@ -59,6 +60,11 @@ public:
 	// Used to inspect the internal PID controller's state
 	const pid_state_s& getPidState() const override { return m_pid; };
 
+	// Throttle model learned while driving, see etb_plant_estimator.h
+	const EtbPlantEstimator& getPlantEstimator() const {
+		return m_plantEstimator;
+	}
+
 	// Use the throttle to automatically calibrate the relevant throttle position sensor(s).
 	void autoCalibrateTps() override;
 
@@ -126,6 +132,9 @@ private:
 	uint8_t m_autotuneCounter = 0;
 	uint8_t m_autotuneCurrentParam = 0;
 
+	void updatePlantEstimator(percent_t output);
+	EtbPlantEstimator m_plantEstimator{1.0f / ETB_LOOP_FREQUENCY};
+
 	Timer m_luaAdjustmentTimer;
 };
 
@@ -0,0 +1,159 @@
+/**
+ * @file etb_plant_estimator.cpp
+ *
+ * Model parameters are kept in regression form, see etb_plant_estimator.h.
+ * Duty and position are regressed in fractions of 100% so that all regressors are of similar magnitude.
+ */
+
+#include "pch.h"
+
+#include "etb_plant_estimator.h"
+
+EtbPlantEstimator::EtbPlantEstimator(float periodSeconds)
+	: m_period(periodSeconds)
+{
+	reset();
+}
+
+void EtbPlantEstimator::reset() {
+	for (size_t i = 0; i < ETB_PLANT_PARAMETER_COUNT; i++) {
+		m_theta[i] = 0;
+
+		for (size_t j = 0; j < ETB_PLANT_PARAMETER_COUNT; j++) {
+			m_p[i][j] = i == j ? ETB_PLANT_INITIAL_COVARIANCE : 0;
+		}
+	}
+
+	m_historyCount = 0;
+	m_sampleCount = 0;
+}
+
+static float motionDirection(float positionDelta) {
+	if (positionDelta > ETB_PLANT_MOTION_DEADBAND) {
+		return 1;
+	} else if (positionDelta < -ETB_PLANT_MOTION_DEADBAND) {
+		return -1;
+	} else {
+		return 0;
+	}
+}
+
+static bool isAwayFromStops(float position) {
+	return position > ETB_PLANT_MIN_POSITION && position < ETB_PLANT_MAX_POSITION;
+}
+
+void EtbPlantEstimator::update(float position, float duty) {
+	float positionDelta = position - m_lastPosition;
+
+	if (m_historyCount >= 2) {
+		bool isMoving = motionDirection(positionDelta) != 0 || motionDirection(m_lastPositionDelta) != 0;
+
+		// Held by friction or against a stop: the model doesn't say anything about these
+		if (isMoving && isAwayFromStops(m_lastPosition) && isAwayFromStops(position)) {
+			float phi[ETB_PLANT_PARAMETER_COUNT] = {
+				m_lastPositionDelta,
+				// with the throttle much slower than the loop, duty shows up in the position over two loops
+				0.005f * (m_lastDuty + m_previousDuty),
+				1,
+				0.01f * m_lastPosition,
+				motionDirection(positionDelta),
+			};
+
+			updateLeastSquares(phi, positionDelta);
+		}
+	} else {
+		m_historyCount++;
+	}
+
+	m_lastPositionDelta = positionDelta;
+	m_lastPosition = position;
+	m_previousDuty = m_lastDuty;
+	m_lastDuty = duty;
+}
+
+void EtbPlantEstimator::updateLeastSquares(const float (&phi)[ETB_PLANT_PARAMETER_COUNT], float measured) {
+	float pPhi[ETB_PLANT_PARAMETER_COUNT];
+	float denominator = 0;
+	float predicted = 0;
+	float trace = 0;
+
+	for (size_t i = 0; i < ETB_PLANT_PARAMETER_COUNT; i++) {
+		pPhi[i] = 0;
+		for (size_t j = 0; j < ETB_PLANT_PARAMETER_COUNT; j++) {
+			pPhi[i] += m_p[i][j] * phi[j];
+		}
+
+		denominator += phi[i] * pPhi[i];
+		predicted += m_theta[i] * phi[i];
+		trace += m_p[i][i];
+	}
+
+	float lambda = trace > ETB_PLANT_MAX_COVARIANCE_TRACE ? 1 : ETB_PLANT_FORGETTING_FACTOR;
+	denominator += lambda;
+
+	float error = measured - predicted;
+
+	for (size_t i = 0; i < ETB_PLANT_PARAMETER_COUNT; i++) {
+		m_theta[i] += pPhi[i] / denominator * error;
+	}
+
+	// P is symmetric, update the upper triangle and mirror it to keep rounding from breaking that
+	for (size_t i = 0; i < ETB_PLANT_PARAMETER_COUNT; i++) {
+		for (size_t j = i; j < ETB_PLANT_PARAMETER_COUNT; j++) {
+			float value = (m_p[i][j] - pPhi[i] * pPhi[j] / denominator) / lambda;
+			m_p[i][j] = value;
+			m_p[j][i] = value;
+		}
+	}
+
+	m_sampleCount++;
+}
+
+bool EtbPlantEstimator::isValid() const {
+	float a = m_theta[0];
+	float b = m_theta[1];
+
+	return m_sampleCount >= ETB_PLANT_MIN_SAMPLES
+		// a decaying throttle speed, and more duty moving the throttle open
+		&& a > 0 && a < 1
+		&& b > 0;
+}
+
+EtbPlantModel EtbPlantEstimator::getModel() const {
+	float a = m_theta[0];
+	// per % duty
+	float b = 0.01f * m_theta[1];
+
+	EtbPlantModel model;
+	// throttle speed decays by a every period
+	model.timeConstant = -m_period / logf(a);
+	// and settles at K * u
+	model.gain = b / (m_period * (1 - a));
+	model.springPreload = -m_theta[2] / b;
+	model.springRate = -m_theta[3] / m_theta[1];
+	model.friction = -m_theta[4] / b;
+
+	return model;
+}
+
+void EtbPlantEstimator::getPidGains(float bandwidth, pid_s& gains) const {
+	EtbPlantModel model = getModel();
+
+	float tau = model.timeConstant;
+	float w = bandwidth;
+
+	// PID zeros at 1 / tau and w / 4: the derivative cancels the throttle's lag, so that
+	//   K / (s * (tau * s + 1))
+	// with the rest of the controller closes as a first order loop at bandwidth w, plus an integrator
+	// slow enough to not cause much overshoot. Spring is small next to that and is left to the integrator.
+	float kp = w / model.gain;
+	float integratorZero = w / 4;
+
+	gains.pFactor = kp * (1 + tau * integratorZero);
+	gains.iFactor = kp * integratorZero;
+	gains.dFactor = kp * tau;
+}
+
+float EtbPlantEstimator::getRecommendedBandwidth() const {
+	return std::min(2 / getModel().timeConstant, 0.2f / m_period);
+}
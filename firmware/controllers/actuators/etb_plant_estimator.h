@@ -0,0 +1,100 @@
+/**
+ * @file etb_plant_estimator.h
+ * @brief Online identification of the electronic throttle
+ *
+ * Throttle position y (%) driven by motor duty u (%):
+ *   tau * y'' + y' = K * (u - preload - springRate * y - friction * sign(y'))
+ *
+ * Sampled at the ETB loop rate with d[k] = y[k] - y[k-1] this is linear in the parameters
+ *   d[k] = a * d[k-1] + b * (u[k-1] + u[k-2]) / 2 + c + e * y[k-1] + f * sign(d[k])
+ * which is identified by recursive least squares from whatever the throttle is doing.
+ * Forgetting lets the estimate follow the throttle as it warms up.
+ */
+
+#pragma once
+
+// regressor: previous position delta, duty, 1, position, direction of motion
+#define ETB_PLANT_PARAMETER_COUNT 5
+
+// samples this close to the stops are the stop pushing back, not the spring
+#define ETB_PLANT_MIN_POSITION 1
+#define ETB_PLANT_MAX_POSITION 99
+
+// position deltas smaller than this (% per loop) count as not moving
+#define ETB_PLANT_MOTION_DEADBAND 0.05f
+
+#define ETB_PLANT_FORGETTING_FACTOR 0.9995f
+#define ETB_PLANT_INITIAL_COVARIANCE 100.0f
+// forgetting is suspended above this covariance trace so that a throttle holding still doesn't wind up the estimator
+#define ETB_PLANT_MAX_COVARIANCE_TRACE 500.0f
+
+// about two seconds of a moving throttle before the model is trusted
+#define ETB_PLANT_MIN_SAMPLES 1000
+
+struct EtbPlantModel {
+	// %/s of throttle speed per % duty
+	float gain;
+	// seconds
+	float timeConstant;
+	// % duty holding the throttle at 0% against the spring
+	float springPreload;
+	// % duty per % position
+	float springRate;
+	// % duty lost to friction whenever the throttle moves
+	float friction;
+};
+
+class EtbPlantEstimator {
+public:
+	EtbPlantEstimator(float periodSeconds);
+
+	void reset();
+
+	/**
+	 * Called once per ETB loop.
+	 * @param position measured this loop
+	 * @param duty output this loop, -100 to 100
+	 */
+	void update(float position, float duty);
+
+	// The throttle was not driven by us for a while, history is stale
+	void interrupt() {
+		m_historyCount = 0;
+	}
+
+	// Enough samples seen and the model is physically sensible
+	bool isValid() const;
+
+	EtbPlantModel getModel() const;
+
+	/**
+	 * PID gains closing the loop at bandwidth (rad/s) with the derivative cancelling the throttle's time constant.
+	 * Spring preload and friction are left for the feed forward table.
+	 * Only pFactor, iFactor and dFactor are written.
+	 */
+	void getPidGains(float bandwidth, pid_s& gains) const;
+
+	// Closed loop bandwidth (rad/s) recommended for this model: twice as fast as the throttle, limited by the loop rate
+	float getRecommendedBandwidth() const;
+
+	uint32_t getSampleCount() const {
+		return m_sampleCount;
+	}
+
+private:
+	void updateLeastSquares(const float (&phi)[ETB_PLANT_PARAMETER_COUNT], float measured);
+
+	const float m_period;
+
+	float m_theta[ETB_PLANT_PARAMETER_COUNT];
+	float m_p[ETB_PLANT_PARAMETER_COUNT][ETB_PLANT_PARAMETER_COUNT];
+
+	// y[k-1], y[k-1] - y[k-2], u[k-1] and u[k-2]
+	float m_lastPosition = 0;
+	float m_lastPositionDelta = 0;
+	float m_lastDuty = 0;
+	float m_previousDuty = 0;
+	uint8_t m_historyCount = 0;
+
+	uint32_t m_sampleCount = 0;
+};
@@ -0,0 +1,68 @@
+/**
+ * @file idle_air_learning.cpp
+ */
+
+#include "pch.h"
+
+#include "idle_air_learning.h"
+
+static const float idleAirLearnCltBins[IDLE_AIR_LEARN_CLT_SIZE] = { -20, 0, 20, 40, 60, 80, 100, 120 };
+
+void IdleAirLearning::reset() {
+	for (size_t i = 0; i < IDLE_AIR_LEARN_LOAD_STATES; i++) {
+		for (size_t j = 0; j < IDLE_AIR_LEARN_CLT_SIZE; j++) {
+			m_learned[i][j] = 0;
+		}
+	}
+}
+
+float IdleAirLearning::getCorrection(float clt, size_t loadState) const {
+	return interpolate2d(clt, idleAirLearnCltBins, m_learned[loadState]);
+}
+
+float IdleAirLearning::learn(float clt, size_t loadState, float integrator) {
+	float before = getCorrection(clt, loadState);
+	float step = clampF(-IDLE_AIR_LEARN_MAX_STEP, IDLE_AIR_LEARN_RATE * integrator, IDLE_AIR_LEARN_MAX_STEP);
+
+	// Spread over the two bins around this CLT the same way getCorrection reads them
+	BinWeight weight = getBinWeight(idleAirLearnCltBins, clt);
+	size_t index = weight.index;
+
+	float* learned = m_learned[loadState];
+	learned[index] = clampF(-IDLE_AIR_LEARN_LIMIT, learned[index] + step * (1 - weight.fraction), IDLE_AIR_LEARN_LIMIT);
+	learned[index + 1] = clampF(-IDLE_AIR_LEARN_LIMIT, learned[index + 1] + step * weight.fraction, IDLE_AIR_LEARN_LIMIT);
+
+	return getCorrection(clt, loadState) - before;
+}
+
+void IdleAirLearning::save(IdleAirLearningBackup& backup) const {
+	for (size_t i = 0; i < IDLE_AIR_LEARN_LOAD_STATES; i++) {
+		copyArray(backup.learned[i], m_learned[i]);
+	}
+
+	backup.cookie = IDLE_AIR_LEARN_COOKIE;
+}
+
+bool IdleAirLearning::restore(const IdleAirLearningBackup& backup) {
+	reset();
+
+	if (backup.cookie != IDLE_AIR_LEARN_COOKIE) {
+		return false;
+	}
+
+	for (size_t i = 0; i < IDLE_AIR_LEARN_LOAD_STATES; i++) {
+		for (size_t j = 0; j < IDLE_AIR_LEARN_CLT_SIZE; j++) {
+			float value = backup.learned[i][j];
+
+			// NaN fails this too
+			if (!(std::abs(value) <= IDLE_AIR_LEARN_LIMIT)) {
+				reset();
+				return false;
+			}
+
+			m_learned[i][j] = value;
+		}
+	}
+
+	return true;
+}
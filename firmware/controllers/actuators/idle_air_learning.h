@@ -0,0 +1,67 @@
+/**
+ * @file idle_air_learning.h
+ *
+ * Idle air the engine needs on top of the open loop tables, learned from what the closed loop idle
+ * integrator holds once RPM has settled. Learned by CLT and by which extra loads (A/C, fan) are on,
+ * and applied as open loop so that the PID only has to trim what is left.
+ */
+
+#pragma once
+
+#include "rusefi_types.h"
+
+#define IDLE_AIR_LEARN_CLT_SIZE 8
+// none, A/C, fan, A/C and fan
+#define IDLE_AIR_LEARN_LOAD_STATES 4
+
+// Fraction of the integrator moved into the table per update
+#define IDLE_AIR_LEARN_RATE 0.02f
+// %, largest change of the learned air per update, whatever the integrator says
+#define IDLE_AIR_LEARN_MAX_STEP 0.05f
+// %
+#define IDLE_AIR_LEARN_LIMIT 20
+
+// RPM has to stay this close to target for IDLE_AIR_LEARN_SETTLE_TIME seconds before anything is learned
+#define IDLE_AIR_LEARN_RPM_WINDOW 50
+#define IDLE_AIR_LEARN_SETTLE_TIME 3
+
+#define IDLE_AIR_LEARN_COOKIE 0x1d1ea1c0
+
+/**
+ * Copy of the learned table which survives a reset in backup RAM
+ *
+ * Backup RAM is only kept while VBAT is powered: on boards without a backup battery, or once the car
+ * battery has been disconnected, learning starts over from zero. Not kept with the persistent config
+ * on purpose, the table changes on every settled idle update and flash would not take that.
+ */
+struct IdleAirLearningBackup {
+	uint32_t cookie;
+	float learned[IDLE_AIR_LEARN_LOAD_STATES][IDLE_AIR_LEARN_CLT_SIZE];
+};
+
+class IdleAirLearning {
+public:
+	IdleAirLearning() {
+		reset();
+	}
+
+	void reset();
+
+	// Learned idle air, %
+	float getCorrection(float clt, size_t loadState) const;
+
+	/**
+	 * Moves part of a settled integrator into the table
+	 * @return how much the learned air went up by, to be taken off the integrator
+	 */
+	float learn(float clt, size_t loadState, float integrator);
+
+	void save(IdleAirLearningBackup& backup) const;
+	/**
+	 * @return false if backup does not hold a valid table, this one is left empty then
+	 */
+	bool restore(const IdleAirLearningBackup& backup);
+
+private:
+	float m_learned[IDLE_AIR_LEARN_LOAD_STATES][IDLE_AIR_LEARN_CLT_SIZE];
+};
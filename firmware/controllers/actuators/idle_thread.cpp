@@ -18,6 +18,10 @@
 
 #include "dc_motors.h"
 
+#if EFI_BACKUP_SRAM
+#include "backup_ram.h"
+#endif // EFI_BACKUP_SRAM
+
 #if EFI_TUNER_STUDIO
 #include "stepper.h"
 #endif
@@ -151,6 +155,10 @@ if (engine->antilagController.isAntilagCondition) {
 
 	running += iacByRpmTaper;
 
+	if (engineConfiguration->idleAirLearning && engineConfiguration->idleMode == IM_AUTO) {
+		running += m_airLearning.getCorrection(clt, getLoadState());
+	}
+
   // are we clamping open loop part separately? should not we clamp once we have total value?
 	return clampPercentValue(running);
 }
@@ -204,6 +212,46 @@ float IdleController::getIdleTimingAdjustment(float rpm, float targetRpm, Phase
 	return m_timingPid.getOutput(targetRpm, rpm, FAST_CALLBACK_PERIOD_MS / 1000.0f);
 }
 
+size_t IdleController::getLoadState() {
+	bool isAcOn = engine->module<AcController>().unmock().acButtonState;
+	bool isFanOn = enginePins.fanRelay.getLogicValue() || enginePins.fanRelay2.getLogicValue();
+
+	return (isAcOn ? 1 : 0) | (isFanOn ? 2 : 0);
+}
+
+float IdleController::learnIdleAir(float rpm, float targetRpm) {
+	auto idlePid = getIdlePid();
+	size_t loadState = getLoadState();
+
+	bool isSettled = engineConfiguration->idleAirLearning
+		// CIC integrator is rebuilt from its own history, moving part of it out would not stick
+		&& idlePid == &industrialWithOverrideIdlePid
+		// A/C or fan just switched: the integrator is still catching up with the new load
+		&& loadState == m_airLearningLoadState
+		&& std::abs(rpm - targetRpm) <= IDLE_AIR_LEARN_RPM_WINDOW;
+
+	m_airLearningLoadState = loadState;
+
+	if (!isSettled) {
+		m_airLearningSettleTimer.reset();
+		return 0;
+	}
+
+	if (!m_airLearningSettleTimer.hasElapsedSec(IDLE_AIR_LEARN_SETTLE_TIME)) {
+		return 0;
+	}
+
+	float clt = Sensor::getOrZero(SensorType::Clt);
+	float learned = m_airLearning.learn(clt, loadState, idlePid->getIntegration());
+	idlePid->iTerm -= learned;
+
+#if EFI_BACKUP_SRAM
+	m_airLearning.save(getBackupSram()->IdleAir);
+#endif // EFI_BACKUP_SRAM
+
+	return learned;
+}
+
 static void finishIdleTestIfNeeded() {
 	if (engine->timeToStopIdleTest != 0 && getTimeNowUs() > engine->timeToStopIdleTest)
 		engine->timeToStopIdleTest = 0;
@@ -251,6 +299,7 @@ float IdleController::getClosedLoop(IIdleController::Phase phase, float tpsPos,
 
 		// We aren't idling, so don't apply any correction.  A positive correction could inhibit a return to idle.
 		m_lastAutomaticPosition = 0;
+		m_airLearningSettleTimer.reset();
 		return 0;
 	}
 
@@ -260,6 +309,7 @@ float IdleController::getClosedLoop(IIdleController::Phase phase, float tpsPos,
 	if (isInDeadZone) {
 		idleState = RPM_DEAD_ZONE;
 		// current RPM is close enough, no need to change anything
+		m_lastAutomaticPosition -= learnIdleAir(rpm, targetRpm);
 		return m_lastAutomaticPosition;
 	}
 
@@ -307,6 +357,9 @@ float IdleController::getClosedLoop(IIdleController::Phase phase, float tpsPos,
 	// which could give unstable results.
 	newValue = interpolateClamped(0, newValue, engineConfiguration->idlePidDeactivationTpsThreshold, 0, tpsPos);
 
+	// Whatever goes into the learned air comes out of the closed loop, so that the sum stays the same
+	newValue -= learnIdleAir(rpm, targetRpm);
+
 	m_lastAutomaticPosition = newValue;
 	return newValue;
 }
@@ -408,6 +461,13 @@ void IdleController::init() {
 	wasResetPid = false;
 	m_timingPid.initPidClass(&engineConfiguration->idleTimingPid);
 	getIdlePid()->initPidClass(&engineConfiguration->idleRpmPid);
+	m_airLearningSettleTimer.reset();
+
+#if EFI_BACKUP_SRAM
+	if (m_airLearning.restore(getBackupSram()->IdleAir)) {
+		efiPrintf("Idle air learning restored from backup RAM");
+	}
+#endif // EFI_BACKUP_SRAM
 }
 
 #endif /* EFI_IDLE_CONTROL */
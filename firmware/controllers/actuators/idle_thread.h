@@ -12,6 +12,7 @@
 #include "rusefi_types.h"
 #include "efi_pid.h"
 #include "sensor.h"
+#include "idle_air_learning.h"
 #include "idle_state_generated.h"
 
 struct IIdleController {
@@ -85,8 +86,19 @@ public:
 		return &industrialWithOverrideIdlePid;
 	}
 
+	const IdleAirLearning& getAirLearning() const {
+		return m_airLearning;
+	}
+
+	// Which extra loads are on, see IDLE_AIR_LEARN_LOAD_STATES
+	static size_t getLoadState();
 
 private:
+	/**
+	 * Once RPM has settled, moves part of the integrator into the learned air
+	 * @return how much was moved, the closed loop output has to go down by that much
+	 */
+	float learnIdleAir(float rpm, float targetRpm);
 
 	// These are stored by getIdlePosition() and used by getIdleTimingAdjustment()
 	Phase m_lastPhase = Phase::Cranking;
@@ -102,6 +114,10 @@ private:
 	float m_lastAutomaticPosition = 0;
 
 	Pid m_timingPid;
+
+	IdleAirLearning m_airLearning;
+	Timer m_airLearningSettleTimer;
+	size_t m_airLearningLoadState = 0;
 };
 
 percent_t getIdlePosition();
@@ -19,10 +19,14 @@ using vvt_map_t = Map3D<VVT_TABLE_SIZE, VVT_TABLE_SIZE, int8_t, uint16_t, uint16
 static vvt_map_t vvtTable1{"vvt1"};
 static vvt_map_t vvtTable2{"vvt2"};
 
+static const float vvtFeedForwardOilTempBins[VVT_FEED_FORWARD_SIZE] = { 20, 60, 90, 120 };
+static const float vvtFeedForwardRpmBins[VVT_FEED_FORWARD_SIZE] = { 1000, 2500, 4500, 7000 };
+
 VvtController::VvtController(int p_index)
 	: index(p_index)
 	, m_bank(BANK_BY_INDEX(p_index))
 	, m_cam(CAM_BY_INDEX(p_index))
+	, m_dt(MS2SEC(FAST_CALLBACK_PERIOD_MS))
 {
 }
 
@@ -40,9 +44,38 @@ void VvtController::onFastCallback() {
 		return;
 	}
 
+	uint32_t measurementCounter = m_measurementCounter;
+
+	if (measurementCounter == m_processedMeasurementCounter) {
+		// Nothing new from the cam, running the loop again would only integrate the same error again
+		if (m_hasMeasurement && m_lastMeasurement.hasElapsedMs(VVT_MEASUREMENT_TIMEOUT_MS)) {
+			m_hasMeasurement = false;
+			setOutput(unexpected);
+		}
+
+		return;
+	}
+
+	m_processedMeasurementCounter = measurementCounter;
+	efitick_t measurementNt = m_measurementNt;
+
+	if (m_hasMeasurement) {
+		// More than one cam position since last time is fine, the PID acts on the latest one
+		m_dt = m_lastMeasurement.getElapsedSecondsAndReset(measurementNt);
+	} else {
+		m_dt = MS2SEC(GET_PERIOD_LIMITED(&engineConfiguration->auxPid[m_cam]));
+		m_lastMeasurement.reset(measurementNt);
+		m_hasMeasurement = true;
+	}
+
 	update();
 }
 
+void VvtController::onCamMeasurement(efitick_t nowNt) {
+	m_measurementNt = nowNt;
+	m_measurementCounter = m_measurementCounter + 1;
+}
+
 void VvtController::onConfigurationChange(engine_configuration_s const * previousConfig) {
 	if (!previousConfig || !m_pid.isSame(&previousConfig->auxPid[m_cam])) {
 		m_pid.reset();
@@ -79,9 +112,47 @@ expected<angle_t> VvtController::getSetpoint() {
 }
 
 expected<percent_t> VvtController::getOpenLoop(angle_t target) {
-	// TODO: could we do VVT open loop?
 	UNUSED(target);
-	return 0;
+
+	// Holding the cam is mostly a matter of oil viscosity and pressure, not of where it is held
+	m_oilTemp = Sensor::get(SensorType::OilTemperature).value_or(Sensor::getOrZero(SensorType::Clt));
+	m_rpm = Sensor::getOrZero(SensorType::Rpm);
+
+	return getFeedForward(m_oilTemp, m_rpm);
+}
+
+float VvtController::getFeedForward(float oilTemp, float rpm) const {
+	return interpolate3d(
+		m_feedForward,
+		vvtFeedForwardOilTempBins, oilTemp,
+		vvtFeedForwardRpmBins, rpm
+	);
+}
+
+void VvtController::learnFeedForward() {
+	// What the integrator holds at steady state is the hold duty, move it into the feed forward
+	// so that it's already there next time around
+	float before = getFeedForward(m_oilTemp, m_rpm);
+	float step = VVT_FEED_FORWARD_LEARN_RATE * m_pid.iTerm;
+
+	// Spread over the four cells around this point the same way getFeedForward reads them
+	BinWeight oilTemp = getBinWeight(vvtFeedForwardOilTempBins, m_oilTemp);
+	BinWeight rpm = getBinWeight(vvtFeedForwardRpmBins, m_rpm);
+	const auto& pid = engineConfiguration->auxPid[m_cam];
+
+	for (size_t i = 0; i < 2; i++) {
+		float oilTempWeight = i == 0 ? 1 - oilTemp.fraction : oilTemp.fraction;
+
+		for (size_t j = 0; j < 2; j++) {
+			float rpmWeight = j == 0 ? 1 - rpm.fraction : rpm.fraction;
+
+			float& cell = m_feedForward[oilTemp.index + i][rpm.index + j];
+			cell = clampF(pid.minValue, cell + step * oilTempWeight * rpmWeight, pid.maxValue);
+		}
+	}
+
+	// Only what the feed forward actually gained here leaves the integrator
+	m_pid.iTerm -= getFeedForward(m_oilTemp, m_rpm) - before;
 }
 
 static bool shouldInvertVvt(int camIndex) {
@@ -101,7 +172,11 @@ expected<percent_t> VvtController::getClosedLoop(angle_t target, angle_t observa
 	bool isInverted = shouldInvertVvt(m_cam);
 	m_pid.setErrorAmplification(isInverted ? -1.0f : 1.0f);
 
-	float retVal = m_pid.getOutput(target, observation);
+	float retVal = m_pid.getOutput(target, observation, m_dt);
+
+	if (std::abs(target - observation) < VVT_FEED_FORWARD_LEARN_ERROR) {
+		learnFeedForward();
+	}
 
 #if EFI_TUNER_STUDIO
 	m_pid.postState(engine->outputChannels.vvtStatus[index]);
@@ -143,6 +218,16 @@ static const char *vvtOutputNames[CAM_INPUTS_COUNT] = {
 static OutputPin vvtPins[CAM_INPUTS_COUNT];
 static SimplePwm vvtPwms[CAM_INPUTS_COUNT] = { "VVT1", "VVT2", "VVT3", "VVT4" };
 
+VvtController* getVvtController(int index) {
+	switch (index) {
+		case 0: return &engine->module<VvtController1>().unmock();
+		case 1: return &engine->module<VvtController2>().unmock();
+		case 2: return &engine->module<VvtController3>().unmock();
+		case 3: return &engine->module<VvtController4>().unmock();
+		default: return nullptr;
+	}
+}
+
 OutputPin* getVvtOutputPin(int index) {
     return &vvtPins[index];
 }
@@ -189,10 +274,10 @@ void initVvtActuators() {
 	vvtTable2.initTable(config->vvtTable2, config->vvtTable2RpmBins, config->vvtTable2LoadBins);
 
 
-	engine->module<VvtController1>()->init(&vvtTable1, &vvtPwms[0]);
-	engine->module<VvtController2>()->init(&vvtTable2, &vvtPwms[1]);
-	engine->module<VvtController3>()->init(&vvtTable1, &vvtPwms[2]);
-	engine->module<VvtController4>()->init(&vvtTable2, &vvtPwms[3]);
+	for (int i = 0; i < CAM_INPUTS_COUNT; i++) {
+		// intake cams use the first table, exhaust cams the second
+		getVvtController(i)->init(CAM_BY_INDEX(i) == 0 ? &vvtTable1 : &vvtTable2, &vvtPwms[i]);
+	}
 
 	startVvtControlPins();
 }
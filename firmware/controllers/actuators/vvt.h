@@ -23,6 +23,18 @@ OutputPin* getVvtOutputPin(int index);
 #define CAM_BY_INDEX(index) (index % CAMS_PER_BANK)
 #define INDEX_BY_BANK_CAM(bank, cam) ((bank) * CAMS_PER_BANK + (cam))
 
+// No new cam position for this long and the last one can't be trusted anymore
+#ifndef VVT_MEASUREMENT_TIMEOUT_MS
+#define VVT_MEASUREMENT_TIMEOUT_MS 500
+#endif
+
+// Learned hold duty, oil temperature by RPM
+#define VVT_FEED_FORWARD_SIZE 4
+// Fraction of the integrator moved into the feed forward on each cam position
+#define VVT_FEED_FORWARD_LEARN_RATE 0.02f
+// Only learn while the cam is close to where it should be, deg
+#define VVT_FEED_FORWARD_LEARN_ERROR 2
+
 class VvtController : public EngineModule, public ClosedLoopController<angle_t, percent_t>, public vvt_s {
 public:
 	VvtController(int index);
@@ -41,11 +53,22 @@ public:
 	expected<percent_t> getClosedLoop(angle_t setpoint, angle_t observation) override;
 	void setOutput(expected<percent_t> outputValue) override;
 
+	/**
+	 * Called from the trigger each time a new position of this cam is recorded.
+	 * The closed loop runs once on the next fast callback, with the time between cam positions as its period.
+	 */
+	void onCamMeasurement(efitick_t nowNt);
+
+	// Duty needed to hold the cam still
+	float getFeedForward(float oilTemp, float rpm) const;
+
 	uint8_t getCamIndex() {
 		return m_cam;
 	}
 
 private:
+	void learnFeedForward();
+
 	const int index;
 	// Bank index, 0 or 1
 	const uint8_t m_bank;
@@ -53,6 +76,20 @@ private:
 	const uint8_t m_cam;
 
 	Pid m_pid;
+	// seconds, between the cam positions the PID acts on
+	float m_dt;
+
+	// Written from the trigger
+	volatile uint32_t m_measurementCounter = 0;
+	efitick_t m_measurementNt = 0;
+
+	uint32_t m_processedMeasurementCounter = 0;
+	bool m_hasMeasurement = false;
+	Timer m_lastMeasurement;
+
+	float m_oilTemp = 0;
+	float m_rpm = 0;
+	float m_feedForward[VVT_FEED_FORWARD_SIZE][VVT_FEED_FORWARD_SIZE] = {};
 
 	const ValueProvider3D* m_targetMap = nullptr;
 	IPwm* m_pwm = nullptr;
@@ -74,3 +111,6 @@ struct VvtController3 : public VvtController {
 struct VvtController4 : public VvtController {
 	VvtController4() : VvtController(3) { }
 };
+
+// By bank and cam index, see INDEX_BY_BANK_CAM
+VvtController* getVvtController(int index);
@@ -76,7 +76,7 @@ angle_t getRunningAdvance(float rpm, float engineLoad) {
 
 	// Add any adjustments if configured
 	for (size_t i = 0; i < efi::size(config->ignBlends); i++) {
-		auto result = calculateBlend(config->ignBlends[i], rpm, engineLoad);
+		auto result = engine->module<BlendEvaluator>()->get(BlendSet::Ignition, i, rpm, engineLoad);
 
 		engine->outputChannels.ignBlendParameter[i] = result.BlendParameter;
 		engine->outputChannels.ignBlendBias[i] = result.Bias;
@@ -46,7 +46,7 @@ float AirmassVeModelBase::getVe(float rpm, float load, bool postState) const {
 
 	// Add any adjustments if configured
 	for (size_t i = 0; i < efi::size(config->veBlends); i++) {
-		auto result = calculateBlend(config->veBlends[i], rpm, load);
+		auto result = engine->module<BlendEvaluator>()->get(BlendSet::Ve, i, rpm, load);
 
 		if (postState) {
 			engine->outputChannels.veBlendParameter[i] = result.BlendParameter;
@@ -32,6 +32,7 @@
 #include "fan_control.h"
 #include "ac_control.h"
 #include "vr_pwm.h"
+#include "malfunction_central.h"
 #include "max3185x.h"
 #if EFI_MC33816
  #include "mc33816.h"
@@ -162,6 +163,8 @@ void Engine::periodicSlowCallback() {
 
 	updateGppwm();
 
+	updateMalfunctionCentral();
+
 	engine->engineModules.apply_all([](auto & m) { m.onSlowCallback(); });
 
 #if (BOARD_TLE8888_COUNT > 0)
@@ -549,6 +552,11 @@ void Engine::periodicFastCallback() {
 	refreshMapAveragingPreCalc();
 #endif
 
+#if EFI_ENGINE_CONTROL
+	// blend inputs for everything computed below
+	module<BlendEvaluator>()->latchInputs();
+#endif // EFI_ENGINE_CONTROL
+
 	engineState.periodicFastCallback();
 
 	tachUpdate();
@@ -56,6 +56,8 @@
 #include "efi_output.h"
 #include "vvt.h"
 #include "trip_odometer.h"
+#include "blend_evaluator.h"
+#include "cylinder_lambda_separation.h"
 
 #include <functional>
 
@@ -136,6 +138,8 @@ public:
 #endif // EFI_HPFP && EFI_ENGINE_CONTROL
 #if EFI_ENGINE_CONTROL
 		Mockable<ThrottleModel>,
+		BlendEvaluator,
+		CylinderLambdaSeparation,
 #endif // EFI_ENGINE_CONTROL
 #if EFI_ALTERNATOR_CONTROL
 		AlternatorController,
@@ -201,7 +201,8 @@ void EngineState::periodicFastCallback() {
 	for (size_t i = 0; i < engineConfiguration->cylindersCount; i++) {
 		uint8_t bankIndex = engineConfiguration->cylinderBankSelect[i];
 		auto bankTrim = engine->engineState.stftCorrection[bankIndex];
-		auto cylinderTrim = getCylinderFuelTrim(i, rpm, fuelLoad);
+		auto cylinderTrim = getCylinderFuelTrim(i, rpm, fuelLoad)
+			* engine->module<CylinderLambdaSeparation>()->getTrimMultiplier(i, rpm, fuelLoad);
 		auto knockTrim = engine->module<KnockController>()->getFuelTrimMultiplier();
 
 		// Apply both per-bank and per-cylinder trims
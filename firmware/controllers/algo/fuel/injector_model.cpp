@@ -10,15 +10,64 @@ void InjectorModelBase::prepare() {
 	m_massFlowRate = flowRatio * getBaseFlowRate();
 	m_deadtime = getDeadtime();
 
-	if (getNonlinearMode() == INJ_FordModel) {
+	m_nonlinearMode = getNonlinearMode();
+	if (m_nonlinearMode == INJ_FordModel) {
 		m_smallPulseFlowRate = flowRatio * getSmallPulseFlowRate();
 		m_smallPulseBreakPoint = getSmallPulseBreakPoint();
 
 		// amount added to small pulses to correct for the "kink" from low flow region
 		m_smallPulseOffset = 1000 * ((m_smallPulseBreakPoint / m_massFlowRate) - (m_smallPulseBreakPoint / m_smallPulseFlowRate));
+	} else if (m_nonlinearMode == INJ_PolynomialAdder) {
+		updatePolynomialLut();
 	}
 }
 
+void InjectorModelBase::updatePolynomialLut() {
+	float limit = engineConfiguration->applyNonlinearBelowPulse;
+	auto& coefs = engineConfiguration->injectorCorrectionPolynomial;
+	static_assert(sizeof(coefs) == sizeof(m_polynomialLutCoefs));
+
+	if (limit == m_polynomialLutLimit && memcmp(coefs, m_polynomialLutCoefs, sizeof(coefs)) == 0) {
+		// nothing changed
+		return;
+	}
+
+	m_polynomialLutLimit = limit;
+	memcpy(m_polynomialLutCoefs, coefs, sizeof(coefs));
+
+	if (limit <= 0) {
+		// correction disabled
+		m_polynomialLutInvStep = 0;
+		return;
+	}
+
+	float step = limit / INJECTOR_POLYNOMIAL_LUT_SIZE;
+	m_polynomialLutInvStep = 1 / step;
+	for (size_t i = 0; i <= INJECTOR_POLYNOMIAL_LUT_SIZE; i++) {
+		// last point lands exactly on the limit where the correction still applies
+		float x = i == INJECTOR_POLYNOMIAL_LUT_SIZE ? limit : i * step;
+		m_polynomialLut[i] = correctInjectionPolynomial(x);
+	}
+}
+
+float InjectorModelBase::lookupPolynomialLut(float baseDuration) const {
+	if (baseDuration > m_polynomialLutLimit) {
+		// Large pulse, skip correction.
+		return baseDuration;
+	}
+
+	if (baseDuration < 0 || m_polynomialLutInvStep == 0) {
+		// outside of the table
+		return correctInjectionPolynomial(baseDuration);
+	}
+
+	float position = baseDuration * m_polynomialLutInvStep;
+	size_t index = std::min<size_t>(position, INJECTOR_POLYNOMIAL_LUT_SIZE - 1);
+	float fraction = position - index;
+
+	return m_polynomialLut[index] + (m_polynomialLut[index + 1] - m_polynomialLut[index]) * fraction;
+}
+
 constexpr float convertToGramsPerSecond(float ccPerMinute) {
 	return ccPerMinute * (fuelDensity / 60.f);
 }
@@ -176,7 +225,7 @@ float InjectorModelBase::getFuelMassForDuration(floatms_t duration) const {
 float InjectorModelBase::getBaseDurationImpl(float fuelMassGram) const {
 	floatms_t baseDuration = fuelMassGram / m_massFlowRate * 1000;
 
-	switch (getNonlinearMode()) {
+	switch (m_nonlinearMode) {
 	case INJ_FordModel:
 		if (fuelMassGram < m_smallPulseBreakPoint) {
 			// Small pulse uses a different slope, and adds the "zero fuel pulse" offset
@@ -186,7 +235,7 @@ float InjectorModelBase::getBaseDurationImpl(float fuelMassGram) const {
 			return baseDuration;
 		}
 	case INJ_PolynomialAdder:
-		return correctInjectionPolynomial(baseDuration);
+		return lookupPolynomialLut(baseDuration);
 	case INJ_None:
 	default:
 		return baseDuration;
@@ -4,6 +4,11 @@
 #include "injector_model_generated.h"
 #include "engine_module.h"
 
+// Segments of the small pulse correction table, see InjectorModelBase::updatePolynomialLut
+#ifndef INJECTOR_POLYNOMIAL_LUT_SIZE
+#define INJECTOR_POLYNOMIAL_LUT_SIZE 64
+#endif
+
 struct IInjectorModel : public EngineModule {
 	virtual void prepare() = 0;
 	virtual floatms_t getInjectionDuration(float fuelMassGram) const = 0;
@@ -31,6 +36,9 @@ public:
 	virtual float getSmallPulseBreakPoint() const = 0;
 
 private:
+	// getNonlinearMode() as of last prepare()
+	InjectorNonlinearMode m_nonlinearMode = INJ_None;
+
 	// Mass flow rate for large-pulse flow, g/s
 	float m_massFlowRate = 0;
 
@@ -42,6 +50,18 @@ private:
 
 	// Correction adder for small pulses to correct for small/large pulse kink, ms
 	float m_smallPulseOffset = 0;
+
+	// correctInjectionPolynomial sampled at uniform steps over [0, applyNonlinearBelowPulse], so that
+	// each injection costs one lookup instead of evaluating the polynomial
+	void updatePolynomialLut();
+	float lookupPolynomialLut(float baseDuration) const;
+
+	float m_polynomialLut[INJECTOR_POLYNOMIAL_LUT_SIZE + 1] = {};
+	float m_polynomialLutInvStep = 0;
+	// Inputs the table was built from: live tuning does not bump the configuration version,
+	// so these are compared on every prepare()
+	float m_polynomialLutLimit = -1;
+	float m_polynomialLutCoefs[sizeof(engine_configuration_s::injectorCorrectionPolynomial) / sizeof(float)] = {};
 };
 
 class InjectorModelWithConfig : public InjectorModelBase {
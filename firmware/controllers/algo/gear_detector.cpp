@@ -1,5 +1,11 @@
 #include "pch.h"
 
+#if EFI_BACKUP_SRAM
+#include "backup_ram.h"
+#endif // EFI_BACKUP_SRAM
+
+static_assert(GEAR_RATIO_LEARN_GEAR_COUNT == TCU_GEAR_COUNT);
+
 static constexpr float geometricMean(float x, float y) {
 	return sqrtf(x * y);
 }
@@ -37,34 +43,124 @@ void GearDetector::initGearDetector() {
 	}
 
 	for (int i = 0; i < gearCount - 1; i++) {
-		// Threshold i is the threshold between gears i and i+1
-		float gearI        = engineConfiguration->gearRatio[i];
-		float gearIplusOne = engineConfiguration->gearRatio[i + 1];
-
-		if (gearI <= gearIplusOne) {
+		if (engineConfiguration->gearRatio[i] <= engineConfiguration->gearRatio[i + 1]) {
 			criticalError("Invalid gear ordering near gear #%d", i + 1);
 		}
-
-		m_gearThresholds[i] = geometricMean(gearI, gearIplusOne);
 	}
 
+	updateGearThresholds();
+
 	Register();
 }
 
-void GearDetector::onConfigurationChange(engine_configuration_s const * /*previousConfig*/) {
+void GearDetector::updateGearThresholds() {
+	uint8_t gearCount = engineConfiguration->totalGearsCount;
+
+	for (int i = 0; i < gearCount - 1; i++) {
+		// Threshold i is the threshold between gears i and i+1
+		m_gearThresholds[i] = geometricMean(getGearRatio(i + 1), getGearRatio(i + 2));
+	}
+}
+
+float GearDetector::getConfigFingerprint(engine_configuration_s const * cfg) {
+	float result = cfg->totalGearsCount + cfg->finalGearRatio * cfg->driveWheelRevPerKm;
+
+	for (size_t i = 0; i < cfg->totalGearsCount && i < TCU_GEAR_COUNT; i++) {
+		result += (i + 1) * cfg->gearRatio[i];
+	}
+
+	return result;
+}
+
+void GearDetector::onConfigurationChange(engine_configuration_s const * previousConfig) {
+	// Learned with other gears or tires
+	if (previousConfig && getConfigFingerprint(previousConfig) != getConfigFingerprint(engineConfiguration)) {
+		m_ratioLearning.reset();
+	}
+
     initGearDetector();
 }
 
-void GearDetector::onSlowCallback() {
+void GearDetector::onFastCallback() {
     if (!isInitialized) {
+#if EFI_BACKUP_SRAM
+		if (m_ratioLearning.restore(getBackupSram()->GearRatios, getConfigFingerprint(engineConfiguration))) {
+			efiPrintf("Gear ratios restored from backup RAM");
+		}
+#endif // EFI_BACKUP_SRAM
+
         initGearDetector();
         isInitialized = true;
     }
 
 	float ratio = computeGearboxRatio();
-	m_gearboxRatio = ratio;
 
-	m_currentGear = determineGearFromRatio(ratio);
+	if (ratio == 0) {
+		// Stopped, nothing to tell the gears apart by
+		m_gearboxRatio = 0;
+		m_currentGear = 0;
+		m_candidateGear = 0;
+		m_stableCallbacks = 0;
+		return;
+	}
+
+	if (m_gearboxRatio == 0) {
+		m_gearboxRatio = ratio;
+	} else {
+		m_gearboxRatio += GEAR_RATIO_FILTER_ALPHA * (ratio - m_gearboxRatio);
+	}
+
+	// Ratio on the move is a shift in progress or a slipping clutch, the gear it passes through is not engaged
+	bool isSteady = std::abs(ratio - m_gearboxRatio) < GEAR_RATIO_STABLE_TOLERANCE * m_gearboxRatio
+		&& !engine->engineState.clutchDownState;
+
+	size_t gear = determineGearFromRatio(m_gearboxRatio);
+
+	if (!isSteady || gear != m_candidateGear) {
+		m_candidateGear = gear;
+		m_stableCallbacks = 0;
+		return;
+	}
+
+	if (m_stableCallbacks < GEAR_RATIO_LEARN_STABLE_CALLBACKS) {
+		m_stableCallbacks++;
+	}
+
+	if (m_stableCallbacks >= GEAR_STABLE_CALLBACKS) {
+		m_currentGear = gear;
+	}
+}
+
+void GearDetector::onSlowCallback() {
+	learnGearRatio();
+}
+
+void GearDetector::learnGearRatio() {
+	bool isSettled = engineConfiguration->learnGearRatios
+		&& m_currentGear != 0
+		&& m_candidateGear == m_currentGear
+		&& m_stableCallbacks >= GEAR_RATIO_LEARN_STABLE_CALLBACKS;
+
+	if (!isSettled) {
+		return;
+	}
+
+	GearRatioLearning previous = m_ratioLearning;
+	m_ratioLearning.learn(m_currentGear, m_gearboxRatio / engineConfiguration->gearRatio[m_currentGear - 1]);
+
+	// Close ratio gearbox with only some of the gears learned: don't let the rest be pushed past each other
+	for (size_t i = 1; i < engineConfiguration->totalGearsCount; i++) {
+		if (getGearRatio(i) <= getGearRatio(i + 1)) {
+			m_ratioLearning = previous;
+			return;
+		}
+	}
+
+	updateGearThresholds();
+
+#if EFI_BACKUP_SRAM
+	m_ratioLearning.save(getBackupSram()->GearRatios, getConfigFingerprint(engineConfiguration));
+#endif // EFI_BACKUP_SRAM
 }
 
 size_t GearDetector::determineGearFromRatio(float ratio) const {
@@ -75,12 +171,12 @@ size_t GearDetector::determineGearFromRatio(float ratio) const {
 	}
 
 	// 1.5x first gear is neutral or clutch slip or something
-	if (ratio > engineConfiguration->gearRatio[0] * 1.5f) {
+	if (ratio > getGearRatio(1) * 1.5f) {
 		return 0;
 	}
 
 	// 0.66x top gear is coasting with engine off or something
-	if (ratio < engineConfiguration->gearRatio[gearCount - 1] * 0.66f) {
+	if (ratio < getGearRatio(gearCount) * 0.66f) {
 		return 0;
 	}
 
@@ -132,13 +228,23 @@ float GearDetector::computeGearboxRatio() const {
 	return engineRpm / driveshaftRpm;
 }
 
-float GearDetector::getRpmInGear(size_t gear) const {
+float GearDetector::getGearRatio(size_t gear) const {
 	if (gear <= 0 || gear > engineConfiguration->totalGearsCount) {
 		return 0;
 	}
 
+	float configured = engineConfiguration->gearRatio[gear - 1];
+
+	if (!engineConfiguration->learnGearRatios) {
+		return configured;
+	}
+
+	return configured * m_ratioLearning.getMultiplier(gear);
+}
+
+float GearDetector::getRpmInGear(size_t gear) const {
 	// Ideal engine RPM is driveshaft speed times gear
-	return getDriveshaftRpm() * engineConfiguration->gearRatio[gear - 1];
+	return getDriveshaftRpm() * getGearRatio(gear);
 }
 
 float GearDetector::getGearboxRatio() const {
@@ -153,4 +259,8 @@ void GearDetector::showInfo(const char* sensorName) const {
 	efiPrintf("Sensor \"%s\" is gear detector.", sensorName);
 	efiPrintf("    Gearbox ratio: %.3f", m_gearboxRatio);
 	efiPrintf("    Detected gear: %d", m_currentGear);
+
+	for (size_t i = 1; i <= engineConfiguration->totalGearsCount; i++) {
+		efiPrintf("    Gear %d ratio: %.3f", i, getGearRatio(i));
+	}
 }
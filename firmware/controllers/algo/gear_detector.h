@@ -1,20 +1,39 @@
 #pragma once
 
+#include "gear_ratio_learning.h"
+
+// per fast callback
+#define GEAR_RATIO_FILTER_ALPHA 0.3f
+// Measured ratio further than this fraction from the filtered one is a shift or the clutch slipping
+#define GEAR_RATIO_STABLE_TOLERANCE 0.03f
+// fast callbacks of steady ratio before a new gear is reported
+#define GEAR_STABLE_CALLBACKS 6
+// and before the ratio is good enough to learn from
+#define GEAR_RATIO_LEARN_STABLE_CALLBACKS 200
+
 class GearDetector : public EngineModule, public Sensor {
 public:
 	GearDetector();
 	~GearDetector();
 
+	void onFastCallback() override;
 	void onSlowCallback() override;
-	void onConfigurationChange(engine_configuration_s const * /*previousConfig*/) override;
+	void onConfigurationChange(engine_configuration_s const * previousConfig) override;
 
 	float getGearboxRatio() const;
 
 	// Returns 0 for neutral, 1 for 1st, 5 for 5th, etc.
 	size_t determineGearFromRatio(float ratio) const;
 
+	// Configured ratio of this gear, corrected by what has been learned
+	float getGearRatio(size_t gear) const;
+
 	float getRpmInGear(size_t gear) const;
 
+	const GearRatioLearning& getRatioLearning() const {
+		return m_ratioLearning;
+	}
+
 	SensorResult get() const override;
 	void showInfo(const char* sensorName) const override;
 
@@ -22,10 +41,19 @@ private:
 	float computeGearboxRatio() const;
 	float getDriveshaftRpm() const;
 	void initGearDetector();
+	void updateGearThresholds();
+	void learnGearRatio();
+	static float getConfigFingerprint(engine_configuration_s const * cfg);
     bool isInitialized = false;
 
 	float m_gearboxRatio = 0;
 	size_t m_currentGear = 0;
 
+	// Gear the ratio points at, and for how long it has been doing that
+	size_t m_candidateGear = 0;
+	uint32_t m_stableCallbacks = 0;
+
 	float m_gearThresholds[TCU_GEAR_COUNT - 1];
+
+	GearRatioLearning m_ratioLearning;
 };
@@ -0,0 +1,91 @@
+/**
+ * @file gear_ratio_learning.cpp
+ */
+
+#include "pch.h"
+
+#include "gear_ratio_learning.h"
+
+static bool isValidMultiplier(float multiplier) {
+	// NaN fails this too
+	return std::abs(multiplier - 1) <= GEAR_RATIO_LEARN_LIMIT;
+}
+
+void GearRatioLearning::reset() {
+	for (size_t i = 0; i < GEAR_RATIO_LEARN_GEAR_COUNT; i++) {
+		m_multiplier[i] = NAN;
+	}
+}
+
+float GearRatioLearning::getMultiplier(size_t gear) const {
+	if (gear < 1 || gear > GEAR_RATIO_LEARN_GEAR_COUNT) {
+		return 1;
+	}
+
+	float learned = m_multiplier[gear - 1];
+	if (!std::isnan(learned)) {
+		return learned;
+	}
+
+	// Not driven in this gear yet: what all learned gears have in common is the best guess
+	float sum = 0;
+	size_t count = 0;
+
+	for (size_t i = 0; i < GEAR_RATIO_LEARN_GEAR_COUNT; i++) {
+		if (!std::isnan(m_multiplier[i])) {
+			sum += m_multiplier[i];
+			count++;
+		}
+	}
+
+	return count == 0 ? 1 : sum / count;
+}
+
+void GearRatioLearning::learn(size_t gear, float multiplier) {
+	if (gear < 1 || gear > GEAR_RATIO_LEARN_GEAR_COUNT) {
+		return;
+	}
+
+	float& learned = m_multiplier[gear - 1];
+
+	if (std::isnan(learned)) {
+		learned = getMultiplier(gear);
+	}
+
+	learned += GEAR_RATIO_LEARN_RATE * (multiplier - learned);
+	learned = clampF(1 - GEAR_RATIO_LEARN_LIMIT, learned, 1 + GEAR_RATIO_LEARN_LIMIT);
+}
+
+void GearRatioLearning::save(GearRatioLearningBackup& backup, float configFingerprint) const {
+	copyArray(backup.multiplier, m_multiplier);
+	backup.configFingerprint = configFingerprint;
+
+	backup.cookie = GEAR_RATIO_LEARN_COOKIE;
+}
+
+bool GearRatioLearning::restore(const GearRatioLearningBackup& backup, float configFingerprint) {
+	reset();
+
+	// Ratios learned with other gears or tires don't mean anything now
+	if (backup.cookie != GEAR_RATIO_LEARN_COOKIE || backup.configFingerprint != configFingerprint) {
+		return false;
+	}
+
+	for (size_t i = 0; i < GEAR_RATIO_LEARN_GEAR_COUNT; i++) {
+		float value = backup.multiplier[i];
+
+		if (std::isnan(value)) {
+			// not learned
+			continue;
+		}
+
+		if (!isValidMultiplier(value)) {
+			reset();
+			return false;
+		}
+
+		m_multiplier[i] = value;
+	}
+
+	return true;
+}
@@ -0,0 +1,62 @@
+/**
+ * @file gear_ratio_learning.h
+ *
+ * Actual overall ratio of each gear as a multiplier on the configured one, learned while driving in that gear.
+ * Tire growth and final drive error are the same for all gears, so gears which have not been learned yet
+ * use the average of those which have.
+ */
+
+#pragma once
+
+#include "rusefi_types.h"
+
+// same as TCU_GEAR_COUNT
+#define GEAR_RATIO_LEARN_GEAR_COUNT 10
+
+// Fraction of the difference to the measured ratio learned per update
+#define GEAR_RATIO_LEARN_RATE 0.01f
+// learned ratio stays within this fraction of the configured one
+#define GEAR_RATIO_LEARN_LIMIT 0.05f
+
+#define GEAR_RATIO_LEARN_COOKIE 0x6ea5a710
+
+/**
+ * Copy of the learned ratios which survives a reset in backup RAM
+ */
+struct GearRatioLearningBackup {
+	uint32_t cookie;
+	// of the gear configuration these were learned with
+	float configFingerprint;
+	float multiplier[GEAR_RATIO_LEARN_GEAR_COUNT];
+};
+
+class GearRatioLearning {
+public:
+	GearRatioLearning() {
+		reset();
+	}
+
+	void reset();
+
+	/**
+	 * @param gear 1 for 1st
+	 * @return actual ratio over configured ratio
+	 */
+	float getMultiplier(size_t gear) const;
+
+	/**
+	 * @param gear 1 for 1st
+	 * @param multiplier measured ratio over configured ratio
+	 */
+	void learn(size_t gear, float multiplier);
+
+	void save(GearRatioLearningBackup& backup, float configFingerprint) const;
+	/**
+	 * @return false if backup does not hold valid ratios for this gear configuration, nothing is learned then
+	 */
+	bool restore(const GearRatioLearningBackup& backup, float configFingerprint);
+
+private:
+	// NAN until learned
+	float m_multiplier[GEAR_RATIO_LEARN_GEAR_COUNT];
+};
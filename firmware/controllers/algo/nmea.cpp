@@ -21,291 +21,418 @@
  */
 #include "pch.h"
 #include "nmea.h"
-#include "rtc_helper.h"
-
-static long hex2int(const char * a, const int len) {
-	int i;
-	long val = 0;
-
-	for (i = 0; i < len; i++)
-		if (a[i] <= 57)
-			val += (a[i] - 48) * (1 << (4 * (len - 1 - i))); // it's decimal number
-		else
-			val += (a[i] - 87) * (1 << (4 * (len - 1 - i))); // it's a-f -> work only with low case hex
-	return val;
-}
 
-static float gps_deg_dec(float deg_point) {
-	float ddeg;
-	float sec = modff(deg_point, &ddeg) * 60;
-	int deg = (int) (ddeg / 100);
-	int min = (int) (deg_point - (deg * 100));
+#define KNOTS_TO_KPH 1.852f
+
+// digits beyond this many decimals are below the receiver's noise, they are dropped
+#define NMEA_MAX_DECIMALS 7
+#define NMEA_MAX_MANTISSA 100000000000000ULL
 
-	float absdlat = round(deg * 1000000.);
-	float absmlat = round(min * 1000000.);
-	float absslat = round(sec * 1000000.);
+static const uint32_t powersOf10[NMEA_MAX_DECIMALS + 1] = { 1, 10, 100, 1000, 10000, 100000, 1000000, 10000000 };
 
-	return round(absdlat + (absmlat / 60) + (absslat / 3600)) / 1000000;
+static int hexDigit(char c) {
+	if (c >= '0' && c <= '9') {
+		return c - '0';
+	}
+	if (c >= 'A' && c <= 'F') {
+		return c - 'A' + 10;
+	}
+	if (c >= 'a' && c <= 'f') {
+		return c - 'a' + 10;
+	}
+	return -1;
 }
 
-// Convert lat e lon to decimals (from deg)
-static void gps_convert_deg_to_dec(float *latitude, char ns, float *longitude, char we) {
-	float lat = (ns == 'N') ? *latitude : -1 * (*latitude);
-	float lon = (we == 'E') ? *longitude : -1 * (*longitude);
+/**
+ * Address field is two talker characters (GP, GN, GL...) followed by the sentence formatter
+ */
+static nmea_message_type getSentenceType(const char* address, size_t length) {
+	if (length != 5) {
+		return NMEA_UNKNOWN;
+	}
+
+	const char* formatter = address + 2;
+	if (formatter[0] == 'R' && formatter[1] == 'M' && formatter[2] == 'C') {
+		return NMEA_GPRMC;
+	}
+	if (formatter[0] == 'G' && formatter[1] == 'G' && formatter[2] == 'A') {
+		return NMEA_GPGGA;
+	}
+	if (formatter[0] == 'V' && formatter[1] == 'T' && formatter[2] == 'G') {
+		return NMEA_GPVTG;
+	}
 
-	*latitude = gps_deg_dec(lat);
-	*longitude = gps_deg_dec(lon);
+	return NMEA_UNKNOWN;
 }
 
-// in string collect all char till comma and convert to float
-static int str_till_comma(const char * const a, char * const dStr) {
+void NmeaParser::reset() {
+	m_state = State::WaitStart;
+}
 
-	int i = 0, sLen = strlen(a);
-	if (sLen > GPS_MAX_STRING)
-		sLen = GPS_MAX_STRING;
+void NmeaParser::startSentence() {
+	m_state = State::Body;
+	m_checksum = 0;
+	m_length = 0;
+	m_fieldIndex = 0;
+	m_malformed = false;
+	m_sentence = {};
+	m_sentence.type = NMEA_UNKNOWN;
 
-	while (i < sLen && a[i] != 44) {	// while not comma or end
-		dStr[i] = a[i];
-		i++;
-	}
-	dStr[i] = '\0';
-	return i;
+	startField();
+}
+
+void NmeaParser::startField() {
+	m_mantissa = 0;
+	m_decimals = 0;
+	m_fieldLength = 0;
+	m_seenDot = false;
+	m_isNegative = false;
+	m_isNumber = true;
 }
 
-/*
-GxGGA - name code
-Parameter	Value	Unit	Description
-UTC					hhmmss.sss	Universal time coordinated
-Lat					ddmm.mmmm	Latitude
-Northing Indicator			N=North, S=South
-Lon					dddmm.mmmm	Longitude
-Easting Indicator			E=East, W=West
-Status				0			0=Invalid, 1=2D/3D, 2=DGPS, 6=Dead Reckoning
-SVs Used			00			Number of SVs used for Navigation
-HDOP				99.99		Horizontal Dilution of Precision
-Alt (MSL)			m	Altitude (above means sea level)
-Unit				M=Meters
-Geoid Sep.			m			Geoid Separation = Alt(HAE) - Alt(MSL)
-Unit				M=Meters
-Age of DGPS Corr	s			Age of Differential Corrections
-DGPS Ref Station				ID of DGPS Reference Station
-*/
-static void nmea_parse_gpgga(char const * const nmea, loc_t *loc) {
-	char const * p = (char *)nmea;
-	char dStr[GPS_MAX_STRING];
-
-	p = strchr(p, ',') + 1; 				//skip time - we read date&time if Valid in GxRMC
-
-	p = strchr(p, ',') + 1;					// in p string started with searching address
-	str_till_comma(p, dStr);				// str to float till comma saved modified string
-	if (strlen(p) == 0) {
-		return;				// if no data in field - empty data - we return
+void NmeaParser::onFieldChar(char c) {
+	if (m_fieldLength < sizeof(m_fieldChars)) {
+		m_fieldChars[m_fieldLength] = c;
+	}
+	m_fieldLength++;
+
+	if (c >= '0' && c <= '9') {
+		if (m_seenDot && m_decimals == NMEA_MAX_DECIMALS) {
+			// more precision than we keep
+			return;
+		}
+
+		if (m_mantissa >= NMEA_MAX_MANTISSA) {
+			m_isNumber = false;
+			return;
+		}
+
+		m_mantissa = m_mantissa * 10 + (c - '0');
+		if (m_seenDot) {
+			m_decimals++;
+		}
+	} else if (c == '.' && !m_seenDot) {
+		m_seenDot = true;
+	} else if (c == '-' && m_fieldLength == 1) {
+		// altitude and geoid separation may be below sea level
+		m_isNegative = true;
+	} else {
+		m_isNumber = false;
 	}
-	
-	loc->latitude = atoff(dStr);				// fulfil data
+}
 
-	p = strchr(p, ',') + 1;					// see above
-	switch (p[0]) {
-	case 'N':
-		loc->lat = 'N';
-		break;
-	case 'S':
-		loc->lat = 'S';
-		break;
-	case ',':
-		loc->lat = '\0';
-		break;
+uint32_t NmeaParser::fieldAsInteger() {
+	if (!m_isNumber || m_isNegative) {
+		m_malformed = true;
+		return 0;
 	}
 
-	p = strchr(p, ',') + 1;
-	str_till_comma(p, dStr);				// str to float till comma saved modified string
-	loc->longitude = atoff(dStr);
+	return m_mantissa / powersOf10[m_decimals];
+}
 
-	p = strchr(p, ',') + 1;
-	switch (p[0]) {
-	case 'W':
-		loc->lon = 'W';
-		break;
-	case 'E':
-		loc->lon = 'E';
-		break;
-	case ',':
-		loc->lon = '\0';
-		break;
+float NmeaParser::fieldAsFloat() {
+	if (!m_isNumber) {
+		m_malformed = true;
+		return 0;
 	}
 
-	p = strchr(p, ',') + 1;
-	str_till_comma(p, dStr);				// str to float till comma saved modified string
-	loc->quality = atoi(dStr);
+	float value = (float)m_mantissa / powersOf10[m_decimals];
+	return m_isNegative ? -value : value;
+}
 
-	p = strchr(p, ',') + 1;
-	str_till_comma(p, dStr);				// str to float till comma saved modified string
-	loc->satellites = atoi(dStr);
+/**
+ * ddmm.mmmm or dddmm.mmmm to 1e-7 degrees, all in integer math so that no resolution is lost
+ */
+int32_t NmeaParser::fieldAsCoordinateE7() {
+	if (!m_isNumber || m_isNegative) {
+		m_malformed = true;
+		return 0;
+	}
 
-	p = strchr(p, ',') + 1;
+	uint64_t scale = powersOf10[m_decimals];
+	uint64_t degrees = m_mantissa / (100 * scale);
+	// minutes, still scaled by 10^decimals
+	uint64_t minutes = m_mantissa - degrees * 100 * scale;
 
-	p = strchr(p, ',') + 1;
-	str_till_comma(p, dStr);				// str to float till comma saved modified string
-	loc->altitude = atoff(dStr);
+	if (degrees > 180) {
+		m_malformed = true;
+		return 0;
+	}
+
+	return degrees * 10000000 + (minutes * 10000000 + 30 * scale) / (60 * scale);
 }
 
-/*
-GxRMC - nmea code
-Parameter	Value		Unit			Description
-UTC						hhmmss.sss		Universal time coordinated
-Status		V		A=Valid, V=Invalid
-Lat			ddmm.mmmm					Latitude
-Northing Indicator			N=North, S=South
-Lon			dddmm.mmmm					Longitude
-Easting Indicator			E=East, W=West
-SOG						nots			Speed Over Ground
-COG (true)				°				Course Over Ground (true)
-Date					ddmmyy			Universal time coordinated
-Magnetic Variation		°				Magnetic Variation
-Magnetic Variation			E=East,W=West
-Mode Indicator	N		A=Autonomous, D=Differential, E=Dead Reckoning, N=None
-Navigational Status			S=Safe C=Caution U=Unsafe V=Not valid
-*/
-
-static void nmea_parse_gprmc(char const * const nmea, loc_t *loc) {
-	char const * p = (char *)nmea;
-	char dStr[GPS_MAX_STRING];
-	efidatetime_t dt;
-
-	p = strchr(p, ',') + 1;					// read time
-	str_till_comma(p, dStr);
-	if (strlen(dStr) > 5) {
-		dt.hour = str2int(dStr, 2);
-		dt.minute = str2int(dStr + 2, 2);
-		dt.second = str2int(dStr + 4, 2);
+void NmeaParser::endField() {
+	if (m_fieldLength == 0) {
+		// empty field, value not available
+		return;
+	}
+
+	if (m_fieldIndex < 32) {
+		m_sentence.present |= 1u << m_fieldIndex;
 	}
-	
-	p = strchr(p, ',') + 1; 				// read field Valid status
-	str_till_comma(p, dStr);
 
-	if (dStr[0] == 'V') {					// if field is invalid
-		loc->quality = 0;
+	if (m_fieldIndex == 0) {
+		m_sentence.type = getSentenceType(m_fieldChars, m_fieldLength);
 		return;
 	}
-	
-	loc->quality = 4;						// this is declaration that last receive field VALID
-	
-	p = strchr(p, ',') + 1;					// latitude
-	str_till_comma(p, dStr);				// str to float till comma saved modified string
-	loc->latitude = atoff(dStr);
-
-	p = strchr(p, ',') + 1;
-	switch (p[0]) {
-	case 'N':
-		loc->lat = 'N';
+
+	auto& s = m_sentence;
+	char firstChar = m_fieldChars[0];
+
+	switch (s.type) {
+	/*
+	GxRMC - nmea code
+	Parameter	Value		Unit			Description
+	UTC						hhmmss.sss		Universal time coordinated
+	Status		V		A=Valid, V=Invalid
+	Lat			ddmm.mmmm					Latitude
+	Northing Indicator			N=North, S=South
+	Lon			dddmm.mmmm					Longitude
+	Easting Indicator			E=East, W=West
+	SOG						nots			Speed Over Ground
+	COG (true)				°				Course Over Ground (true)
+	Date					ddmmyy			Universal time coordinated
+	Magnetic Variation		°				Magnetic Variation
+	Magnetic Variation			E=East,W=West
+	Mode Indicator	N		A=Autonomous, D=Differential, E=Dead Reckoning, N=None
+	Navigational Status			S=Safe C=Caution U=Unsafe V=Not valid
+	*/
+	case NMEA_GPRMC:
+		switch (m_fieldIndex) {
+		case 1: s.time = fieldAsInteger(); break;
+		case 2: s.status = firstChar; break;
+		case 3: s.latitudeE7 = fieldAsCoordinateE7(); break;
+		case 4: s.ns = firstChar; break;
+		case 5: s.longitudeE7 = fieldAsCoordinateE7(); break;
+		case 6: s.ew = firstChar; break;
+		case 7: s.speedKnots = fieldAsFloat(); break;
+		case 8: s.course = fieldAsFloat(); break;
+		case 9: s.date = fieldAsInteger(); break;
+		}
+		break;
+	/*
+	GxGGA - name code
+	Parameter	Value	Unit	Description
+	UTC					hhmmss.sss	Universal time coordinated
+	Lat					ddmm.mmmm	Latitude
+	Northing Indicator			N=North, S=South
+	Lon					dddmm.mmmm	Longitude
+	Easting Indicator			E=East, W=West
+	Status				0			0=Invalid, 1=2D/3D, 2=DGPS, 6=Dead Reckoning
+	SVs Used			00			Number of SVs used for Navigation
+	HDOP				99.99		Horizontal Dilution of Precision
+	Alt (MSL)			m	Altitude (above means sea level)
+	Unit				M=Meters
+	Geoid Sep.			m			Geoid Separation = Alt(HAE) - Alt(MSL)
+	Unit				M=Meters
+	Age of DGPS Corr	s			Age of Differential Corrections
+	DGPS Ref Station				ID of DGPS Reference Station
+	*/
+	case NMEA_GPGGA:
+		switch (m_fieldIndex) {
+		case 1: s.time = fieldAsInteger(); break;
+		case 2: s.latitudeE7 = fieldAsCoordinateE7(); break;
+		case 3: s.ns = firstChar; break;
+		case 4: s.longitudeE7 = fieldAsCoordinateE7(); break;
+		case 5: s.ew = firstChar; break;
+		case 6: s.quality = fieldAsInteger(); break;
+		case 7: s.satellites = fieldAsInteger(); break;
+		case 9: s.altitude = fieldAsFloat(); break;
+		}
 		break;
-	case 'S':
-		loc->lat = 'S';
+	/*
+	GxVTG - course over ground and ground speed
+	Parameter	Value	Unit	Description
+	COG (true)			°			Course Over Ground (true)
+	Fixed field			T
+	COG (magnetic)		°			Course Over Ground (magnetic)
+	Fixed field			M
+	SOG					knots		Speed Over Ground
+	Fixed field			N
+	SOG					km/h		Speed Over Ground
+	Fixed field			K
+	Mode Indicator		N			A=Autonomous, D=Differential, E=Dead Reckoning, N=None
+	*/
+	case NMEA_GPVTG:
+		switch (m_fieldIndex) {
+		case 1: s.course = fieldAsFloat(); break;
+		case 5: s.speedKnots = fieldAsFloat(); break;
+		case 7: s.speedKph = fieldAsFloat(); break;
+		}
 		break;
-	case ',':
-		loc->lat = '\0';
+	default:
 		break;
 	}
+}
 
-	p = strchr(p, ',') + 1;					// longitude
-	str_till_comma(p, dStr);				// str to float till comma saved modified string
-	loc->longitude = atoff(dStr);
+static void setPosition(loc_t& location, int32_t latitudeE7, char ns, int32_t longitudeE7, char ew) {
+	location.lat = ns;
+	location.lon = ew;
+	location.latitudeE7 = ns == 'S' ? -latitudeE7 : latitudeE7;
+	location.longitudeE7 = ew == 'W' ? -longitudeE7 : longitudeE7;
+	location.latitude = location.latitudeE7 * 1e-7f;
+	location.longitude = location.longitudeE7 * 1e-7f;
+}
 
-	p = strchr(p, ',') + 1;
-	switch (p[0]) {
-	case 'W':
-		loc->lon = 'W';
-		break;
-	case 'E':
-		loc->lon = 'E';
-		break;
-	case ',':
-		loc->lon = '\0';
-		break;
+nmea_message_type NmeaParser::endSentence(loc_t& location) {
+	if (m_receivedChecksum != m_checksum) {
+		m_checksumErrorCount++;
+		return NMEA_CHECKSUM_ERR;
 	}
 
-	p = strchr(p, ',') + 1;
-	str_till_comma(p, dStr);				// str to float till comma saved modified string
-	loc->speed = atoff(dStr);
-	
-	p = strchr(p, ',') + 1;
-	str_till_comma(p, dStr);				// str to float till comma saved modified string
-	loc->course = atoff(dStr);
-
-	p = strchr(p, ',') + 1;					// read date
-	str_till_comma(p, dStr);
-	if (strlen(dStr) > 5) {
-		dt.day = str2int(dStr, 2);
-		dt.month = str2int(dStr + 2, 2);
-		dt.year = 100 +						// we receive -200, but standard wait -1900 = add correction
-			str2int(dStr + 4, 2);
+	if (m_malformed) {
+		m_messageErrorCount++;
+		return NMEA_MESSAGE_ERR;
 	}
 
-	if (dt.year > 0 ) {						// check if date field is valid
-		memcpy(&loc->time, &dt, sizeof(dt));
+	const auto& s = m_sentence;
+
+	switch (s.type) {
+	case NMEA_GPRMC:
+		if (s.status != 'A') {
+			// receiver says this fix is not valid
+			location.quality = 0;
+			break;
+		}
+
+		// this is declaration that last receive field VALID
+		location.quality = 4;
+
+		if (hasField(3) && hasField(5)) {
+			setPosition(location, s.latitudeE7, s.ns, s.longitudeE7, s.ew);
+		}
+		if (hasField(7)) {
+			location.speed = s.speedKnots;
+			location.speedKph = s.speedKnots * KNOTS_TO_KPH;
+		}
+		if (hasField(8)) {
+			location.course = s.course;
+		}
+		if (hasField(1) && hasField(9)) {
+			location.time.hour = s.time / 10000;
+			location.time.minute = s.time / 100 % 100;
+			location.time.second = s.time % 100;
+			location.time.day = s.date / 10000;
+			location.time.month = s.date / 100 % 100;
+			// we receive -200, but standard wait -1900 = add correction
+			location.time.year = 100 + s.date % 100;
+		}
+		break;
+	case NMEA_GPGGA:
+		location.quality = s.quality;
+		location.satellites = s.satellites;
+
+		if (hasField(2) && hasField(4)) {
+			setPosition(location, s.latitudeE7, s.ns, s.longitudeE7, s.ew);
+		}
+		if (hasField(9)) {
+			location.altitude = s.altitude;
+		}
+		break;
+	case NMEA_GPVTG:
+		if (hasField(1)) {
+			location.course = s.course;
+		}
+		if (hasField(5)) {
+			location.speed = s.speedKnots;
+		}
+		if (hasField(7)) {
+			location.speedKph = s.speedKph;
+		} else if (hasField(5)) {
+			location.speedKph = s.speedKnots * KNOTS_TO_KPH;
+		}
+		break;
+	default:
+		// valid, but nothing we are interested in
+		return NMEA_UNKNOWN;
 	}
+
+	location.type = s.type;
+	m_sentenceCount++;
+	return s.type;
 }
 
-/**
- * Get the message type (GPGGA, GPRMC, etc..)
- *
- * This function filters out also wrong packages (invalid checksum)
- *
- * @param message The NMEA message
- * @return The type of message if it is valid
- */
-nmea_message_type nmea_get_message_type(const char *message) {
-	int checksum = nmea_valid_checksum(message);
-	if (checksum != _EMPTY) {
-		return static_cast<nmea_message_type>(checksum);
+nmea_message_type NmeaParser::feed(char c, loc_t& location) {
+	if (c == '$') {
+		// start of a sentence, this also recovers from a sentence cut short
+		startSentence();
+		return NMEA_UNKNOWN;
 	}
 
-	if (strstr(message, NMEA_GPGGA_STR) != NULL) {
-		return NMEA_GPGGA;
+	switch (m_state) {
+	case State::WaitStart:
+		return NMEA_UNKNOWN;
+	case State::Body:
+		if (c == '*') {
+			endField();
+			m_state = State::Checksum;
+			m_receivedChecksum = 0;
+			m_checksumDigits = 0;
+			return NMEA_UNKNOWN;
+		}
+
+		if (c == '\r' || c == '\n' || ++m_length > GPS_MAX_STRING) {
+			// sentence without checksum, or runaway garbage
+			m_state = State::WaitStart;
+			m_messageErrorCount++;
+			return NMEA_MESSAGE_ERR;
+		}
+
+		m_checksum ^= c;
+
+		if (c == ',') {
+			endField();
+			m_fieldIndex++;
+			startField();
+		} else {
+			onFieldChar(c);
+		}
+		return NMEA_UNKNOWN;
+	case State::Checksum: {
+		int digit = hexDigit(c);
+		if (digit < 0) {
+			m_state = State::WaitStart;
+			m_messageErrorCount++;
+			return NMEA_MESSAGE_ERR;
+		}
+
+		m_receivedChecksum = (m_receivedChecksum << 4) | digit;
+		if (++m_checksumDigits < 2) {
+			return NMEA_UNKNOWN;
+		}
+
+		m_state = State::WaitStart;
+		return endSentence(location);
 	}
-
-	if (strstr(message, NMEA_GPRMC_STR) != NULL) {
-		return NMEA_GPRMC;
 	}
 
 	return NMEA_UNKNOWN;
 }
 
-int nmea_valid_checksum(char const * message) {
-	char p;
-	int sum = 0;
-	const char* starPtr = strrchr(message, '*');
-	if (!starPtr) {
-		return NMEA_CHECKSUM_ERR;
-	}
-	const char* int_message = starPtr + 1;
-	long checksum = hex2int(int_message, 2);
+size_t NmeaParser::feed(const char* data, size_t size, loc_t& location) {
+	size_t sentences = 0;
 
-	++message;
-	while ((p = *message++) != '*') {
-		sum ^= p;
+	for (size_t i = 0; i < size; i++) {
+		nmea_message_type result = feed(data[i], location);
+		if (result != NMEA_UNKNOWN && result != NMEA_CHECKSUM_ERR && result != NMEA_MESSAGE_ERR) {
+			sentences++;
+		}
 	}
 
-	if (sum != checksum) {
-		return NMEA_CHECKSUM_ERR;
-	}
-	return _EMPTY;
+	return sentences;
 }
 
-// Compute the GPS location using decimal scale
 void gps_location(loc_t *coord, char const * const buffer) {
-	coord->type = nmea_get_message_type(buffer);
-
-	switch (coord->type) {
-	case NMEA_GPGGA:
-		nmea_parse_gpgga(buffer, coord);
-		gps_convert_deg_to_dec(&(coord->latitude), coord->lat, &(coord->longitude), coord->lon);
-		break;
-	case NMEA_GPRMC:
-		nmea_parse_gprmc(buffer, coord);
-		break;
-	case NMEA_UNKNOWN:
-		// unknown message type
-		break;
+	NmeaParser parser;
+	nmea_message_type result = NMEA_UNKNOWN;
+
+	for (const char* p = buffer; *p; p++) {
+		nmea_message_type type = parser.feed(*p, *coord);
+		if (type != NMEA_UNKNOWN) {
+			result = type;
+		}
 	}
+
+	coord->type = result;
 }
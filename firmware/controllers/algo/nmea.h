@@ -1,33 +1,45 @@
 /**
+ * @file nmea.h
  *
- * https://github.com/wdalmut/libgps/tree/develop/src
+ * Single pass NMEA 0183 parser: bytes are fed one at a time (or as a DMA chunk) and every
+ * field is decoded as it goes by, nothing is buffered or re-scanned. A sentence only updates
+ * the location once its checksum has been verified.
  *
+ * Supported sentences are RMC, GGA and VTG from any talker (GP, GN, GL...)
+ *
+ * see #testGpsParser
  */
 
 #pragma once
 
 #include "rusefi_types.h"
 
+// NMEA 0183 limits a sentence to 82 characters, allow some slack for chatty receivers
 #define GPS_MAX_STRING 256
 
 typedef enum {
 	NMEA_UNKNOWN = 0x00,
 	NMEA_GPRMC = 0x01,
-	NMEA_GPGGA = 0x02
-} nmea_message_type;
-
-#define _EMPTY 0x00
-#define NMEA_GPRMC_STR "$GPRMC"
-#define NMEA_GPGGA_STR "$GPGGA"
-#define _COMPLETED 0x03
+	NMEA_GPGGA = 0x02,
+	NMEA_GPVTG = 0x03,
 
-#define NMEA_CHECKSUM_ERR 0x80
-#define NMEA_MESSAGE_ERR 0xC0
+	// sentence did not match its checksum
+	NMEA_CHECKSUM_ERR = 0x80,
+	// checksum was fine but a field could not be decoded, or the sentence was too long
+	NMEA_MESSAGE_ERR = 0xC0,
+} nmea_message_type;
 
 struct GPSlocation {
+	// signed decimal degrees, north and east are positive
 	float latitude;
 	float longitude;
+	// same in 1e-7 degree units (about 1cm), without float rounding
+	int32_t latitudeE7;
+	int32_t longitudeE7;
+	// speed over ground, knots
 	float speed;
+	// speed over ground, km/h
+	float speedKph;
 	float altitude;
 	float course;
 	efidatetime_t time;
@@ -39,18 +51,99 @@ struct GPSlocation {
 };
 typedef struct GPSlocation loc_t;
 
-nmea_message_type nmea_get_message_type(const char *);
-int nmea_valid_checksum(const char *);
+class NmeaParser {
+public:
+	/**
+	 * @return type of the sentence completed by this byte, NMEA_UNKNOWN in the middle of a sentence
+	 */
+	nmea_message_type feed(char c, loc_t& location);
+	/**
+	 * @return number of valid sentences applied to the location
+	 */
+	size_t feed(const char* data, size_t size, loc_t& location);
 
+	void reset();
 
-void gps_location(loc_t *, char const * const);
+	uint32_t getSentenceCount() const {
+		return m_sentenceCount;
+	}
+
+	uint32_t getChecksumErrorCount() const {
+		return m_checksumErrorCount;
+	}
+
+	uint32_t getMessageErrorCount() const {
+		return m_messageErrorCount;
+	}
+
+private:
+	enum class State : uint8_t {
+		WaitStart,
+		Body,
+		Checksum,
+	};
+
+	// Everything decoded from the sentence in flight, applied once the checksum matches
+	struct Sentence {
+		nmea_message_type type;
+		// bit per field index which was not empty
+		uint32_t present;
 
-static int str2int(const char * a, const int len) {
-	int i = 0,  k = 0;
-	while (i < len) {
-		k = (k << 3) + (k << 1) + (*a) - '0';
-		a++;
-		i++;
+		uint32_t time;
+		uint32_t date;
+		char status;
+		int32_t latitudeE7;
+		char ns;
+		int32_t longitudeE7;
+		char ew;
+		float speedKnots;
+		float speedKph;
+		float course;
+		float altitude;
+		int quality;
+		int satellites;
+	};
+
+	void startSentence();
+	void startField();
+	void onFieldChar(char c);
+	void endField();
+	nmea_message_type endSentence(loc_t& location);
+
+	// Decoders for the field just completed, these flag the sentence as malformed if it is not a number
+	uint32_t fieldAsInteger();
+	float fieldAsFloat();
+	int32_t fieldAsCoordinateE7();
+
+	bool hasField(int index) const {
+		return m_sentence.present & (1u << index);
 	}
-	return k;
-}
+
+	State m_state = State::WaitStart;
+	uint8_t m_checksum = 0;
+	uint8_t m_receivedChecksum = 0;
+	uint8_t m_checksumDigits = 0;
+	uint16_t m_length = 0;
+	uint16_t m_fieldIndex = 0;
+	bool m_malformed = false;
+
+	// current field
+	uint64_t m_mantissa = 0;
+	uint8_t m_decimals = 0;
+	uint16_t m_fieldLength = 0;
+	bool m_seenDot = false;
+	bool m_isNegative = false;
+	bool m_isNumber = true;
+	char m_fieldChars[5] = {};
+
+	Sentence m_sentence = {};
+
+	uint32_t m_sentenceCount = 0;
+	uint32_t m_checksumErrorCount = 0;
+	uint32_t m_messageErrorCount = 0;
+};
+
+/**
+ * Parses one complete sentence, '$' through checksum
+ */
+void gps_location(loc_t *, char const * const);
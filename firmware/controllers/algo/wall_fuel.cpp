@@ -11,7 +11,7 @@ void WallFuel::resetWF() {
 	wallFuel = 0;
 }
 
-float WallFuel::adjust(float desiredMassGrams) {
+float WallFuel::adjust(float desiredMassGrams, const WallFuelCoefs& coefs) {
 	invocationCounter++;
 	if (std::isnan(desiredMassGrams)) {
 		return desiredMassGrams;
@@ -41,28 +41,21 @@ float WallFuel::adjust(float desiredMassGrams) {
 		the time the fuel spent on the wall this cycle, (recriprocal RPM).
 
 		beta describes the amount of fuel that hits the wall.
-	*/
 
-	// If disabled, pass value through
-	if (!engine->module<WallFuelController>()->getEnable()) {
-		return desiredMassGrams;
-	}
-
-	float alpha = engine->module<WallFuelController>()->getAlpha();
-	float beta = engine->module<WallFuelController>()->getBeta();
+		When the model is disabled the coefficients are alpha = 1, beta = 0
+		which passes fuel through and keeps the film as is, so there is no branch here.
+	*/
 
 	float fuelFilmMass = wallFuel;
-	float M_cmd = (desiredMassGrams - (1 - alpha) * fuelFilmMass) / (1 - beta);
+	float M_cmd = (desiredMassGrams - coefs.oneMinusAlpha * fuelFilmMass) / coefs.oneMinusBeta;
 
 	// We can't inject a negative amount of fuel
 	// If this goes below zero we will be over-fueling slightly,
 	// but that's ok.
-	if (M_cmd <= 0) {
-		M_cmd = 0;
-	}
+	M_cmd = std::max(0.0f, M_cmd);
 
 	// remainder on walls from last time + new from this time
-	float fuelFilmMassNext = alpha * fuelFilmMass + beta * M_cmd;
+	float fuelFilmMassNext = coefs.alpha * fuelFilmMass + coefs.beta * M_cmd;
 
 	wallFuel = fuelFilmMassNext;
 	wallFuelCorrection = M_cmd - desiredMassGrams;
@@ -132,11 +125,41 @@ float WallFuelController::computeBeta() const {
 	return clampF(0, beta, 1);
 }
 
+void WallFuelController::setCylinderTrim(size_t cylinderIndex, float alphaTrim, float betaTrim) {
+	if (cylinderIndex >= efi::size(m_trims)) {
+		return;
+	}
+
+	m_trims[cylinderIndex].alpha = alphaTrim;
+	m_trims[cylinderIndex].beta = betaTrim;
+}
+
+void WallFuelController::updateCoefs() {
+	if (!m_enable) {
+		for (auto& coefs : m_coefs) {
+			coefs = WallFuelCoefs();
+		}
+		return;
+	}
+
+	// Trims may not push a cylinder to alpha = beta = 1 where the model divides by zero,
+	// but must not touch untrimmed values
+	float maxAlpha = std::max(m_alpha, 0.99f);
+
+	for (size_t i = 0; i < efi::size(m_coefs); i++) {
+		float alpha = clampF(0, m_alpha * m_trims[i].alpha, maxAlpha);
+		float beta = clampF(0, m_beta * m_trims[i].beta, alpha);
+
+		m_coefs[i] = WallFuelCoefs(alpha, beta);
+	}
+}
+
 void WallFuelController::onFastCallback() {
 	// disable wall wetting cranking
 	// TODO: is this correct? Why not correct for cranking?
 	if (engine->rpmCalculator.isCranking()) {
 		m_enable = false;
+		updateCoefs();
 		return;
 	}
 
@@ -147,6 +170,7 @@ void WallFuelController::onFastCallback() {
 	// you probably meant to disable wwae.
 	if (tau < 0.01f || beta < 0.01f) {
 		m_enable = false;
+		updateCoefs();
 		return;
 	}
 
@@ -155,6 +179,7 @@ void WallFuelController::onFastCallback() {
 	// Ignore low RPM
 	if (rpm < 100) {
 		m_enable = false;
+		updateCoefs();
 		return;
 	}
 
@@ -172,4 +197,5 @@ void WallFuelController::onFastCallback() {
 	m_alpha = alpha;
 	m_beta = beta;
 	m_enable = true;
+	updateCoefs();
 }
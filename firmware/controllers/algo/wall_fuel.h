@@ -8,17 +8,45 @@
 #include "wall_fuel_state_generated.h"
 #include "engine_module.h"
 
+/**
+ * Film model coefficients of one cylinder, latched by WallFuelController once per fast callback
+ * so that the per injection update is plain arithmetic.
+ * Default coefficients pass fuel through and leave the film untouched.
+ */
+struct WallFuelCoefs {
+	WallFuelCoefs() : WallFuelCoefs(1, 0) { }
+
+	WallFuelCoefs(float p_alpha, float p_beta)
+		: alpha(p_alpha)
+		, beta(p_beta)
+		, oneMinusAlpha(1 - p_alpha)
+		, oneMinusBeta(1 - p_beta)
+	{
+	}
+
+	// fraction of the film which remains on the wall per cycle
+	float alpha;
+	// fraction of the injected fuel which hits the wall
+	float beta;
+
+	float oneMinusAlpha;
+	float oneMinusBeta;
+};
+
 /**
  * Wall wetting, also known as fuel film
  * See https://github.com/rusefi/rusefi/issues/151 for the theory
+ *
+ * Each InjectionEvent owns one, so every cylinder keeps its own film mass.
  */
 class WallFuel : public wall_fuel_state_s {
 public:
 	/**
 	 * @param desiredMassGrams desired fuel quantity, in grams
+	 * @param coefs film coefficients of the cylinder this film belongs to
 	 * @return total adjusted fuel squirt mass in grams once wall wetting is taken into effect
 	 */
-	float adjust(float desiredMassGrams);
+	float adjust(float desiredMassGrams, const WallFuelCoefs& coefs);
 	float getWallFuel() const;
 	void resetWF();
 	int invocationCounter = 0;
@@ -28,6 +56,8 @@ struct IWallFuelController {
 	virtual bool getEnable() const = 0;
 	virtual float getAlpha() const = 0;
 	virtual float getBeta() const = 0;
+	// Coefficients with the per cylinder trims applied
+	virtual const WallFuelCoefs& getCoefs(size_t cylinderIndex) const = 0;
 };
 
 class WallFuelController : public IWallFuelController, public EngineModule {
@@ -48,12 +78,32 @@ public:
 		return m_beta;
 	}
 
+	const WallFuelCoefs& getCoefs(size_t cylinderIndex) const override {
+		return m_coefs[cylinderIndex];
+	}
+
+	/**
+	 * Scale alpha and beta of one cylinder, for example for ports with different runner lengths.
+	 * Takes effect on the next fast callback.
+	 */
+	void setCylinderTrim(size_t cylinderIndex, float alphaTrim, float betaTrim);
+
 protected:
 	float computeTau() const;
 	float computeBeta() const;
 
 private:
+	void updateCoefs();
+
 	bool m_enable = false;
 	float m_alpha = 0;
 	float m_beta = 0;
+
+	struct Trim {
+		float alpha = 1;
+		float beta = 1;
+	};
+
+	Trim m_trims[MAX_CYLINDER_COUNT];
+	WallFuelCoefs m_coefs[MAX_CYLINDER_COUNT];
 };
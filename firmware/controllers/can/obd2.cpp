@@ -29,6 +29,7 @@
 #include "can.h"
 #include "can_msg_tx.h"
 #include "fuel_math.h"
+#include "malfunction_central.h"
 
 static const int16_t supportedPids0120[] = { 
 	PID_MONITOR_STATUS,
@@ -56,37 +57,57 @@ static const int16_t supportedPids4160[] = {
 	-1
 };
 
-static void obdSendPacket(int mode, int PID, int numBytes, uint32_t iValue, size_t busIndex) {
+static const int16_t supportedFreezeFramePids0120[] = {
+	PID_FREEZE_DTC,
+	PID_ENGINE_LOAD,
+	PID_COOLANT_TEMP,
+	PID_RPM,
+	-1
+};
+
+static const int16_t supportedFreezeFramePids2140[] = {
+	PID_FUEL_AIR_RATIO_1,
+	-1
+};
+
+/**
+ * @param frameIndex only for mode 02 responses which echo the freeze frame number after the PID
+ */
+static void obdSendPacket(int mode, int PID, int numBytes, uint32_t iValue, size_t busIndex, int frameIndex = -1) {
 	CanTxMessage resp(CanCategory::OBD, OBD_TEST_RESPONSE);
 
 	// Respond on the same bus we got the request from
 	resp.busIndex = busIndex;
 
-	// write number of bytes
-	resp[0] = (uint8_t)(2 + numBytes);
 	// write 2 bytes of header
 	resp[1] = (uint8_t)(0x40 + mode);
 	resp[2] = (uint8_t)PID;
+	int j = 3;
+	if (frameIndex >= 0) {
+		resp[j++] = (uint8_t)frameIndex;
+	}
+	// write number of bytes
+	resp[0] = (uint8_t)(j - 1 + numBytes);
 	// write N data bytes
-	for (int i = 8 * (numBytes - 1), j = 3; i >= 0; i -= 8, j++) {
+	for (int i = 8 * (numBytes - 1); i >= 0; i -= 8, j++) {
 		resp[j] = (uint8_t)((iValue >> i) & 0xff);
 	}
 }
 
 #define _1_MODE 1
 
-static void obdSendValue(int mode, int PID, int numBytes, float value, size_t busIndex) {
+static void obdSendValue(int mode, int PID, int numBytes, float value, size_t busIndex, int frameIndex = -1) {
 	efiAssertVoid(ObdCode::CUSTOM_ERR_6662, numBytes <= 2, "invalid numBytes");
 	int iValue = (int)efiRound(value, 1.0f);
 	// clamp to uint8_t (0..255) or uint16_t (0..65535)
 	iValue = maxI(minI(iValue, (numBytes == 1) ? 255 : 65535), 0);
-	obdSendPacket(mode, PID, numBytes, iValue, busIndex);
+	obdSendPacket(mode, PID, numBytes, iValue, busIndex, frameIndex);
 }
 
 
 //#define MOCK_SUPPORTED_PIDS 0xffffffff
 
-static void obdWriteSupportedPids(int PID, int bitOffset, const int16_t *supportedPids, size_t busIndex) {
+static uint32_t getSupportedPidsMask(int bitOffset, const int16_t *supportedPids) {
 	uint32_t value = 0;
 	// gather all 32 bit fields
 	for (int i = 0; i < 32 && supportedPids[i] > 0; i++)
@@ -97,7 +118,11 @@ static void obdWriteSupportedPids(int PID, int bitOffset, const int16_t *support
 	value = MOCK_SUPPORTED_PIDS;
 #endif
 
-	obdSendPacket(1, PID, 4, value, busIndex);
+	return value;
+}
+
+static void obdWriteSupportedPids(int PID, int bitOffset, const int16_t *supportedPids, size_t busIndex) {
+	obdSendPacket(1, PID, 4, getSupportedPidsMask(bitOffset, supportedPids), busIndex);
 }
 
 static void handleGetDataRequest(const CANRxFrame& rx, size_t busIndex) {
@@ -107,10 +132,10 @@ static void handleGetDataRequest(const CANRxFrame& rx, size_t busIndex) {
 		obdWriteSupportedPids(pid, 1, supportedPids0120, busIndex);
 		break;
 	case PID_SUPPORTED_PIDS_REQUEST_21_40:
-		obdWriteSupportedPids(pid, 21, supportedPids2140, busIndex);
+		obdWriteSupportedPids(pid, 0x21, supportedPids2140, busIndex);
 		break;
 	case PID_SUPPORTED_PIDS_REQUEST_41_60:
-		obdWriteSupportedPids(pid, 41, supportedPids4160, busIndex);
+		obdWriteSupportedPids(pid, 0x41, supportedPids4160, busIndex);
 		break;
 	case PID_MONITOR_STATUS:
 		obdSendPacket(1, pid, 4, 0, busIndex);	// todo: add statuses
@@ -174,18 +199,85 @@ static void handleGetDataRequest(const CANRxFrame& rx, size_t busIndex) {
 	}
 }
 
-static void handleDtcRequest(int numCodes, ObdCode* dtcCode) {
-	// TODO: this appears to be unfinished?
-	UNUSED(numCodes);
-	UNUSED(dtcCode);
-
-	// int numBytes = numCodes * 2;
-	// // write CAN-TP Single Frame header?
-	// txmsg.data8[0] = (uint8_t)((0 << 4) | numBytes);
-	// for (int i = 0, j = 1; i < numCodes; i++) {
-	// 	txmsg.data8[j++] = (uint8_t)((dtcCode[i] >> 8) & 0xff);
-	// 	txmsg.data8[j++] = (uint8_t)(dtcCode[i] & 0xff);
-	// }
+static void handleFreezeFrameRequest(const CANRxFrame& rx, size_t busIndex) {
+	int pid = rx.data8[2];
+	int frameIndex = rx.data8[3];
+
+	switch (pid) {
+	case PID_SUPPORTED_PIDS_REQUEST_01_20:
+		obdSendPacket(OBD_FREEZE_FRAME_DATA, pid, 4, getSupportedPidsMask(0x01, supportedFreezeFramePids0120), busIndex, frameIndex);
+		return;
+	case PID_SUPPORTED_PIDS_REQUEST_21_40:
+		obdSendPacket(OBD_FREEZE_FRAME_DATA, pid, 4, getSupportedPidsMask(0x21, supportedFreezeFramePids2140), busIndex, frameIndex);
+		return;
+	}
+
+	const DtcFreezeFrame* frame = getFreezeFrameByIndex(frameIndex);
+	if (!frame) {
+		if (pid == PID_FREEZE_DTC) {
+			// P0000 means there is no such frame
+			obdSendPacket(OBD_FREEZE_FRAME_DATA, pid, 2, 0, busIndex, frameIndex);
+		}
+		return;
+	}
+
+	switch (pid) {
+	case PID_FREEZE_DTC:
+		obdSendPacket(OBD_FREEZE_FRAME_DATA, pid, 2, getObdDtcValue(frame->code), busIndex, frameIndex);
+		break;
+	case PID_ENGINE_LOAD:
+		obdSendValue(OBD_FREEZE_FRAME_DATA, pid, 1, frame->load * ODB_TPS_BYTE_PERCENT, busIndex, frameIndex);
+		break;
+	case PID_COOLANT_TEMP:
+		obdSendValue(OBD_FREEZE_FRAME_DATA, pid, 1, frame->clt + ODB_TEMP_EXTRA, busIndex, frameIndex);
+		break;
+	case PID_RPM:
+		obdSendValue(OBD_FREEZE_FRAME_DATA, pid, 2, frame->rpm * ODB_RPM_MULT, busIndex, frameIndex);
+		break;
+	case PID_FUEL_AIR_RATIO_1: {
+		float lambda = clampF(0, frame->lambda, 1.99f);
+		uint16_t scaled = lambda * 32768;
+		obdSendPacket(OBD_FREEZE_FRAME_DATA, pid, 4, scaled << 16, busIndex, frameIndex);
+		break;
+	} default:
+		// ignore unhandled PIDs
+		break;
+	}
+}
+
+static void handleDtcRequest(int mode, size_t busIndex) {
+	error_codes_set_s codes;
+	getErrorCodes(&codes);
+
+	CanTxMessage resp(CanCategory::OBD, OBD_TEST_RESPONSE);
+	resp.busIndex = busIndex;
+	resp[1] = (uint8_t)(0x40 + mode);
+
+	int numCodes = 0;
+	int j = 3;
+	// todo: ISO-TP multi-frame response for the rest of the codes
+	for (int i = 0; i < codes.count && numCodes < OBD_MAX_DTC_PER_FRAME; i++) {
+		uint16_t value = getObdDtcValue(codes.error_codes[i]);
+		if (value == 0) {
+			// custom code, no way to report it over OBD
+			continue;
+		}
+		resp[j++] = (uint8_t)(value >> 8);
+		resp[j++] = (uint8_t)(value & 0xff);
+		numCodes++;
+	}
+
+	resp[2] = (uint8_t)numCodes;
+	resp[0] = (uint8_t)(j - 1);
+}
+
+static void handleClearDtcRequest(size_t busIndex) {
+	clearWarnings();
+
+	CanTxMessage resp(CanCategory::OBD, OBD_TEST_RESPONSE);
+	resp.busIndex = busIndex;
+	resp[0] = 1;
+	resp[1] = (uint8_t)(0x40 + OBD_CLEAR_DIAGNOSTIC_TROUBLE_CODES);
 }
 
 #if HAL_USE_CAN
@@ -196,12 +288,16 @@ void obdOnCanPacketRx(const CANRxFrame& rx, size_t busIndex) {
 
 	if (rx.data8[0] == _OBD_2 && rx.data8[1] == OBD_CURRENT_DATA) {
 		handleGetDataRequest(rx, busIndex);
+	} else if (rx.data8[0] == 3 && rx.data8[1] == OBD_FREEZE_FRAME_DATA) {
+		handleFreezeFrameRequest(rx, busIndex);
 	} else if (rx.data8[0] == 1 && rx.data8[1] == OBD_STORED_DIAGNOSTIC_TROUBLE_CODES) {
 		// todo: implement stored/pending difference?
-		handleDtcRequest(1, &engine->engineState.warnings.lastErrorCode);
+		handleDtcRequest(OBD_STORED_DIAGNOSTIC_TROUBLE_CODES, busIndex);
 	} else if (rx.data8[0] == 1 && rx.data8[1] == OBD_PENDING_DIAGNOSTIC_TROUBLE_CODES) {
 		// todo: implement stored/pending difference?
-		handleDtcRequest(1, &engine->engineState.warnings.lastErrorCode);
+		handleDtcRequest(OBD_PENDING_DIAGNOSTIC_TROUBLE_CODES, busIndex);
+	} else if (rx.data8[0] == 1 && rx.data8[1] == OBD_CLEAR_DIAGNOSTIC_TROUBLE_CODES) {
+		handleClearDtcRequest(busIndex);
 	}
 }
 #endif /* HAL_USE_CAN */
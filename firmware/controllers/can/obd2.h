@@ -12,14 +12,21 @@
 #define OBD_TEST_RESPONSE 0x7E8
 
 #define OBD_CURRENT_DATA 1
+#define OBD_FREEZE_FRAME_DATA 2
 #define _OBD_2 2
 #define OBD_STORED_DIAGNOSTIC_TROUBLE_CODES 3
+#define OBD_CLEAR_DIAGNOSTIC_TROUBLE_CODES 4
 #define OBD_PENDING_DIAGNOSTIC_TROUBLE_CODES 7
 
+// single frame response: mode, count and two bytes per code
+#define OBD_MAX_DTC_PER_FRAME 2
+
 // https://en.wikipedia.org/wiki/OBD-II_PIDs
 
 #define PID_SUPPORTED_PIDS_REQUEST_01_20 0x00
 #define PID_MONITOR_STATUS 0x01
+// mode 02 only: the code which caused the freeze frame
+#define PID_FREEZE_DTC 0x02
 #define PID_FUEL_SYSTEM_STATUS 0x03
 #define PID_ENGINE_LOAD 0x04
 #define PID_COOLANT_TEMP 0x05
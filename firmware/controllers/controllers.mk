@@ -9,9 +9,11 @@ CONTROLLERS_DIR=$(PROJECT_DIR)/controllers
 
 CONTROLLERS_SRC_CPP = \
 	$(CONTROLLERS_DIR)/actuators/electronic_throttle.cpp \
+	$(CONTROLLERS_DIR)/actuators/etb_plant_estimator.cpp \
 	$(CONTROLLERS_DIR)/actuators/ac_control.cpp \
 	$(CONTROLLERS_DIR)/actuators/alternator_controller.cpp \
 	$(CONTROLLERS_DIR)/actuators/boost_control.cpp \
+	$(CONTROLLERS_DIR)/actuators/boost_spool_model.cpp \
 	$(CONTROLLERS_DIR)/actuators/dc_motors.cpp \
 	$(CONTROLLERS_DIR)/actuators/fan_control.cpp \
 	$(CONTROLLERS_DIR)/actuators/fuel_pump.cpp \
@@ -19,6 +21,7 @@ CONTROLLERS_SRC_CPP = \
 	$(CONTROLLERS_DIR)/actuators/idle_thread_io.cpp \
 	$(CONTROLLERS_DIR)/actuators/idle_hardware.cpp \
 	$(CONTROLLERS_DIR)/actuators/idle_thread.cpp \
+	$(CONTROLLERS_DIR)/actuators/idle_air_learning.cpp \
 	$(CONTROLLERS_DIR)/actuators/ignition_controller.cpp \
 	$(CONTROLLERS_DIR)/actuators/main_relay.cpp \
 	$(CONTROLLERS_DIR)/actuators/vvt.cpp \
@@ -2,29 +2,150 @@
 
 #include "big_buffer.h"
 
-static BigBufferUser s_currentUser;
+#define BIG_BUFFER_BLOCK_COUNT (BIG_BUFFER_SIZE / BIG_BUFFER_BLOCK_SIZE)
+static_assert(BIG_BUFFER_SIZE % BIG_BUFFER_BLOCK_SIZE == 0);
+static_assert(BIG_BUFFER_BLOCK_SIZE % sizeof(uint32_t) == 0);
+
+#define BIG_BUFFER_USER_COUNT ((size_t)BigBufferUser::KnockSpectrogram + 1)
+
 // uint32_t type to get 4-byte alignment
 // alignment is required since we sometimes allocate objects in the buffer (like Timer of CompositeBuffer)
 // we've only observed issue on F7 in -Os compiler configuration but technically all processors care
 static uint32_t s_bigBuffer[BIG_BUFFER_SIZE / sizeof(uint32_t)];
 
+struct BigBufferLease {
+	uint16_t firstBlock;
+	// zero if the user has no lease
+	uint16_t blockCount;
+	BigBufferEvictCallback onEvict;
+};
+
+// at most one lease per user
+static BigBufferLease s_leases[BIG_BUFFER_USER_COUNT];
+static BigBufferUser s_blockOwners[BIG_BUFFER_BLOCK_COUNT];
+
+/**
+ * Handles are released both from threads and from within critical sections, so this lock nests
+ */
+class BigBufferLock {
+#if EFI_PROD_CODE || EFI_SIMULATOR
+public:
+	BigBufferLock() : m_status(chSysGetStatusAndLockX()) { }
+	~BigBufferLock() {
+		chSysRestoreStatusX(m_status);
+	}
+
+private:
+	const syssts_t m_status;
+#endif // EFI_PROD_CODE || EFI_SIMULATOR
+};
+
+/**
+ * When the arena is full, leases of lower priority users are reclaimed
+ */
+static int getPriority(BigBufferUser user) {
+	switch (user) {
+	case BigBufferUser::SensorChart:
+		// continuous background capture
+		return 0;
+	case BigBufferUser::TriggerScope:
+	case BigBufferUser::KnockSpectrogram:
+		return 1;
+	default:
+		// explicitly requested one shot captures
+		return 2;
+	}
+}
+
+static BigBufferLease& getLease(BigBufferUser user) {
+	return s_leases[(size_t)user];
+}
+
+static uint8_t* getBlock(size_t block) {
+	return reinterpret_cast<uint8_t*>(s_bigBuffer) + block * BIG_BUFFER_BLOCK_SIZE;
+}
+
+/**
+ * First fit
+ * @return index of the first block or -1
+ */
+static int findFreeBlocks(size_t blockCount) {
+	size_t runLength = 0;
+	for (size_t i = 0; i < BIG_BUFFER_BLOCK_COUNT; i++) {
+		if (s_blockOwners[i] != BigBufferUser::None) {
+			runLength = 0;
+			continue;
+		}
+
+		runLength++;
+		if (runLength == blockCount) {
+			return i + 1 - blockCount;
+		}
+	}
+
+	return -1;
+}
+
+/**
+ * @return lowest priority user which holds a reclaimable lease and has lower priority than requester
+ */
+static BigBufferUser findEvictionCandidate(BigBufferUser requester) {
+	BigBufferUser candidate = BigBufferUser::None;
+	int candidatePriority = getPriority(requester);
+
+	for (size_t i = 0; i < BIG_BUFFER_USER_COUNT; i++) {
+		auto user = static_cast<BigBufferUser>(i);
+		const auto& lease = getLease(user);
+		if (lease.blockCount == 0 || !lease.onEvict) {
+			continue;
+		}
+
+		int priority = getPriority(user);
+		if (priority < candidatePriority) {
+			candidate = user;
+			candidatePriority = priority;
+		}
+	}
+
+	return candidate;
+}
+
 #if EFI_UNIT_TEST
-BigBufferUser getBigBufferCurrentUser() {
-  return s_currentUser;
+bool hasBigBufferLease(BigBufferUser user) {
+	return getLease(user).blockCount != 0;
+}
+
+size_t getBigBufferFreeSize() {
+	size_t freeBlocks = 0;
+	for (size_t i = 0; i < BIG_BUFFER_BLOCK_COUNT; i++) {
+		if (s_blockOwners[i] == BigBufferUser::None) {
+			freeBlocks++;
+		}
+	}
+	return freeBlocks * BIG_BUFFER_BLOCK_SIZE;
 }
 #endif // EFI_UNIT_TEST
 
 static void releaseBuffer(void* bufferPtr, BigBufferUser user) {
-	if (bufferPtr != &s_bigBuffer || user != s_currentUser) {
+	BigBufferLock lock;
+
+	auto& lease = getLease(user);
+	if (lease.blockCount == 0 || bufferPtr != getBlock(lease.firstBlock)) {
 		// todo: panic!
+		return;
+	}
+
+	for (size_t i = lease.firstBlock; i < lease.firstBlock + lease.blockCount; i++) {
+		s_blockOwners[i] = BigBufferUser::None;
 	}
 
-	s_currentUser = BigBufferUser::None;
+	lease = {};
 }
 
-BigBufferHandle::BigBufferHandle(void* buffer, BigBufferUser user)
+BigBufferHandle::BigBufferHandle(void* buffer, BigBufferUser user, size_t size)
 	: m_bufferPtr(buffer)
 	, m_user(user)
+	, m_size(size)
 {
 }
 
@@ -35,6 +156,9 @@ BigBufferHandle::BigBufferHandle(BigBufferHandle&& other) {
 
 	m_user = other.m_user;
 	other.m_user = BigBufferUser::None;
+
+	m_size = other.m_size;
+	other.m_size = 0;
 }
 
 BigBufferHandle& BigBufferHandle::operator= (BigBufferHandle&& other) {
@@ -48,6 +172,9 @@ BigBufferHandle& BigBufferHandle::operator= (BigBufferHandle&& other) {
 
 		m_user = other.m_user;
 		other.m_user = BigBufferUser::None;
+
+		m_size = other.m_size;
+		other.m_size = 0;
 	}
 	return *this;
 }
@@ -58,13 +185,51 @@ BigBufferHandle::~BigBufferHandle() {
 	}
 }
 
-BigBufferHandle getBigBuffer(BigBufferUser user) {
-	if (s_currentUser != BigBufferUser::None) {
-		// fatal
+BigBufferHandle getBigBuffer(BigBufferUser user, size_t size, BigBufferEvictCallback onEvict) {
+	size_t blockCount = (size + BIG_BUFFER_BLOCK_SIZE - 1) / BIG_BUFFER_BLOCK_SIZE;
+	if (user == BigBufferUser::None || blockCount == 0 || blockCount > BIG_BUFFER_BLOCK_COUNT) {
 		return {};
 	}
 
-	s_currentUser = user;
+	while (true) {
+		BigBufferUser victim;
+		BigBufferEvictCallback evict;
+
+		{
+			BigBufferLock lock;
+
+			auto& lease = getLease(user);
+			if (lease.blockCount != 0) {
+				// fatal
+				return {};
+			}
+
+			int firstBlock = findFreeBlocks(blockCount);
+			if (firstBlock >= 0) {
+				for (size_t i = firstBlock; i < firstBlock + blockCount; i++) {
+					s_blockOwners[i] = user;
+				}
+
+				lease.firstBlock = firstBlock;
+				lease.blockCount = blockCount;
+				lease.onEvict = onEvict;
 
-	return BigBufferHandle(s_bigBuffer, user);
+				return BigBufferHandle(getBlock(firstBlock), user, blockCount * BIG_BUFFER_BLOCK_SIZE);
+			}
+
+			victim = findEvictionCandidate(user);
+			if (victim == BigBufferUser::None) {
+				return {};
+			}
+			evict = getLease(victim).onEvict;
+		}
+
+		// the owner drops its handle which releases the lease
+		evict();
+
+		if (getLease(victim).blockCount != 0) {
+			// owner is busy with its buffer, do not loop forever
+			return {};
+		}
+	}
 }
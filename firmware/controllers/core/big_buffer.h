@@ -1,24 +1,41 @@
 // This file handles the "big buffer" - a shared buffer that can be used by multiple users depending on which function is enabled
+// The buffer is an arena: each user leases a block aligned slice of it, so for example a tooth log and
+// a perf trace of the same event can be captured together.
 
 #pragma once
 
+#include <cstddef>
+
 #ifndef BIG_BUFFER_SIZE
 #define BIG_BUFFER_SIZE 8192
 #endif
 
+// Lease granularity
+#ifndef BIG_BUFFER_BLOCK_SIZE
+#define BIG_BUFFER_BLOCK_SIZE 256
+#endif
+
 enum class BigBufferUser {
 	None,
 	ToothLogger,
 	PerfTrace,
 	TriggerScope,
+	SensorChart,
 	// todo: actually start using this!
 	KnockSpectrogram,
 };
 
+/**
+ * Invoked when a higher priority user needs the space, should drop the handle before returning.
+ * An owner which is still reading its buffer may keep it, the request then fails.
+ * Called from the thread requesting the buffer, outside of any lock.
+ */
+using BigBufferEvictCallback = void (*)();
+
 class BigBufferHandle {
 public:
 	BigBufferHandle() = default;
-	BigBufferHandle(void* buffer, BigBufferUser user);
+	BigBufferHandle(void* buffer, BigBufferUser user, size_t size);
 	~BigBufferHandle();
 
 	// But allow moving (passing ownership of the buffer)
@@ -41,12 +58,24 @@ public:
 	}
 
 	size_t size() const {
-		return BIG_BUFFER_SIZE;
+		return m_size;
 	}
 
 private:
 	void* m_bufferPtr = nullptr;
 	BigBufferUser m_user = BigBufferUser::None;
+	size_t m_size = 0;
 };
 
-BigBufferHandle getBigBuffer(BigBufferUser user);
+/**
+ * @param size is rounded up to BIG_BUFFER_BLOCK_SIZE
+ * @param onEvict null means the lease is never reclaimed, see BigBufferEvictCallback
+ * @return empty handle if the user already holds a lease or there is no room even after reclaiming
+ * leases of lower priority users
+ */
+BigBufferHandle getBigBuffer(BigBufferUser user, size_t size = BIG_BUFFER_SIZE, BigBufferEvictCallback onEvict = nullptr);
+
+#if EFI_UNIT_TEST
+bool hasBigBufferLease(BigBufferUser user);
+size_t getBigBufferFreeSize();
+#endif // EFI_UNIT_TEST
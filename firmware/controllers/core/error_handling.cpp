@@ -9,6 +9,7 @@
 #include "rusefi/efistringutil.h"
 #include "os_util.h"
 #include "backup_ram.h"
+#include "malfunction_central.h"
 #include "error_handling_led.h"
 #include "error_handling_c.h"
 #include "log_hard_fault.h"
@@ -180,6 +181,11 @@ bool warning(ObdCode code, const char *fmt, ...) {
 	// if known - just reset timer
 	engine->engineState.warnings.addWarningCode(code);
 
+	if (code < ObdCode::CUSTOM_NAN_ENGINE_LOAD) {
+		// standard OBD code, keep it with its freeze frame until cleared
+		addError(code);
+	}
+
 	// we just had this same warning, let's not spam
 	if (known) {
 		return true;
@@ -452,6 +452,8 @@ void commonInitEngineController() {
 	initVvtActuators();
 #endif /* EFI_VVT_PID */
 
+	initMalfunctionCentral();
+
 #if EFI_MALFUNCTION_INDICATOR
 	initMalfunctionIndicator();
 #endif /* EFI_MALFUNCTION_INDICATOR */
@@ -145,66 +145,102 @@ bool InjectionEvent::updateInjectionAngle() {
  * @returns false in case of error, true if success
  */
 bool InjectionEvent::update() {
-	bool updatedAngle = updateInjectionAngle();
+	return updateInjectionAngle();
+}
 
-	if (!updatedAngle) {
-		return false;
-	}
+void InjectionEvent::setTopology(const InjectionTopology::Event& event, bool simultaneous) {
+	memcpy(outputs, event.outputs, sizeof(outputs));
+	memcpy(outputsStage2, event.outputsStage2, sizeof(outputsStage2));
+	isSimultaneous = simultaneous;
+	// Stash the cylinder number so we can select the correct fueling bank later
+	cylinderNumber = event.cylinderNumber;
+}
 
-	injection_mode_e mode = getCurrentInjectionMode();
-	engine->outputChannels.currentInjectionMode = static_cast<uint8_t>(mode);
+void InjectionTopology::build(injection_mode_e mode) {
+	firingOrder = engineConfiguration->firingOrder;
+	cylindersCount = engineConfiguration->cylindersCount;
+	isSimultaneous = mode == IM_SIMULTANEOUS;
+	isBuilt = true;
+
+	for (size_t ownIndex = 0; ownIndex < cylindersCount; ownIndex++) {
+		int injectorIndex;
+		if (mode == IM_SIMULTANEOUS || mode == IM_SINGLE_POINT) {
+			// These modes only have one injector
+			injectorIndex = 0;
+		} else if (mode == IM_SEQUENTIAL || mode == IM_BATCH) {
+			// Map order index -> cylinder index (firing order)
+			injectorIndex = ID2INDEX(getFiringOrderCylinderId(ownIndex));
+		} else {
+			firmwareError(ObdCode::CUSTOM_OBD_UNEXPECTED_INJECTION_MODE, "Unexpected injection mode %d", mode);
+			injectorIndex = 0;
+		}
 
-	int injectorIndex;
-	if (mode == IM_SIMULTANEOUS || mode == IM_SINGLE_POINT) {
-		// These modes only have one injector
-		injectorIndex = 0;
-	} else if (mode == IM_SEQUENTIAL || mode == IM_BATCH) {
-		// Map order index -> cylinder index (firing order)
-		injectorIndex = ID2INDEX(getFiringOrderCylinderId(ownIndex));
-	} else {
-		firmwareError(ObdCode::CUSTOM_OBD_UNEXPECTED_INJECTION_MODE, "Unexpected injection mode %d", mode);
-		injectorIndex = 0;
-	}
-
-	InjectorOutputPin *secondOutput;
-	InjectorOutputPin* secondOutputStage2;
-
-	if (mode == IM_BATCH) {
-		/**
-		 * also fire the 2nd half of the injectors so that we can implement a batch mode on individual wires
-		 */
-		// Compute the position of this cylinder's twin in the firing order
-		// Each injector gets fired as a primary (the same as sequential), but also
-		// fires the injector 360 degrees later in the firing order.
-		int secondOrder = (ownIndex + (engineConfiguration->cylindersCount / 2)) % engineConfiguration->cylindersCount;
-		int secondIndex = ID2INDEX(getFiringOrderCylinderId(secondOrder));
-		secondOutput = &enginePins.injectors[secondIndex];
-		secondOutputStage2 = &enginePins.injectorsStage2[secondIndex];
-	} else {
-		secondOutput = nullptr;
-		secondOutputStage2 = nullptr;
-	}
+		InjectorOutputPin *secondOutput;
+		InjectorOutputPin* secondOutputStage2;
+
+		if (mode == IM_BATCH) {
+			/**
+			 * also fire the 2nd half of the injectors so that we can implement a batch mode on individual wires
+			 */
+			// Compute the position of this cylinder's twin in the firing order
+			// Each injector gets fired as a primary (the same as sequential), but also
+			// fires the injector 360 degrees later in the firing order.
+			int secondOrder = (ownIndex + (cylindersCount / 2)) % cylindersCount;
+			int secondIndex = ID2INDEX(getFiringOrderCylinderId(secondOrder));
+			secondOutput = &enginePins.injectors[secondIndex];
+			secondOutputStage2 = &enginePins.injectorsStage2[secondIndex];
+		} else {
+			secondOutput = nullptr;
+			secondOutputStage2 = nullptr;
+		}
 
-	InjectorOutputPin *output = &enginePins.injectors[injectorIndex];
+		InjectorOutputPin *output = &enginePins.injectors[injectorIndex];
 
-	outputs[0] = output;
-	outputs[1] = secondOutput;
-	isSimultaneous = mode == IM_SIMULTANEOUS;
-	// Stash the cylinder number so we can select the correct fueling bank later
-	cylinderNumber = injectorIndex;
+		Event& event = events[ownIndex];
+		event.outputs[0] = output;
+		event.outputs[1] = secondOutput;
+		event.outputsStage2[0] = &enginePins.injectorsStage2[injectorIndex];
+		event.outputsStage2[1] = secondOutputStage2;
+		event.cylinderNumber = injectorIndex;
+
+		if (!isSimultaneous && !output->isInitialized()) {
+			// todo: extract method for this index math
+			warning(ObdCode::CUSTOM_OBD_INJECTION_NO_PIN_ASSIGNED, "no_pin_inj #%s", output->getName());
+		}
+	}
+}
 
-	outputsStage2[0] = &enginePins.injectorsStage2[injectorIndex];
-	outputsStage2[1] = secondOutputStage2;
+void FuelSchedule::selectTopology(injection_mode_e mode) {
+	if (mode > IM_SINGLE_POINT) {
+		firmwareError(ObdCode::CUSTOM_OBD_UNEXPECTED_INJECTION_MODE, "Unexpected injection mode %d", mode);
+		// same single injector behavior as before topologies were cached
+		mode = IM_SINGLE_POINT;
+	}
 
-	if (!isSimultaneous && !output->isInitialized()) {
-		// todo: extract method for this index math
-		warning(ObdCode::CUSTOM_OBD_INJECTION_NO_PIN_ASSIGNED, "no_pin_inj #%s", output->getName());
+	InjectionTopology& topology = m_topologies[mode];
+	if (!topology.isBuiltFor(engineConfiguration->firingOrder, engineConfiguration->cylindersCount)) {
+		topology.build(mode);
+		m_topologyBuildCount++;
+		// rebuilt in place, events still have to pick up the new outputs
+		m_activeTopology = nullptr;
 	}
 
-	return true;
+	if (m_activeTopology == &topology) {
+		return;
+	}
+
+	for (size_t cylinderIndex = 0; cylinderIndex < topology.cylindersCount; cylinderIndex++) {
+		elements[cylinderIndex].setTopology(topology.events[cylinderIndex], topology.isSimultaneous);
+	}
+	m_activeTopology = &topology;
 }
 
 void FuelSchedule::addFuelEvents() {
+	injection_mode_e mode = getCurrentInjectionMode();
+	engine->outputChannels.currentInjectionMode = static_cast<uint8_t>(mode);
+
+	selectTopology(mode);
+
 	for (size_t cylinderIndex = 0; cylinderIndex < engineConfiguration->cylindersCount; cylinderIndex++) {
 		bool result = elements[cylinderIndex].update();
 
@@ -13,12 +13,45 @@
 
 #define MAX_WIRES_COUNT 2
 
+/**
+ * Outputs driven by each injection event. These only depend on injection mode, firing order and
+ * cylinder count so they are built once per combination: switching between cranking and running
+ * injection modes picks another prebuilt topology instead of redoing the firing order math.
+ */
+struct InjectionTopology {
+	void build(injection_mode_e mode);
+
+	bool isBuiltFor(firing_order_e order, size_t cylinders) const {
+		return isBuilt && firingOrder == order && cylindersCount == cylinders;
+	}
+
+	struct Event {
+		InjectorOutputPin* outputs[MAX_WIRES_COUNT];
+		InjectorOutputPin* outputsStage2[MAX_WIRES_COUNT];
+		// injector (and fuel bank) index of the primary output
+		uint8_t cylinderNumber;
+	};
+
+	bool isBuilt = false;
+	bool isSimultaneous = false;
+	firing_order_e firingOrder;
+	uint8_t cylindersCount = 0;
+	// per firing order position
+	Event events[MAX_CYLINDER_COUNT];
+};
+
 class InjectionEvent {
 public:
 	InjectionEvent();
 
+	/**
+	 * Updates the injection start angle, outputs come from setTopology
+	 * @returns false if the angle can not be computed yet
+	 */
 	bool update();
 
+	void setTopology(const InjectionTopology::Event& event, bool isSimultaneous);
+
 	// Call this every decoded trigger tooth.  It will schedule any relevant events for this injector.
 	void onTriggerTooth(efitick_t nowNt, float currentPhase, float nextPhase);
 
@@ -74,6 +107,10 @@ public:
 	 */
 	void addFuelEvents();
 
+	uint32_t getTopologyBuildCount() const {
+		return m_topologyBuildCount;
+	}
+
 	void resetOverlapping();
 
 	/**
@@ -81,6 +118,14 @@ public:
 	 */
 	InjectionEvent elements[MAX_CYLINDER_COUNT];
 	bool isReady = false;
+
+private:
+	// Points every event at the topology of this mode, building it first if needed
+	void selectTopology(injection_mode_e mode);
+
+	InjectionTopology m_topologies[IM_SINGLE_POINT + 1];
+	const InjectionTopology* m_activeTopology = nullptr;
+	uint32_t m_topologyBuildCount = 0;
 };
 
 FuelSchedule * getFuelSchedule();
@@ -89,7 +89,7 @@ void InjectionEvent::onTriggerTooth(efitick_t nowNt, float currentPhase, float n
 	// Perform wall wetting adjustment on fuel mass, not duration, so that
 	// it's correct during fuel pressure (injector flow) or battery voltage (deadtime) transients
 	// TODO: is it correct to wall wet on both pulses?
-	injectionMassGrams = wallFuel.adjust(injectionMassGrams);
+	injectionMassGrams = wallFuel.adjust(injectionMassGrams, engine->module<WallFuelController>()->getCoefs(this->cylinderNumber));
 
 	// Disable staging in simultaneous mode
 	float stage2Fraction = isSimultaneous ? 0 : getEngineState()->injectionStage2Fraction;
@@ -2,8 +2,6 @@
  * @file malfunction_central.c
  * @brief This data structure holds current malfunction codes
  *
- * todo: make this a class
- *
  * @date Dec 20, 2013
  * @author Andrey Belomutskiy, (c) 2012-2020
  */
@@ -11,52 +9,287 @@
 #include "pch.h"
 
 #include "malfunction_central.h"
+#include "backup_ram.h"
 
-static error_codes_set_s error_codes_set;
+static uint32_t getDtcMask(ObdCode code) {
+	return 1u << (static_cast<size_t>(code) % 32);
+}
 
-void clearWarnings(void) {
-	error_codes_set.count = 0;
+static size_t getDtcWord(ObdCode code) {
+	return static_cast<size_t>(code) / 32;
 }
 
-// TODO: wow this is not used by real firmware?!
-#if EFI_UNIT_TEST
-/**
- * Search if code is present
- * @return -1 if code not found
- */
-static int find_position(ObdCode e_code) {
-	// cycle for searching element equal seaching code
-	for (int t = 0; t < error_codes_set.count; t++)
-		if (error_codes_set.error_codes[t] == e_code)
-			return t;			// we found position where this code is present
-	return -1;														// -1 if code not found
+bool DtcStore::isSet(ObdCode code) const {
+	if (!isValidCode(code)) {
+		return false;
+	}
+
+	return (m_bits[getDtcWord(code)] & getDtcMask(code)) != 0;
+}
+
+bool DtcStore::set(ObdCode code, const DtcFreezeFrame* frame) {
+	if (!isValidCode(code) || isSet(code) || m_count >= MAX_ERROR_CODES_COUNT) {
+		return false;
+	}
+
+	m_bits[getDtcWord(code)] |= getDtcMask(code);
+	m_count++;
+
+	if (frame) {
+		m_frames[m_frameHead] = *frame;
+		m_frames[m_frameHead].code = code;
+		m_frameHead = (m_frameHead + 1) % DTC_FREEZE_FRAME_COUNT;
+	}
+
+	return true;
+}
+
+bool DtcStore::clear(ObdCode code) {
+	if (!isSet(code)) {
+		return false;
+	}
+
+	m_bits[getDtcWord(code)] &= ~getDtcMask(code);
+	m_count--;
+
+	for (auto& frame : m_frames) {
+		if (frame.code == code) {
+			frame = DtcFreezeFrame();
+		}
+	}
+
+	return true;
+}
+
+void DtcStore::clearAll() {
+	memset(m_bits, 0, sizeof(m_bits));
+	m_count = 0;
+
+	for (auto& frame : m_frames) {
+		frame = DtcFreezeFrame();
+	}
+	m_frameHead = 0;
+}
+
+void DtcStore::getCodes(error_codes_set_s* copy) const {
+	int count = 0;
+
+	for (size_t i = 0; i < efi::size(m_bits) && count < m_count; i++) {
+		uint32_t word = m_bits[i];
+		while (word != 0) {
+			int bit = __builtin_ctz(word);
+			// drop lowest set bit
+			word &= word - 1;
+			copy->error_codes[count++] = static_cast<ObdCode>(i * 32 + bit);
+		}
+	}
+
+	copy->count = count;
+}
+
+const DtcFreezeFrame* DtcStore::getFreezeFrame(ObdCode code) const {
+	if (!isSet(code)) {
+		return nullptr;
+	}
+
+	for (auto& frame : m_frames) {
+		if (frame.code == code) {
+			return &frame;
+		}
+	}
+
+	return nullptr;
+}
+
+const DtcFreezeFrame* DtcStore::getFreezeFrameByIndex(size_t index) const {
+	for (size_t age = 0; age < DTC_FREEZE_FRAME_COUNT; age++) {
+		size_t slot = (m_frameHead + DTC_FREEZE_FRAME_COUNT - 1 - age) % DTC_FREEZE_FRAME_COUNT;
+		const DtcFreezeFrame& frame = m_frames[slot];
+
+		// slots of cleared codes are holes in the ring
+		if (frame.code == ObdCode::None) {
+			continue;
+		}
+
+		if (index == 0) {
+			return &frame;
+		}
+		index--;
+	}
+
+	return nullptr;
+}
+
+void DtcStore::save(DtcBackup& backup) const {
+	error_codes_set_s codes;
+	getCodes(&codes);
+
+	backup.count = codes.count;
+	copyArray(backup.codes, codes.error_codes);
+
+	// newest first, holes squeezed out
+	for (size_t i = 0; i < DTC_FREEZE_FRAME_COUNT; i++) {
+		const DtcFreezeFrame* frame = getFreezeFrameByIndex(i);
+		backup.frames[i] = frame ? *frame : DtcFreezeFrame();
+	}
+
+	backup.cookie = DTC_BACKUP_COOKIE;
+}
+
+bool DtcStore::restore(const DtcBackup& backup) {
+	clearAll();
+
+	if (backup.cookie != DTC_BACKUP_COOKIE || backup.count > MAX_ERROR_CODES_COUNT) {
+		return false;
+	}
+
+	for (size_t i = 0; i < backup.count; i++) {
+		if (!isValidCode(backup.codes[i])) {
+			clearAll();
+			return false;
+		}
+		set(backup.codes[i]);
+	}
+
+	// oldest first so that the ring order is preserved
+	for (size_t i = DTC_FREEZE_FRAME_COUNT; i-- > 0;) {
+		const DtcFreezeFrame& frame = backup.frames[i];
+		if (isSet(frame.code) && !getFreezeFrame(frame.code)) {
+			m_frames[m_frameHead] = frame;
+			m_frameHead = (m_frameHead + 1) % DTC_FREEZE_FRAME_COUNT;
+		}
+	}
+
+	return true;
+}
+
+static DtcStore dtcStore;
+// warning() adds codes from interrupt context too, backup RAM copy is only written by updateMalfunctionCentral
+static volatile bool isBackupOutdated = false;
+
+static void onDtcStoreChanged() {
+	isBackupOutdated = true;
+}
+
+void updateMalfunctionCentral() {
+	if (!isBackupOutdated) {
+		return;
+	}
+
+#if EFI_BACKUP_SRAM
+	chibios_rt::CriticalSectionLocker csl;
+	dtcStore.save(getBackupSram()->Dtc);
+#endif // EFI_BACKUP_SRAM
+
+	isBackupOutdated = false;
+}
+
+void clearWarnings(void) {
+	{
+		chibios_rt::CriticalSectionLocker csl;
+		dtcStore.clearAll();
+	}
+	onDtcStoreChanged();
 }
 
 void addError(ObdCode errorCode) {
-	if (error_codes_set.count < MAX_ERROR_CODES_COUNT && find_position(errorCode) == -1) {
-		error_codes_set.error_codes[error_codes_set.count] = errorCode;
-		error_codes_set.count++;
+	if (dtcStore.isSet(errorCode)) {
+		// repeated report of an active fault is the common case, keep it cheap
+		return;
+	}
+
+	DtcFreezeFrame frame;
+	frame.rpm = Sensor::getOrZero(SensorType::Rpm);
+	frame.load = engine ? engine->engineState.fuelingLoad : 0;
+	frame.clt = Sensor::getOrZero(SensorType::Clt);
+	frame.lambda = Sensor::getOrZero(SensorType::Lambda1);
+	frame.timestampMs = getTimeNowMs();
+
+	bool isAdded;
+	{
+		chibios_rt::CriticalSectionLocker csl;
+		isAdded = dtcStore.set(errorCode, &frame);
+	}
+
+	if (isAdded) {
+		onDtcStoreChanged();
 	}
 }
 
 void removeError(ObdCode errorCode) {
-	int pos = find_position(errorCode);
-	if (pos >= 0) {
-		// shift all right elements to one pos left
-		for (int t = pos; t < error_codes_set.count - 1; t++) {
-			error_codes_set.error_codes[t] = error_codes_set.error_codes[t + 1];
-		}
+	bool isRemoved;
+	{
+		chibios_rt::CriticalSectionLocker csl;
+		isRemoved = dtcStore.clear(errorCode);
+	}
 
-		error_codes_set.error_codes[--error_codes_set.count] = (ObdCode)0;				// place 0
+	if (isRemoved) {
+		onDtcStoreChanged();
 	}
 }
-#endif // EFI_UNIT_TEST
 
 void getErrorCodes(error_codes_set_s * copy) {
-	copy->count = error_codes_set.count;
-	copyArray(copy->error_codes, error_codes_set.error_codes);
+	chibios_rt::CriticalSectionLocker csl;
+	dtcStore.getCodes(copy);
 }
 
 bool hasErrorCodes(void) {
-	return error_codes_set.count > 0;
+	return dtcStore.getCount() > 0;
+}
+
+bool hasErrorCode(ObdCode errorCode) {
+	return dtcStore.isSet(errorCode);
+}
+
+const DtcFreezeFrame* getFreezeFrame(ObdCode errorCode) {
+	return dtcStore.getFreezeFrame(errorCode);
+}
+
+const DtcFreezeFrame* getFreezeFrameByIndex(size_t index) {
+	return dtcStore.getFreezeFrameByIndex(index);
+}
+
+uint16_t getObdDtcValue(ObdCode errorCode) {
+	int code = static_cast<int>(errorCode);
+	// first digit only has two bits, anything above P3999 is one of our custom codes
+	if (code <= 0 || code >= 4000) {
+		return 0;
+	}
+
+	// each decimal digit goes into a nibble
+	return ((code / 1000) << 12) | ((code / 100 % 10) << 8) | ((code / 10 % 10) << 4) | (code % 10);
+}
+
+#if !EFI_UNIT_TEST
+static void printDtcInfo() {
+	error_codes_set_s codes;
+	getErrorCodes(&codes);
+
+	efiPrintf("%d trouble code(s)", codes.count);
+	for (int i = 0; i < codes.count; i++) {
+		ObdCode code = codes.error_codes[i];
+		const DtcFreezeFrame* frame = getFreezeFrame(code);
+		if (frame) {
+			efiPrintf("%s%04d at %lums: rpm=%.0f load=%.1f clt=%.1f lambda=%.3f",
+				code < ObdCode::CUSTOM_NAN_ENGINE_LOAD ? "P" : "C", (int)code,
+				frame->timestampMs, frame->rpm, frame->load, frame->clt, frame->lambda);
+		} else {
+			efiPrintf("%s%04d: no freeze frame",
+				code < ObdCode::CUSTOM_NAN_ENGINE_LOAD ? "P" : "C", (int)code);
+		}
+	}
+}
+#endif // EFI_UNIT_TEST
+
+void initMalfunctionCentral() {
+#if EFI_BACKUP_SRAM
+	if (dtcStore.restore(getBackupSram()->Dtc)) {
+		efiPrintf("%d trouble code(s) restored from backup RAM", dtcStore.getCount());
+	}
+#endif // EFI_BACKUP_SRAM
+
+#if !EFI_UNIT_TEST
+	addConsoleAction("dtcinfo", printDtcInfo);
+	addConsoleAction("dtcclear", clearWarnings);
+#endif // EFI_UNIT_TEST
 }
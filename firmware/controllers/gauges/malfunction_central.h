@@ -2,6 +2,9 @@
  * @file malfunction_central.h
  * @brief This data structure holds current malfunction codes
  *
+ * Codes are indexed by a bitset so that set/clear/test are O(1), engine conditions at the
+ * moment a code was set go into a small freeze-frame ring.
+ *
  * @date Dec 20, 2013
  * @author Andrey Belomutskiy, (c) 2012-2020
  */
@@ -12,18 +15,97 @@
 
 #define MAX_ERROR_CODES_COUNT 10
 
+// all codes are four decimal digits
+#define DTC_CODE_LIMIT 10000
+#define DTC_FREEZE_FRAME_COUNT 8
+
+// These use very specific values to avoid interpreting random garbage memory as a real value
+#define DTC_BACKUP_COOKIE 0xd7c0ffee
+
 struct error_codes_set_s {
 	int count = 0;
 	ObdCode error_codes[MAX_ERROR_CODES_COUNT];
 };
 
-// TODO: wow this is not used by real firmware?!
-#if EFI_UNIT_TEST
+/**
+ * Engine conditions at the moment a code was set
+ */
+struct DtcFreezeFrame {
+	// ObdCode::None for an empty slot
+	ObdCode code = ObdCode::None;
+	float rpm = 0;
+	float load = 0;
+	float clt = 0;
+	float lambda = 0;
+	// time since boot
+	uint32_t timestampMs = 0;
+};
+
+/**
+ * Dense copy of the store which survives a reset in backup RAM
+ */
+struct DtcBackup {
+	uint32_t cookie;
+	uint32_t count;
+	ObdCode codes[MAX_ERROR_CODES_COUNT];
+	DtcFreezeFrame frames[DTC_FREEZE_FRAME_COUNT];
+};
+
+class DtcStore {
+public:
+	/**
+	 * Frame is only recorded for a new code: we want the conditions of the first occurrence
+	 * @return true if the code was not set before and there was room for it
+	 */
+	bool set(ObdCode code, const DtcFreezeFrame* frame = nullptr);
+	/**
+	 * Removes the code together with its freeze frame
+	 * @return true if the code was set
+	 */
+	bool clear(ObdCode code);
+	bool isSet(ObdCode code) const;
+	void clearAll();
+
+	int getCount() const {
+		return m_count;
+	}
+
+	/**
+	 * Copies current codes in ascending order
+	 */
+	void getCodes(error_codes_set_s* copy) const;
+
+	const DtcFreezeFrame* getFreezeFrame(ObdCode code) const;
+	/**
+	 * @param index zero is the most recent frame
+	 * @return nullptr if there are not that many frames
+	 */
+	const DtcFreezeFrame* getFreezeFrameByIndex(size_t index) const;
+
+	void save(DtcBackup& backup) const;
+	/**
+	 * @return false if backup does not hold a valid store, this store is left empty then
+	 */
+	bool restore(const DtcBackup& backup);
+
+private:
+	static bool isValidCode(ObdCode code) {
+		return code != ObdCode::None && static_cast<size_t>(code) < DTC_CODE_LIMIT;
+	}
+
+	uint32_t m_bits[DTC_CODE_LIMIT / 32 + 1] = {};
+	int m_count = 0;
+
+	DtcFreezeFrame m_frames[DTC_FREEZE_FRAME_COUNT];
+	// slot for the next frame, the oldest frame is overwritten
+	size_t m_frameHead = 0;
+};
+
 /**
  * @brief Adds an error code into the set of current errors.
- * The error code is placed into the fixed-size data structure if it fits into it.
- * The error code stays in the data structure till it is removed by 'clearError'
- *
+ * The error code is placed into the set if it fits into it, current engine conditions are
+ * recorded as its freeze frame.
+ * The error code stays in the set till it is removed by 'removeError'
  */
 void addError(ObdCode errorCode);
 /**
@@ -31,7 +113,6 @@ void addError(ObdCode errorCode);
  *
  */
 void removeError(ObdCode errorCode);
-#endif // EFI_UNIT_TEST
 
 void clearWarnings(void);
 /**
@@ -40,3 +121,21 @@ void clearWarnings(void);
 void getErrorCodes(error_codes_set_s * buffer);
 
 bool hasErrorCodes(void);
+bool hasErrorCode(ObdCode errorCode);
+
+const DtcFreezeFrame* getFreezeFrame(ObdCode errorCode);
+const DtcFreezeFrame* getFreezeFrameByIndex(size_t index);
+
+/**
+ * Two byte DTC as reported by OBD-II modes 02/03/07, P0xxx-P3xxx
+ */
+uint16_t getObdDtcValue(ObdCode errorCode);
+
+/**
+ * Brings back codes stored before the last reset and registers console commands
+ */
+void initMalfunctionCentral();
+/**
+ * Copies changed codes to backup RAM, invoked from the slow callback
+ */
+void updateMalfunctionCentral();
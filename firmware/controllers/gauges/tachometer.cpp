@@ -2,7 +2,9 @@
  * @file tachometer.cpp
  * @brief This is about driving external analog tachometers
  *
- * This implementation produces one pulse per engine cycle
+ * While the trigger is synchronized tach pulses are scheduled by angle from the trigger teeth,
+ * same as sparks, so that the gauge follows RPM transients without any lag. PWM at the RPM derived
+ * frequency is only used as a fallback while we do not know the engine phase.
  *
  * @date Aug 18, 2015
  * @author Andrey Belomutskiy, (c) 2012-2020
@@ -15,6 +17,8 @@
 static SimplePwm tachControl("tach"); 
 static float tachFreq;  
 static float duty;   
+// pulses are driven from the trigger, PWM stays quiet
+static bool tachIsAngleBased = false;
 
 #if EFI_UNIT_TEST
 float getTachFreq() {
@@ -24,10 +28,35 @@ float getTachFreq() {
 float getTachDuty() {
 	return duty;
 }
+
+bool isTachAngleBased() {
+	return tachIsAngleBased;
+}
 #endif
 
 static bool tachHasInit = false;
 
+// PWM state changes are ignored while pulses are scheduled by angle
+static void tachPwmCallback(int stateIndex, PwmConfig* state) {
+	if (tachIsAngleBased) {
+		return;
+	}
+
+	applyPinState(stateIndex, state);
+}
+
+static void tachPinHigh(void*) {
+	enginePins.tachOut.setHigh();
+}
+
+static void tachPinLow(void*) {
+	enginePins.tachOut.setLow();
+}
+
+static bool isValidTachPulseCount(int periods) {
+	return periods > 0 && periods <= 10;
+}
+
 void tachUpdate() {
 	// Only do anything if tach enabled
 	if (!tachHasInit) {
@@ -37,13 +66,16 @@ void tachUpdate() {
 	// How many tach pulse periods do we have?
 	int periods = engineConfiguration->tachPulsePerRev;
 
-	if (periods == 0 || periods > 10) {
+	if (!isValidTachPulseCount(periods)) {
 		firmwareError(ObdCode::CUSTOM_ERR_6709, "Invalid tachometer pulse per rev: %d", periods);
 		return;
 	}
 
+	float rpm = Sensor::getOrZero(SensorType::Rpm);
+	tachIsAngleBased = getTriggerCentral()->triggerState.getShaftSynchronized() && isValidRpm(rpm);
+
 	// What is the angle per tach output period?
-	float cycleTimeMs = 60000.0f / Sensor::getOrZero(SensorType::Rpm);
+	float cycleTimeMs = 60000.0f / rpm;
 	float periodTimeMs = cycleTimeMs / periods;
 	tachFreq = 1000.0f / periodTimeMs;
 	
@@ -61,11 +93,58 @@ void tachUpdate() {
 	}
 	
 	tachControl.setSimplePwmDutyCycle(duty);
-	tachControl.setFrequency(tachFreq);
+	// nothing for the PWM to do while pulses are scheduled by angle
+	tachControl.setFrequency(tachIsAngleBased ? NAN : tachFreq);
+}
+
+/**
+ * Schedules the tach pulses which fall between this tooth and the next one.
+ * Pulses are evenly spaced and the first one is at TDC of cylinder #1.
+ */
+void tachSignalCallback(efitick_t edgeTimestamp, angle_t currentPhase, angle_t nextPhase) {
+	if (!tachHasInit || !tachIsAngleBased) {
+		return;
+	}
+
+	int periods = engineConfiguration->tachPulsePerRev;
+	if (!isValidTachPulseCount(periods)) {
+		return;
+	}
+
+	angle_t engineCycle = getEngineState()->engineCycle;
+	angle_t pulseSpacing = 360.0f / periods;
+	int pulsesPerCycle = periods * engineCycle / 360;
+
+	// Pulse width, stretched with RPM in duty cycle mode
+	float periodUs = engine->rpmCalculator.oneDegreeUs * pulseSpacing;
+	float highTimeUs = engineConfiguration->tachPulseDurationAsDutyCycle
+		? engineConfiguration->tachPulseDuractionMs * periodUs
+		: MS2US(engineConfiguration->tachPulseDuractionMs);
+	// leave room for the pin to go low before the next pulse
+	highTimeUs = std::min(highTimeUs, 0.9f * periodUs);
+
+	int pulseIndex = std::ceil(currentPhase / pulseSpacing);
+	for (int i = 0; i < pulsesPerCycle; i++, pulseIndex++) {
+		angle_t pulseAngle = (pulseIndex % pulsesPerCycle) * pulseSpacing;
+
+		if (!isPhaseInRange(pulseAngle, currentPhase, nextPhase)) {
+			// the rest is for the teeth to come
+			break;
+		}
+
+		float angleFromNow = pulseAngle - currentPhase;
+		if (angleFromNow < 0) {
+			angleFromNow += engineCycle;
+		}
+
+		efitick_t riseNt = scheduleByAngle(nullptr, edgeTimestamp, angleFromNow, tachPinHigh);
+		getScheduler()->schedule("tach", nullptr, riseNt + US2NT((int)highTimeUs), tachPinLow);
+	}
 }
 
 void initTachometer() {
 	tachHasInit = false;
+	tachIsAngleBased = false;
 
 	if (!isBrainPinValid(engineConfiguration->tachOutputPin)) {
 		return;
@@ -75,7 +154,7 @@ void initTachometer() {
 				"Tachometer",
 				&engine->scheduler,
 				&enginePins.tachOut,
-				NAN, 0.1f);
+				NAN, 0.1f, tachPwmCallback);
 
 	tachHasInit = true;
 }
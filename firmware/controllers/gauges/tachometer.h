@@ -9,3 +9,4 @@
 
 void initTachometer();
 void tachUpdate();
+void tachSignalCallback(efitick_t edgeTimestamp, angle_t currentPhase, angle_t nextPhase);
@@ -2385,17 +2385,21 @@ struct engine_configuration_s {
 	offset 1304 bit 22 */
 	bool limitTorqueReductionTime : 1 {};
 	/**
+	 * Learn per-cylinder fuel trims from the bank wideband by attributing its samples to cylinders by crank angle. Needs full engine phase sync and closed loop fuel correction.
 	offset 1304 bit 23 */
-	bool unusedFancy7 : 1 {};
+	bool cylinderLambdaSeparation : 1 {};
 	/**
+	 * Learn idle air from the closed loop idle integrator, by CLT and A/C and fan state, and use it as open loop. Learned values are kept in backup RAM.
 	offset 1304 bit 24 */
-	bool unusedFancy8 : 1 {};
+	bool idleAirLearning : 1 {};
 	/**
+	 * Closed loop boost: predict the boost rise from a turbo spool model and back the wastegate duty off ahead of the target instead of after overshooting it. Uses EGT1 if present.
 	offset 1304 bit 25 */
-	bool unusedFancy9 : 1 {};
+	bool boostSpoolFeedForward : 1 {};
 	/**
+	 * Learn the actual ratio of each gear, including tire growth and final drive error, while driving in it. Learned ratios are used for gear detection and kept in backup RAM.
 	offset 1304 bit 26 */
-	bool unusedFancy10 : 1 {};
+	bool learnGearRatios : 1 {};
 	/**
 	 * Are you a developer troubleshooting TS over CAN ISO/TP?
 	offset 1304 bit 27 */
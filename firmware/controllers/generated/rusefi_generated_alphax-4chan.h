@@ -1557,8 +1557,12 @@
 #define TS_GET_COMPOSITE_BUFFER_DONE_DIFFERENTLY_char 8
 #define TS_GET_CONFIG_ERROR 'e'
 #define TS_GET_CONFIG_ERROR_char e
+#define TS_GET_CUT_TIMELINE 'j'
+#define TS_GET_CUT_TIMELINE_char j
 #define TS_GET_FIRMWARE_VERSION 'V'
 #define TS_GET_FIRMWARE_VERSION_char V
+#define TS_GET_HISTOGRAM 'h'
+#define TS_GET_HISTOGRAM_char h
 #define TS_GET_OUTPUTS_SIZE '4'
 #define TS_GET_OUTPUTS_SIZE_char 4
 #define TS_GET_PROTOCOL_VERSION_COMMAND_F 'F'
@@ -1571,6 +1575,10 @@
 #define TS_HELLO_COMMAND_char S
 #define TS_IO_TEST_COMMAND 'Z'
 #define TS_IO_TEST_COMMAND_char Z
+#define TS_LOG_STREAM_COMMAND 'y'
+#define TS_LOG_STREAM_COMMAND_char y
+#define TS_LOG_STREAM_START 1
+#define TS_LOG_STREAM_STOP 2
 #define TS_ONLINE_PROTOCOL 'z'
 #define TS_ONLINE_PROTOCOL_char z
 #define TS_OUTPUT_ALL_COMMAND 'A'
@@ -1593,11 +1601,13 @@
 #define TS_RESPONSE_BURN_OK 4
 #define TS_RESPONSE_CRC_FAILURE 0x82
 #define TS_RESPONSE_FRAMING_ERROR 0x8D
+#define TS_RESPONSE_LOG_STREAM_RECORD 0x10
 #define TS_RESPONSE_OK 0
 #define TS_RESPONSE_OUT_OF_RANGE 0x84
 #define TS_RESPONSE_OVERRUN 0x81
 #define TS_RESPONSE_UNDERRUN 0x80
 #define TS_RESPONSE_UNRECOGNIZED_COMMAND 0x83
+#define TS_SENSOR_CHART_READ 7
 #define TS_SET_LOGGER_SWITCH 'l'
 #define TS_SET_LOGGER_SWITCH_char l
 #define ts_show_acr_pins true
@@ -241,6 +241,42 @@ todo AndreiKA this change breaks 22 unit tests?
 		// Tracks the last time any cut happened
 		m_lastCutTime.reset(nowNt);
 	}
+
+	updateCutHistory(rpm, nowNt);
+}
+
+void LimpManager::updateCutHistory(float rpm, efitick_t nowNt) {
+	uint32_t fuelReasons = getFuelCutReasons();
+	uint32_t sparkReasons = getSparkCutReasons();
+
+	if (m_hasUpdated) {
+		// whatever was cutting since the previous update gets the time
+		efidur_t elapsedNt = nowNt - m_lastUpdateNt;
+		uint32_t reasons = m_fuelCutReasons | m_sparkCutReasons;
+		for (size_t i = 0; i < efi::size(m_cutDurationNt); i++) {
+			if (reasons & clearReasonBit((ClearReason)i)) {
+				m_cutDurationNt[i] += elapsedNt;
+			}
+		}
+	}
+
+	if (fuelReasons != m_fuelCutReasons || sparkReasons != m_sparkCutReasons) {
+		LimpCutTransition& transition = m_cutTimeline[m_cutTransitionCount % LIMP_CUT_TIMELINE_SIZE];
+		transition.timestampMs = nowNt / MS2NT(1);
+		transition.fuelReasons = fuelReasons;
+		transition.sparkReasons = sparkReasons;
+		transition.rpm = clampF(0, rpm, UINT16_MAX);
+		transition.pad = 0;
+		m_cutTransitionCount++;
+	}
+
+	m_fuelCutReasons = fuelReasons;
+	m_sparkCutReasons = sparkReasons;
+	m_lastUpdateNt = nowNt;
+	m_hasUpdated = true;
+
+	engine->outputChannels.fuelCutReasonMask = fuelReasons;
+	engine->outputChannels.sparkCutReasonMask = sparkReasons;
 }
 
 void LimpManager::onIgnitionStateChanged(bool ignitionOn) {
@@ -312,4 +348,49 @@ float LimpManager::getLimitingFuelCorrection() const {
 float LimpManager::getTimeSinceAnyCut() const {
 	return m_lastCutTime.getElapsedSeconds();
 }
+
+uint32_t LimpManager::getFuelCutReasons() const {
+	return m_allowInjection.getReasons() | m_transientAllowInjection.getReasons();
+}
+
+uint32_t LimpManager::getSparkCutReasons() const {
+	return m_allowIgnition.getReasons() | m_transientAllowIgnition.getReasons();
+}
+
+float LimpManager::getCutTimeSeconds(ClearReason reason) const {
+	size_t index = (size_t)reason;
+	if (index >= efi::size(m_cutDurationNt)) {
+		return 0;
+	}
+
+	return m_cutDurationNt[index] / (float)MS2NT(1000);
+}
+
+const LimpCutTransition* LimpManager::getCutTransition(size_t index) const {
+	if (index >= m_cutTransitionCount || index >= LIMP_CUT_TIMELINE_SIZE) {
+		return nullptr;
+	}
+
+	return &m_cutTimeline[(m_cutTransitionCount - 1 - index) % LIMP_CUT_TIMELINE_SIZE];
+}
+
+void LimpManager::getCutHistory(LimpCutHistory& history) const {
+	memset(&history, 0, sizeof(history));
+
+	history.transitionCount = m_cutTransitionCount;
+	history.fuelReasons = getFuelCutReasons();
+	history.sparkReasons = getSparkCutReasons();
+
+	for (size_t i = 0; i < efi::size(history.cutTimeMs); i++) {
+		history.cutTimeMs[i] = m_cutDurationNt[i] / MS2NT(1);
+	}
+
+	for (size_t i = 0; i < efi::size(history.timeline); i++) {
+		auto transition = getCutTransition(i);
+		if (!transition) {
+			break;
+		}
+		history.timeline[i] = *transition;
+	}
+}
 #endif // EFI_ENGINE_CONTROL
@@ -30,8 +30,17 @@ enum class ClearReason : uint8_t {
 
 	// Keep this list in sync with fuelIgnCutCodeList in tunerstudio.template.ini!
 	// todo: add a code generator between ClearReason and fuelIgnCutCodeList in tunerstudio.template.ini
+
+	// not a reason, keep last
+	Count,
 };
 
+static_assert((size_t)ClearReason::Count <= 32, "cut reasons are reported as a 32 bit mask");
+
+constexpr uint32_t clearReasonBit(ClearReason reason) {
+	return 1u << (uint32_t)reason;
+}
+
 enum class TpsState : uint8_t {
 	None, // 0
 	EngineStopped, // 1
@@ -54,16 +63,24 @@ public:
 	Clearable(bool value) : m_value(value) {
 		if (!m_value) {
 			clearReason = ClearReason::Settings;
+			m_reasons = clearReasonBit(ClearReason::Settings);
 		}
 	}
 
 	void clear(ClearReason p_clearReason) {
+		m_reasons |= clearReasonBit(p_clearReason);
+
 		if (m_value) {
 			m_value = false;
 			clearReason = p_clearReason;
 		}
 	}
 
+	// Every reason this was cleared for, clearReason is only the first one
+	uint32_t getReasons() const {
+		return m_reasons;
+	}
+
 	operator bool() const {
 		return m_value;
 	}
@@ -71,6 +88,7 @@ public:
 	ClearReason clearReason = ClearReason::None;
 private:
 	bool m_value = true;
+	uint32_t m_reasons = 0;
 };
 
 struct LimpState {
@@ -83,6 +101,32 @@ struct LimpState {
 	}
 };
 
+// Set of active fuel and spark cut reasons as of some moment, see LimpManager::getCutTransition
+struct LimpCutTransition {
+	uint32_t timestampMs;
+	// masks of clearReasonBit
+	uint32_t fuelReasons;
+	uint32_t sparkReasons;
+	uint16_t rpm;
+	uint16_t pad;
+};
+
+static_assert(sizeof(LimpCutTransition) == 16);
+
+#define LIMP_CUT_TIMELINE_SIZE 32
+
+// Reply to TS_GET_CUT_TIMELINE, little endian like everything else on the wire
+struct LimpCutHistory {
+	// total number of changes since boot, timeline only has the last LIMP_CUT_TIMELINE_SIZE
+	uint32_t transitionCount;
+	uint32_t fuelReasons;
+	uint32_t sparkReasons;
+	// indexed by ClearReason
+	uint32_t cutTimeMs[(size_t)ClearReason::Count];
+	// most recent first, unused entries are zero
+	LimpCutTransition timeline[LIMP_CUT_TIMELINE_SIZE];
+};
+
 class LimpManager : public EngineModule {
 public:
 	ShutdownController shutdownController;
@@ -101,6 +145,25 @@ public:
 
 	float getTimeSinceAnyCut() const;
 
+	// Masks of clearReasonBit, all reasons which are cutting right now
+	uint32_t getFuelCutReasons() const;
+	uint32_t getSparkCutReasons() const;
+
+	// Total time fuel or spark has been cut for this reason, overlapping reasons all count
+	float getCutTimeSeconds(ClearReason reason) const;
+
+	// Number of times the set of cut reasons has changed
+	uint32_t getCutTransitionCount() const {
+		return m_cutTransitionCount;
+	}
+
+	/**
+	 * @param index 0 for the most recent change of cut reasons
+	 * @return nullptr if that change is not in the timeline (anymore)
+	 */
+	const LimpCutTransition* getCutTransition(size_t index) const;
+	void getCutHistory(LimpCutHistory& history) const;
+
 	bool allowTriggerInput() const;
 
 	void updateRevLimit(float rpm);
@@ -114,6 +177,7 @@ public:
 
 private:
 	void setFaultRevLimit(int limit);
+	void updateCutHistory(float rpm, efitick_t nowNt);
 
 	Hysteresis m_revLimitHysteresis;
 	MaxLimitWithHysteresis m_boostCutHysteresis;
@@ -150,6 +214,17 @@ private:
 
 	// Tracks how long oil pressure has been below threshold
 	Timer m_lowOilPressureTimer;
+
+	// Cut reasons as of the previous update, time since then is accounted to them
+	uint32_t m_fuelCutReasons = 0;
+	uint32_t m_sparkCutReasons = 0;
+	efitick_t m_lastUpdateNt = 0;
+	bool m_hasUpdated = false;
+
+	efidur_t m_cutDurationNt[(size_t)ClearReason::Count] = {};
+
+	LimpCutTransition m_cutTimeline[LIMP_CUT_TIMELINE_SIZE];
+	uint32_t m_cutTransitionCount = 0;
 };
 
 #if EFI_ENGINE_CONTROL
@@ -825,6 +825,12 @@ float getOutputValueByName(const char *name) {
 // fuelCutReasonBlinker
 		case 1745186508:
 			return engine->outputChannels.fuelCutReasonBlinker;
+// fuelCutReasonMask
+		case 1571919121:
+			return engine->outputChannels.fuelCutReasonMask;
+// sparkCutReasonMask
+		case 281744934:
+			return engine->outputChannels.sparkCutReasonMask;
 // totalFuelCorrection
 #if EFI_ENGINE_CONTROL
 		case -1779658835:
@@ -12,6 +12,7 @@
 #include "tunerstudio.h"
 #include "lua_pid.h"
 #include "start_stop.h"
+#include "malfunction_central.h"
 
 #if EFI_PROD_CODE && HW_HELLEN
 #include "hellen_meta.h"
@@ -797,6 +798,45 @@ void configureRusefiLuaHooks(lua_State* lState) {
 		return 0;
 	});
 
+	lua_register(lState, "getDtcCount", [](lua_State* l) {
+		error_codes_set_s codes;
+		getErrorCodes(&codes);
+		lua_pushinteger(l, codes.count);
+		return 1;
+	});
+	lua_register(lState, "hasDtc", [](lua_State* l) {
+		auto code = luaL_checkinteger(l, 1);
+		lua_pushboolean(l, hasErrorCode(static_cast<ObdCode>(code)));
+		return 1;
+	});
+	lua_register(lState, "setDtc", [](lua_State* l) {
+		auto code = luaL_checkinteger(l, 1);
+		addError(static_cast<ObdCode>(code));
+		return 0;
+	});
+	lua_register(lState, "clearDtc", [](lua_State* l) {
+		if (lua_gettop(l) == 0) {
+			clearWarnings();
+		} else {
+			removeError(static_cast<ObdCode>(luaL_checkinteger(l, 1)));
+		}
+		return 0;
+	});
+	lua_register(lState, "getFreezeFrame", [](lua_State* l) {
+		auto code = luaL_checkinteger(l, 1);
+		auto frame = getFreezeFrame(static_cast<ObdCode>(code));
+		if (!frame) {
+			lua_pushnil(l);
+			return 1;
+		}
+		lua_pushnumber(l, frame->rpm);
+		lua_pushnumber(l, frame->load);
+		lua_pushnumber(l, frame->clt);
+		lua_pushnumber(l, frame->lambda);
+		lua_pushinteger(l, frame->timestampMs);
+		return 5;
+	});
+
 #if EFI_ELECTRONIC_THROTTLE_BODY && EFI_PROD_CODE
   lua_register(lState, "getEtbTarget", [](lua_State* l) {
     auto controller = engine->etbControllers[0];
@@ -860,6 +900,15 @@ void configureRusefiLuaHooks(lua_State* lState) {
 		engine->engineState.lua.fuelMult = luaL_checknumber(l, 1);
 		return 0;
 	});
+	lua_register(lState, "setWallFuelTrim", [](lua_State* l) {
+		// index starting from 1
+		auto humanCylinderIdx = luaL_checkinteger(l, 1);
+		auto alphaTrim = luaL_checknumber(l, 2);
+		auto betaTrim = luaL_checknumber(l, 3);
+
+		engine->module<WallFuelController>().unmock().setCylinderTrim(humanCylinderIdx - HUMAN_OFFSET, alphaTrim, betaTrim);
+		return 0;
+	});
 #if EFI_ELECTRONIC_THROTTLE_BODY && EFI_PROD_CODE
 	lua_register(lState, "setEtbAdd", [](lua_State* l) {
 		auto luaAdjustment = luaL_checknumber(l, 1);
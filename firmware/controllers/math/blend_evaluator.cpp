@@ -0,0 +1,137 @@
+/**
+ * @file blend_evaluator.cpp
+ *
+ * see blend_evaluator.h
+ */
+
+#include "pch.h"
+
+#include "blend_evaluator.h"
+#include "gppwm_channel_reader.h"
+
+#if EFI_ENGINE_CONTROL
+
+static blend_table_s& getBlendConfig(BlendSet set, size_t index) {
+	switch (set) {
+	case BlendSet::Ignition:
+		return config->ignBlends[index];
+	case BlendSet::BoostOpenLoop:
+		return config->boostOpenLoopBlends[index];
+	case BlendSet::BoostClosedLoop:
+		return config->boostClosedLoopBlends[index];
+	case BlendSet::Ve:
+	default:
+		return config->veBlends[index];
+	}
+}
+
+template <typename TFunc>
+void BlendEvaluator::forEachSlot(TFunc func) {
+	for (size_t i = 0; i < efi::size(m_ve); i++) {
+		func(m_ve[i], config->veBlends[i]);
+	}
+	for (size_t i = 0; i < efi::size(m_ignition); i++) {
+		func(m_ignition[i], config->ignBlends[i]);
+	}
+	for (size_t i = 0; i < efi::size(m_boostOpenLoop); i++) {
+		func(m_boostOpenLoop[i], config->boostOpenLoopBlends[i]);
+	}
+	for (size_t i = 0; i < efi::size(m_boostClosedLoop); i++) {
+		func(m_boostClosedLoop[i], config->boostClosedLoopBlends[i]);
+	}
+}
+
+BlendEvaluator::Slot* BlendEvaluator::getSlot(BlendSet set, size_t index) {
+	switch (set) {
+	case BlendSet::Ve:
+		return index < efi::size(m_ve) ? &m_ve[index] : nullptr;
+	case BlendSet::Ignition:
+		return index < efi::size(m_ignition) ? &m_ignition[index] : nullptr;
+	case BlendSet::BoostOpenLoop:
+		return index < efi::size(m_boostOpenLoop) ? &m_boostOpenLoop[index] : nullptr;
+	case BlendSet::BoostClosedLoop:
+		return index < efi::size(m_boostClosedLoop) ? &m_boostClosedLoop[index] : nullptr;
+	}
+
+	return nullptr;
+}
+
+void BlendEvaluator::onConfigurationChange(engine_configuration_s const * /*previousConfig*/) {
+	forEachSlot([](Slot& slot, blend_table_s& cfg) {
+		slot = Slot();
+		slot.isEnabled = cfg.blendParameter != GPPWM_Zero;
+	});
+
+	m_isInitialized = true;
+}
+
+void BlendEvaluator::latchInputs() {
+	if (!m_isInitialized) {
+		onConfigurationChange(nullptr);
+	}
+
+	forEachSlot([](Slot& slot, blend_table_s& cfg) {
+		if (!slot.isEnabled) {
+			return;
+		}
+
+		auto parameter = readGppwmChannel(cfg.blendParameter);
+
+		bool hasYAxisOverride = cfg.yAxisOverride != GPPWM_Zero;
+		// TODO: is this value_or(0) correct or even reasonable?
+		float yAxisOverride = hasYAxisOverride ? readGppwmChannel(cfg.yAxisOverride).value_or(0) : 0;
+
+		chibios_rt::CriticalSectionLocker csl;
+
+		slot.hasParameter = parameter.Valid;
+		slot.parameter = parameter.Value;
+		slot.hasYAxisOverride = hasYAxisOverride;
+		slot.yAxisOverride = yAxisOverride;
+		slot.isCached = false;
+	});
+}
+
+BlendResult BlendEvaluator::get(BlendSet set, size_t index, float rpm, float load) {
+	Slot* slot = getSlot(set, index);
+
+	if (!slot || !slot->isEnabled) {
+		return { 0, 0, 0 };
+	}
+
+	float parameter;
+
+	{
+		// Lua asks too, the cache must not hand out what was looked up for someone else's RPM/load
+		chibios_rt::CriticalSectionLocker csl;
+
+		if (!slot->hasParameter) {
+			return { 0, 0, 0 };
+		}
+
+		if (slot->hasYAxisOverride) {
+			load = slot->yAxisOverride;
+		}
+
+		if (slot->isCached && slot->rpm == rpm && slot->load == load) {
+			return slot->result;
+		}
+
+		parameter = slot->parameter;
+	}
+
+	// Table lookup itself stays outside of the critical section
+	BlendResult result = evaluateBlend(getBlendConfig(set, index), parameter, rpm, load);
+
+	{
+		chibios_rt::CriticalSectionLocker csl;
+
+		slot->result = result;
+		slot->rpm = rpm;
+		slot->load = load;
+		slot->isCached = true;
+	}
+
+	return result;
+}
+
+#endif // EFI_ENGINE_CONTROL
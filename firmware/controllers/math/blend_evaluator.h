@@ -0,0 +1,65 @@
+/**
+ * @file blend_evaluator.h
+ *
+ * Blend tables are looked up by several consumers, some of them more than once per cycle.
+ * Blend parameter and Y axis override are read once per fast callback, table lookups are
+ * only redone when the consumer asks for a different RPM/load than last time.
+ * Lua reads airmass from its own thread, so the latched inputs and the cache are only
+ * touched in a critical section.
+ */
+
+#pragma once
+
+#include "engine_module.h"
+#include "engine_math.h"
+
+enum class BlendSet : uint8_t {
+	Ve,
+	Ignition,
+	BoostOpenLoop,
+	BoostClosedLoop,
+};
+
+class BlendEvaluator : public EngineModule {
+public:
+	// Disabled slots are found here so that the per-cycle work only covers the enabled ones
+	void onConfigurationChange(engine_configuration_s const * /*previousConfig*/) override;
+
+	/**
+	 * Reads blend parameters for the upcoming cycle, to be invoked before any consumer
+	 */
+	void latchInputs();
+
+	/**
+	 * Same result as calculateBlend() with the inputs latched by latchInputs()
+	 */
+	BlendResult get(BlendSet set, size_t index, float rpm, float load);
+
+private:
+	struct Slot {
+		bool isEnabled = false;
+
+		bool hasParameter = false;
+		float parameter = 0;
+		bool hasYAxisOverride = false;
+		float yAxisOverride = 0;
+
+		// most recent lookup
+		bool isCached = false;
+		float rpm = 0;
+		float load = 0;
+		BlendResult result = { 0, 0, 0 };
+	};
+
+	template <typename TFunc>
+	void forEachSlot(TFunc func);
+
+	Slot* getSlot(BlendSet set, size_t index);
+
+	bool m_isInitialized = false;
+
+	Slot m_ve[VE_BLEND_COUNT];
+	Slot m_ignition[IGN_BLEND_COUNT];
+	Slot m_boostOpenLoop[BOOST_BLEND_COUNT];
+	Slot m_boostClosedLoop[BOOST_BLEND_COUNT];
+};
@@ -16,7 +16,7 @@ static Deadband<25> idleDeadband;
 static Deadband<2> overrunDeadband;
 static Deadband<2> loadDeadband;
 
-static SensorType getSensorForBankIndex(size_t index) {
+SensorType getSensorForBankIndex(size_t index) {
 	switch (index) {
 		case 0: return SensorType::Lambda1;
 		case 1: return SensorType::Lambda2;
@@ -47,7 +47,7 @@ size_t computeStftBin(float rpm, float load, stft_s& cfg) {
 	return 3;
 }
 
-static bool shouldCorrect() {
+bool shouldCorrect() {
 	const auto& cfg = engineConfiguration->stft;
 
 	// User disable bit
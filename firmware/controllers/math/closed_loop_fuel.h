@@ -16,3 +16,6 @@ struct ClosedLoopFuelResult {
 ClosedLoopFuelResult fuelClosedLoopCorrection();
 size_t computeStftBin(float rpm, float load, stft_s& cfg);
 bool shouldUpdateCorrection(SensorType sensor);
+// Engine conditions for closed loop fuel, regardless of sensor
+bool shouldCorrect();
+SensorType getSensorForBankIndex(size_t index);
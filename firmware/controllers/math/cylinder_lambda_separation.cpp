@@ -0,0 +1,213 @@
+#include "pch.h"
+
+#include "cylinder_lambda_separation.h"
+#include "closed_loop_fuel.h"
+
+#if EFI_ENGINE_CONTROL
+
+PUBLIC_API_WEAK float getCylinderExhaustDelayMs(size_t /*cylinderIndex*/, float rpm, float load) {
+	float flow = std::max(rpm * load, (float)LAMBDA_SEPARATION_MIN_FLOW);
+
+	return LAMBDA_SEPARATION_SENSOR_DELAY_MS + LAMBDA_SEPARATION_PIPE_DELAY_MS * LAMBDA_SEPARATION_REFERENCE_FLOW / flow;
+}
+
+void CylinderLambdaSeparation::onConfigurationChange(engine_configuration_s const * /*previousConfig*/) {
+	if (!engineConfiguration->cylinderLambdaSeparation) {
+		reset();
+	}
+}
+
+void CylinderLambdaSeparation::reset() {
+	m_isActive = false;
+
+	for (size_t i = 0; i < MAX_CYLINDER_COUNT; i++) {
+		m_samples[i] = {};
+		m_lambda[i] = NAN;
+	}
+
+	memset(m_trims, 0, sizeof(m_trims));
+}
+
+void CylinderLambdaSeparation::onFastCallback() {
+	float rpm = Sensor::getOrZero(SensorType::Rpm);
+	float load = getFuelingLoad();
+
+	if (m_isActive) {
+		learn(rpm, load);
+	}
+
+	// Sample is attributed by engine phase, that needs full sync
+	m_isActive = engineConfiguration->cylinderLambdaSeparation
+		&& shouldCorrect()
+		&& engine->triggerCentral.triggerState.hasSynchronizedPhase()
+		&& rpm * load > LAMBDA_SEPARATION_MIN_FLOW;
+
+	if (!m_isActive) {
+		for (size_t i = 0; i < MAX_CYLINDER_COUNT; i++) {
+			m_samples[i] = {};
+		}
+
+		return;
+	}
+
+	for (size_t i = 0; i < STFT_BANK_COUNT; i++) {
+		m_isBankActive[i] = shouldUpdateCorrection(getSensorForBankIndex(i));
+	}
+
+	size_t cylindersCount = engineConfiguration->cylindersCount;
+	m_windowWidth = engine->engineState.engineCycle / cylindersCount;
+
+	for (size_t i = 0; i < cylindersCount; i++) {
+		// Firing order is by cylinder number, everything here is indexed from zero
+		size_t cylinderIndex = ID2INDEX(getFiringOrderCylinderId(i));
+		float delayAngle = getCylinderExhaustDelayMs(cylinderIndex, rpm, load) / getOneDegreeTimeMs(rpm);
+
+		angle_t start = getPerCylinderFiringOrderOffset(i, cylinderIndex)
+			+ LAMBDA_SEPARATION_EXHAUST_OPEN_ANGLE
+			+ delayAngle;
+		wrapAngle(start, "lambdaSeparation", ObdCode::CUSTOM_ERR_CYL_ANGLE);
+
+		m_windowStart[cylinderIndex] = start;
+	}
+}
+
+void CylinderLambdaSeparation::onEnginePhase(angle_t currentPhase) {
+	if (!m_isActive) {
+		return;
+	}
+
+	float bankLambda[STFT_BANK_COUNT];
+	for (size_t i = 0; i < STFT_BANK_COUNT; i++) {
+		bankLambda[i] = m_isBankActive[i] ? Sensor::get(getSensorForBankIndex(i)).value_or(NAN) : NAN;
+	}
+
+	angle_t engineCycle = engine->engineState.engineCycle;
+
+	for (size_t i = 0; i < engineConfiguration->cylindersCount; i++) {
+		auto& samples = m_samples[i];
+
+		angle_t sinceStart = currentPhase - m_windowStart[i];
+		if (sinceStart < 0) {
+			sinceStart += engineCycle;
+		}
+
+		bool isInWindow = sinceStart < m_windowWidth;
+
+		if (isInWindow) {
+			float lambda = bankLambda[engineConfiguration->cylinderBankSelect[i]];
+
+			if (!std::isnan(lambda)) {
+				samples.sum += lambda;
+				samples.count++;
+			}
+		} else if (samples.isInWindow) {
+			// This cylinder's exhaust has passed the sensor
+			if (samples.count > 0) {
+				samples.cycleLambda = samples.sum / samples.count;
+				samples.isCycleReady = true;
+			}
+
+			samples.sum = 0;
+			samples.count = 0;
+		}
+
+		samples.isInWindow = isInWindow;
+	}
+}
+
+void CylinderLambdaSeparation::learn(float rpm, float load) {
+	size_t cylindersCount = engineConfiguration->cylindersCount;
+	bool hasNewCycle = false;
+
+	for (size_t i = 0; i < cylindersCount; i++) {
+		auto& samples = m_samples[i];
+
+		if (!samples.isCycleReady) {
+			continue;
+		}
+
+		samples.isCycleReady = false;
+		hasNewCycle = true;
+
+		if (std::isnan(m_lambda[i])) {
+			m_lambda[i] = samples.cycleLambda;
+		} else {
+			m_lambda[i] += LAMBDA_SEPARATION_FILTER_ALPHA * (samples.cycleLambda - m_lambda[i]);
+		}
+	}
+
+	if (!hasNewCycle) {
+		return;
+	}
+
+	size_t loadIndex = closestBin(config->fuelTrimLoadBins, load);
+	size_t rpmIndex = closestBin(config->fuelTrimRpmBins, rpm);
+
+	for (size_t bank = 0; bank < STFT_BANK_COUNT; bank++) {
+		// Only compare cylinders which have all been seen
+		float lambdaSum = 0;
+		size_t cylinderCount = 0;
+
+		for (size_t i = 0; i < cylindersCount; i++) {
+			if (engineConfiguration->cylinderBankSelect[i] != bank) {
+				continue;
+			}
+
+			if (std::isnan(m_lambda[i])) {
+				cylinderCount = 0;
+				break;
+			}
+
+			lambdaSum += m_lambda[i];
+			cylinderCount++;
+		}
+
+		// One cylinder is always its own average
+		if (cylinderCount < 2) {
+			continue;
+		}
+
+		float bankLambda = lambdaSum / cylinderCount;
+
+		// Lean cylinders get more fuel, bank average is left alone
+		float trimSum = 0;
+		for (size_t i = 0; i < cylindersCount; i++) {
+			if (engineConfiguration->cylinderBankSelect[i] != bank) {
+				continue;
+			}
+
+			float& trim = m_trims[i][loadIndex][rpmIndex];
+			trim += LAMBDA_SEPARATION_LEARN_RATE * (m_lambda[i] / bankLambda - 1);
+			trimSum += trim;
+		}
+
+		float trimAverage = trimSum / cylinderCount;
+
+		for (size_t i = 0; i < cylindersCount; i++) {
+			if (engineConfiguration->cylinderBankSelect[i] != bank) {
+				continue;
+			}
+
+			float& trim = m_trims[i][loadIndex][rpmIndex];
+			trim = clampF(-LAMBDA_SEPARATION_MAX_TRIM, trim - trimAverage, LAMBDA_SEPARATION_MAX_TRIM);
+		}
+	}
+}
+
+float CylinderLambdaSeparation::getCylinderLambda(size_t cylinderIndex) const {
+	return m_lambda[cylinderIndex];
+}
+
+float CylinderLambdaSeparation::getTrimMultiplier(size_t cylinderIndex, float rpm, float load) const {
+	if (!engineConfiguration->cylinderLambdaSeparation) {
+		return 1;
+	}
+
+	return 1 + interpolate3d(
+		m_trims[cylinderIndex],
+		config->fuelTrimLoadBins, load,
+		config->fuelTrimRpmBins, rpm
+	);
+}
+
+#endif // EFI_ENGINE_CONTROL
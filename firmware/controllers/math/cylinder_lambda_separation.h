@@ -0,0 +1,98 @@
+/**
+ * @file cylinder_lambda_separation.h
+ *
+ * Per-cylinder lambda from one wideband per bank: the sensor is sampled on every trigger tooth
+ * and each sample is attributed to the cylinder whose exhaust pulse is passing the sensor at that
+ * moment, accounting for the time the gas takes to get there.
+ *
+ * Cylinders leaner than their bank average get more fuel via a learned trim on top of the
+ * per-cylinder fuel trim table, with the same RPM/load bins. Bank average itself is still
+ * the job of closed loop fuel.
+ */
+
+#pragma once
+
+#include "engine_module.h"
+
+// Exhaust valve opening after that cylinder's TDC, the exhaust pulse lasts one firing interval from there
+#ifndef LAMBDA_SEPARATION_EXHAUST_OPEN_ANGLE
+#define LAMBDA_SEPARATION_EXHAUST_OPEN_ANGLE 140
+#endif
+
+// Sensor response including CAN if any
+#ifndef LAMBDA_SEPARATION_SENSOR_DELAY_MS
+#define LAMBDA_SEPARATION_SENSOR_DELAY_MS 40
+#endif
+
+// Exhaust transport time from valve to sensor at the reference flow, it scales inversely with RPM * load
+#ifndef LAMBDA_SEPARATION_PIPE_DELAY_MS
+#define LAMBDA_SEPARATION_PIPE_DELAY_MS 10
+#endif
+#define LAMBDA_SEPARATION_REFERENCE_FLOW (1000 * 100)
+// below this RPM * load the exhaust mixes too much on its way to tell cylinders apart
+#define LAMBDA_SEPARATION_MIN_FLOW (600 * 20)
+
+// per engine cycle
+#define LAMBDA_SEPARATION_FILTER_ALPHA 0.1f
+// trim change per engine cycle per unit of lambda deviation from the bank average
+#define LAMBDA_SEPARATION_LEARN_RATE 0.02f
+#define LAMBDA_SEPARATION_MAX_TRIM 0.1f
+
+/**
+ * Exhaust delay from valve to sensor for this cylinder (0 for #1), ms
+ * Default is the same for all cylinders, boards which know their exhaust manifold can do better
+ */
+float getCylinderExhaustDelayMs(size_t cylinderIndex, float rpm, float load);
+
+class CylinderLambdaSeparation : public EngineModule {
+public:
+	CylinderLambdaSeparation() {
+		reset();
+	}
+
+	void onConfigurationChange(engine_configuration_s const * /*previousConfig*/) override;
+
+	// Learns from the cycles completed since last time, and latches the sampling windows for the next ones
+	void onFastCallback() override;
+
+	/**
+	 * Called from the trigger on every tooth
+	 */
+	void onEnginePhase(angle_t currentPhase);
+
+	void reset();
+
+	// Filtered lambda of this cylinder (0 for #1), NAN until it has been seen
+	float getCylinderLambda(size_t cylinderIndex) const;
+
+	// Multiplier for this cylinder's fuel, on top of getCylinderFuelTrim
+	float getTrimMultiplier(size_t cylinderIndex, float rpm, float load) const;
+
+private:
+	void learn(float rpm, float load);
+
+	bool m_isActive = false;
+	bool m_isBankActive[STFT_BANK_COUNT] = {};
+
+	// Engine phase at which each cylinder's exhaust reaches the sensor
+	angle_t m_windowStart[MAX_CYLINDER_COUNT] = {};
+	angle_t m_windowWidth = 0;
+
+	// Written from the trigger
+	struct CylinderSamples {
+		float sum = 0;
+		uint16_t count = 0;
+		bool isInWindow = false;
+
+		// Average of the last complete window, consumed by learn()
+		float cycleLambda = 0;
+		bool isCycleReady = false;
+	};
+
+	CylinderSamples m_samples[MAX_CYLINDER_COUNT];
+
+	float m_lambda[MAX_CYLINDER_COUNT];
+
+	// fraction, same bins as config->fuelTrims
+	float m_trims[MAX_CYLINDER_COUNT][FUEL_TRIM_SIZE][FUEL_TRIM_SIZE];
+};
@@ -483,15 +483,19 @@ BlendResult calculateBlend(blend_table_s& cfg, float rpm, float load) {
 		load = readGppwmChannel(cfg.yAxisOverride).value_or(0);
 	}
 
+	return evaluateBlend(cfg, value.Value, rpm, load);
+}
+
+BlendResult evaluateBlend(blend_table_s& cfg, float blendParameter, float rpm, float load) {
 	float tableValue = interpolate3d(
 		cfg.table,
 		cfg.loadBins, load,
 		cfg.rpmBins, rpm
 	);
 
-	float blendFactor = interpolate2d(value.Value, cfg.blendBins, cfg.blendValues);
+	float blendFactor = interpolate2d(blendParameter, cfg.blendBins, cfg.blendValues);
 
-	return { value.Value, blendFactor, 0.01f * blendFactor * tableValue };
+	return { blendParameter, blendFactor, 0.01f * blendFactor * tableValue };
 }
 
 #endif /* EFI_ENGINE_CONTROL */
@@ -67,3 +67,7 @@ struct BlendResult {
 };
 
 BlendResult calculateBlend(blend_table_s& cfg, float rpm, float load);
+/**
+ * Table lookup part of calculateBlend() for an already known blend parameter, Y axis override already applied
+ */
+BlendResult evaluateBlend(blend_table_s& cfg, float blendParameter, float rpm, float load);
@@ -1,8 +1,10 @@
 
 CONTROLLERS_MATH_SRC_CPP = $(PROJECT_DIR)/controllers/math/engine_math.cpp \
+	$(PROJECT_DIR)/controllers/math/blend_evaluator.cpp \
 	$(PROJECT_DIR)/controllers/math/speed_density.cpp \
 	$(PROJECT_DIR)/controllers/math/closed_loop_fuel.cpp \
 	$(PROJECT_DIR)/controllers/math/closed_loop_fuel_cell.cpp \
+	$(PROJECT_DIR)/controllers/math/cylinder_lambda_separation.cpp \
 	$(PROJECT_DIR)/controllers/math/lambda_monitor.cpp \
 	$(PROJECT_DIR)/controllers/math/throttle_model.cpp \
 
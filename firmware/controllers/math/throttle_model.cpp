@@ -73,8 +73,53 @@ private:
 	}
 };
 
+void ThrottleModelBase::updateAreaTable() const {
+	float maxArea = 0;
+	for (size_t i = 0; i < THROTTLE_MODEL_AREA_POINTS; i++) {
+		// A throttle never flows less when opened further, flatten any dip in the curve
+		maxArea = std::max(maxArea, effectiveArea(i));
+		m_areaTable[i] = maxArea;
+	}
+
+	m_isAreaTableValid = true;
+}
+
+float ThrottleModelBase::throttlePositionForArea(float area) const {
+	if (!m_isAreaTableValid) {
+		updateAreaTable();
+	}
+
+	if (area <= m_areaTable[0]) {
+		return 0;
+	}
+
+	constexpr size_t last = THROTTLE_MODEL_AREA_POINTS - 1;
+	if (area >= m_areaTable[last]) {
+		return last;
+	}
+
+	// first point at or above the requested area
+	size_t high = std::lower_bound(m_areaTable, m_areaTable + last, area) - m_areaTable;
+	size_t low = high - 1;
+
+	return interpolateMsg("throttle area", m_areaTable[low], low, m_areaTable[high], high, area);
+}
+
 // Find the throttle position that gives the specified flow
 float ThrottleModelBase::throttlePositionForFlow(float flow, float pressureRatio, float p_up, float iat) const {
+	float flowCorrection = flowCorrections(pressureRatio, p_up, iat);
+
+	// If the target flow is more than the throttle can flow, return 100% since the throttle
+	// can't open any further
+	if (flow > partThrottleFlow(100, flowCorrection)) {
+		return 100;
+	}
+
+	// Flow is area times a correction that does not depend on TPS, so only the area curve needs inverting
+	return throttlePositionForArea(flow / flowCorrection);
+}
+
+float ThrottleModelBase::solveThrottlePositionForFlow(float flow, float pressureRatio, float p_up, float iat) const {
 	// What does the bare throttle flow at wide open?
 	float wideOpenFlow = partThrottleFlow(100, pressureRatio, p_up, iat);
 
@@ -136,6 +181,11 @@ expected<float> ThrottleModelBase::estimateThrottleFlow(float map, float tps) {
 	return estimateThrottleFlow(tip.Value, tps, map, iat.Value);
 }
 
+void ThrottleModelBase::onConfigurationChange(engine_configuration_s const * /*previousConfig*/) {
+	// effective area table may have been edited
+	invalidateAreaTable();
+}
+
 void ThrottleModelBase::onSlowCallback() {
 	throttleEstimatedFlow = estimateThrottleFlow(Sensor::getOrZero(SensorType::Map), Sensor::getOrZero(SensorType::Tps1)).value_or(0);
 }
@@ -2,11 +2,15 @@
 
 #include "throttle_model_generated.h"
 
+// effective area is tabulated at 1% TPS steps
+#define THROTTLE_MODEL_AREA_POINTS 101
+
 struct ThrottleModelBase : public throttle_model_s, public EngineModule {
 public:
 	using interface_t = ThrottleModelBase;
 
 	void onSlowCallback() override;
+	void onConfigurationChange(engine_configuration_s const * /*previousConfig*/) override;
 
 	float estimateThrottleFlow(float tip, float tps, float map, float iat);
 	expected<float> estimateThrottleFlow(float map, float tps);
@@ -15,6 +19,15 @@ public:
 	float partThrottleFlow(float tps, float pressureRatio, float p_up, float iat) const;
 
 	float throttlePositionForFlow(float flow, float pressureRatio, float p_up, float iat) const;
+	// Reference implementation of throttlePositionForFlow, iterates on effectiveArea
+	float solveThrottlePositionForFlow(float flow, float pressureRatio, float p_up, float iat) const;
+
+	// Inverse of effectiveArea via the tabulated area curve, no solver iterations
+	float throttlePositionForArea(float area) const;
+
+	void invalidateAreaTable() {
+		m_isAreaTableValid = false;
+	}
 
 protected:
 	// Given some TPS, what is the normalized choked flow in g/s?
@@ -23,6 +36,12 @@ protected:
 	// Given some MAP, what is the most the engine can pull through a wide open throttle, in g/s?
 	virtual float maxEngineFlow(float map) const = 0;
 
+private:
+	void updateAreaTable() const;
+
+	// effectiveArea sampled at 0, 1, ... 100% TPS, made non-decreasing so that it can be inverted
+	mutable float m_areaTable[THROTTLE_MODEL_AREA_POINTS];
+	mutable bool m_isAreaTableValid = false;
 };
 
 class ThrottleModel : public ThrottleModelBase {
@@ -18,9 +18,11 @@
 #include "local_version_holder.h"
 #include "trigger_simulator.h"
 #include "trigger_emulator_algo.h"
+#include "log_histogram.h"
 
 #include "map_averaging.h"
 #include "main_trigger_callback.h"
+#include "tachometer.h"
 #include "status_loop.h"
 #include "engine_sniffer.h"
 #include "auto_generated_sync_edge.h"
@@ -420,6 +422,9 @@ void handleVvtCamSignal(TriggerValue front, efitick_t nowNt, int index) {
 	// Only record VVT position if we have full engine sync - may be bogus before that point
 	if (tc->triggerState.hasSynchronizedPhase()) {
 		tc->vvtPosition[bankIndex][camIndex] = vvtPosition;
+#if EFI_VVT_PID
+		getVvtController(index)->onCamMeasurement(nowNt);
+#endif // EFI_VVT_PID
 	} else {
 		tc->vvtPosition[bankIndex][camIndex] = 0;
 	}
@@ -531,6 +536,7 @@ void handleShaftSignal(int signalIndex, bool isRising, efitick_t timestamp) {
 	triggerReentrant--;
 	triggerDuration = getTimeNowLowerNt() - triggerHandlerEntryTime;
 	triggerMaxDuration = maxI(triggerMaxDuration, triggerDuration);
+	getLatencyHistogram(LatencyHistogram::TriggerIsr).add(triggerDuration);
 }
 
 void TriggerCentral::resetCounters() {
@@ -864,6 +870,13 @@ void TriggerCentral::handleShaftSignal(trigger_event_e signal, efitick_t timesta
 		// Handle ignition and injection
 		mainTriggerCallback(triggerIndexForListeners, timestamp, currentEngineDecodedPhase, nextPhase);
 
+		// Tachometer pulses are scheduled just like sparks
+		tachSignalCallback(timestamp, currentEngineDecodedPhase, nextPhase);
+
+#if EFI_ENGINE_CONTROL
+		engine->module<CylinderLambdaSeparation>()->onEnginePhase(currentEngineDecodedPhase);
+#endif // EFI_ENGINE_CONTROL
+
 		// Decode the MAP based "cam" sensor
 		decodeMapCam(timestamp, currentEngineDecodedPhase);
 	} else {
@@ -32,7 +32,9 @@ struct TraceEntry
 // Ensure that the struct is the size we think it is - the binary layout is important
 static_assert(sizeof(TraceEntry) == 8);
 
-#define TRACE_BUFFER_LENGTH (BIG_BUFFER_SIZE / sizeof(TraceEntry))
+// Half of the big buffer so that a tooth log of the same event can be captured alongside
+#define TRACE_BUFFER_SIZE (BIG_BUFFER_SIZE / 2)
+#define TRACE_BUFFER_LENGTH (TRACE_BUFFER_SIZE / sizeof(TraceEntry))
 
 // This buffer stores a trace - we write the full buffer once, then disable tracing
 static BigBufferHandle s_traceBuffer;
@@ -117,15 +119,7 @@ void perfEventInstantGlobal(PE event) {
 }
 
 void perfTraceEnable() {
-#if EFI_TOOTH_LOGGER
-	// force release of the buffer if occupied by the tooth logger
-	if (IsToothLoggerEnabled()) {
-		// don't worry, it will be automatically enabled
-		// when the next TS_GET_COMPOSITE_BUFFER_DONE_DIFFERENTLY command arrives
-		DisableToothLogger();
-	}
-#endif // EFI_TOOTH_LOGGER
-	s_traceBuffer = getBigBuffer(BigBufferUser::PerfTrace);
+	s_traceBuffer = getBigBuffer(BigBufferUser::PerfTrace, TRACE_BUFFER_SIZE);
 	s_isTracing = true;
 }
 
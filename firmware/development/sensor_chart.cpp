@@ -10,67 +10,78 @@
 #include "sensor_chart.h"
 
 #if EFI_SENSOR_CHART
-#include "status_loop.h"
 
-#if EFI_TEXT_LOGGING
-static char LOGGING_BUFFER[SC_BUFFER_SIZE] CCM_OPTIONAL;
-static Logging scLogging("analog chart", LOGGING_BUFFER, sizeof(LOGGING_BUFFER));
-#endif /* EFI_TEXT_LOGGING */
+#define SC_BIN_WIDTH_DEG (720.0f / SC_BIN_COUNT)
 
 static int initialized = false;
 
 enum class ScState {
-	PreArm,
+	// waiting for the engine phase to wrap so that we start at the beginning of a cycle
 	Armed,
 	Logging,
 	Full
 };
 
-static ScState state = ScState::PreArm;
-static uint32_t lastRevCount = 0;
+static BigBufferHandle buffer;
+static SensorChartCapture* capture = nullptr;
 
+static ScState state = ScState::Armed;
+static float lastAngle = 0;
+
+// TS is sending the capture, the buffer must stay ours until it is returned
+static bool isReadOut = false;
+static bool isReleasePending = false;
+
+static void resetCapture(sensor_chart_e mode) {
+	memset(capture, 0, sizeof(*capture));
+	capture->mode = mode;
+	capture->binCount = SC_BIN_COUNT;
+	capture->binWidthDeg = SC_BIN_WIDTH_DEG;
+
+	state = ScState::Armed;
+}
+
+/**
+ * Invoked from trigger and fast ADC callbacks, so only binary bookkeeping here
+ */
 void scAddData(float angle, float value) {
-#if EFI_TEXT_LOGGING
-	if (!initialized) {
+	if (!initialized || !capture) {
 		return; // this is possible because of initialization sequence
 	}
 
-	// Don't log if we need a flush
+	// Don't log until the host has read the capture
 	if (state == ScState::Full) {
 		return;
 	}
 
-	auto currentRev = getRevolutionCounter();
+	bool isNewCycle = angle < lastAngle;
+	lastAngle = angle;
 
-	if (state == ScState::PreArm) {
-		// nothing to do - we just need to grab the rev counter once so we can detect a change
-		state = ScState::Armed;
-	} else if (state == ScState::Armed) {
-		// If armed, wait for a NEW revolution to start
-		if (lastRevCount != currentRev) {
-			state = ScState::Logging;
-
-			// Reset logging and append header
-			scLogging.reset();
-			scLogging.appendPrintf(PROTOCOL_ANALOG_CHART LOG_DELIMITER);
+	if (state == ScState::Armed) {
+		if (!isNewCycle) {
+			return;
 		}
-	} else if (state == ScState::Logging) {
-		// If running and the revolution idx changes, terminate logging and wait for flush
-		if (lastRevCount != currentRev) {
+		state = ScState::Logging;
+	} else if (isNewCycle) {
+		capture->cycleCount++;
+		if (capture->cycleCount >= SC_CYCLE_COUNT) {
+			capture->isComplete = true;
 			state = ScState::Full;
+			return;
 		}
 	}
 
-	lastRevCount = currentRev;
+	int binIndex = angle / SC_BIN_WIDTH_DEG;
+	if (binIndex < 0 || binIndex >= SC_BIN_COUNT) {
+		return;
+	}
 
-	if (state == ScState::Logging) {
-		if (scLogging.remainingSize() > 100) {
-			scLogging.appendPrintf( "%.2f|%.2f|", angle, value);
-		} else {
-			state = ScState::Full;
-		}
+	// running average, in place
+	SensorChartBin& bin = capture->bins[binIndex];
+	if (bin.sampleCount < UINT16_MAX) {
+		bin.sampleCount++;
+		bin.value += (value - bin.value) / bin.sampleCount;
 	}
-#endif /* EFI_TEXT_LOGGING */
 }
 
 void initSensorChart(void) {
@@ -81,15 +92,77 @@ void initSensorChart(void) {
 	initialized = true;
 }
 
-void publishSensorChartIfFull() {
-	if (state != ScState::Full) {
+// also invoked when a higher priority big buffer user needs the space
+static void releaseCapture() {
+	chibios_rt::CriticalSectionLocker csl;
+
+	if (isReadOut) {
+		// that user will have to try again, sensorChartReturnCapture releases the buffer
+		isReleasePending = true;
 		return;
 	}
 
-	scLogging.appendPrintf(LOG_DELIMITER);
-	scheduleLogging(&scLogging);
+	// let somebody else have the buffer
+	capture = nullptr;
+	buffer = {};
+}
+
+void updateSensorChart() {
+	sensor_chart_e mode = getEngineState()->sensorChartMode;
 
-	state = ScState::Armed;
+	if (mode == SC_OFF) {
+		releaseCapture();
+		return;
+	}
+
+	if (!buffer) {
+		// lowest priority user: we get the buffer only if there is room left by the others
+		BigBufferHandle newBuffer = getBigBuffer(BigBufferUser::SensorChart, sizeof(SensorChartCapture), releaseCapture);
+		if (!newBuffer) {
+			return;
+		}
+
+		chibios_rt::CriticalSectionLocker csl;
+		buffer = efi::move(newBuffer);
+		capture = buffer.get<SensorChartCapture>();
+		resetCapture(mode);
+		return;
+	}
+
+	chibios_rt::CriticalSectionLocker csl;
+	if (capture && !isReadOut && capture->mode != mode) {
+		resetCapture(mode);
+	}
+}
+
+const SensorChartCapture* sensorChartGetCapture() {
+	chibios_rt::CriticalSectionLocker csl;
+
+	if (capture) {
+		isReadOut = true;
+	}
+
+	return capture;
+}
+
+void sensorChartReturnCapture() {
+	{
+		chibios_rt::CriticalSectionLocker csl;
+
+		isReadOut = false;
+
+		if (!isReleasePending) {
+			if (capture && state == ScState::Full) {
+				resetCapture((sensor_chart_e)capture->mode);
+			}
+
+			return;
+		}
+
+		isReleasePending = false;
+	}
+
+	releaseCapture();
 }
 
 #endif /* EFI_SENSOR_CHART */
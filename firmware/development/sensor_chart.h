@@ -1,6 +1,10 @@
 /**
  * @file	sensor_chart.h
  *
+ * Sensor chart captures one signal selected by sensorChartMode in the crank angle domain:
+ * samples are binned by engine phase and averaged in place over SC_CYCLE_COUNT engine cycles,
+ * the result is read out in binary with TS_SENSOR_CHART_READ.
+ *
  * @date Dec 20, 2013
  * @author Andrey Belomutskiy, (c) 2012-2020
  */
@@ -8,7 +12,46 @@
 #pragma once
 
 #include "global.h"
+#include "big_buffer.h"
+
+#ifndef SC_BIN_COUNT
+#define SC_BIN_COUNT 720
+#endif
+
+#ifndef SC_CYCLE_COUNT
+#define SC_CYCLE_COUNT 8
+#endif
+
+struct SensorChartBin {
+	// average of all samples which fell into this bin
+	float value;
+	uint16_t sampleCount;
+	uint16_t pad;
+};
+
+/**
+ * Binary layout of the TS_SENSOR_CHART_READ response, little endian
+ */
+struct SensorChartCapture {
+	// sensor_chart_e
+	uint8_t mode;
+	uint8_t isComplete;
+	uint16_t cycleCount;
+	uint16_t binCount;
+	uint16_t pad;
+	// bin 0 starts at engine phase zero
+	float binWidthDeg;
+	SensorChartBin bins[SC_BIN_COUNT];
+};
+
+static_assert(sizeof(SensorChartCapture) <= BIG_BUFFER_SIZE);
 
 void scAddData(float angle, float value);
 void initSensorChart(void);
-void publishSensorChartIfFull();
+// acquires or releases the big buffer according to current sensorChartMode
+void updateSensorChart();
+
+// nullptr if sensor chart is not running, otherwise the buffer is held until sensorChartReturnCapture
+const SensorChartCapture* sensorChartGetCapture();
+// host is done with the capture: once complete, start averaging a new one
+void sensorChartReturnCapture();
@@ -10,6 +10,9 @@
 #include "efi_gpio.h"
 
 #include "error_handling.h"
+#include "malfunction_central.h"
+#include "idle_air_learning.h"
+#include "gear_ratio_learning.h"
 
 enum class backup_ram_e {
 	/**
@@ -68,6 +71,15 @@ struct BackupSramData {
 		uint32_t BootCountCookie;
 	} Err;
 
+	// Trouble codes with their freeze frames, see malfunction_central.cpp
+	DtcBackup Dtc;
+
+	// Learned idle air, see idle_thread.cpp
+	IdleAirLearningBackup IdleAir;
+
+	// Learned gear ratios, see gear_detector.cpp
+	GearRatioLearningBackup GearRatios;
+
 };
 
 BackupSramData* getBackupSram();
@@ -21,6 +21,7 @@
 #include "can_msg_tx.h"
 #include "string.h"
 #include "mpu_util.h"
+#include "log_histogram.h"
 
 static bool isCanEnabled = false;
 
@@ -68,7 +69,9 @@ public:
 			// Process the message
 			engine->outputChannels.canReadCounter++;
 
-			processCanRxMessage(m_index, m_buffer, getTimeNowNt());
+			efitick_t rxNt = getTimeNowNt();
+			processCanRxMessage(m_index, m_buffer, rxNt);
+			getLatencyHistogram(LatencyHistogram::CanRx).add(getTimeNowNt() - rxNt);
 		}
 	}
 
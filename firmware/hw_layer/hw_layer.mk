@@ -19,6 +19,8 @@ HW_LAYER_CPP = \
 	$(PROJECT_DIR)/hw_layer/hardware.cpp \
 	$(PROJECT_DIR)/hw_layer/ports/arm_common.cpp \
 	$(PROJECT_DIR)/hw_layer/kline.cpp \
+	$(PROJECT_DIR)/hw_layer/kline_transport.cpp \
+	$(PROJECT_DIR)/hw_layer/kline_protocols.cpp \
 	$(PROJECT_DIR)/hw_layer/mmc_card.cpp \
 	$(PROJECT_DIR)/hw_layer/adc/adc_inputs.cpp \
 	$(PROJECT_DIR)/hw_layer/adc/adc_inputs_onchip.cpp \
@@ -27,6 +29,7 @@ HW_LAYER_CPP = \
 	$(PROJECT_DIR)/hw_layer/sensors/hip9011.cpp \
 	$(PROJECT_DIR)/hw_layer/sensors/hip9011_logic.cpp \
 	$(PROJECT_DIR)/hw_layer/mc33816.cpp \
+	$(PROJECT_DIR)/hw_layer/mc33816_profile.cpp \
 	$(PROJECT_DIR)/hw_layer/stepper.cpp \
 	$(PROJECT_DIR)/hw_layer/stepper_dual_hbridge.cpp \
 	$(PROJECT_DIR)/hw_layer/io_pins.cpp \
@@ -1,12 +1,12 @@
 /**
- * this file is mostly about SEFMJ early 2000s specific honda K-line protocol
- * https://rusefi.com/forum/viewtopic.php?f=4&t=2514
+ * K-line serial port and thread, everything about framing is in kline_transport.cpp
+ * and about the devices on the other end in kline_protocols.cpp
  */
 
 #include "pch.h"
 #include "kline.h"
+#include "kline_protocols.h"
 #include "hellen_meta.h"
-#include "crc8hondak.h"
 
 size_t readWhileGives(ByteSource source, uint8_t *buffer, size_t bufferSize) {
         size_t totalBytes = 0;
@@ -23,134 +23,106 @@ size_t readWhileGives(ByteSource source, uint8_t *buffer, size_t bufferSize) {
 
 #ifdef EFI_KLINE
 
-static uint8_t kvalues[8];
+static SerialDriver* const klDriver = &KLINE_SERIAL_DEVICE;
+static THD_WORKING_AREA(klThreadStack, UTILITY_THREAD_STACK_SIZE);
 
-#define HONDA_K_BCM_STATUS_NIBBLE 0x0
-#define HONDA_K_BCM_REQ_NIBBLE 0x1
+static int totalBytes = 0;
 
-bool kAcRequestState;
+class KLineSerialPort final : public IKLinePort {
+public:
+	void write(const uint8_t* data, size_t size) override {
+		chnWrite(klDriver, data, size);
+	}
 
-static void handleHonda(uint8_t *bufferIn) {
+	void wakeup(uint32_t lowUs, uint32_t highUs) override {
+		driveTx(false);
+		chThdSleepMicroseconds(lowUs);
+		driveTx(true);
+		chThdSleepMicroseconds(highUs);
+		releaseTx();
+	}
 
-    // no headlights 0x40, with headlights 0x60
-	uint8_t statusByte1 = bufferIn[1];
-	// no cabin blower 0x06, with blower 0x86
-	uint8_t statusByte2 = bufferIn[2];
-    kAcRequestState = statusByte2 & 0x80;
-    if (engineConfiguration->verboseKLine) {
-        efiPrintf("honda status packet with 0x%02x 0x%02x state %d", statusByte1, statusByte2, kAcRequestState);
-    }
-}
+	void writeFiveBaud(uint8_t address) override {
+		// start bit, data bits LSB first, stop bit
+		driveTx(false);
+		chThdSleepMilliseconds(200);
+		for (int i = 0; i < 8; i++) {
+			driveTx(address & BIT(i));
+			chThdSleepMilliseconds(200);
+		}
+		driveTx(true);
+		chThdSleepMilliseconds(200);
+		releaseTx();
+	}
 
-static SerialDriver* const klDriver = &KLINE_SERIAL_DEVICE;
-static THD_WORKING_AREA(klThreadStack, UTILITY_THREAD_STACK_SIZE);
+	void discardRx() override {
+		uint8_t junk[16];
+		while (chnReadTimeout(klDriver, junk, sizeof(junk), TIME_IMMEDIATE) > 0) {
+		}
+	}
 
-static int totalBytes = 0;
+private:
+	// bit banging while the UART is parked
+	static void driveTx(bool isHigh) {
+#if EFI_PROD_CODE
+		ioportid_t port = getHwPort("K-Line TX", KLINE_SERIAL_DEVICE_TX);
+		ioportmask_t pin = getHwPin("K-Line TX", KLINE_SERIAL_DEVICE_TX);
+		palSetPadMode(port, pin, PAL_MODE_OUTPUT_PUSHPULL);
+		palWritePad(port, pin, isHigh);
+#else
+		UNUSED(isHigh);
+#endif /* EFI_PROD_CODE */
+	}
+
+	static void releaseTx() {
+#if EFI_PROD_CODE
+		palSetPadMode(getHwPort("K-Line TX", KLINE_SERIAL_DEVICE_TX), getHwPin("K-Line TX", KLINE_SERIAL_DEVICE_TX),
+			PAL_MODE_ALTERNATE(TS_SERIAL_AF));
+#endif /* EFI_PROD_CODE */
+	}
+};
+
+static KLineSerialPort klPort;
+static KLineTransport klTransport;
+
+static HondaKLineProtocol hondaProtocol;
+static Iso9141Protocol iso9141Protocol;
+static Kwp2000Protocol kwp2000Protocol;
+
+static KLineProtocol* const protocols[] = { &hondaProtocol, &iso9141Protocol, &kwp2000Protocol };
+// written from console, picked up by the thread
+static volatile size_t requestedProtocol = 0;
 
 void kLineThread(void*) {
-    // due to single wire we read everything we've transmitted
-    bool ignoreRecentTransmit = false;
-    int sendCounter = 0;
-    while (1) {
-
-        /**
-         * under the hood there is SERIAL_BUFFERS_SIZE which we hope to help us
-         */
-
-        uint8_t bufferIn[16];
-        // a bit of a busy read open question if this would affect performance?
-        // on 2003 Honda for instance the bus seems to be 70%-ish busy. 9600 baud is 1.04ms per byte, a bit below 1kHz
-        ByteSource serialSource = [] (uint8_t * buffer, int maxSize) {
-            return chnReadTimeout(klDriver,buffer, maxSize, TIME_US2I(engineConfiguration->kLinePeriodUs));
-        };
-        size_t len = readWhileGives(serialSource, bufferIn, sizeof(bufferIn));
-
-                    if (engineConfiguration->verboseKLine) {
-//                        efiPrintf("ignoreRecentTransmit %d", ignoreRecentTransmit);
-                    }
-
-        // to begin with just write byte to console
-        if (len > 0) {
-            if (engineConfiguration->verboseKLine) {
-                efiPrintf("kline: got count 0x%02x", len);
-            }
-            for (size_t i =0;i<len;i++) {
-                if (engineConfiguration->verboseKLine) {
-                    efiPrintf("kline: got 0x%02x", bufferIn[i]);
-                }
-                totalBytes++;
-            }
-            if (len > 1) {
-                int crc = crc_hondak_calc(bufferIn, len - 1);
-                uint8_t low = bufferIn[0] & 0xF;
-                if (crc == bufferIn[len - 1]) {
-                    if (engineConfiguration->verboseKLine) {
-                        efiPrintf("happy CRC 0x%02x", crc);
-                    }
-                    if (low == HONDA_K_BCM_STATUS_NIBBLE) {
-                        handleHonda(bufferIn);
-                    }
-
-                    if (low == HONDA_K_BCM_REQ_NIBBLE) {
-                        if (engineConfiguration->verboseKLine) {
-                            efiPrintf("BCM request 0x%02x", bufferIn[0]);
-                        }
-                    }
-
-                } else if (low == HONDA_K_BCM_STATUS_NIBBLE && bufferIn[4] == crc_hondak_calc(bufferIn, 4)) {
-                    if (engineConfiguration->verboseKLine) {
-                        efiPrintf("hack for now, happy CRC 0x%02x", crc);
-                    }
-                    handleHonda(bufferIn);
-                }
-
-
-                if (engineConfiguration->kLineDoHondaSend && !ignoreRecentTransmit) {
-                    sendCounter++;
-#define OUT_SIZE 6
-//                	const uint8_t out2[] = {0x2, 0x0, 0x0, 0x50, 0x0, 0x0};
-               	    //static_assert(sizeof(out2) == OUT_SIZE);
-//                	const uint8_t outB[] = {0x42, 0x0, 0x0, 0x50, 0x0, 0x0};
-//                	static_assert(sizeof(outB) == OUT_SIZE);
-                	//const uint8_t *out = (sendCounter % 3 == 0) ? outB : out2;
-//                	const uint8_t *out = out2;
-
-                    if (sendCounter % 30 == 0) {
-                        // no idea what this, maybe "i am running"?
-                        kvalues[0] = 0x82;
-                        kvalues[2] = 0x10;
-                    } else {
-                        kvalues[0] = 0x2;
-                        kvalues[2] = 0;
-                    }
-
-                    if (engineConfiguration->verboseKLine) {
-                        efiPrintf("kline doSend");
-                    }
-                    int positiveCltWithHighishValueInCaseOfSensorIssue = maxI(1,
-#ifdef HW_HELLEN_HONDA
-                        /* temporary while we are playing with calibration */
-                        config->hondaKcltGaugeAdder
-#else
-  50
-#endif
-                         + Sensor::get(SensorType::Clt).value_or(140)
-                    );
-    // 125 about horizontal
-    // 162 points at red mark, looks like gauge has hysteresis?
-    // value 200 way above red mark
-                    kvalues[3] = positiveCltWithHighishValueInCaseOfSensorIssue;
-
-                    chnWrite(klDriver, (const uint8_t *)kvalues, OUT_SIZE);
-                    crc = crc_hondak_calc(kvalues, OUT_SIZE);
-                    chnWrite(klDriver, (const uint8_t *)&crc, 1);
-                    ignoreRecentTransmit = true;
-                } else {
-                    ignoreRecentTransmit = false;
-                }
-            }
-        }
-    }
+	size_t activeProtocol = requestedProtocol;
+	klTransport.init(protocols[activeProtocol], &klPort, engineConfiguration->kLineBaudRate);
+
+	efidur_t timeoutNt = 0;
+	while (1) {
+		uint8_t bufferIn[16];
+		// sleep until the first byte or until the frame gap / protocol timer is due
+		size_t len = chnReadTimeout(klDriver, bufferIn, 1, TIME_US2I(NT2US(timeoutNt)));
+		if (len > 0) {
+			// whatever else is already in SERIAL_BUFFERS_SIZE comes for free
+			len += chnReadTimeout(klDriver, bufferIn + 1, sizeof(bufferIn) - 1, TIME_IMMEDIATE);
+			totalBytes += len;
+
+			if (engineConfiguration->verboseKLine) {
+				for (size_t i = 0; i < len; i++) {
+					efiPrintf("kline: got 0x%02x", bufferIn[i]);
+				}
+			}
+
+			klTransport.onRx(bufferIn, len, getTimeNowNt());
+		}
+
+		if (activeProtocol != requestedProtocol) {
+			activeProtocol = requestedProtocol;
+			klTransport.init(protocols[activeProtocol], &klPort, engineConfiguration->kLineBaudRate);
+		}
+
+		timeoutNt = klTransport.onIdle(getTimeNowNt());
+	}
 }
 #endif // EFI_KLINE
 
@@ -202,12 +174,12 @@ void initKLine() {
 #ifdef EFI_KLINE
 	startKLine();
 
-    memset(kvalues, 0, sizeof(kvalues));
-    kvalues[0] = 0x2;
-
     chThdCreateStatic(klThreadStack, sizeof(klThreadStack), NORMALPRIO + 1, kLineThread, nullptr);
     addConsoleAction("kline", [](){
-        efiPrintf("kline totalBytes %d", totalBytes);
+        efiPrintf("kline %s totalBytes %d", klTransport.getProtocol()->getName(), totalBytes);
+        efiPrintf("kline frames %lu invalid %lu overrun %lu echo %lu collisions %lu",
+            klTransport.getFrameCount(), klTransport.getInvalidFrameCount(), klTransport.getOverrunCount(),
+            klTransport.getEchoByteCount(), klTransport.getCollisionCount());
     });
     addConsoleAction("klineyes", [](){
         engineConfiguration->kLineDoHondaSend = true;
@@ -218,7 +190,13 @@ void initKLine() {
         efiPrintf("kline send %d", engineConfiguration->kLineDoHondaSend);
     });
     addConsoleActionII("temp_k", [](int index, int value) {
-        kvalues[index] = value;
+        hondaProtocol.setValue(index, value);
+    });
+    addConsoleActionI("kline_protocol", [](int index) {
+        if (index >= 0 && index < (int)efi::size(protocols)) {
+            requestedProtocol = index;
+        }
+        efiPrintf("kline protocol %s", protocols[requestedProtocol]->getName());
     });
 
 #endif // EFI_KLINE
@@ -0,0 +1,353 @@
+/**
+ * @file kline_protocols.cpp
+ *
+ * see kline_protocols.h
+ */
+
+#include "pch.h"
+#include "kline_protocols.h"
+#include "crc8hondak.h"
+
+#define HONDA_K_BCM_STATUS_NIBBLE 0x0
+#define HONDA_K_BCM_REQ_NIBBLE 0x1
+
+bool kAcRequestState;
+
+uint32_t HondaKLineProtocol::getFrameGapUs(uint32_t baudRate) const {
+	// on 2003 Honda for instance the bus seems to be 70%-ish busy, gaps between frames are short
+	uint32_t characterTimeUs = getKLineCharacterTimeUs(baudRate);
+	return characterTimeUs + std::max<uint32_t>(engineConfiguration->kLinePeriodUs, characterTimeUs / 2);
+}
+
+bool HondaKLineProtocol::isValidFrame(const uint8_t* frame, size_t size) const {
+	if (size < 2) {
+		return false;
+	}
+
+	if (crc_hondak_calc(frame, size - 1) == frame[size - 1]) {
+		return true;
+	}
+
+	// status frame immediately followed by something else
+	return (frame[0] & 0xF) == HONDA_K_BCM_STATUS_NIBBLE && size > 5 && frame[4] == crc_hondak_calc(frame, 4);
+}
+
+void HondaKLineProtocol::onFrame(KLineTransport& transport, const uint8_t* frame, size_t size, efitick_t nowNt) {
+	uint8_t low = frame[0] & 0xF;
+	if (low == HONDA_K_BCM_STATUS_NIBBLE && size >= 3) {
+		// no headlights 0x40, with headlights 0x60
+		uint8_t statusByte1 = frame[1];
+		// no cabin blower 0x06, with blower 0x86
+		uint8_t statusByte2 = frame[2];
+		kAcRequestState = statusByte2 & 0x80;
+		if (engineConfiguration->verboseKLine) {
+			efiPrintf("honda status packet with 0x%02x 0x%02x state %d", statusByte1, statusByte2, kAcRequestState);
+		}
+	} else if (low == HONDA_K_BCM_REQ_NIBBLE) {
+		if (engineConfiguration->verboseKLine) {
+			efiPrintf("BCM request 0x%02x", frame[0]);
+		}
+	}
+
+	if (!engineConfiguration->kLineDoHondaSend) {
+		return;
+	}
+
+	m_sendCounter++;
+	if (m_sendCounter % 30 == 0) {
+		// no idea what this, maybe "i am running"?
+		m_values[0] = 0x82;
+		m_values[2] = 0x10;
+	} else {
+		m_values[0] = 0x2;
+		m_values[2] = 0;
+	}
+
+	int positiveCltWithHighishValueInCaseOfSensorIssue = maxI(1,
+#ifdef HW_HELLEN_HONDA
+		/* temporary while we are playing with calibration */
+		config->hondaKcltGaugeAdder
+#else
+		50
+#endif
+		+ Sensor::get(SensorType::Clt).value_or(140)
+	);
+	// 125 about horizontal
+	// 162 points at red mark, looks like gauge has hysteresis?
+	// value 200 way above red mark
+	m_values[3] = positiveCltWithHighishValueInCaseOfSensorIssue;
+
+	uint8_t out[sizeof(m_values) + 1];
+	memcpy(out, m_values, sizeof(m_values));
+	out[sizeof(m_values)] = crc_hondak_calc(m_values, sizeof(m_values));
+	transport.send(out, sizeof(out), nowNt);
+}
+
+void HondaKLineProtocol::reset() {
+	memset(m_values, 0, sizeof(m_values));
+	m_values[0] = 0x2;
+	m_sendCounter = 0;
+}
+
+void HondaKLineProtocol::setValue(size_t index, uint8_t value) {
+	if (index < sizeof(m_values)) {
+		m_values[index] = value;
+	}
+}
+
+void KLineObdClient::setPids(const uint8_t* pids, size_t count) {
+	m_pidCount = std::min(count, (size_t)KLINE_MAX_PIDS);
+	memcpy(m_pids, pids, m_pidCount);
+	if (m_pidCount == 0) {
+		// supported PIDs request still keeps the session alive
+		m_pids[0] = 0x00;
+		m_pidCount = 1;
+	}
+	m_pidIndex = 0;
+}
+
+uint32_t KLineObdClient::getFrameGapUs(uint32_t /*baudRate*/) const {
+	return MS2US(KLINE_P1_MAX_MS);
+}
+
+void KLineObdClient::reset() {
+	setState(State::Disconnected, 0);
+	m_isWaitingResponse = false;
+	m_missedResponses = 0;
+	m_pidIndex = 0;
+}
+
+void KLineObdClient::onConnected(efitick_t nowNt) {
+	setState(State::Connected, nowNt + MS2NT(KLINE_P3_MIN_MS));
+	m_isWaitingResponse = false;
+	m_missedResponses = 0;
+	m_pidIndex = 0;
+	if (engineConfiguration->verboseKLine) {
+		efiPrintf("kline: %s connected", getName());
+	}
+}
+
+void KLineObdClient::onDisconnected(efitick_t nowNt) {
+	setState(State::Disconnected, nowNt + MS2NT(KLINE_INIT_RETRY_MS));
+	m_isWaitingResponse = false;
+	m_missedResponses = 0;
+}
+
+void KLineObdClient::sendRequest(KLineTransport& transport, efitick_t nowNt) {
+	m_requestedPid = m_pids[m_pidIndex];
+	m_pidIndex = (m_pidIndex + 1) % m_pidCount;
+
+	const uint8_t data[] = { 0x01, m_requestedPid };
+	uint8_t frame[KLINE_MAX_FRAME];
+	size_t size = buildRequest(frame, data, sizeof(data));
+	transport.send(frame, size, nowNt);
+
+	m_isWaitingResponse = true;
+	m_timerNt = nowNt + MS2NT(KLINE_RESPONSE_TIMEOUT_MS);
+}
+
+void KLineObdClient::onFrame(KLineTransport& transport, const uint8_t* frame, size_t size, efitick_t nowNt) {
+	switch (m_state) {
+	case State::Disconnected:
+		return;
+	case State::Connected:
+		break;
+	default:
+		onInitFrame(transport, frame, size, nowNt);
+		return;
+	}
+
+	if (!m_isWaitingResponse) {
+		return;
+	}
+
+	size_t headerSize = getHeaderSize(frame, size);
+	const uint8_t* payload = frame + headerSize;
+	size_t payloadSize = size - headerSize - 1;
+
+	// mode 01 positive response echoes the PID, anything else (0x7F negative response) still is an answer
+	if (payloadSize >= 2 && payload[0] == 0x41 && payload[1] == m_requestedPid) {
+		m_responseCount++;
+		if (m_listener) {
+			m_listener->onObdResponse(m_requestedPid, payload + 2, payloadSize - 2);
+		}
+	}
+
+	m_isWaitingResponse = false;
+	m_missedResponses = 0;
+	m_timerNt = nowNt + MS2NT(KLINE_P3_MIN_MS);
+}
+
+efidur_t KLineObdClient::onIdle(KLineTransport& transport, efitick_t nowNt) {
+	switch (m_state) {
+	case State::Disconnected:
+		if (nowNt >= m_timerNt) {
+			startInit(transport, nowNt);
+		}
+		break;
+	case State::Connected:
+		if (m_isWaitingResponse && nowNt >= m_timerNt) {
+			m_isWaitingResponse = false;
+			m_timeoutCount++;
+			if (++m_missedResponses >= KLINE_MAX_MISSED_RESPONSES) {
+				onDisconnected(nowNt);
+				break;
+			}
+		}
+
+		if (!m_isWaitingResponse && nowNt >= m_timerNt) {
+			sendRequest(transport, nowNt);
+		}
+		break;
+	default:
+		if (nowNt >= m_timerNt) {
+			onInitIdle(transport, nowNt);
+		}
+		break;
+	}
+
+	return std::max<efidur_t>(0, m_timerNt - nowNt);
+}
+
+void KLineObdClient::onInitIdle(KLineTransport& /*transport*/, efitick_t nowNt) {
+	// peer did not answer in time
+	onDisconnected(nowNt);
+}
+
+/**
+ * ISO 9141-2
+ */
+
+#define ISO9141_ADDRESS 0x33
+#define ISO9141_SYNC 0x55
+// 5 baud address takes 2s, then W1 max
+#define ISO9141_SYNC_TIMEOUT_MS (2000 + 300)
+// W4 min
+#define ISO9141_KEY_COMPLEMENT_DELAY_MS 25
+
+bool Iso9141Protocol::isValidFrame(const uint8_t* frame, size_t size) const {
+	switch (m_state) {
+	case State::Initializing:
+		// sync and both key bytes
+		return size == 3 && frame[0] == ISO9141_SYNC;
+	case State::WaitAddressComplement:
+		return size == 1 && frame[0] == (uint8_t)~ISO9141_ADDRESS;
+	default:
+		return size >= 5 && frame[0] == 0x48 && frame[1] == 0x6B
+			&& getKLineChecksum(frame, size - 1) == frame[size - 1];
+	}
+}
+
+void Iso9141Protocol::startInit(KLineTransport& transport, efitick_t nowNt) {
+	transport.getPort()->writeFiveBaud(ISO9141_ADDRESS);
+	setState(State::Initializing, nowNt + MS2NT(ISO9141_SYNC_TIMEOUT_MS));
+}
+
+void Iso9141Protocol::onInitFrame(KLineTransport& /*transport*/, const uint8_t* frame, size_t /*size*/, efitick_t nowNt) {
+	if (m_state == State::Initializing) {
+		m_keyByte2 = frame[2];
+		setState(State::SendKeyComplement, nowNt + MS2NT(ISO9141_KEY_COMPLEMENT_DELAY_MS));
+	} else if (m_state == State::WaitAddressComplement) {
+		onConnected(nowNt);
+	}
+}
+
+void Iso9141Protocol::onInitIdle(KLineTransport& transport, efitick_t nowNt) {
+	if (m_state != State::SendKeyComplement) {
+		KLineObdClient::onInitIdle(transport, nowNt);
+		return;
+	}
+
+	uint8_t keyComplement = ~m_keyByte2;
+	transport.send(&keyComplement, 1, nowNt);
+	setState(State::WaitAddressComplement, nowNt + MS2NT(KLINE_RESPONSE_TIMEOUT_MS));
+}
+
+size_t Iso9141Protocol::buildRequest(uint8_t* frame, const uint8_t* data, size_t size) const {
+	frame[0] = 0x68;
+	frame[1] = 0x6A;
+	frame[2] = KLINE_OBD_TESTER_ADDRESS;
+	memcpy(frame + 3, data, size);
+	frame[3 + size] = getKLineChecksum(frame, 3 + size);
+	return 3 + size + 1;
+}
+
+size_t Iso9141Protocol::getHeaderSize(const uint8_t* /*frame*/, size_t /*size*/) const {
+	return 3;
+}
+
+/**
+ * KWP2000
+ */
+
+// TiniL and the rest of TWuP
+#define KWP_WAKEUP_LOW_US 25000
+#define KWP_WAKEUP_HIGH_US 25000
+#define KWP_START_COMMUNICATION 0x81
+
+size_t Kwp2000Protocol::getHeaderSize(const uint8_t* frame, size_t size) const {
+	if (size == 0) {
+		return 0;
+	}
+	// format byte, target and source if address mode bits say so, length byte if it did not fit into format byte
+	return 1 + ((frame[0] & 0x80) ? 2 : 0) + ((frame[0] & 0x3F) == 0 ? 1 : 0);
+}
+
+size_t Kwp2000Protocol::getExpectedSize(const uint8_t* frame, size_t size) const {
+	size_t headerSize = getHeaderSize(frame, size);
+	if (headerSize == 0 || size < headerSize) {
+		return 0;
+	}
+
+	size_t dataSize = frame[0] & 0x3F;
+	if (dataSize == 0) {
+		dataSize = frame[headerSize - 1];
+	}
+	return headerSize + dataSize + 1;
+}
+
+bool Kwp2000Protocol::isValidFrame(const uint8_t* frame, size_t size) const {
+	size_t headerSize = getHeaderSize(frame, size);
+	if (size != getExpectedSize(frame, size) || size <= headerSize + 1) {
+		return false;
+	}
+
+	if ((frame[0] & 0x80) && frame[1] != KLINE_OBD_TESTER_ADDRESS) {
+		// somebody else's conversation
+		return false;
+	}
+
+	return getKLineChecksum(frame, size - 1) == frame[size - 1];
+}
+
+void Kwp2000Protocol::startInit(KLineTransport& transport, efitick_t nowNt) {
+	transport.getPort()->wakeup(KWP_WAKEUP_LOW_US, KWP_WAKEUP_HIGH_US);
+	// the pattern blocks for about 50 ms and the low phase reads back as a break on RX
+	nowNt = getTimeNowNt();
+	transport.discardRx();
+
+	const uint8_t data[] = { KWP_START_COMMUNICATION };
+	uint8_t frame[KLINE_MAX_FRAME];
+	size_t size = buildRequest(frame, data, sizeof(data));
+	transport.send(frame, size, nowNt);
+
+	setState(State::Initializing, nowNt + MS2NT(KLINE_RESPONSE_TIMEOUT_MS));
+}
+
+void Kwp2000Protocol::onInitFrame(KLineTransport& /*transport*/, const uint8_t* frame, size_t size, efitick_t nowNt) {
+	// positive response carries the key bytes, we do not care which ones
+	if (frame[getHeaderSize(frame, size)] == KWP_START_COMMUNICATION + 0x40) {
+		onConnected(nowNt);
+	} else {
+		onDisconnected(nowNt);
+	}
+}
+
+size_t Kwp2000Protocol::buildRequest(uint8_t* frame, const uint8_t* data, size_t size) const {
+	frame[0] = 0xC0 | size;
+	frame[1] = KLINE_OBD_FUNCTIONAL_ADDRESS;
+	frame[2] = KLINE_OBD_TESTER_ADDRESS;
+	memcpy(frame + 3, data, size);
+	frame[3 + size] = getKLineChecksum(frame, 3 + size);
+	return 3 + size + 1;
+}
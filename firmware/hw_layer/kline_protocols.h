@@ -0,0 +1,182 @@
+/**
+ * @file kline_protocols.h
+ * @brief Devices we know how to talk to over K-line
+ *
+ * Honda: early 2000s SEFMJ BCM and dash, see https://rusefi.com/forum/viewtopic.php?f=4&t=2514
+ * ISO 9141-2 and KWP2000 (ISO 14230): we are the scan tool, the peer is initialized
+ * then polled for OBD mode 01 PIDs.
+ */
+
+#pragma once
+
+#include "kline_transport.h"
+
+// A/C request as seen by the Honda BCM
+extern bool kAcRequestState;
+
+/**
+ * Honda BCM talks to the ECU, the ECU answers with the dash frame carrying coolant temperature
+ */
+class HondaKLineProtocol final : public KLineProtocol {
+public:
+	const char* getName() const override {
+		return "Honda";
+	}
+
+	uint32_t getFrameGapUs(uint32_t baudRate) const override;
+	bool isValidFrame(const uint8_t* frame, size_t size) const override;
+	void onFrame(KLineTransport& transport, const uint8_t* frame, size_t size, efitick_t nowNt) override;
+	void reset() override;
+
+	void setValue(size_t index, uint8_t value);
+
+private:
+	// dash frame payload, checksum goes on top
+	uint8_t m_values[6] = {};
+	int m_sendCounter = 0;
+};
+
+struct IKLineObdListener {
+	/**
+	 * @param data PID value bytes, after the mode and PID echo
+	 */
+	virtual void onObdResponse(uint8_t pid, const uint8_t* data, size_t size) = 0;
+};
+
+// ISO 9141-2 / ISO 14230-2 timing
+// ECU inter-byte time within a response
+#define KLINE_P1_MAX_MS 20
+// end of response to next request
+#define KLINE_P3_MIN_MS 55
+// request to end of the response: P2 max plus room for the response itself and the frame gap
+#define KLINE_RESPONSE_TIMEOUT_MS 100
+// unanswered requests before the session is considered lost
+#define KLINE_MAX_MISSED_RESPONSES 3
+#define KLINE_INIT_RETRY_MS 1000
+#define KLINE_MAX_PIDS 8
+
+#define KLINE_OBD_TESTER_ADDRESS 0xF1
+#define KLINE_OBD_FUNCTIONAL_ADDRESS 0x33
+
+/**
+ * Scan tool side of an OBD session, common to ISO 9141-2 and KWP2000: after init PIDs are
+ * requested round robin which also keeps the session alive
+ */
+class KLineObdClient : public KLineProtocol {
+public:
+	enum class State : uint8_t {
+		Disconnected,
+		Initializing,
+		// ISO 9141-2 only: key bytes received, complement of the second one is due
+		SendKeyComplement,
+		// ISO 9141-2 only: waiting for the complement of the address
+		WaitAddressComplement,
+		Connected,
+	};
+
+	void setPids(const uint8_t* pids, size_t count);
+
+	void setListener(IKLineObdListener* listener) {
+		m_listener = listener;
+	}
+
+	uint32_t getFrameGapUs(uint32_t baudRate) const override;
+	void onFrame(KLineTransport& transport, const uint8_t* frame, size_t size, efitick_t nowNt) override;
+	efidur_t onIdle(KLineTransport& transport, efitick_t nowNt) override;
+	void reset() override;
+
+	State getState() const {
+		return m_state;
+	}
+
+	uint32_t getResponseCount() const {
+		return m_responseCount;
+	}
+
+	uint32_t getTimeoutCount() const {
+		return m_timeoutCount;
+	}
+
+protected:
+	virtual void startInit(KLineTransport& transport, efitick_t nowNt) = 0;
+	virtual void onInitFrame(KLineTransport& transport, const uint8_t* frame, size_t size, efitick_t nowNt) = 0;
+	/**
+	 * Timer of an init state has expired, by default the peer failed to answer in time
+	 */
+	virtual void onInitIdle(KLineTransport& transport, efitick_t nowNt);
+
+	/**
+	 * Wraps service data into a request frame
+	 * @return frame size
+	 */
+	virtual size_t buildRequest(uint8_t* frame, const uint8_t* data, size_t size) const = 0;
+	virtual size_t getHeaderSize(const uint8_t* frame, size_t size) const = 0;
+
+	void setState(State state, efitick_t timerNt) {
+		m_state = state;
+		m_timerNt = timerNt;
+	}
+
+	void onConnected(efitick_t nowNt);
+	void onDisconnected(efitick_t nowNt);
+
+	State m_state = State::Disconnected;
+	// next action for the current state: retry, timeout or next request
+	efitick_t m_timerNt = 0;
+
+private:
+	void sendRequest(KLineTransport& transport, efitick_t nowNt);
+
+	uint8_t m_pids[KLINE_MAX_PIDS] = {};
+	size_t m_pidCount = 1;
+	size_t m_pidIndex = 0;
+	IKLineObdListener* m_listener = nullptr;
+
+	bool m_isWaitingResponse = false;
+	uint8_t m_requestedPid = 0;
+	int m_missedResponses = 0;
+
+	uint32_t m_responseCount = 0;
+	uint32_t m_timeoutCount = 0;
+};
+
+/**
+ * ISO 9141-2 with 5 baud init
+ */
+class Iso9141Protocol final : public KLineObdClient {
+public:
+	const char* getName() const override {
+		return "ISO 9141-2";
+	}
+
+	bool isValidFrame(const uint8_t* frame, size_t size) const override;
+
+protected:
+	void startInit(KLineTransport& transport, efitick_t nowNt) override;
+	void onInitFrame(KLineTransport& transport, const uint8_t* frame, size_t size, efitick_t nowNt) override;
+	void onInitIdle(KLineTransport& transport, efitick_t nowNt) override;
+	size_t buildRequest(uint8_t* frame, const uint8_t* data, size_t size) const override;
+	size_t getHeaderSize(const uint8_t* frame, size_t size) const override;
+
+private:
+	uint8_t m_keyByte2 = 0;
+};
+
+/**
+ * KWP2000 with fast init, functional addressing
+ */
+class Kwp2000Protocol final : public KLineObdClient {
+public:
+	const char* getName() const override {
+		return "KWP2000";
+	}
+
+	size_t getExpectedSize(const uint8_t* frame, size_t size) const override;
+	bool isValidFrame(const uint8_t* frame, size_t size) const override;
+
+protected:
+	void startInit(KLineTransport& transport, efitick_t nowNt) override;
+	void onInitFrame(KLineTransport& transport, const uint8_t* frame, size_t size, efitick_t nowNt) override;
+	size_t buildRequest(uint8_t* frame, const uint8_t* data, size_t size) const override;
+	size_t getHeaderSize(const uint8_t* frame, size_t size) const override;
+};
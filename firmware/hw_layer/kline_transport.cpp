@@ -0,0 +1,133 @@
+/**
+ * @file kline_transport.cpp
+ *
+ * see kline_transport.h
+ */
+
+#include "pch.h"
+#include "kline_transport.h"
+
+uint8_t getKLineChecksum(const uint8_t* data, size_t size) {
+	uint8_t sum = 0;
+	for (size_t i = 0; i < size; i++) {
+		sum += data[i];
+	}
+	return sum;
+}
+
+void KLineTransport::init(KLineProtocol* protocol, IKLinePort* port, uint32_t baudRate) {
+	m_protocol = protocol;
+	m_port = port;
+	m_baudRate = baudRate;
+	m_characterTimeNt = US2NT(getKLineCharacterTimeUs(baudRate));
+	m_frameGapNt = US2NT(protocol->getFrameGapUs(baudRate));
+
+	m_frameSize = 0;
+	m_isOverrun = false;
+	m_echoSize = 0;
+	m_echoPosition = 0;
+
+	protocol->reset();
+}
+
+void KLineTransport::onRx(const uint8_t* data, size_t size, efitick_t nowNt) {
+	for (size_t i = 0; i < size; i++) {
+		onByte(data[i], nowNt);
+	}
+}
+
+void KLineTransport::onByte(uint8_t b, efitick_t nowNt) {
+	if (m_frameSize > 0 && nowNt - m_lastByteNt >= m_frameGapNt) {
+		// we were late to notice the gap, previous frame is over
+		completeFrame(nowNt);
+	}
+
+	if (isEcho(b, nowNt)) {
+		return;
+	}
+
+	m_lastByteNt = nowNt;
+
+	if (m_frameSize == sizeof(m_frame)) {
+		// keep swallowing until the gap so that the tail is not taken for a new frame
+		m_isOverrun = true;
+		return;
+	}
+
+	m_frame[m_frameSize++] = b;
+
+	size_t expectedSize = m_protocol->getExpectedSize(m_frame, m_frameSize);
+	if (expectedSize != 0 && m_frameSize >= expectedSize) {
+		// no need to wait for the gap, this is what makes slow peers cheap
+		completeFrame(nowNt);
+	}
+}
+
+bool KLineTransport::isEcho(uint8_t b, efitick_t nowNt) {
+	if (m_echoPosition >= m_echoSize) {
+		return false;
+	}
+
+	if (nowNt > m_echoDeadlineNt || b != m_echo[m_echoPosition]) {
+		// our transmission did not make it to the wire intact
+		m_collisionCount++;
+		m_echoSize = 0;
+		m_echoPosition = 0;
+		return false;
+	}
+
+	m_echoPosition++;
+	m_echoByteCount++;
+	return true;
+}
+
+void KLineTransport::completeFrame(efitick_t nowNt) {
+	if (m_isOverrun) {
+		m_overrunCount++;
+	} else if (m_protocol->isValidFrame(m_frame, m_frameSize)) {
+		m_frameCount++;
+		m_protocol->onFrame(*this, m_frame, m_frameSize, nowNt);
+	} else {
+		m_invalidFrameCount++;
+	}
+
+	m_frameSize = 0;
+	m_isOverrun = false;
+}
+
+efidur_t KLineTransport::onIdle(efitick_t nowNt) {
+	if (m_frameSize > 0) {
+		efidur_t quietNt = nowNt - m_lastByteNt;
+		if (quietNt < m_frameGapNt) {
+			return m_frameGapNt - quietNt;
+		}
+		completeFrame(nowNt);
+	}
+
+	return m_protocol->onIdle(*this, nowNt);
+}
+
+void KLineTransport::send(const uint8_t* data, size_t size, efitick_t nowNt) {
+	if (m_echoPosition >= m_echoSize) {
+		m_echoSize = 0;
+		m_echoPosition = 0;
+	} else if (m_echoPosition > 0) {
+		// previous transmission is still coming back, keep its tail
+		memmove(m_echo, m_echo + m_echoPosition, m_echoSize - m_echoPosition);
+		m_echoSize -= m_echoPosition;
+		m_echoPosition = 0;
+	}
+
+	size_t echoSize = std::min(size, sizeof(m_echo) - m_echoSize);
+	memcpy(m_echo + m_echoSize, data, echoSize);
+	m_echoSize += echoSize;
+	m_echoDeadlineNt = nowNt + (m_echoSize + 1) * m_characterTimeNt + m_frameGapNt;
+
+	m_port->write(data, size);
+}
+
+void KLineTransport::discardRx() {
+	m_port->discardRx();
+	m_frameSize = 0;
+	m_isOverrun = false;
+}
@@ -0,0 +1,179 @@
+/**
+ * @file kline_transport.h
+ * @brief K-line byte stream to frames, independent of the device on the other end
+ *
+ * Received bytes are split into frames on inter-byte gaps (or as soon as the protocol knows the
+ * frame is complete) and checked by the active protocol before it gets to see them.
+ * K-line is a single wire so everything we transmit comes back on RX: these bytes are matched
+ * against what was sent and dropped, a mismatch means somebody else was talking at the same time.
+ *
+ * Nothing here touches hardware, see kline.cpp for the serial port side.
+ */
+
+#pragma once
+
+#include "efitime.h"
+
+// KWP2000 allows up to 255 data bytes but nothing we talk to comes close
+#define KLINE_MAX_FRAME 64
+
+/**
+ * One character on the wire is start bit, 8 data bits and stop bit
+ */
+inline uint32_t getKLineCharacterTimeUs(uint32_t baudRate) {
+	return 10 * 1000000 / baudRate;
+}
+
+/**
+ * 8 bit modulo 256 sum used by both ISO 9141-2 and ISO 14230 (KWP2000)
+ */
+uint8_t getKLineChecksum(const uint8_t* data, size_t size);
+
+/**
+ * Whatever drives the wire
+ */
+struct IKLinePort {
+	virtual void write(const uint8_t* data, size_t size) = 0;
+	/**
+	 * KWP2000 fast init wake up pattern: line low then high for the given durations
+	 */
+	virtual void wakeup(uint32_t lowUs, uint32_t highUs) = 0;
+	/**
+	 * ISO 9141-2 slow init: one byte at 5 baud, about two seconds
+	 */
+	virtual void writeFiveBaud(uint8_t address) = 0;
+	/**
+	 * Drops whatever has been received but not read yet
+	 */
+	virtual void discardRx() = 0;
+};
+
+class KLineTransport;
+
+/**
+ * Everything specific to one kind of K-line device
+ */
+class KLineProtocol {
+public:
+	virtual const char* getName() const = 0;
+
+	/**
+	 * Idle time after which bytes received so far are handled as one frame
+	 */
+	virtual uint32_t getFrameGapUs(uint32_t baudRate) const = 0;
+
+	/**
+	 * @return size of the frame in flight if the header tells it, zero if only the gap would tell
+	 */
+	virtual size_t getExpectedSize(const uint8_t* /*frame*/, size_t /*size*/) const {
+		return 0;
+	}
+
+	virtual bool isValidFrame(const uint8_t* frame, size_t size) const = 0;
+
+	/**
+	 * Valid frame from the peer, our own echo never gets here
+	 */
+	virtual void onFrame(KLineTransport& transport, const uint8_t* frame, size_t size, efitick_t nowNt) = 0;
+
+	/**
+	 * Called when there is no frame to handle, this is where a protocol starts its own transmissions
+	 * @return how soon the protocol wants to be called again
+	 */
+	virtual efidur_t onIdle(KLineTransport& /*transport*/, efitick_t /*nowNt*/) {
+		return MS2NT(100);
+	}
+
+	/**
+	 * Protocol was (re)selected, forget any session state
+	 */
+	virtual void reset() { }
+};
+
+class KLineTransport {
+public:
+	void init(KLineProtocol* protocol, IKLinePort* port, uint32_t baudRate);
+
+	/**
+	 * Bytes which have arrived by nowNt
+	 */
+	void onRx(const uint8_t* data, size_t size, efitick_t nowNt);
+
+	/**
+	 * Completes the frame in flight if the line has been quiet long enough and lets the protocol transmit
+	 * @return how long the reader may block waiting for the next byte
+	 */
+	efidur_t onIdle(efitick_t nowNt);
+
+	void send(const uint8_t* data, size_t size, efitick_t nowNt);
+
+	/**
+	 * Forgets the frame in flight together with anything still waiting in the port, for example
+	 * what the wake up pattern left on RX
+	 */
+	void discardRx();
+
+	IKLinePort* getPort() const {
+		return m_port;
+	}
+
+	KLineProtocol* getProtocol() const {
+		return m_protocol;
+	}
+
+	uint32_t getBaudRate() const {
+		return m_baudRate;
+	}
+
+	bool isFrameInFlight() const {
+		return m_frameSize > 0;
+	}
+
+	uint32_t getFrameCount() const {
+		return m_frameCount;
+	}
+
+	uint32_t getInvalidFrameCount() const {
+		return m_invalidFrameCount;
+	}
+
+	uint32_t getEchoByteCount() const {
+		return m_echoByteCount;
+	}
+
+	uint32_t getCollisionCount() const {
+		return m_collisionCount;
+	}
+
+	uint32_t getOverrunCount() const {
+		return m_overrunCount;
+	}
+
+private:
+	void onByte(uint8_t b, efitick_t nowNt);
+	// true if this byte is our own transmission coming back
+	bool isEcho(uint8_t b, efitick_t nowNt);
+	void completeFrame(efitick_t nowNt);
+
+	KLineProtocol* m_protocol = nullptr;
+	IKLinePort* m_port = nullptr;
+	uint32_t m_baudRate = 0;
+	efidur_t m_frameGapNt = 0;
+	efidur_t m_characterTimeNt = 0;
+
+	uint8_t m_frame[KLINE_MAX_FRAME];
+	size_t m_frameSize = 0;
+	bool m_isOverrun = false;
+	efitick_t m_lastByteNt = 0;
+
+	uint8_t m_echo[KLINE_MAX_FRAME];
+	size_t m_echoSize = 0;
+	size_t m_echoPosition = 0;
+	efitick_t m_echoDeadlineNt = 0;
+
+	uint32_t m_frameCount = 0;
+	uint32_t m_invalidFrameCount = 0;
+	uint32_t m_echoByteCount = 0;
+	uint32_t m_collisionCount = 0;
+	uint32_t m_overrunCount = 0;
+};
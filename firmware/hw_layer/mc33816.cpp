@@ -23,6 +23,11 @@
 #include "hardware.h"
 #include "mpu_util.h"
 #include "ignition_controller.h"
+#include "mc33816_profile.h"
+
+// waiting for battery voltage: first fire on cranking depends on how soon we notice it
+#define MC33_INIT_POLL_MS 10
+#define MC33_POLL_MS 100
 
 static SPIConfig spiCfg = {
     .circular = false,
@@ -47,10 +52,14 @@ static SPIConfig spiCfg = {
 			SPI_CR2_16BIT_MODE
 		 };
 
-class Pt2001 : public Pt2001Base {
+class Pt2001 : public Pt2001ProfileBase {
 public:
 	bool init();
 	void initIfNeeded();
+	/**
+	 * Tuning peak/hold currents or timings on a running chip does not need a restart
+	 */
+	void updateProfileIfNeeded();
 
 protected:
  	void acquireBus() override {
@@ -107,69 +116,6 @@ protected:
 		return Sensor::get(SensorType::BatteryVoltage).value_or(0);
 	}
 
-	// CONFIGURATIONS: currents, timings, voltages
-	float getBoostVoltage() const override {
-		return engineConfiguration->mc33_hvolt;
-	}
-
-	// Currents in amps
-	float getBoostCurrent() const override {
-		return engineConfiguration->mc33_i_boost;
-	}
-
-	float getPeakCurrent() const override {
-		return engineConfiguration->mc33_i_peak;
-	}
-
-	float getHoldCurrent() const override {
-		return engineConfiguration->mc33_i_hold;
-	}
-
-	float getPumpPeakCurrent() const override {
-		return engineConfiguration->mc33_hpfp_i_peak;
-	}
-
-	float getPumpHoldCurrent() const override {
-		return engineConfiguration->mc33_hpfp_i_hold;
-	}
-
-	// Timings in microseconds
-	uint16_t getTpeakOff() const override {
-		return engineConfiguration->mc33_t_peak_off;
-	}
-
-	uint16_t getTpeakTot() const override {
-		return engineConfiguration->mc33_t_peak_tot;
-	}
-
-	uint16_t getTbypass() const override {
-		return engineConfiguration->mc33_t_bypass;
-	}
-
-	uint16_t getTholdOff() const override {
-		return engineConfiguration->mc33_t_hold_off;
-	}
-
-	uint16_t getTHoldTot() const override {
-		return engineConfiguration->mc33_t_hold_tot;
-	}
-
-	uint16_t getTBoostMin() const override {
-		return engineConfiguration->mc33_t_min_boost;
-	}
-
-	uint16_t getTBoostMax() const override {
-		return engineConfiguration->mc33_t_max_boost;
-	}
-
-	uint16_t getPumpTholdOff() const override {
-		return engineConfiguration->mc33_hpfp_i_hold_off;
-	}
-
-	uint16_t getPumpTholdTot() const override {
-		return engineConfiguration->mc33_hpfp_max_hold;
-	}
-
 	// Print out an error message
 	void onError(const char* why) override {
 		efiPrintf("PT2001 error: %s", why);
@@ -194,6 +140,8 @@ private:
 
 static Pt2001 pt;
 
+static void showProfile();
+
 /**
  * returns true if chip has configuration
  */
@@ -243,6 +191,7 @@ bool Pt2001::init() {
 	addConsoleAction("mc33_restart", [](){
     pt.initIfNeeded();
   });
+	addConsoleAction("mc33_profile", showProfile);
 
 	// todo: too soon to read voltage, it has to fail, right?!
 	initIfNeeded();
@@ -257,6 +206,7 @@ void Pt2001::initIfNeeded() {
 	  efiPrintf("unhappy mc33 due to battery voltage");
 	} else {
 		if (!isInitialized) {
+			setProfile(Pt2001Profile::fromConfig());
 			isInitialized = restart();
 			if (isInitialized) {
 			  efiPrintf("happy mc33/PT2001!");
@@ -267,6 +217,27 @@ void Pt2001::initIfNeeded() {
 	}
 }
 
+void Pt2001::updateProfileIfNeeded() {
+	Pt2001Profile wanted = Pt2001Profile::fromConfig();
+	if (wanted == getProfile()) {
+		return;
+	}
+
+	applyProfile(wanted);
+	efiPrintf("mc33/PT2001 profile updated, crc=%lx", getProfile().getCrc());
+}
+
+static void showProfile() {
+	const Pt2001Profile& profile = pt.getProfile();
+	efiPrintf("mc33/PT2001 %s profile crc=%lx", isInitialized ? "active" : "pending", profile.getCrc());
+	efiPrintf("boost %.1fV %.1fA, peak %.1fA, hold %.1fA, pump peak %.1fA hold %.1fA",
+		profile.boostVoltage, profile.boostCurrent, profile.peakCurrent, profile.holdCurrent,
+		profile.pumpPeakCurrent, profile.pumpHoldCurrent);
+	efiPrintf("peak off/tot %d/%d, bypass %d, hold off/tot %d/%d, boost min/max %d/%d",
+		profile.tPeakOff, profile.tPeakTot, profile.tBypass, profile.tHoldOff, profile.tHoldTot,
+		profile.tBoostMin, profile.tBoostMax);
+}
+
 static THD_WORKING_AREA(mc33_thread_wa, 256);
 
 static THD_FUNCTION(mc33_driver_thread, p) {
@@ -278,11 +249,15 @@ static THD_FUNCTION(mc33_driver_thread, p) {
         efiPrintf("Power loss? Would have to re-init mc33/PT2001?");
         isInitialized = false;
       }
-      chThdSleepMilliseconds(100);
+      chThdSleepMilliseconds(MC33_INIT_POLL_MS);
       continue;
     }
-    pt.initIfNeeded();
-    chThdSleepMilliseconds(100);
+    if (isInitialized) {
+      pt.updateProfileIfNeeded();
+    } else {
+      pt.initIfNeeded();
+    }
+    chThdSleepMilliseconds(MC33_POLL_MS);
   }
 }
 
@@ -0,0 +1,47 @@
+/*
+ * @file mc33816_profile.cpp
+ *
+ * see mc33816_profile.h
+ */
+
+#include "pch.h"
+
+#include "mc33816_profile.h"
+
+static_assert(sizeof(Pt2001Profile) == 6 * sizeof(float) + 10 * sizeof(uint16_t), "Pt2001Profile has padding");
+
+Pt2001Profile Pt2001Profile::fromConfig() {
+	Pt2001Profile profile;
+
+	profile.boostVoltage = engineConfiguration->mc33_hvolt;
+
+	profile.boostCurrent = engineConfiguration->mc33_i_boost;
+	profile.peakCurrent = engineConfiguration->mc33_i_peak;
+	profile.holdCurrent = engineConfiguration->mc33_i_hold;
+	profile.pumpPeakCurrent = engineConfiguration->mc33_hpfp_i_peak;
+	profile.pumpHoldCurrent = engineConfiguration->mc33_hpfp_i_hold;
+
+	profile.tPeakOff = engineConfiguration->mc33_t_peak_off;
+	profile.tPeakTot = engineConfiguration->mc33_t_peak_tot;
+	profile.tBypass = engineConfiguration->mc33_t_bypass;
+	profile.tHoldOff = engineConfiguration->mc33_t_hold_off;
+	profile.tHoldTot = engineConfiguration->mc33_t_hold_tot;
+	profile.tBoostMin = engineConfiguration->mc33_t_min_boost;
+	profile.tBoostMax = engineConfiguration->mc33_t_max_boost;
+	profile.pumpTholdOff = engineConfiguration->mc33_hpfp_i_hold_off;
+	profile.pumpTholdTot = engineConfiguration->mc33_hpfp_max_hold;
+
+	return profile;
+}
+
+uint32_t Pt2001Profile::getCrc() const {
+	return crc32(this, sizeof(*this));
+}
+
+void Pt2001ProfileBase::applyProfile(const Pt2001Profile& profile) {
+	m_profile = profile;
+
+	acquireBus();
+	setTimings();
+	releaseBus();
+}
@@ -0,0 +1,137 @@
+/*
+ * @file mc33816_profile.h
+ *
+ * Currents, timings and voltage the PT2001 gets programmed with. The profile is latched
+ * from configuration once so that the chip always gets one consistent set, the same set is
+ * then used to tell if a running chip needs an update.
+ *
+ * @date Oct 18, 2026
+ */
+
+#pragma once
+
+struct Pt2001Profile {
+	static Pt2001Profile fromConfig();
+
+	uint32_t getCrc() const;
+
+	bool operator==(const Pt2001Profile& other) const {
+		// Fields are packed without padding (see mc33816_profile.cpp) so the bytes are the whole profile,
+		// a matching CRC alone could hide a retune which happens to collide
+		return memcmp(this, &other, sizeof(*this)) == 0;
+	}
+
+	bool operator!=(const Pt2001Profile& other) const {
+		return !(*this == other);
+	}
+
+	// volts
+	float boostVoltage = 0;
+
+	// amps
+	float boostCurrent = 0;
+	float peakCurrent = 0;
+	float holdCurrent = 0;
+	float pumpPeakCurrent = 0;
+	float pumpHoldCurrent = 0;
+
+	// microseconds
+	uint16_t tPeakOff = 0;
+	uint16_t tPeakTot = 0;
+	uint16_t tBypass = 0;
+	uint16_t tHoldOff = 0;
+	uint16_t tHoldTot = 0;
+	uint16_t tBoostMin = 0;
+	uint16_t tBoostMax = 0;
+	uint16_t pumpTholdOff = 0;
+	uint16_t pumpTholdTot = 0;
+
+	// no implicit padding, CRC covers every byte
+	uint16_t pad = 0;
+};
+
+/**
+ * PT2001 which takes its settings from a latched profile instead of live configuration
+ */
+class Pt2001ProfileBase : public Pt2001Base {
+public:
+	/**
+	 * Profile for the next restart()
+	 */
+	void setProfile(const Pt2001Profile& profile) {
+		m_profile = profile;
+	}
+
+	const Pt2001Profile& getProfile() const {
+		return m_profile;
+	}
+
+	/**
+	 * Reprograms currents and timings of a running chip, microcode stays as it is
+	 */
+	void applyProfile(const Pt2001Profile& profile);
+
+protected:
+	float getBoostVoltage() const override {
+		return m_profile.boostVoltage;
+	}
+
+	float getBoostCurrent() const override {
+		return m_profile.boostCurrent;
+	}
+
+	float getPeakCurrent() const override {
+		return m_profile.peakCurrent;
+	}
+
+	float getHoldCurrent() const override {
+		return m_profile.holdCurrent;
+	}
+
+	float getPumpPeakCurrent() const override {
+		return m_profile.pumpPeakCurrent;
+	}
+
+	float getPumpHoldCurrent() const override {
+		return m_profile.pumpHoldCurrent;
+	}
+
+	uint16_t getTpeakOff() const override {
+		return m_profile.tPeakOff;
+	}
+
+	uint16_t getTpeakTot() const override {
+		return m_profile.tPeakTot;
+	}
+
+	uint16_t getTbypass() const override {
+		return m_profile.tBypass;
+	}
+
+	uint16_t getTholdOff() const override {
+		return m_profile.tHoldOff;
+	}
+
+	uint16_t getTHoldTot() const override {
+		return m_profile.tHoldTot;
+	}
+
+	uint16_t getTBoostMin() const override {
+		return m_profile.tBoostMin;
+	}
+
+	uint16_t getTBoostMax() const override {
+		return m_profile.tBoostMax;
+	}
+
+	uint16_t getPumpTholdOff() const override {
+		return m_profile.pumpTholdOff;
+	}
+
+	uint16_t getPumpTholdTot() const override {
+		return m_profile.pumpTholdTot;
+	}
+
+private:
+	Pt2001Profile m_profile;
+};
@@ -19,6 +19,7 @@
 #include "buffered_writer.h"
 #include "status_loop.h"
 #include "binary_logging.h"
+#include "log_histogram.h"
 
 static bool fs_ready = false;
 
@@ -454,7 +455,9 @@ struct SdLogBufferWriter final : public BufferedWriter<512> {
 
 		totalLoggedBytes += count;
 
+		uint32_t writeStartNt = getTimeNowLowerNt();
 		FRESULT err = f_write(&FDLogFile, buffer, count, &bytesWritten);
+		getLatencyHistogram(LatencyHistogram::SdWrite).add(getTimeNowLowerNt() - writeStartNt);
 
 		if (bytesWritten != count) {
 			printError("write error or disk full", err);
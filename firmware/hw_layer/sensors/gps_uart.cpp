@@ -14,8 +14,6 @@
 #include "pch.h"
 
 #if EFI_UART_GPS
-#include <string.h>
-
 #include "rusefi_types.h"
 #include "console_io.h"
 #include "eficonsole.h"
@@ -30,8 +28,7 @@ static THD_WORKING_AREA(gpsThreadStack, UTILITY_THREAD_STACK_SIZE);
 static loc_t GPSdata;
 static efidatetime_t lastDateTime;
 
-static int gpsMessageCount = 0;
-static int uartErrors = 0;
+static NmeaParser gpsParser;
 
 // TODO: some data structure for coordinates location
 
@@ -44,52 +41,43 @@ static void printGpsInfo() {
 	efiPrintf("GPS RX %s", hwPortname(engineConfiguration->gps_rx_pin));
 	efiPrintf("GPS TX %s", hwPortname(engineConfiguration->gps_tx_pin));
 
-	efiPrintf("m=%d,e=%d: vehicle speed = %.2f", gpsMessageCount, uartErrors, getCurrentSpeed());
+	efiPrintf("m=%lu,checksum errors=%lu,message errors=%lu: vehicle speed = %.2f",
+		gpsParser.getSentenceCount(), gpsParser.getChecksumErrorCount(), gpsParser.getMessageErrorCount(),
+		getCurrentSpeed());
 
 	float sec = getTimeNowMs() / 1000.0;
-	efiPrintf("communication speed: %.2f", gpsMessageCount / sec);
+	efiPrintf("communication speed: %.2f", gpsParser.getSentenceCount() / sec);
 
 	efiPrintf("GPS latitude = %.2f\r\n", GPSdata.latitude);
 	efiPrintf("GPS longitude = %.2f\r\n", GPSdata.longitude);
 }
 
-static void onGpsMessage(const char * const buffer) {
-	gps_location(&GPSdata, buffer);
-
-	if (GPSdata.quality == 4 && GPSdata.time.year > 0) {
+static void onGpsMessage(nmea_message_type type) {
+	if (type == NMEA_GPRMC && GPSdata.quality == 4 && GPSdata.time.year > 0) {
 		getRtcDateTime(&lastDateTime);
-		if (GPSdata.time.second != dateTime.second) {
+		if (GPSdata.time.second != lastDateTime.second) {
 			// quality =4 (valid GxRMC), year > 0, and difference more than second
 			setRtcDateTime(GPSdata.time);
 		}
 	}
-
-	gpsMessageCount++;
 }
 
-// we do not want this on stack, right?
-static char gps_str[GPS_MAX_STRING];
-
 static THD_FUNCTION(GpsThreadEntryPoint, arg) {
 	(void) arg;
 	chRegSetThreadName("GPS thread");
 
-	int count = 0;
+	char buffer[64];
 
 	while (true) {
-		msg_t charbuf = streamGet(GPS_SERIAL_DEVICE);
-		if (charbuf == 10 || count == GPS_MAX_STRING) {					// if 0xD,0xA or limit
-			if (count >= 1)
-				gps_str[--count] = '\0';					// delete 0xD
-
-			// scheduleMsg(&logger, "got GPS [%s]", gps_str);
-
-			// 'gps_str' string completed
-			onGpsMessage(gps_str);
-			memset(&gps_str, '\0', GPS_MAX_STRING);			// clear buffer
-			count = 0;
-		} else {
-			gps_str[count++] = charbuf;
+		// block for the first byte, then take whatever else has arrived in one go
+		buffer[0] = streamGet(GPS_SERIAL_DEVICE);
+		size_t count = 1 + chnReadTimeout(GPS_SERIAL_DEVICE, reinterpret_cast<uint8_t*>(buffer + 1), sizeof(buffer) - 1, TIME_IMMEDIATE);
+
+		for (size_t i = 0; i < count; i++) {
+			nmea_message_type type = gpsParser.feed(buffer[i], GPSdata);
+			if (type != NMEA_UNKNOWN && type != NMEA_CHECKSUM_ERR && type != NMEA_MESSAGE_ERR) {
+				onGpsMessage(type);
+			}
 		}
 	}
 }
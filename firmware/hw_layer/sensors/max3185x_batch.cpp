@@ -0,0 +1,248 @@
+/**
+ * @file max3185x_batch.cpp
+ *
+ * http://datasheets.maximintegrated.com/en/ds/MAX31855.pdf
+ * https://www.analog.com/media/en/technical-documentation/data-sheets/MAX31856.pdf
+ *
+ * @date Oct 18, 2026
+ */
+
+#include "pch.h"
+#include "max3185x_batch.h"
+
+// bits D17 and D3 are always expected to be zero
+#define MAX31855_RESERVED_BITS	0x20008
+
+#define MAX33855_FAULT_BIT			BIT(16)
+#define MAX33855_OPEN_BIT			BIT(0)
+#define MAX33855_GND_BIT			BIT(1)
+#define MAX33855_VCC_BIT			BIT(2)
+
+// MAX31856 fault status register
+#define MAX31856_SR_OPEN			BIT(0)
+#define MAX31856_SR_OVUV			BIT(1)
+#define MAX31856_SR_TC_RANGE		BIT(6)
+#define MAX31856_SR_CJ_RANGE		BIT(7)
+
+const char* getMax3185xErrorCodeName(Max3185xState code) {
+	switch (code) {
+	case MAX3185X_OK:
+		return "Ok";
+	case MAX3185X_OPEN_CIRCUIT:
+		return "Open";
+	case MAX3185X_SHORT_TO_GND:
+		return "short gnd";
+	case MAX3185X_SHORT_TO_VCC:
+		return "short VCC";
+	case MAX3185X_NO_REPLY:
+		return "no reply";
+	case MAX3185X_NOT_ENABLED:
+		return "not enabled";
+	case MAX3185X_OUT_OF_RANGE:
+		return "out of range";
+	default:
+		return "invalid";
+	}
+}
+
+const char* getMax3185xTypeName(Max3185xType type) {
+	switch (type) {
+	case MAX31855_TYPE:
+		return "max31855";
+	case MAX31856_TYPE:
+		return "max31856";
+	default:
+		return "unknown";
+	}
+}
+
+static uint32_t toUint32(const uint8_t* rx) {
+	return (rx[0] << 24) |
+			(rx[1] << 16) |
+			(rx[2] <<  8) |
+			(rx[3] <<  0);
+}
+
+void Max3185xBatch::setEnabled(size_t channel, bool isEnabled) {
+	m_enabled[channel] = isEnabled;
+	m_types[channel] = UNKNOWN_TYPE;
+	m_hasColdJunction[channel] = false;
+	m_snapshot.state[channel] = isEnabled ? MAX3185X_NO_REPLY : MAX3185X_NOT_ENABLED;
+}
+
+Max3185xType Max3185xBatch::detect(IMax3185xBus& bus, size_t channel) {
+	uint8_t rx[4];
+	uint8_t tx[4];
+
+	/* try to apply settings to max31956 and then read back settings */
+	// Wr, register 0x00
+	tx[0] = 0x00 | BIT(7);
+	// CR0: 50Hz mode
+	// Change the notch frequency only while in the "Normally Off" mode - not in the Automatic
+	tx[1] = 0x01;
+	if (!bus.exchange(channel, tx, rx, 2)) {
+		return UNKNOWN_TYPE;
+	}
+
+	// CR0: Automatic Conversion mode, OCFAULT = 2, 50Hz mode
+	tx[1] = BIT(7) | BIT(0) | (2 << 4);
+	// CR1: 4 samples average, K type
+	tx[2] = (2 << 4) | (3 << 0);
+	if (!bus.exchange(channel, tx, rx, 3)) {
+		return UNKNOWN_TYPE;
+	}
+
+	/* Now readback settings */
+	tx[0] = 0x00;
+	tx[3] = 0x00;
+	if (!bus.exchange(channel, tx, rx, 4)) {
+		return UNKNOWN_TYPE;
+	}
+	if ((rx[1] == tx[1]) && (rx[2] == tx[2])) {
+		return MAX31856_TYPE;
+	}
+
+	/* in case of max31855 we get standart reply with few reserved, always zero bits */
+	uint32_t data = toUint32(rx);
+
+	/* MISO is constantly low or high */
+	if ((data == 0xffffffff) || (data == 0x0)) {
+		return UNKNOWN_TYPE;
+	}
+
+	if ((data & MAX31855_RESERVED_BITS) == 0x0) {
+		return MAX31855_TYPE;
+	}
+
+	return UNKNOWN_TYPE;
+}
+
+Max3185xState Max3185xBatch::decodeMax31855(uint32_t packet, float& temp, float& coldJunctionTemp) {
+	if (((packet & MAX31855_RESERVED_BITS) != 0) ||
+		(packet == 0x0) ||
+		(packet == 0xffffffff)) {
+		return MAX3185X_NO_REPLY;
+	} else if ((packet & MAX33855_OPEN_BIT) != 0) {
+		return MAX3185X_OPEN_CIRCUIT;
+	} else if ((packet & MAX33855_GND_BIT) != 0) {
+		return MAX3185X_SHORT_TO_GND;
+	} else if ((packet & MAX33855_VCC_BIT) != 0) {
+		return MAX3185X_SHORT_TO_VCC;
+	}
+
+	// bits 31:18, 0.25C resolution (1/4 C)
+	int16_t tmp = (packet >> 18) & 0x3fff;
+	/* extend sign */
+	tmp = tmp << 2;
+	tmp = tmp >> 2;	/* shifting right signed is not a good idea */
+	temp = (float) tmp * 0.25;
+
+	// bits 15:4, 0.0625C resolution (1/16 C)
+	tmp = (packet >> 4) & 0xfff;
+	/* extend sign */
+	tmp = tmp << 4;
+	tmp = tmp >> 4;	/* shifting right signed is not a good idea */
+	coldJunctionTemp = (float)tmp * 0.0625;
+
+	return MAX3185X_OK;
+}
+
+/**
+ * @param rx reply to a read starting at register 0x0a: address echo, Cold-Junction temperature MSB, LSB,
+ * Linearized TC temperature 3 bytes and Fault Status
+ */
+Max3185xState Max3185xBatch::decodeMax31856(const uint8_t* rx, float& temp, float& coldJunctionTemp) {
+	uint8_t status = rx[6];
+
+	if (status & MAX31856_SR_OPEN) {
+		return MAX3185X_OPEN_CIRCUIT;
+	} else if (status & MAX31856_SR_OVUV) {
+		return MAX3185X_SHORT_TO_VCC;
+	} else if (status & (MAX31856_SR_TC_RANGE | MAX31856_SR_CJ_RANGE)) {
+		return MAX3185X_OUT_OF_RANGE;
+	}
+
+	// 10 bit before point and 7 bits after
+	int32_t tmp = (rx[3] << 11) | (rx[4] << 3) | (rx[5] >> 5);
+	/* extend sign: move top bit 18 to 31 */
+	tmp = tmp << 13;
+	tmp = tmp >> 13;	/* shifting right signed is not a good idea */
+	temp = ((float)tmp) / 128.0;
+
+	int16_t cj = (rx[1] << 6) | (rx[2] >> 2);
+	/* extend sign */
+	cj = cj << 2;
+	cj = cj >> 2;	/* shifting right signed is not a good idea */
+	coldJunctionTemp = ((float)cj) / 64.0;
+
+	return MAX3185X_OK;
+}
+
+Max3185xState Max3185xBatch::readChannel(IMax3185xBus& bus, size_t channel, float& temp, float& coldJunctionTemp) {
+	if (!m_enabled[channel]) {
+		return MAX3185X_NOT_ENABLED;
+	}
+
+	/* if chip type is not detected yet try to detect */
+	if (m_types[channel] == UNKNOWN_TYPE) {
+		m_types[channel] = detect(bus, channel);
+	}
+
+	Max3185xState ret = MAX3185X_NO_REPLY;
+
+	if (m_types[channel] == MAX31855_TYPE) {
+		/* dummy */
+		uint8_t tx[4] = {0};
+		uint8_t rx[4];
+
+		if (bus.exchange(channel, tx, rx, sizeof(rx))) {
+			ret = decodeMax31855(toUint32(rx), temp, coldJunctionTemp);
+		}
+	} else if (m_types[channel] == MAX31856_TYPE) {
+		uint8_t tx[7] = {0x0a};
+		uint8_t rx[7];
+
+		if (bus.exchange(channel, tx, rx, sizeof(rx))) {
+			ret = decodeMax31856(rx, temp, coldJunctionTemp);
+		}
+	}
+
+	if (ret == MAX3185X_NO_REPLY) {
+		// chip may have been swapped or lost power, detect again next time
+		m_types[channel] = UNKNOWN_TYPE;
+		m_hasColdJunction[channel] = false;
+	}
+
+	return ret;
+}
+
+const EgtSnapshot& Max3185xBatch::read(IMax3185xBus& bus, efitick_t nowNt) {
+	bus.begin();
+
+	for (size_t i = 0; i < EGT_CHANNEL_COUNT; i++) {
+		float temp = 0;
+		float coldJunctionTemp = 0;
+
+		Max3185xState state = readChannel(bus, i, temp, coldJunctionTemp);
+		m_snapshot.state[i] = state;
+
+		if (state != MAX3185X_OK) {
+			continue;
+		}
+
+		m_snapshot.temperature[i] = temp;
+
+		float& filtered = m_snapshot.coldJunction[i];
+		if (m_hasColdJunction[i]) {
+			filtered += MAX3185X_COLD_JUNCTION_FILTER * (coldJunctionTemp - filtered);
+		} else {
+			filtered = coldJunctionTemp;
+			m_hasColdJunction[i] = true;
+		}
+	}
+
+	bus.end();
+
+	m_snapshot.timestamp = nowNt;
+	return m_snapshot;
+}
@@ -0,0 +1,88 @@
+/**
+ * @file max3185x_batch.h
+ * @brief Chip detection and decoding for a set of MAX31855/MAX31856 thermocouple converters
+ *
+ * All chips are read back to back while the SPI bus is owned once, results are published
+ * as one snapshot with a common timestamp. The bus itself is abstracted so that this part
+ * is covered by unit tests.
+ *
+ * @date Oct 18, 2026
+ */
+
+#pragma once
+
+#include "global.h"
+#include "engine_configuration.h"
+
+typedef enum {
+	UNKNOWN_TYPE = 0,
+	MAX31855_TYPE = 1,
+	MAX31856_TYPE = 2,
+} Max3185xType;
+
+typedef enum {
+	MAX3185X_OK = 0,
+	MAX3185X_OPEN_CIRCUIT = 1,
+	MAX3185X_SHORT_TO_GND = 2,
+	MAX3185X_SHORT_TO_VCC = 3,
+	MAX3185X_NO_REPLY = 4,
+	MAX3185X_NOT_ENABLED = 5,
+	// MAX31856: thermocouple or cold junction outside of the chip's range
+	MAX3185X_OUT_OF_RANGE = 6,
+} Max3185xState;
+
+const char* getMax3185xErrorCodeName(Max3185xState code);
+const char* getMax3185xTypeName(Max3185xType type);
+
+/**
+ * SPI access for one batch: the bus is owned from begin() to end()
+ */
+struct IMax3185xBus {
+	virtual void begin() = 0;
+	// Full duplex transfer with chip select of the given channel asserted, false if the channel can not be reached
+	virtual bool exchange(size_t channel, const uint8_t* tx, uint8_t* rx, size_t n) = 0;
+	virtual void end() = 0;
+};
+
+struct EgtSnapshot {
+	efitick_t timestamp = 0;
+	Max3185xState state[EGT_CHANNEL_COUNT] = {};
+	// thermocouple temperature, valid if state is MAX3185X_OK
+	float temperature[EGT_CHANNEL_COUNT] = {};
+	// filtered chip temperature
+	float coldJunction[EGT_CHANNEL_COUNT] = {};
+};
+
+// Weight of a new cold junction sample, the chip temperature moves slowly and is noisy at 1/16 C
+#define MAX3185X_COLD_JUNCTION_FILTER 0.2f
+
+class Max3185xBatch {
+public:
+	void setEnabled(size_t channel, bool isEnabled);
+
+	/**
+	 * Reads every enabled chip, detecting chip type where it is not yet known
+	 */
+	const EgtSnapshot& read(IMax3185xBus& bus, efitick_t nowNt);
+
+	const EgtSnapshot& getSnapshot() const {
+		return m_snapshot;
+	}
+
+	Max3185xType getType(size_t channel) const {
+		return m_types[channel];
+	}
+
+	static Max3185xState decodeMax31855(uint32_t packet, float& temp, float& coldJunctionTemp);
+	static Max3185xState decodeMax31856(const uint8_t* rx, float& temp, float& coldJunctionTemp);
+
+private:
+	Max3185xType detect(IMax3185xBus& bus, size_t channel);
+	Max3185xState readChannel(IMax3185xBus& bus, size_t channel, float& temp, float& coldJunctionTemp);
+
+	bool m_enabled[EGT_CHANNEL_COUNT] = {};
+	Max3185xType m_types[EGT_CHANNEL_COUNT] = {};
+	bool m_hasColdJunction[EGT_CHANNEL_COUNT] = {};
+
+	EgtSnapshot m_snapshot;
+};
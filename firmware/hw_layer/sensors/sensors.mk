@@ -7,4 +7,5 @@ HW_SENSORS_CPP = \
 	$(HW_SENSORS_DIR)/accelerometer.cpp \
 	$(HW_SENSORS_DIR)/lps25.cpp \
 	$(HW_SENSORS_DIR)/max3185x.cpp \
+	$(HW_SENSORS_DIR)/max3185x_batch.cpp \
 	$(HW_SENSORS_DIR)/gps_uart.cpp
@@ -1394,9 +1394,25 @@ struct output_channels_s {
 	 */
 	int8_t fuelCutReasonBlinker = (int8_t)0;
 	/**
+	 * need 4 byte alignment
+	 * units: units
 	 * offset 794
 	 */
-	uint8_t unusedAtTheEnd[52];
+	uint8_t alignmentFill_at_794[2];
+	/**
+	 * Fuel: Cut Reasons
+	 * offset 796
+	 */
+	uint32_t fuelCutReasonMask = (uint32_t)0;
+	/**
+	 * Ign: Cut Reasons
+	 * offset 800
+	 */
+	uint32_t sparkCutReasonMask = (uint32_t)0;
+	/**
+	 * offset 804
+	 */
+	uint8_t unusedAtTheEnd[42];
 	/**
 	 * need 4 byte alignment
 	 * units: units
@@ -6,6 +6,11 @@
  * command line interface action names & callback. This logic is invoked in
  * user context by the console thread - see consoleThreadEntryPoint
  *
+ * Lookup goes through a hash index over the registration array so that scripted rigs
+ * driving thousands of commands do not pay a string compare per registered action.
+ * Actions are registered at runtime from many modules, so the index is built as they
+ * are added rather than generated at build time; the array keeps registration order for 'help'.
+ *
  * TODO: there is too much copy-paste here, this class needs some refactoring :)
  *
  * see testConsoleLogic()
@@ -42,24 +47,72 @@
 static int consoleActionCount = 0;
 static TokenCallback consoleActions[CONSOLE_MAX_ACTIONS];
 
+static constexpr size_t getActionIndexSize() {
+	// at most half full so that probe sequences stay short and always hit an empty slot
+	size_t size = 1;
+	while (size < 2 * CONSOLE_MAX_ACTIONS) {
+		size <<= 1;
+	}
+	return size;
+}
+
+#define ACTION_INDEX_SIZE getActionIndexSize()
+#define ACTION_INDEX_MASK (ACTION_INDEX_SIZE - 1)
+
+/**
+ * Open addressing hash index into consoleActions: zero is an empty slot, otherwise action index + 1
+ */
+static uint16_t consoleActionIndex[ACTION_INDEX_SIZE];
+
+/**
+ * FNV-1a
+ */
+static uint32_t hashToken(const char *token) {
+	uint32_t hash = 2166136261u;
+	while (*token) {
+		hash ^= (uint8_t)*token++;
+		hash *= 16777619u;
+	}
+	return hash;
+}
+
+/**
+ * @return slot holding this token, or the empty slot where it would go
+ */
+static uint32_t findActionSlot(const char *token) {
+	uint32_t slot = hashToken(token) & ACTION_INDEX_MASK;
+	while (true) {
+		uint16_t entry = consoleActionIndex[slot];
+		if (entry == 0 || strEqual(token, consoleActions[entry - 1].token)) {
+			return slot;
+		}
+		slot = (slot + 1) & ACTION_INDEX_MASK;
+	}
+}
+
+static TokenCallback *findAction(const char *token) {
+	uint16_t entry = consoleActionIndex[findActionSlot(token)];
+	return entry == 0 ? nullptr : &consoleActions[entry - 1];
+}
+
 void resetConsoleActions(void) {
 	consoleActionCount = 0;
+	memset(consoleActionIndex, 0, sizeof(consoleActionIndex));
 }
 
 static void doAddAction(const char *token, action_type_e type, Void callback, void *param) {
 #if !defined(EFI_DISABLE_CONSOLE_ACTIONS)
-	for (uint32_t i = 0; i < strlen(token);i++) {
-		char ch = token[i];
-		if (isupper(ch)) {
+	for (const char *ch = token; *ch; ch++) {
+		if (isupper(*ch)) {
 		    onCliCaseError(token);
 		    return;
 		}
 	}
-	for (int i = 0; i < consoleActionCount; i++) {
-		if (strcmp(token, consoleActions[i].token) == 0 /* zero result means strings are equal */) {
-			onCliDuplicateError(token);
-		    return;
-		}
+
+	uint32_t slot = findActionSlot(token);
+	if (consoleActionIndex[slot] != 0) {
+		onCliDuplicateError(token);
+		return;
 	}
 
     if (consoleActionCount >= CONSOLE_MAX_ACTIONS) {
@@ -67,6 +120,8 @@ static void doAddAction(const char *token, action_type_e type, Void callback, vo
 		return;
     }
 
+	consoleActionIndex[slot] = consoleActionCount + 1;
+
 	TokenCallback *current = &consoleActions[consoleActionCount++];
 	current->token = token;
 	current->parameterType = type;
@@ -473,9 +528,27 @@ void initConsoleLogic() {
 
 static char handleBuffer[MAX_CMD_LINE_LENGTH + 1];
 
-static int handleConsoleLineInternal(const char *commandLine) {
-	strncpy(handleBuffer, commandLine, sizeof(handleBuffer) - 1);
+/**
+ * Copies the line into handleBuffer and measures it in the same pass
+ * @return line length or -1 if it does not fit
+ */
+static int copyToHandleBuffer(const char *line) {
+	int length = 0;
+	while (line[length]) {
+		if (length == MAX_CMD_LINE_LENGTH) {
+			return -1;
+		}
+		handleBuffer[length] = line[length];
+		length++;
+	}
+	handleBuffer[length] = 0;
+	return length;
+}
 
+/**
+ * @param commandLine original line, handleBuffer holds a copy which is split into arguments in place
+ */
+static int handleConsoleLineInternal(const char *commandLine) {
 	char *argv[10];
 	int argc = setargs(handleBuffer, argv, 10);
 
@@ -484,22 +557,20 @@ static int handleConsoleLineInternal(const char *commandLine) {
 		return -1;
 	}
 
-	for (int i = 0; i < consoleActionCount; i++) {
-		TokenCallback *current = &consoleActions[i];
-		if (strEqual(argv[0], current->token)) {
-			if ((argc - 1) != getParameterCount(current->parameterType)) {
-				efiPrintf("Incorrect argument count %d, expected %d",
-					(argc - 1), getParameterCount(current->parameterType));
-				return -1;
-			}
+	TokenCallback *current = findAction(argv[0]);
+	if (current == nullptr) {
+		efiPrintf("unknown command [%s]", commandLine);
+		return -1;
+	}
 
-			/* skip commant name */
-			return handleActionWithParameter(current, argv + 1, argc - 1);
-		}
+	if ((argc - 1) != getParameterCount(current->parameterType)) {
+		efiPrintf("Incorrect argument count %d, expected %d",
+			(argc - 1), getParameterCount(current->parameterType));
+		return -1;
 	}
 
-	efiPrintf("unknown command [%s]", commandLine);
-	return -1;
+	/* skip commant name */
+	return handleActionWithParameter(current, argv + 1, argc - 1);
 }
 
 /**
@@ -509,8 +580,8 @@ void handleConsoleLine(char *line) {
 	if (line == NULL)
 		return; // error detected
 
-	int lineLength = strlen(line);
-	if (lineLength > MAX_CMD_LINE_LENGTH) {
+	int lineLength = copyToHandleBuffer(line);
+	if (lineLength < 0) {
 		// todo: better reaction to excessive line
 		efiPrintf("Long line?");
 		return;
@@ -0,0 +1,93 @@
+/**
+ * @file	log_histogram.cpp
+ *
+ * @date Oct 18, 2026
+ */
+
+#include "pch.h"
+
+#include "log_histogram.h"
+
+void LogHistogram::reset() {
+	m_count = 0;
+	m_max = 0;
+	memset(m_buckets, 0, sizeof(m_buckets));
+}
+
+uint32_t LogHistogram::getBucketLowerBound(size_t index) {
+	if (index < LOG_HISTOGRAM_SUB_BUCKETS) {
+		return index;
+	}
+
+	size_t shift = (index >> LOG_HISTOGRAM_SUB_BUCKET_BITS) - 1;
+	uint32_t mantissa = index & (LOG_HISTOGRAM_SUB_BUCKETS - 1);
+	return (LOG_HISTOGRAM_SUB_BUCKETS + mantissa) << shift;
+}
+
+uint32_t LogHistogram::getBucketUpperBound(size_t index) {
+	if (index + 1 >= LOG_HISTOGRAM_BUCKET_COUNT) {
+		return UINT32_MAX;
+	}
+
+	return getBucketLowerBound(index + 1) - 1;
+}
+
+uint32_t LogHistogram::getPercentile(float percentile) const {
+	// saturated buckets under-count, so rank against what is actually stored
+	uint32_t stored = 0;
+	for (size_t i = 0; i < LOG_HISTOGRAM_BUCKET_COUNT; i++) {
+		stored += m_buckets[i];
+	}
+
+	if (stored == 0) {
+		return 0;
+	}
+
+	// nearest rank, 1 based
+	uint32_t rank = std::max<uint32_t>(1, std::ceil(percentile / 100 * stored));
+
+	uint32_t accumulated = 0;
+	for (size_t i = 0; i < LOG_HISTOGRAM_BUCKET_COUNT; i++) {
+		accumulated += m_buckets[i];
+		if (accumulated >= rank) {
+			return std::min(getBucketUpperBound(i), m_max);
+		}
+	}
+
+	return m_max;
+}
+
+static LogHistogram latencyHistograms[(size_t)LatencyHistogram::Count];
+
+static const char* const latencyHistogramNames[] = {
+	"trigger",
+	"can rx",
+	"sd write",
+};
+
+static_assert(efi::size(latencyHistogramNames) == (size_t)LatencyHistogram::Count);
+
+LogHistogram& getLatencyHistogram(LatencyHistogram id) {
+	return latencyHistograms[(size_t)id];
+}
+
+const char* getLatencyHistogramName(LatencyHistogram id) {
+	return latencyHistogramNames[(size_t)id];
+}
+
+void fillLatencyHistogramReport(LatencyHistogram id, LatencyHistogramReport& report) {
+	const LogHistogram& histogram = getLatencyHistogram(id);
+
+	memset(&report, 0, sizeof(report));
+	strncpy(report.name, getLatencyHistogramName(id), sizeof(report.name) - 1);
+	report.ticksPerSecond = US2NT(US_PER_SECOND);
+	report.count = histogram.getCount();
+	report.p50 = histogram.getPercentile(50);
+	report.p99 = histogram.getPercentile(99);
+	report.max = histogram.getMax();
+	report.bucketCount = LOG_HISTOGRAM_BUCKET_COUNT;
+	report.subBucketBits = LOG_HISTOGRAM_SUB_BUCKET_BITS;
+	for (size_t i = 0; i < LOG_HISTOGRAM_BUCKET_COUNT; i++) {
+		report.buckets[i] = histogram.getBucket(i);
+	}
+}
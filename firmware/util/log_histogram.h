@@ -0,0 +1,115 @@
+/**
+ * @file	log_histogram.h
+ * @brief Compact latency histogram which is cheap enough to stay enabled in production
+ *
+ * HDR style bucketing: each power of two range is split into LOG_HISTOGRAM_SUB_BUCKETS linear steps,
+ * so the bucket index is a count-leading-zeros plus a shift and the relative error of any reported
+ * value is below 1 / LOG_HISTOGRAM_SUB_BUCKETS over the whole uint32_t range. Values below
+ * LOG_HISTOGRAM_SUB_BUCKETS are exact.
+ *
+ * Counters are 16 bit and saturate, see histogram.h for the legacy heavyweight implementation.
+ *
+ * @date Oct 18, 2026
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#define LOG_HISTOGRAM_SUB_BUCKET_BITS 3
+#define LOG_HISTOGRAM_SUB_BUCKETS (1 << LOG_HISTOGRAM_SUB_BUCKET_BITS)
+#define LOG_HISTOGRAM_BUCKET_COUNT ((32 - LOG_HISTOGRAM_SUB_BUCKET_BITS + 1) * LOG_HISTOGRAM_SUB_BUCKETS)
+
+class LogHistogram {
+public:
+	void reset();
+
+	/**
+	 * Safe to call from ISR, a sample may be lost if another ISR adds to the same histogram at the same time
+	 */
+	void add(uint32_t value) {
+		uint16_t& bucket = m_buckets[getBucketIndex(value)];
+		if (bucket != UINT16_MAX) {
+			bucket++;
+		}
+
+		m_count++;
+		if (value > m_max) {
+			m_max = value;
+		}
+	}
+
+	static size_t getBucketIndex(uint32_t value) {
+		if (value < LOG_HISTOGRAM_SUB_BUCKETS) {
+			return value;
+		}
+
+		int msb = 31 - __builtin_clz(value);
+		int shift = msb - LOG_HISTOGRAM_SUB_BUCKET_BITS;
+		// top bit is implied by the power of two range, keep the next SUB_BUCKET_BITS as mantissa
+		uint32_t mantissa = (value >> shift) & (LOG_HISTOGRAM_SUB_BUCKETS - 1);
+		return ((shift + 1) << LOG_HISTOGRAM_SUB_BUCKET_BITS) + mantissa;
+	}
+
+	static uint32_t getBucketLowerBound(size_t index);
+	static uint32_t getBucketUpperBound(size_t index);
+
+	/**
+	 * @param percentile 0..100
+	 * @return highest value which falls into the same bucket as the requested percentile, never above getMax()
+	 */
+	uint32_t getPercentile(float percentile) const;
+
+	// number of samples added since reset, including the ones lost to counter saturation
+	uint32_t getCount() const {
+		return m_count;
+	}
+
+	uint32_t getMax() const {
+		return m_max;
+	}
+
+	uint16_t getBucket(size_t index) const {
+		return m_buckets[index];
+	}
+
+private:
+	uint32_t m_count = 0;
+	uint32_t m_max = 0;
+	uint16_t m_buckets[LOG_HISTOGRAM_BUCKET_COUNT] = {};
+};
+
+/**
+ * Histograms which are always collected, values are in NT ticks
+ */
+enum class LatencyHistogram : uint8_t {
+	// trigger edge handling
+	TriggerIsr,
+	// processCanRxMessage
+	CanRx,
+	// one f_write of the SD card log
+	SdWrite,
+
+	Count,
+};
+
+LogHistogram& getLatencyHistogram(LatencyHistogram id);
+const char* getLatencyHistogramName(LatencyHistogram id);
+
+/**
+ * Binary layout of the TS_GET_HISTOGRAM response, little endian
+ */
+struct __attribute__ ((packed)) LatencyHistogramReport {
+	char name[12];
+	uint32_t ticksPerSecond;
+	uint32_t count;
+	uint32_t p50;
+	uint32_t p99;
+	uint32_t max;
+	uint16_t bucketCount;
+	uint16_t subBucketBits;
+	uint16_t buckets[LOG_HISTOGRAM_BUCKET_COUNT];
+};
+
+void fillLatencyHistogramReport(LatencyHistogram id, LatencyHistogramReport& report);
@@ -107,6 +107,44 @@ int findIndexMsg(const char *msg, const kType array[], int size, kType value) {
 	return middle;
 }
 
+/**
+ * @return index of the bin nearest to value, for tables which are learned one cell at a time
+ */
+template<typename TBin, size_t TSize>
+size_t closestBin(const TBin (&bins)[TSize], float value) {
+	size_t result = 0;
+
+	for (size_t i = 1; i < TSize; i++) {
+		if (std::abs(bins[i] - value) < std::abs(bins[result] - value)) {
+			result = i;
+		}
+	}
+
+	return result;
+}
+
+/**
+ * How interpolate2d splits value between the two bins around it: bins[index] gets 1 - fraction of it and
+ * bins[index + 1] gets fraction. Off the ends of the axis all of it goes to the end bin.
+ */
+struct BinWeight {
+	size_t index;
+	float fraction;
+};
+
+template<typename TBin, size_t TSize>
+BinWeight getBinWeight(const TBin (&bins)[TSize], float value) {
+	static_assert(TSize >= 2, "need two bins to interpolate between");
+
+	size_t index = 0;
+	while (index < TSize - 2 && value >= bins[index + 1]) {
+		index++;
+	}
+
+	float fraction = (value - bins[index]) / (bins[index + 1] - bins[index]);
+	return { index, clampF(0, fraction, 1) };
+}
+
 /**
  * Sets specified value for specified key in a correction curve
  * see also setLinearCurve()
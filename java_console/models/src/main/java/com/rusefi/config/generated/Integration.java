@@ -86,13 +86,18 @@ public class Integration {
 	public static final char TS_EXECUTE = 'E';
 	public static final char TS_GET_COMPOSITE_BUFFER_DONE_DIFFERENTLY = '8';
 	public static final char TS_GET_CONFIG_ERROR = 'e';
+	public static final char TS_GET_CUT_TIMELINE = 'j';
 	public static final char TS_GET_FIRMWARE_VERSION = 'V';
+	public static final char TS_GET_HISTOGRAM = 'h';
 	public static final char TS_GET_OUTPUTS_SIZE = '4';
 	public static final char TS_GET_PROTOCOL_VERSION_COMMAND_F = 'F';
 	public static final char TS_GET_SCATTERED_GET_COMMAND = '9';
 	public static final char TS_GET_TEXT = 'G';
 	public static final char TS_HELLO_COMMAND = 'S';
 	public static final char TS_IO_TEST_COMMAND = 'Z';
+	public static final char TS_LOG_STREAM_COMMAND = 'y';
+	public static final int TS_LOG_STREAM_START = 1;
+	public static final int TS_LOG_STREAM_STOP = 2;
 	public static final char TS_ONLINE_PROTOCOL = 'z';
 	public static final char TS_OUTPUT_ALL_COMMAND = 'A';
 	public static final char TS_OUTPUT_COMMAND = 'O';
@@ -107,11 +112,13 @@ public class Integration {
 	public static final int TS_RESPONSE_BURN_OK = 4;
 	public static final int TS_RESPONSE_CRC_FAILURE = 0x82;
 	public static final int TS_RESPONSE_FRAMING_ERROR = 0x8D;
+	public static final int TS_RESPONSE_LOG_STREAM_RECORD = 0x10;
 	public static final int TS_RESPONSE_OK = 0;
 	public static final int TS_RESPONSE_OUT_OF_RANGE = 0x84;
 	public static final int TS_RESPONSE_OVERRUN = 0x81;
 	public static final int TS_RESPONSE_UNDERRUN = 0x80;
 	public static final int TS_RESPONSE_UNRECOGNIZED_COMMAND = 0x83;
+	public static final int TS_SENSOR_CHART_READ = 7;
 	public static final char TS_SET_LOGGER_SWITCH = 'l';
 	public static final char TS_SIMULATE_CAN = '>';
 	public static final char TS_SINGLE_WRITE_COMMAND = 'W';
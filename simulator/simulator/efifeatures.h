@@ -60,8 +60,6 @@
 
 #define EFI_PRINTF_FUEL_DETAILS FALSE
 
-#define SC_BUFFER_SIZE 4000
-
 #define EFI_ACTIVE_CONFIGURATION_IN_FLASH FALSE
 
 #define EFI_BOOST_CONTROL TRUE
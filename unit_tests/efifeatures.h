@@ -23,8 +23,6 @@
 
 #define EFI_SENSOR_CHART TRUE
 
-#define SC_BUFFER_SIZE 4000
-
 #define EFI_PRINTF_FUEL_DETAILS TRUE
 
 #define EFI_CJ125 TRUE
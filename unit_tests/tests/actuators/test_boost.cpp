@@ -93,6 +93,61 @@ TEST(BoostControl, OpenLoop) {
 	EXPECT_FLOAT_EQ(bc.getOpenLoop(0).value_or(-1), 47.0f);
 }
 
+TEST(BoostControl, SpoolFeedForward) {
+	MockVp3d openMap;
+
+	// Just pass TPS input to output
+	EXPECT_CALL(openMap, getValue(_, _))
+		.WillRepeatedly([](float xRpm, float tps) { return tps; });
+
+	EngineTestHelper eth(engine_type_e::TEST_ENGINE);
+	engineConfiguration->isBoostControlEnabled = true;
+	engineConfiguration->boostType = CLOSED_LOOP;
+	engineConfiguration->boostSpoolFeedForward = true;
+
+	BoostController bc;
+
+	testBoostCltCorr.initTable(config->cltBoostCorr, config->cltBoostCorrBins);
+	testBoostIatCorr.initTable(config->iatBoostCorr, config->iatBoostCorrBins);
+	testBoostCltAdder.initTable(config->cltBoostAdder, config->cltBoostAdderBins);
+	testBoostIatAdder.initTable(config->iatBoostAdder, config->iatBoostAdderBins);
+
+	bc.init(nullptr, &openMap, nullptr, testBoostCltCorr, testBoostIatCorr, testBoostCltAdder, testBoostIatAdder, nullptr);
+
+	Sensor::setMockValue(SensorType::Tps1, 40.0f);
+	Sensor::setMockValue(SensorType::BarometricPressure, 100.0f);
+	// Lots of exhaust, the turbo is going to make more than 100 kPa of boost
+	engine->engineState.airflowEstimate = 700;
+
+	// Boost coming up quickly
+	float map = 150;
+	for (int i = 0; i < 20; i++) {
+		map += 2;
+		Sensor::setMockValue(SensorType::Map, map);
+		bc.setOutput(bc.getOpenLoop(200));
+	}
+
+	// Backed off ahead of the target
+	EXPECT_TRUE(bc.getSpoolModel().isSpooling());
+	EXPECT_LT(bc.getOpenLoop(200).value_or(-1), 35);
+
+	// Boost holding still is left to closed loop
+	for (int i = 0; i < 50; i++) {
+		bc.setOutput(bc.getOpenLoop(200));
+	}
+
+	EXPECT_FALSE(bc.getSpoolModel().isSpooling());
+	EXPECT_FLOAT_EQ(40, bc.getOpenLoop(200).value_or(-1));
+
+	// Disabled does nothing
+	engineConfiguration->boostSpoolFeedForward = false;
+	for (int i = 0; i < 20; i++) {
+		map += 2;
+		Sensor::setMockValue(SensorType::Map, map);
+		EXPECT_FLOAT_EQ(40, bc.getOpenLoop(200).value_or(-1));
+	}
+}
+
 TEST(BoostControl, BoostOpenLoopYAxis)
 {
 	MockVp3d openMap;
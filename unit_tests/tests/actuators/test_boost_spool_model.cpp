@@ -0,0 +1,173 @@
+#include "pch.h"
+
+#include "boost_spool_model.h"
+
+#define LOOP_PERIOD (FAST_CALLBACK_PERIOD_MS / 1000.0f)
+
+// Turbo with the same structure as the model, but a somewhat slower and stronger one than the defaults
+class SimulatedTurbo {
+public:
+	float gain = 0.3f;
+	float timeConstant = 0.6f;
+
+	float boost = 0;
+
+	void step(float exhaustPower, float duty) {
+		constexpr int substeps = 5;
+		constexpr float dt = LOOP_PERIOD / substeps;
+
+		for (int i = 0; i < substeps; i++) {
+			float opening = clampF(0, (boost * (1 - duty / 100) - BOOST_SPOOL_WASTEGATE_PRELOAD) / BOOST_SPOOL_WASTEGATE_SPAN, 1);
+			float turbineDrive = exhaustPower * (1 - opening * BOOST_SPOOL_WASTEGATE_BYPASS);
+			float tau = timeConstant * BOOST_SPOOL_REFERENCE_POWER / std::max(exhaustPower, BOOST_SPOOL_REFERENCE_POWER / 4.0f);
+
+			boost += (gain * turbineDrive - boost) / tau * dt;
+		}
+	}
+};
+
+// PI on top of open loop, the way BoostController does it
+class BoostLoop {
+public:
+	BoostLoop(SimulatedTurbo& turbo, BoostSpoolModel& model, bool useFeedForward)
+		: m_turbo(turbo)
+		, m_model(model)
+		, m_useFeedForward(useFeedForward)
+	{
+	}
+
+	float target = 100;
+	float openLoop = 40;
+
+	float maxBoost = 0;
+
+	void run(float seconds, float fromPower, float toPower, float rampSeconds) {
+		int loops = seconds / LOOP_PERIOD;
+
+		for (int i = 0; i < loops; i++) {
+			float exhaustPower = fromPower + (toPower - fromPower) * std::min(1.0f, i * LOOP_PERIOD / rampSeconds);
+
+			m_model.update(m_turbo.boost, exhaustPower, m_duty, LOOP_PERIOD);
+			float feedForward = m_useFeedForward ? m_model.getFeedForward(target) : 0;
+
+			float closedLoop = 0;
+			float error = target - m_turbo.boost;
+			if (m_turbo.boost < 20) {
+				m_integrator = 0;
+			} else {
+				if (!(m_useFeedForward && m_model.isSpooling())) {
+					float handover = m_useFeedForward ? m_model.getIntegratorHandover() : 0;
+					m_integrator = clampF(-20, m_integrator + handover + 2 * error * LOOP_PERIOD, 20);
+				}
+
+				closedLoop = clampF(-20, error + m_integrator, 20);
+			}
+
+			m_duty = clampF(0, openLoop + closedLoop + feedForward, 100);
+			m_turbo.step(exhaustPower, m_duty);
+
+			maxBoost = std::max(maxBoost, m_turbo.boost);
+		}
+	}
+
+private:
+	SimulatedTurbo& m_turbo;
+	BoostSpoolModel& m_model;
+	bool m_useFeedForward;
+
+	float m_duty = 0;
+	float m_integrator = 0;
+};
+
+TEST(BoostSpoolModel, exhaustPower) {
+	// 300 kg/h at 800C
+	EXPECT_NEAR(322, BoostSpoolModel::getExhaustPower(300, 800), 0.1f);
+}
+
+TEST(BoostSpoolModel, learnsGain) {
+	SimulatedTurbo turbo;
+	BoostSpoolModel model;
+	EXPECT_FLOAT_EQ(BOOST_SPOOL_DEFAULT_GAIN, model.getGain());
+
+	// Cruising on a little boost, wastegate shut
+	BoostLoop loop(turbo, model, false);
+	loop.run(5, 200, 200, 1);
+	EXPECT_NEAR(60, turbo.boost, 0.5f);
+	EXPECT_NEAR(turbo.gain, model.getGain(), 0.005f);
+
+	// And with the wastegate bypassing some of the exhaust
+	turbo.gain = 0.35f;
+	loop.run(5, 500, 500, 1);
+	EXPECT_NEAR(100, turbo.boost, 0.5f);
+	EXPECT_NEAR(turbo.gain, model.getGain(), 0.005f);
+
+	// Losing track of the turbo for a moment keeps what was learned
+	model.reset();
+	EXPECT_NEAR(turbo.gain, model.getGain(), 0.005f);
+
+	model.resetLearned();
+	EXPECT_FLOAT_EQ(BOOST_SPOOL_DEFAULT_GAIN, model.getGain());
+}
+
+TEST(BoostSpoolModel, predictsSpool) {
+	SimulatedTurbo turbo;
+	BoostSpoolModel model;
+	BoostLoop loop(turbo, model, false);
+	loop.run(5, 200, 200, 1);
+
+	// Exhaust power jumps, it takes a moment for the turbo to follow
+	for (int i = 0; i < 20; i++) {
+		turbo.step(500, 40);
+		model.update(turbo.boost, 500, 40, LOOP_PERIOD);
+	}
+	float predicted = model.predict(40);
+
+	SimulatedTurbo expected = turbo;
+	for (int i = 0; i < BOOST_SPOOL_HORIZON / LOOP_PERIOD; i++) {
+		expected.step(500, 40);
+	}
+
+	EXPECT_GT(predicted, turbo.boost + 20);
+	EXPECT_NEAR(expected.boost, predicted, 5);
+
+	// More duty holds the wastegate shut for longer
+	EXPECT_GT(model.predict(80), predicted);
+}
+
+static float tipIn(bool useFeedForward, float& settledBoost) {
+	SimulatedTurbo turbo;
+	BoostSpoolModel model;
+	BoostLoop loop(turbo, model, useFeedForward);
+
+	// Part throttle long enough to learn the turbo
+	loop.run(5, 200, 200, 1);
+
+	loop.maxBoost = 0;
+	loop.run(4, 200, 500, 0.2f);
+
+	settledBoost = turbo.boost;
+
+	if (useFeedForward) {
+		// Done spooling, nothing taken away from closed loop
+		EXPECT_FALSE(model.isSpooling());
+		EXPECT_EQ(0, model.getFeedForward(loop.target));
+	}
+
+	return loop.maxBoost;
+}
+
+TEST(BoostSpoolModel, reducesOvershoot) {
+	float settledWithout;
+	float overshootWithout = tipIn(false, settledWithout) - 100;
+
+	float settledWith;
+	float overshootWith = tipIn(true, settledWith) - 100;
+
+	// The integrator winding up while the turbo spools overshoots by a lot
+	EXPECT_GT(overshootWithout, 8);
+	EXPECT_LT(overshootWith, 3);
+
+	// Both get there in the end
+	EXPECT_NEAR(100, settledWithout, 1);
+	EXPECT_NEAR(100, settledWith, 1);
+}
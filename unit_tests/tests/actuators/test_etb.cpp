@@ -15,6 +15,7 @@
 
 using ::testing::_;
 using ::testing::Ne;
+using ::testing::NiceMock;
 using ::testing::Return;
 using ::testing::StrictMock;
 
@@ -731,6 +732,40 @@ TEST(etb, setOutputLimpHome) {
 	etb.setOutput(25.0f);
 }
 
+TEST(etb, setOutputFeedsPlantEstimator) {
+	EngineTestHelper eth(engine_type_e::TEST_ENGINE);
+	NiceMock<MockMotor> motor;
+
+	// Must have TPS & PPS initialized for ETB setup
+	Sensor::setMockValue(SensorType::Tps1Primary, 0);
+	Sensor::setMockValue(SensorType::Tps1, 0.0f, true);
+	Sensor::setMockValue(SensorType::AcceleratorPedal, 0.0f, true);
+
+	EtbController etb;
+	etb.init(DC_Throttle1, &motor, nullptr, nullptr, true);
+
+	// Throttle moving open
+	for (int i = 0; i < 5; i++) {
+		Sensor::setMockValue(SensorType::Tps1, 30.0f + i, true);
+		etb.setOutput(40.0f);
+	}
+
+	// First two loops only fill history
+	EXPECT_EQ(3u, etb.getPlantEstimator().getSampleCount());
+
+	// Paused throttle isn't driven by us, positions after that are not a continuation
+	engineConfiguration->pauseEtbControl = true;
+	etb.setOutput(40.0f);
+	engineConfiguration->pauseEtbControl = false;
+
+	for (int i = 0; i < 2; i++) {
+		Sensor::setMockValue(SensorType::Tps1, 50.0f + i, true);
+		etb.setOutput(40.0f);
+	}
+
+	EXPECT_EQ(3u, etb.getPlantEstimator().getSampleCount());
+}
+
 TEST(etb, closedLoopPid) {
 	EngineTestHelper eth(engine_type_e::TEST_ENGINE);
 
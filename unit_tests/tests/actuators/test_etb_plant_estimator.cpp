@@ -0,0 +1,205 @@
+#include "pch.h"
+
+#include "etb_plant_estimator.h"
+
+#define LOOP_PERIOD (1.0f / 500)
+
+// Throttle with the same structure as the identified model, Coulomb friction holds it still
+class SimulatedThrottle {
+public:
+	float gain = 40;
+	float timeConstant = 0.04f;
+	float springPreload = 12;
+	float springRate = 0.15f;
+	float friction = 4;
+
+	float position = 0;
+	float speed = 0;
+
+	void step(float duty) {
+		constexpr int substeps = 20;
+		constexpr float dt = LOOP_PERIOD / substeps;
+
+		for (int i = 0; i < substeps; i++) {
+			float drive = duty - springPreload - springRate * position;
+
+			if (speed == 0 && std::abs(drive) <= friction) {
+				continue;
+			}
+
+			float direction = speed != 0 ? (speed > 0 ? 1 : -1) : (drive > 0 ? 1 : -1);
+			float newSpeed = speed + (gain * (drive - friction * direction) - speed) / timeConstant * dt;
+
+			// friction stops it rather than reversing it
+			if (speed != 0 && newSpeed * speed < 0) {
+				newSpeed = 0;
+			}
+
+			speed = newSpeed;
+			position += speed * dt;
+
+			if (position < 0 || position > 100) {
+				position = clampF(0, position, 100);
+				speed = 0;
+			}
+		}
+	}
+};
+
+// Throttle following a pedal that keeps moving around, with a slightly noisy TPS
+class ThrottleDrive {
+public:
+	ThrottleDrive(SimulatedThrottle& throttle) : m_throttle(throttle) { }
+
+	void run(EtbPlantEstimator& estimator, float seconds) {
+		int loops = seconds / LOOP_PERIOD;
+
+		for (int i = 0; i < loops; i++) {
+			if (m_loop++ % 150 == 0) {
+				m_target = 5 + 85 * random();
+			}
+
+			float measured = m_throttle.position + 0.02f * (random() - 0.5f);
+
+			// feed forward for the spring we don't know, plus proportional
+			float duty = 12 + 0.15f * m_target + 4 * (m_target - measured);
+			duty = clampF(-90, duty, 90);
+
+			estimator.update(measured, duty);
+			m_throttle.step(duty);
+		}
+	}
+
+private:
+	float random() {
+		m_seed = m_seed * 1103515245 + 12345;
+		return ((m_seed >> 8) & 0xFFFF) / 65536.0f;
+	}
+
+	SimulatedThrottle& m_throttle;
+	uint32_t m_seed = 1;
+	uint32_t m_loop = 0;
+	float m_target = 0;
+};
+
+static void assertModel(const SimulatedThrottle& throttle, const EtbPlantEstimator& estimator) {
+	ASSERT_TRUE(estimator.isValid());
+
+	EtbPlantModel model = estimator.getModel();
+	EXPECT_NEAR(throttle.gain, model.gain, 0.1f * throttle.gain);
+	EXPECT_NEAR(throttle.timeConstant, model.timeConstant, 0.1f * throttle.timeConstant);
+	EXPECT_NEAR(throttle.springPreload, model.springPreload, 1.5f);
+	EXPECT_NEAR(throttle.springRate, model.springRate, 0.03f);
+	EXPECT_NEAR(throttle.friction, model.friction, 1.0f);
+}
+
+TEST(EtbPlantEstimator, notValidUntilEnoughMotion) {
+	EtbPlantEstimator estimator(LOOP_PERIOD);
+	EXPECT_FALSE(estimator.isValid());
+
+	// Throttle resting on its stop teaches nothing
+	for (int i = 0; i < 5000; i++) {
+		estimator.update(0, -10);
+	}
+	EXPECT_EQ(0u, estimator.getSampleCount());
+	EXPECT_FALSE(estimator.isValid());
+
+	// Neither does one held by friction at part throttle
+	estimator.interrupt();
+	for (int i = 0; i < 5000; i++) {
+		estimator.update(30, 16);
+	}
+	EXPECT_EQ(0u, estimator.getSampleCount());
+	EXPECT_FALSE(estimator.isValid());
+}
+
+TEST(EtbPlantEstimator, converges) {
+	SimulatedThrottle throttle;
+	ThrottleDrive drive(throttle);
+	EtbPlantEstimator estimator(LOOP_PERIOD);
+
+	drive.run(estimator, 20);
+
+	assertModel(throttle, estimator);
+}
+
+TEST(EtbPlantEstimator, followsDrift) {
+	SimulatedThrottle throttle;
+	ThrottleDrive drive(throttle);
+	EtbPlantEstimator estimator(LOOP_PERIOD);
+
+	drive.run(estimator, 20);
+	assertModel(throttle, estimator);
+
+	// Warm motor and grease: weaker and less sticky
+	throttle.gain = 32;
+	throttle.friction = 2.5f;
+
+	drive.run(estimator, 20);
+	assertModel(throttle, estimator);
+}
+
+TEST(EtbPlantEstimator, interruptDropsHistory) {
+	SimulatedThrottle throttle;
+	ThrottleDrive drive(throttle);
+	EtbPlantEstimator estimator(LOOP_PERIOD);
+
+	drive.run(estimator, 20);
+	uint32_t sampleCount = estimator.getSampleCount();
+
+	// Positions from before and after a gap in control are not one step apart
+	estimator.interrupt();
+	estimator.update(80, 20);
+	estimator.update(80.5f, 20);
+	EXPECT_EQ(sampleCount, estimator.getSampleCount());
+
+	estimator.update(81, 20);
+	EXPECT_EQ(sampleCount + 1, estimator.getSampleCount());
+}
+
+TEST(EtbPlantEstimator, pidGains) {
+	SimulatedThrottle throttle;
+	ThrottleDrive drive(throttle);
+	EtbPlantEstimator estimator(LOOP_PERIOD);
+
+	drive.run(estimator, 20);
+	ASSERT_TRUE(estimator.isValid());
+
+	float bandwidth = estimator.getRecommendedBandwidth();
+	EXPECT_NEAR(2 / throttle.timeConstant, bandwidth, 5);
+
+	pid_s gains = {};
+	estimator.getPidGains(bandwidth, gains);
+
+	// Exact model: tau = 0.04, K = 40, bandwidth = 50
+	EXPECT_NEAR(1.875f, gains.pFactor, 0.2f);
+	EXPECT_NEAR(15.6f, gains.iFactor, 1.5f);
+	EXPECT_NEAR(0.05f, gains.dFactor, 0.005f);
+
+	// Those gains with the feed forward from the model settle a step in half a second
+	EtbPlantModel model = estimator.getModel();
+	throttle.position = 20;
+	throttle.speed = 0;
+
+	float target = 60;
+	float integrator = 0;
+	float previousError = target - throttle.position;
+	float maxPosition = 0;
+
+	for (int i = 0; i < 250; i++) {
+		float error = target - throttle.position;
+		integrator += gains.iFactor * error * LOOP_PERIOD;
+		float duty = model.springPreload + model.springRate * target
+			+ gains.pFactor * error
+			+ integrator
+			+ gains.dFactor * (error - previousError) / LOOP_PERIOD;
+		previousError = error;
+
+		throttle.step(clampF(-90, duty, 90));
+		maxPosition = std::max(maxPosition, throttle.position);
+	}
+
+	EXPECT_NEAR(target, throttle.position, 1);
+	// overshoot is less than a quarter of the step
+	EXPECT_LT(maxPosition, target + 10);
+}
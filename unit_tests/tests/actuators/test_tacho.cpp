@@ -1,7 +1,11 @@
 #include "pch.h"
+#include "tachometer.h"
+
+#include <vector>
 
 extern float getTachFreq(void);
 extern float getTachDuty(void);
+extern bool isTachAngleBased(void);
 
 TEST(Actuators, Tachometer) {
     // This engine has a tach pin set - we need that
@@ -39,3 +43,156 @@ TEST(Actuators, Tachometer) {
     ASSERT_EQ(100, getTachFreq());
     ASSERT_EQ(0.5, getTachDuty());
 }
+
+static void setupAngleBasedTach(EngineTestHelper& eth) {
+	engineConfiguration->isInjectionEnabled = false;
+	engineConfiguration->isIgnitionEnabled = false;
+
+	// 3 pulses per rev: every 120 degrees, which is not on a tooth
+	engineConfiguration->tachPulsePerRev = 3;
+	engineConfiguration->tachPulseDuractionMs = 1;
+	engineConfiguration->tachPulseDurationAsDutyCycle = false;
+
+	engineConfiguration->trigger.type = trigger_type_e::TT_TOOTHED_WHEEL;
+	engineConfiguration->trigger.customTotalToothCount = 8;
+	engineConfiguration->trigger.customSkippedToothCount = 0;
+	engineConfiguration->globalTriggerAngleOffset = 0;
+	setCamOperationMode();
+	eth.applyTriggerWaveform();
+}
+
+/**
+ * Spins the wheel one edge at a time with each edge 'edgeFactor' times as long as the previous one,
+ * and collects the engine phase of every tach pulse. Phase between edges is interpolated the way
+ * the wheel actually moved, not the way the ECU predicted it.
+ * @return duration of the last edge
+ */
+static float spinTach(EngineTestHelper& eth, float edgeUs, float edgeFactor, int edgeCount, std::vector<float>& pulsePhases) {
+	constexpr int stepUs = 10;
+
+	bool isRising = true;
+	bool wasHigh = enginePins.tachOut.getLogicValue();
+	efitick_t previousEdgeNt = getTimeNowNt();
+	expected<float> previousPhase = unexpected;
+
+	for (int i = 0; i < edgeCount; i++, edgeUs *= edgeFactor) {
+		std::vector<efitick_t> rises;
+
+		for (int elapsedUs = 0; elapsedUs < (int)edgeUs; elapsedUs += stepUs) {
+			eth.moveTimeForwardAndInvokeEventsUs(std::min(stepUs, (int)edgeUs - elapsedUs));
+
+			bool isHigh = enginePins.tachOut.getLogicValue();
+			if (isHigh && !wasHigh) {
+				rises.push_back(getTimeNowNt());
+			}
+			wasHigh = isHigh;
+		}
+
+		if (isRising) {
+			eth.firePrimaryTriggerRise();
+		} else {
+			eth.firePrimaryTriggerFall();
+		}
+		isRising = !isRising;
+
+		efitick_t edgeNt = getTimeNowNt();
+		expected<float> phase = unexpected;
+		auto phaseFromSyncPoint = engine->triggerCentral.getCurrentEnginePhase(edgeNt);
+		if (phaseFromSyncPoint) {
+			float enginePhase = phaseFromSyncPoint.Value - tdcPosition();
+			wrapAngle(enginePhase, "test", ObdCode::CUSTOM_ERR_6555);
+			phase = enginePhase;
+		}
+
+		if (previousPhase && phase) {
+			float travel = phase.Value - previousPhase.Value;
+			if (travel < 0) {
+				travel += 720;
+			}
+
+			for (efitick_t riseNt : rises) {
+				float pulsePhase = previousPhase.Value + travel * (riseNt - previousEdgeNt) / (edgeNt - previousEdgeNt);
+				pulsePhases.push_back(pulsePhase);
+			}
+		}
+
+		previousEdgeNt = edgeNt;
+		previousPhase = phase;
+
+		// fast callback
+		tachUpdate();
+	}
+
+	return edgeUs;
+}
+
+static void assertTachPhases(const std::vector<float>& pulsePhases, float tolerance) {
+	for (float phase : pulsePhases) {
+		// distance to the nearest multiple of 120 degrees
+		EXPECT_NEAR(0, std::remainder(phase, 120), tolerance) << phase;
+	}
+}
+
+TEST(Actuators, TachometerAngleBased) {
+	EngineTestHelper eth(engine_type_e::MAZDA_MIATA_NB2, [](engine_configuration_s* engineConfiguration) {
+		engineConfiguration->tachOutputPin = Gpio::E8;
+	});
+	setupAngleBasedTach(eth);
+
+	// 16 edges per cycle, 5ms each is 1500 rpm
+	std::vector<float> pulsePhases;
+	spinTach(eth, 5000, 1, 64, pulsePhases);
+	ASSERT_EQ(1500, Sensor::getOrZero(SensorType::Rpm));
+
+	pulsePhases.clear();
+	spinTach(eth, 5000, 1, 64, pulsePhases);
+	// four cycles, six pulses each
+	EXPECT_NEAR(24, pulsePhases.size(), 1);
+	assertTachPhases(pulsePhases, 0.5);
+}
+
+TEST(Actuators, TachometerAngleBasedRamp) {
+	EngineTestHelper eth(engine_type_e::MAZDA_MIATA_NB2, [](engine_configuration_s* engineConfiguration) {
+		engineConfiguration->tachOutputPin = Gpio::E8;
+	});
+	setupAngleBasedTach(eth);
+
+	std::vector<float> pulsePhases;
+	spinTach(eth, 5000, 1, 64, pulsePhases);
+
+	// accelerate from 1500 to about 2000 rpm over ten cycles
+	pulsePhases.clear();
+	float edgeUs = spinTach(eth, 5000, 0.998, 160, pulsePhases);
+	EXPECT_NEAR(60, pulsePhases.size(), 1);
+	EXPECT_GT(Sensor::getOrZero(SensorType::Rpm), 1900);
+	// RPM is only known once per cycle, pulses between teeth are off by no more than the change since
+	assertTachPhases(pulsePhases, 3);
+
+	// and back down
+	pulsePhases.clear();
+	spinTach(eth, edgeUs, 1.002, 160, pulsePhases);
+	EXPECT_NEAR(60, pulsePhases.size(), 1);
+	EXPECT_LT(Sensor::getOrZero(SensorType::Rpm), 1600);
+	assertTachPhases(pulsePhases, 3);
+}
+
+TEST(Actuators, TachometerPwmFallback) {
+	EngineTestHelper eth(engine_type_e::MAZDA_MIATA_NB2, [](engine_configuration_s* engineConfiguration) {
+		engineConfiguration->tachOutputPin = Gpio::E8;
+	});
+	setupAngleBasedTach(eth);
+
+	// a few edges, not enough for RPM
+	std::vector<float> pulsePhases;
+	spinTach(eth, 5000, 1, 3, pulsePhases);
+	EXPECT_FALSE(isTachAngleBased());
+
+	spinTach(eth, 5000, 1, 64, pulsePhases);
+	EXPECT_TRUE(isTachAngleBased());
+	EXPECT_EQ(75, getTachFreq());
+
+	// engine stopped, back to PWM
+	engine->rpmCalculator.setStopSpinning();
+	tachUpdate();
+	EXPECT_FALSE(isTachAngleBased());
+}
@@ -2,8 +2,13 @@
 
 #include "vvt.h"
 
+using ::testing::_;
+using ::testing::FloatNear;
+using ::testing::NiceMock;
 using ::testing::StrictMock;
 using ::testing::Return;
+using ::testing::ReturnPointee;
+using ::testing::SaveArg;
 
 TEST(Vvt, TestSetPoint) {
 	EngineTestHelper eth(engine_type_e::TEST_ENGINE);
@@ -38,7 +43,7 @@ TEST(Vvt, observePlant) {
 TEST(Vvt, openLoop) {
 	VvtController dut(0);
 
-	// No open loop for now
+	// Nothing learned yet, no feed forward
 	EXPECT_EQ(dut.getOpenLoop(10), 0);
 }
 
@@ -76,3 +81,167 @@ TEST(Vvt, ClosedLoopInverted) {
 	// Target of -30 with position -20 should yield positive duty, P=1.5 means 15% duty for 10% error
 	EXPECT_EQ(dut.getClosedLoop(-30, -20).value_or(0), 15);
 }
+
+static void setupVvtClosedLoop(float pFactor, float iFactor) {
+	engineConfiguration->vvtControlMinRpm = 500;
+	engineConfiguration->vvtActivationDelayMs = 0;
+	engineConfiguration->invertVvtControlIntake = false;
+
+	engineConfiguration->auxPid[0].pFactor = pFactor;
+	engineConfiguration->auxPid[0].iFactor = iFactor;
+	engineConfiguration->auxPid[0].dFactor = 0;
+	engineConfiguration->auxPid[0].offset = 0;
+	engineConfiguration->auxPid[0].periodMs = 10;
+	engineConfiguration->auxPid[0].minValue = -100;
+	engineConfiguration->auxPid[0].maxValue = 100;
+
+	engine->engineState.fuelingLoad = 50;
+	Sensor::setMockValue(SensorType::Rpm, 2500);
+	Sensor::setMockValue(SensorType::OilTemperature, 90);
+}
+
+static void camMeasurement(VvtController& dut, angle_t position) {
+	engine->triggerCentral.vvtPosition[0][0] = position;
+	dut.onCamMeasurement(getTimeNowNt());
+}
+
+TEST(Vvt, ClosedLoopOncePerCamPosition) {
+	EngineTestHelper eth(engine_type_e::TEST_ENGINE);
+	setupVvtClosedLoop(0, 10);
+
+	NiceMock<MockVp3d> targetMap;
+	ON_CALL(targetMap, getValue(_, _)).WillByDefault(Return(30));
+	StrictMock<MockPwm> pwm;
+
+	VvtController dut(0);
+	dut.init(&targetMap, &pwm);
+
+	// No cam position yet, nothing to act on
+	dut.onFastCallback();
+
+	// First one has no previous cam position, PID period from config is used: 10 * 0.01s * 10deg
+	camMeasurement(dut, 20);
+	EXPECT_CALL(pwm, setSimplePwmDutyCycle(FloatNear(0.01f, 1e-5)));
+	dut.onFastCallback();
+	// Same cam position, the loop doesn't run again
+	dut.onFastCallback();
+	dut.onFastCallback();
+	testing::Mock::VerifyAndClearExpectations(&pwm);
+
+	// Slow cam: many fast callbacks for one cam position 20ms later, 10 * 0.02s * 10deg more
+	eth.moveTimeForwardMs(20);
+	camMeasurement(dut, 20);
+	EXPECT_CALL(pwm, setSimplePwmDutyCycle(FloatNear(0.03f, 1e-5)));
+	for (int i = 0; i < 4; i++) {
+		dut.onFastCallback();
+	}
+	testing::Mock::VerifyAndClearExpectations(&pwm);
+
+	// Cam steps closer to the target, 10 * 0.04s * 5deg more
+	eth.moveTimeForwardMs(40);
+	camMeasurement(dut, 25);
+	EXPECT_CALL(pwm, setSimplePwmDutyCycle(FloatNear(0.05f, 1e-5)));
+	dut.onFastCallback();
+	testing::Mock::VerifyAndClearExpectations(&pwm);
+
+	// Cam signal is gone: output off once the last position is too old
+	eth.moveTimeForwardMs(VVT_MEASUREMENT_TIMEOUT_MS / 2);
+	dut.onFastCallback();
+	testing::Mock::VerifyAndClearExpectations(&pwm);
+
+	eth.moveTimeForwardMs(VVT_MEASUREMENT_TIMEOUT_MS);
+	EXPECT_CALL(pwm, setSimplePwmDutyCycle(0));
+	dut.onFastCallback();
+	dut.onFastCallback();
+}
+
+TEST(Vvt, LearnsHoldDuty) {
+	EngineTestHelper eth(engine_type_e::TEST_ENGINE);
+	setupVvtClosedLoop(2, 2);
+
+	float target = 20;
+	NiceMock<MockVp3d> targetMap;
+	ON_CALL(targetMap, getValue(_, _)).WillByDefault(ReturnPointee(&target));
+	float duty = 0;
+	NiceMock<MockPwm> pwm;
+	ON_CALL(pwm, setSimplePwmDutyCycle(_)).WillByDefault(SaveArg<0>(&duty));
+
+	VvtController dut(0);
+	dut.init(&targetMap, &pwm);
+
+	// Cam phaser moves at 2 deg/s per % duty away from its 40% hold duty, one cam position every 40ms
+	constexpr float holdDuty = 40;
+	float position = 25;
+
+	for (int i = 0; i < 1500; i++) {
+		// Cam phase steps back and forth every second
+		target = (i / 25) % 2 ? 30 : 20;
+
+		camMeasurement(dut, position);
+		dut.onFastCallback();
+
+		position += 2 * (100 * duty - holdDuty) * 0.04f;
+		eth.moveTimeForwardMs(40);
+	}
+
+	EXPECT_NEAR(target, position, 1.5f);
+
+	// Hold duty went from the integrator into the feed forward where we were running
+	EXPECT_NEAR(holdDuty, dut.getFeedForward(90, 2500), 1);
+	EXPECT_NEAR(holdDuty, dut.getOpenLoop(target).value_or(0), 1);
+
+	// Not where we weren't
+	EXPECT_EQ(0, dut.getFeedForward(20, 7000));
+}
+
+TEST(Vvt, LearnsHoldDutyBetweenBins) {
+	EngineTestHelper eth(engine_type_e::TEST_ENGINE);
+	setupVvtClosedLoop(2, 2);
+	// Output range is narrower than what a single cell would need if it took all of the learning
+	engineConfiguration->auxPid[0].maxValue = 60;
+
+	// Halfway between the oil temperature bins, a quarter of the way between the RPM bins
+	Sensor::setMockValue(SensorType::Clt, 75);
+	Sensor::setMockValue(SensorType::Rpm, 3000);
+
+	float target = 20;
+	NiceMock<MockVp3d> targetMap;
+	ON_CALL(targetMap, getValue(_, _)).WillByDefault(ReturnPointee(&target));
+	float duty = 0;
+	NiceMock<MockPwm> pwm;
+	ON_CALL(pwm, setSimplePwmDutyCycle(_)).WillByDefault(SaveArg<0>(&duty));
+
+	VvtController dut(0);
+	dut.init(&targetMap, &pwm);
+
+	constexpr float holdDuty = 40;
+	float position = 25;
+
+	for (int i = 0; i < 1500; i++) {
+		target = (i / 25) % 2 ? 30 : 20;
+
+		camMeasurement(dut, position);
+		dut.onFastCallback();
+
+		position += 2 * (100 * duty - holdDuty) * 0.04f;
+		eth.moveTimeForwardMs(40);
+	}
+
+	EXPECT_NEAR(target, position, 1.5f);
+
+	// Read back where we were running, the integrator did not have to keep pushing a single cell past the hold duty
+	EXPECT_NEAR(holdDuty, dut.getFeedForward(75, 3000), 1);
+
+	// Every cell around the operating point took its share and none of them left the output range
+	for (float oilTemp : { 60, 90 }) {
+		for (float rpm : { 2500, 4500 }) {
+			float cell = dut.getFeedForward(oilTemp, rpm);
+			EXPECT_GT(cell, 10) << oilTemp << "/" << rpm;
+			EXPECT_LE(cell, 60) << oilTemp << "/" << rpm;
+		}
+	}
+
+	// Nothing outside of them
+	EXPECT_EQ(0, dut.getFeedForward(20, 1000));
+	EXPECT_EQ(0, dut.getFeedForward(120, 7000));
+}
@@ -9,55 +9,38 @@
 
 #include "pch.h"
 
-struct MockWallController : public IWallFuelController {
-	MOCK_METHOD(bool, getEnable, (), (const, override));
-	MOCK_METHOD(float, getAlpha, (), (const, override));
-	MOCK_METHOD(float, getBeta, (), (const, override));
-};
-
 TEST(fuel, testWallWettingEnrichmentMath) {
 	EngineTestHelper eth(engine_type_e::FORD_ASPIRE_1996);
 
-	MockWallController wallController;
-
-	// WW is enabled!
-	EXPECT_CALL(wallController, getEnable()).WillRepeatedly(Return(true));
-
-	// 1/2 of fuel remains on walls
-	EXPECT_CALL(wallController, getAlpha()).WillRepeatedly(Return(0.5f));
-
-	// 1/4 of fuel is lands on walls
-	EXPECT_CALL(wallController, getBeta()).WillRepeatedly(Return(0.25f));
-
-	// install our mock in to the engine
-	engine->engineModules.get<WallFuelController>().set(&wallController);
+	// 1/2 of fuel remains on walls, 1/4 of fuel is lands on walls
+	WallFuelCoefs coefs(0.5f, 0.25f);
 
 	WallFuel wallFuel;
 
 	// each invocation of 'adjust' changes WallWetting internal state
-	EXPECT_NEAR(1.3333, wallFuel.adjust(1), EPS4D);
-	EXPECT_NEAR(1.1111, wallFuel.adjust(1), EPS4D);
-	EXPECT_NEAR(1.0370, wallFuel.adjust(1), EPS4D);
-	EXPECT_NEAR(1.0123, wallFuel.adjust(1), EPS4D);
+	EXPECT_NEAR(1.3333, wallFuel.adjust(1, coefs), EPS4D);
+	EXPECT_NEAR(1.1111, wallFuel.adjust(1, coefs), EPS4D);
+	EXPECT_NEAR(1.0370, wallFuel.adjust(1, coefs), EPS4D);
+	EXPECT_NEAR(1.0123, wallFuel.adjust(1, coefs), EPS4D);
 
 	// get to steady state
 	for (size_t i = 0; i < 50; i++) {
-		wallFuel.adjust(1);
+		wallFuel.adjust(1, coefs);
 	}
 
-	EXPECT_NEAR(1, wallFuel.adjust(1), EPS4D);
+	EXPECT_NEAR(1, wallFuel.adjust(1, coefs), EPS4D);
 
 	// now run half the fuel
-	EXPECT_NEAR(0.3333, wallFuel.adjust(0.5), EPS4D);
-	EXPECT_NEAR(0.4444, wallFuel.adjust(0.5), EPS4D);
-	EXPECT_NEAR(0.4815, wallFuel.adjust(0.5), EPS4D);
-	EXPECT_NEAR(0.4938, wallFuel.adjust(0.5), EPS4D);
+	EXPECT_NEAR(0.3333, wallFuel.adjust(0.5, coefs), EPS4D);
+	EXPECT_NEAR(0.4444, wallFuel.adjust(0.5, coefs), EPS4D);
+	EXPECT_NEAR(0.4815, wallFuel.adjust(0.5, coefs), EPS4D);
+	EXPECT_NEAR(0.4938, wallFuel.adjust(0.5, coefs), EPS4D);
 
 	for (size_t i = 0; i < 50; i++) {
-		wallFuel.adjust(0.5);
+		wallFuel.adjust(0.5, coefs);
 	}
 
-	EXPECT_NEAR(0.5, wallFuel.adjust(0.5), EPS4D);
+	EXPECT_NEAR(0.5, wallFuel.adjust(0.5, coefs), EPS4D);
 }
 
 TEST(fuel, testWallWettingEnrichmentScheduling) {
@@ -94,3 +77,104 @@ TEST(fuel, testWallWettingEnrichmentScheduling) {
 	// Cylinder 5 doesn't exist - shouldn't have been called!
 	ASSERT_EQ(0, engine->injectionEvents.elements[5].getWallFuel().invocationCounter);
 }
+
+/**
+ * Wall wetting math as it was with a single set of coefficients for all cylinders
+ */
+struct ReferenceWallFuel {
+	float adjust(float desiredMassGrams, const IWallFuelController& controller) {
+		if (!controller.getEnable()) {
+			return desiredMassGrams;
+		}
+
+		float alpha = controller.getAlpha();
+		float beta = controller.getBeta();
+
+		float M_cmd = (desiredMassGrams - (1 - alpha) * film) / (1 - beta);
+		if (M_cmd <= 0) {
+			M_cmd = 0;
+		}
+
+		film = alpha * film + beta * M_cmd;
+		return M_cmd;
+	}
+
+	float film = 0;
+};
+
+static void setSimpleWallModel() {
+	engineConfiguration->complexWallModel = false;
+	engineConfiguration->wwaeTau = 0.3f;
+	engineConfiguration->wwaeBeta = 0.4f;
+}
+
+TEST(fuel, testWallWettingUntrimmedMatchesReference) {
+	EngineTestHelper eth(engine_type_e::FORD_ASPIRE_1996);
+	setSimpleWallModel();
+
+	auto& controller = engine->module<WallFuelController>().unmock();
+	WallFuel wallFuel;
+	ReferenceWallFuel reference;
+
+	const float masses[] = { 0.02f, 0.02f, 0.05f, 0.05f, 0.05f, 0.001f, 0.001f, 0.03f, 0.01f, 0.04f };
+	const float rpms[] = { 900, 2500, 6000 };
+
+	for (float rpm : rpms) {
+		Sensor::setMockValue(SensorType::Rpm, rpm);
+		controller.onFastCallback();
+		ASSERT_TRUE(controller.getEnable());
+
+		for (float mass : masses) {
+			float expected = reference.adjust(mass, controller);
+			// bit for bit, not just close
+			EXPECT_EQ(expected, wallFuel.adjust(mass, controller.getCoefs(0))) << rpm << " " << mass;
+			EXPECT_EQ(reference.film, wallFuel.getWallFuel());
+		}
+	}
+
+	// below 100 rpm the model is disabled: fuel passes through and the film is kept
+	Sensor::setMockValue(SensorType::Rpm, 50);
+	controller.onFastCallback();
+	ASSERT_FALSE(controller.getEnable());
+
+	float film = wallFuel.getWallFuel();
+	EXPECT_EQ(0.02f, wallFuel.adjust(0.02f, controller.getCoefs(0)));
+	EXPECT_EQ(film, wallFuel.getWallFuel());
+}
+
+TEST(fuel, testWallWettingCylinderTrim) {
+	EngineTestHelper eth(engine_type_e::FORD_ASPIRE_1996);
+	setSimpleWallModel();
+	Sensor::setMockValue(SensorType::Rpm, 3000);
+
+	auto& controller = engine->module<WallFuelController>().unmock();
+	// long runner cylinder: film evaporates slower and catches more fuel
+	controller.setCylinderTrim(1, 1.05f, 1.3f);
+	controller.onFastCallback();
+
+	EXPECT_EQ(controller.getAlpha(), controller.getCoefs(0).alpha);
+	EXPECT_EQ(controller.getBeta(), controller.getCoefs(0).beta);
+	EXPECT_NEAR(controller.getAlpha() * 1.05f, controller.getCoefs(1).alpha, EPS4D);
+	EXPECT_NEAR(controller.getBeta() * 1.3f, controller.getCoefs(1).beta, EPS4D);
+
+	WallFuel shortRunner;
+	WallFuel longRunner;
+	for (int i = 0; i < 5; i++) {
+		shortRunner.adjust(0.02f, controller.getCoefs(0));
+		longRunner.adjust(0.02f, controller.getCoefs(1));
+	}
+
+	EXPECT_GT(longRunner.getWallFuel(), shortRunner.getWallFuel());
+
+	// tip-in: the cylinder with more film on the wall needs more extra fuel
+	float shortExtra = shortRunner.adjust(0.04f, controller.getCoefs(0)) - 0.04f;
+	float longExtra = longRunner.adjust(0.04f, controller.getCoefs(1)) - 0.04f;
+	EXPECT_GT(longExtra, shortExtra);
+	EXPECT_GT(shortExtra, 0);
+
+	// trims can not make the model unstable
+	controller.setCylinderTrim(2, 10, 10);
+	controller.onFastCallback();
+	EXPECT_LT(controller.getCoefs(2).beta, 1);
+	EXPECT_LE(controller.getCoefs(2).beta, controller.getCoefs(2).alpha);
+}
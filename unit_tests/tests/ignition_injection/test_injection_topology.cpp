@@ -0,0 +1,118 @@
+#include "pch.h"
+
+static void assertOutputs(const char* msg, InjectionEvent& event, int primary, int twin) {
+	ASSERT_NE(nullptr, event.outputs[0]) << msg;
+	EXPECT_EQ(primary, event.outputs[0]->injectorIndex) << msg;
+	EXPECT_EQ(&enginePins.injectorsStage2[primary], event.outputsStage2[0]) << msg;
+
+	if (twin < 0) {
+		EXPECT_EQ(nullptr, event.outputs[1]) << msg;
+		EXPECT_EQ(nullptr, event.outputsStage2[1]) << msg;
+	} else {
+		ASSERT_NE(nullptr, event.outputs[1]) << msg;
+		EXPECT_EQ(twin, event.outputs[1]->injectorIndex) << msg;
+		EXPECT_EQ(&enginePins.injectorsStage2[twin], event.outputsStage2[1]) << msg;
+	}
+}
+
+static void assertSequential(FuelSchedule& schedule) {
+	// 1-3-4-2
+	assertOutputs("seq 0", schedule.elements[0], 0, -1);
+	assertOutputs("seq 1", schedule.elements[1], 2, -1);
+	assertOutputs("seq 2", schedule.elements[2], 3, -1);
+	assertOutputs("seq 3", schedule.elements[3], 1, -1);
+}
+
+static void assertSimultaneous(FuelSchedule& schedule) {
+	for (size_t i = 0; i < 4; i++) {
+		assertOutputs("simultaneous", schedule.elements[i], 0, -1);
+	}
+}
+
+static void setupTopologyTest(EngineTestHelper& eth, injection_mode_e crankingMode) {
+	setupSimpleTestEngineWithMafAndTT_ONE_trigger(&eth, IM_SEQUENTIAL);
+	engineConfiguration->cylindersCount = 4;
+	engineConfiguration->firingOrder = FO_1_3_4_2;
+	engineConfiguration->crankingInjectionMode = crankingMode;
+}
+
+TEST(InjectionTopology, simultaneousCrankingToSequential) {
+	EngineTestHelper eth(engine_type_e::TEST_ENGINE);
+	setupTopologyTest(eth, IM_SIMULTANEOUS);
+	FuelSchedule& schedule = engine->injectionEvents;
+
+	engine->rpmCalculator.setRpmValue(200);
+	ASSERT_TRUE(engine->rpmCalculator.isCranking());
+	schedule.addFuelEvents();
+	EXPECT_EQ((uint8_t)IM_SIMULTANEOUS, engine->outputChannels.currentInjectionMode);
+	assertSimultaneous(schedule);
+
+	engine->rpmCalculator.setRpmValue(1000);
+	ASSERT_TRUE(engine->rpmCalculator.isRunning());
+	EXPECT_EQ((uint8_t)IM_SEQUENTIAL, engine->outputChannels.currentInjectionMode);
+	assertSequential(schedule);
+
+	uint32_t buildCount = schedule.getTopologyBuildCount();
+
+	// stall and restart: both topologies are already there
+	engine->rpmCalculator.setRpmValue(0);
+	engine->rpmCalculator.setRpmValue(200);
+	ASSERT_TRUE(engine->rpmCalculator.isCranking());
+	schedule.addFuelEvents();
+	assertSimultaneous(schedule);
+
+	engine->rpmCalculator.setRpmValue(1000);
+	assertSequential(schedule);
+
+	for (int i = 0; i < 10; i++) {
+		schedule.addFuelEvents();
+	}
+	assertSequential(schedule);
+	EXPECT_EQ(buildCount, schedule.getTopologyBuildCount());
+}
+
+TEST(InjectionTopology, batchCrankingToSequential) {
+	EngineTestHelper eth(engine_type_e::TEST_ENGINE);
+	setupTopologyTest(eth, IM_BATCH);
+	FuelSchedule& schedule = engine->injectionEvents;
+
+	engine->rpmCalculator.setRpmValue(200);
+	ASSERT_TRUE(engine->rpmCalculator.isCranking());
+	schedule.addFuelEvents();
+	EXPECT_EQ((uint8_t)IM_BATCH, engine->outputChannels.currentInjectionMode);
+	// each injector also fires its twin 360 degrees later in the firing order
+	assertOutputs("batch 0", schedule.elements[0], 0, 3);
+	assertOutputs("batch 1", schedule.elements[1], 2, 1);
+	assertOutputs("batch 2", schedule.elements[2], 3, 0);
+	assertOutputs("batch 3", schedule.elements[3], 1, 2);
+
+	engine->rpmCalculator.setRpmValue(1000);
+	assertSequential(schedule);
+
+	uint32_t buildCount = schedule.getTopologyBuildCount();
+	engine->rpmCalculator.setRpmValue(0);
+	engine->rpmCalculator.setRpmValue(200);
+	schedule.addFuelEvents();
+	assertOutputs("batch again", schedule.elements[1], 2, 1);
+	EXPECT_EQ(buildCount, schedule.getTopologyBuildCount());
+}
+
+TEST(InjectionTopology, firingOrderChange) {
+	EngineTestHelper eth(engine_type_e::TEST_ENGINE);
+	setupTopologyTest(eth, IM_SEQUENTIAL);
+	FuelSchedule& schedule = engine->injectionEvents;
+
+	engine->rpmCalculator.setRpmValue(1000);
+	schedule.addFuelEvents();
+	assertSequential(schedule);
+	uint32_t buildCount = schedule.getTopologyBuildCount();
+
+	// same mode, the cached topology no longer matches
+	engineConfiguration->firingOrder = FO_1_2_4_3;
+	schedule.addFuelEvents();
+	EXPECT_EQ(buildCount + 1, schedule.getTopologyBuildCount());
+	assertOutputs("1-2-4-3 0", schedule.elements[0], 0, -1);
+	assertOutputs("1-2-4-3 1", schedule.elements[1], 1, -1);
+	assertOutputs("1-2-4-3 2", schedule.elements[2], 3, -1);
+	assertOutputs("1-2-4-3 3", schedule.elements[3], 2, -1);
+}
@@ -129,6 +129,66 @@ TEST(InjectorModel, nonlinearPolynomial) {
 	EXPECT_EQ(dut.correctInjectionPolynomial(10.1f), 10.1f);
 }
 
+TEST(InjectorModel, nonlinearPolynomialLookup) {
+	EngineTestHelper eth(engine_type_e::TEST_ENGINE);
+	InjectorModelPrimary dut;
+
+	engineConfiguration->injectorNonlinearMode = INJ_PolynomialAdder;
+	engineConfiguration->applyNonlinearBelowPulse = 3;
+	setArrayValues(engineConfiguration->injectorCorrectionPolynomial, 0);
+	engineConfiguration->injectorCorrectionPolynomial[0] = 0.3f;
+	engineConfiguration->injectorCorrectionPolynomial[1] = -0.2f;
+	engineConfiguration->injectorCorrectionPolynomial[2] = 0.05f;
+	engineConfiguration->injectorCorrectionPolynomial[3] = -0.005f;
+
+	dut.prepare();
+
+	// table lookup matches the polynomial across the whole corrected range
+	for (int i = 0; i < 300; i++) {
+		float duration = i * 0.01f;
+		float mass = dut.getFuelMassForDuration(duration);
+		EXPECT_NEAR(dut.getBaseDurationImpl(mass), dut.correctInjectionPolynomial(duration), 1e-3) << duration;
+	}
+
+	// no correction above the limit
+	float largeMass = dut.getFuelMassForDuration(3.5f);
+	EXPECT_NEAR(dut.getBaseDurationImpl(largeMass), 3.5f, EPS4D);
+
+	// live tuning changes are picked up without a burn
+	engineConfiguration->injectorCorrectionPolynomial[0] = 0.5f;
+	dut.prepare();
+	float mass = dut.getFuelMassForDuration(1);
+	EXPECT_NEAR(dut.getBaseDurationImpl(mass), dut.correctInjectionPolynomial(1), 1e-3);
+	EXPECT_NEAR(dut.getBaseDurationImpl(mass), 1 + 0.5f - 0.2f + 0.05f - 0.005f, 1e-3);
+}
+
+TEST(InjectorModel, nonlinearPolynomialLookupFullPolynomial) {
+	EngineTestHelper eth(engine_type_e::TEST_ENGINE);
+	InjectorModelPrimary dut;
+
+	// All 8 terms, fitted to an adder which starts at 0.45ms and fades out by 1.25ms
+	engineConfiguration->injectorNonlinearMode = INJ_PolynomialAdder;
+	engineConfiguration->applyNonlinearBelowPulse = 1.25f;
+	const float coefs[] = { 0.45f, -0.99f, 1.089f, -0.7986f, 0.4392f, -0.1933f, 0.0709f, -0.0223f };
+	static_assert(sizeof(coefs) == sizeof(engineConfiguration->injectorCorrectionPolynomial));
+	copyArray(engineConfiguration->injectorCorrectionPolynomial, coefs);
+
+	dut.prepare();
+
+	// Linear interpolation error is at most step^2 / 8 times the largest curvature, which is 2.2ms/ms^2 at zero
+	float step = engineConfiguration->applyNonlinearBelowPulse / INJECTOR_POLYNOMIAL_LUT_SIZE;
+	float bound = step * step / 8 * 2.2f + 1e-5f;
+	// a fraction of a microsecond
+	ASSERT_LT(bound, 2e-4f);
+
+	// half steps keep the samples off the limit itself, where rounding in the mass round trip decides the side
+	for (int i = 0; i < 1300; i++) {
+		float duration = (i + 0.5f) * 0.001f;
+		float mass = dut.getFuelMassForDuration(duration);
+		EXPECT_NEAR(dut.getBaseDurationImpl(mass), dut.correctInjectionPolynomial(duration), bound) << duration;
+	}
+}
+
 TEST(InjectorModel, Deadtime) {
 	EngineTestHelper eth(engine_type_e::TEST_ENGINE);
 
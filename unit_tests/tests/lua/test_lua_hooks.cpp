@@ -1,5 +1,6 @@
 #include "pch.h"
 #include "rusefi_lua.h"
+#include "malfunction_central.h"
 
 
 TEST(LuaHooks, TestCrc8) {
@@ -214,3 +215,35 @@ end
 TEST(LuaHooks, LuaPid) {
 	EXPECT_EQ(testLuaReturnsNumber(pidTest), 0);
 }
+
+static const char* dtcTest = R"(
+function testFunc()
+	setDtc(2135)
+	setDtc(2136)
+	if not hasDtc(2135) or getDtcCount() ~= 2 then
+		return 1
+	end
+
+	local rpm, load, clt, lambda = getFreezeFrame(2135)
+	if rpm ~= 3000 then
+		return 2
+	end
+
+	clearDtc(2135)
+	if hasDtc(2135) or getFreezeFrame(2135) ~= nil then
+		return 3
+	end
+
+	clearDtc()
+	return getDtcCount()
+end
+)";
+
+TEST(LuaHooks, Dtc) {
+	EngineTestHelper eth(engine_type_e::TEST_ENGINE);
+	clearWarnings();
+	Sensor::setMockValue(SensorType::Rpm, 3000);
+
+	EXPECT_EQ(testLuaReturnsNumber(dtcTest), 0);
+	EXPECT_FALSE(hasErrorCodes());
+}
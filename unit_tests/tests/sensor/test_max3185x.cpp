@@ -0,0 +1,216 @@
+#include "pch.h"
+
+#include "max3185x_batch.h"
+
+namespace {
+
+enum class ChipKind {
+	Absent,
+	Max31855,
+	Max31856,
+};
+
+static uint32_t max31855Packet(float temp, float coldJunction, uint8_t faults = 0) {
+	uint32_t tc = (int32_t)(temp * 4) & 0x3fff;
+	uint32_t cj = (int32_t)(coldJunction * 16) & 0xfff;
+	return (tc << 18) | (faults ? BIT(16) : 0) | (cj << 4) | faults;
+}
+
+/**
+ * Emulates the chips behind each chip select
+ */
+class MockMax3185xBus final : public IMax3185xBus {
+public:
+	void begin() override {
+		EXPECT_FALSE(inBatch);
+		inBatch = true;
+		batchCount++;
+	}
+
+	void end() override {
+		EXPECT_TRUE(inBatch);
+		inBatch = false;
+	}
+
+	bool exchange(size_t channel, const uint8_t* tx, uint8_t* rx, size_t n) override {
+		EXPECT_TRUE(inBatch);
+		exchangeCount++;
+
+		auto& chip = chips[channel];
+		switch (chip.kind) {
+		case ChipKind::Absent:
+			// MISO pulled up
+			memset(rx, 0xff, n);
+			break;
+		case ChipKind::Max31855:
+			// read only, shifts out the last conversion whatever is on MOSI
+			for (size_t i = 0; i < n; i++) {
+				rx[i] = i < 4 ? chip.packet >> (24 - 8 * i) : 0;
+			}
+			break;
+		case ChipKind::Max31856: {
+			uint8_t address = tx[0] & 0x7f;
+			rx[0] = 0;
+			for (size_t i = 1; i < n; i++) {
+				uint8_t reg = (address + i - 1) & 0xf;
+				if (tx[0] & BIT(7)) {
+					chip.registers[reg] = tx[i];
+					rx[i] = 0;
+				} else {
+					rx[i] = chip.registers[reg];
+				}
+			}
+			break;
+		}
+		}
+
+		return true;
+	}
+
+	struct Chip {
+		ChipKind kind = ChipKind::Absent;
+		uint32_t packet = 0;
+		uint8_t registers[16] = {};
+
+		void setMax31856(float temp, float coldJunction, uint8_t status = 0) {
+			uint32_t tc = (int32_t)(temp * 128) & 0x7ffff;
+			registers[0x0c] = tc >> 11;
+			registers[0x0d] = tc >> 3;
+			registers[0x0e] = (tc & 0x7) << 5;
+
+			uint32_t cj = (int32_t)(coldJunction * 64) & 0x3fff;
+			registers[0x0a] = cj >> 6;
+			registers[0x0b] = (cj & 0x3f) << 2;
+
+			registers[0x0f] = status;
+		}
+	};
+
+	Chip chips[EGT_CHANNEL_COUNT];
+	bool inBatch = false;
+	int batchCount = 0;
+	int exchangeCount = 0;
+};
+
+}
+
+TEST(Max3185x, decodeMixedChips) {
+	MockMax3185xBus bus;
+	bus.chips[0].kind = ChipKind::Max31855;
+	bus.chips[0].packet = max31855Packet(850.25f, 25.5f);
+	bus.chips[1].kind = ChipKind::Max31856;
+	bus.chips[1].setMax31856(612.5f, 31.25f);
+	bus.chips[2].kind = ChipKind::Max31855;
+	bus.chips[2].packet = max31855Packet(-10.5f, -5.0f);
+	// chip 3 enabled but not fitted
+
+	Max3185xBatch batch;
+	for (size_t i = 0; i < 4; i++) {
+		batch.setEnabled(i, true);
+	}
+
+	const auto& snapshot = batch.read(bus, 1234);
+
+	// one bus ownership for all chips
+	EXPECT_EQ(1, bus.batchCount);
+	EXPECT_EQ(1234, snapshot.timestamp);
+
+	EXPECT_EQ(MAX31855_TYPE, batch.getType(0));
+	EXPECT_EQ(MAX3185X_OK, snapshot.state[0]);
+	EXPECT_FLOAT_EQ(850.25f, snapshot.temperature[0]);
+	EXPECT_FLOAT_EQ(25.5f, snapshot.coldJunction[0]);
+
+	EXPECT_EQ(MAX31856_TYPE, batch.getType(1));
+	EXPECT_EQ(MAX3185X_OK, snapshot.state[1]);
+	EXPECT_FLOAT_EQ(612.5f, snapshot.temperature[1]);
+	EXPECT_FLOAT_EQ(31.25f, snapshot.coldJunction[1]);
+	// detection put the chip in automatic conversion mode, K type
+	EXPECT_EQ(BIT(7) | BIT(0) | (2 << 4), bus.chips[1].registers[0]);
+	EXPECT_EQ((2 << 4) | 3, bus.chips[1].registers[1]);
+
+	EXPECT_EQ(MAX3185X_OK, snapshot.state[2]);
+	EXPECT_FLOAT_EQ(-10.5f, snapshot.temperature[2]);
+	EXPECT_FLOAT_EQ(-5.0f, snapshot.coldJunction[2]);
+
+	EXPECT_EQ(UNKNOWN_TYPE, batch.getType(3));
+	EXPECT_EQ(MAX3185X_NO_REPLY, snapshot.state[3]);
+
+	for (size_t i = 4; i < EGT_CHANNEL_COUNT; i++) {
+		EXPECT_EQ(MAX3185X_NOT_ENABLED, snapshot.state[i]);
+	}
+
+	// once detected, each chip costs a single transfer
+	bus.exchangeCount = 0;
+	batch.read(bus, 2345);
+	EXPECT_EQ(2, bus.batchCount);
+	// three known chips plus detection attempt on the missing one
+	EXPECT_EQ(3 + 3, bus.exchangeCount);
+}
+
+TEST(Max3185x, faults) {
+	float temp = 0;
+	float coldJunction = 0;
+
+	EXPECT_EQ(MAX3185X_OPEN_CIRCUIT, Max3185xBatch::decodeMax31855(max31855Packet(0, 25, BIT(0)), temp, coldJunction));
+	EXPECT_EQ(MAX3185X_SHORT_TO_GND, Max3185xBatch::decodeMax31855(max31855Packet(0, 25, BIT(1)), temp, coldJunction));
+	EXPECT_EQ(MAX3185X_SHORT_TO_VCC, Max3185xBatch::decodeMax31855(max31855Packet(0, 25, BIT(2)), temp, coldJunction));
+	// reserved bits set, or bus stuck
+	EXPECT_EQ(MAX3185X_NO_REPLY, Max3185xBatch::decodeMax31855(max31855Packet(100, 25) | BIT(17), temp, coldJunction));
+	EXPECT_EQ(MAX3185X_NO_REPLY, Max3185xBatch::decodeMax31855(0, temp, coldJunction));
+	EXPECT_EQ(MAX3185X_NO_REPLY, Max3185xBatch::decodeMax31855(0xffffffff, temp, coldJunction));
+
+	MockMax3185xBus bus;
+	bus.chips[0].kind = ChipKind::Max31856;
+	bus.chips[1].kind = ChipKind::Max31855;
+	bus.chips[1].packet = max31855Packet(400, 25);
+
+	Max3185xBatch batch;
+	batch.setEnabled(0, true);
+	batch.setEnabled(1, true);
+
+	bus.chips[0].setMax31856(500, 25, BIT(0));
+	EXPECT_EQ(MAX3185X_OPEN_CIRCUIT, batch.read(bus, 0).state[0]);
+	bus.chips[0].setMax31856(500, 25, BIT(1));
+	EXPECT_EQ(MAX3185X_SHORT_TO_VCC, batch.read(bus, 0).state[0]);
+	bus.chips[0].setMax31856(500, 25, BIT(6));
+	EXPECT_EQ(MAX3185X_OUT_OF_RANGE, batch.read(bus, 0).state[0]);
+	bus.chips[0].setMax31856(500, 25);
+	EXPECT_EQ(MAX3185X_OK, batch.read(bus, 0).state[0]);
+
+	// faults are per chip, the other one keeps reading
+	EXPECT_EQ(MAX3185X_OK, batch.getSnapshot().state[1]);
+
+	// chip stops answering: reported and detected again once it is back
+	bus.chips[1].kind = ChipKind::Absent;
+	EXPECT_EQ(MAX3185X_NO_REPLY, batch.read(bus, 0).state[1]);
+	EXPECT_EQ(UNKNOWN_TYPE, batch.getType(1));
+
+	bus.chips[1].kind = ChipKind::Max31855;
+	EXPECT_EQ(MAX3185X_OK, batch.read(bus, 0).state[1]);
+	EXPECT_EQ(MAX31855_TYPE, batch.getType(1));
+	EXPECT_FLOAT_EQ(400, batch.getSnapshot().temperature[1]);
+}
+
+TEST(Max3185x, coldJunctionFilter) {
+	MockMax3185xBus bus;
+	bus.chips[0].kind = ChipKind::Max31855;
+	bus.chips[0].packet = max31855Packet(300, 25);
+
+	Max3185xBatch batch;
+	batch.setEnabled(0, true);
+
+	// first reading is taken as is
+	EXPECT_FLOAT_EQ(25, batch.read(bus, 0).coldJunction[0]);
+
+	bus.chips[0].packet = max31855Packet(300, 35);
+	EXPECT_FLOAT_EQ(25 + 10 * MAX3185X_COLD_JUNCTION_FILTER, batch.read(bus, 0).coldJunction[0]);
+
+	for (int i = 0; i < 50; i++) {
+		batch.read(bus, 0);
+	}
+	EXPECT_NEAR(35, batch.getSnapshot().coldJunction[0], 0.01);
+
+	// thermocouple temperature itself is not filtered
+	bus.chips[0].packet = max31855Packet(500, 35);
+	EXPECT_FLOAT_EQ(500, batch.read(bus, 0).temperature[0]);
+}
@@ -1,10 +1,117 @@
 #include "pch.h"
 
-BigBufferUser getBigBufferCurrentUser();
-
 TEST(BigBuffer, CppMagic) {
   BigBufferHandle h = getBigBuffer(BigBufferUser::ToothLogger);
-  ASSERT_EQ(getBigBufferCurrentUser(), BigBufferUser::ToothLogger);
+  ASSERT_TRUE(hasBigBufferLease(BigBufferUser::ToothLogger));
   h = {};
-  ASSERT_EQ(getBigBufferCurrentUser(), BigBufferUser::None);
+  ASSERT_FALSE(hasBigBufferLease(BigBufferUser::ToothLogger));
+}
+
+TEST(BigBuffer, ConcurrentUsers) {
+	BigBufferHandle teeth = getBigBuffer(BigBufferUser::ToothLogger, BIG_BUFFER_SIZE / 2);
+	BigBufferHandle trace = getBigBuffer(BigBufferUser::PerfTrace, 1000);
+	ASSERT_TRUE(teeth);
+	ASSERT_TRUE(trace);
+
+	// rounded up to whole blocks
+	EXPECT_EQ(trace.size(), 4u * BIG_BUFFER_BLOCK_SIZE);
+	EXPECT_GE(trace.get<uint8_t>(), teeth.get<uint8_t>() + teeth.size());
+
+	// one lease per user
+	EXPECT_FALSE(getBigBuffer(BigBufferUser::ToothLogger, BIG_BUFFER_BLOCK_SIZE));
+	// does not fit
+	EXPECT_FALSE(getBigBuffer(BigBufferUser::TriggerScope, BIG_BUFFER_SIZE / 2));
+
+	teeth = {};
+	trace = {};
+	EXPECT_EQ(getBigBufferFreeSize(), (size_t)BIG_BUFFER_SIZE);
+}
+
+static BigBufferHandle chartBuffer;
+static int chartEvictCount = 0;
+
+static void evictChart() {
+	chartEvictCount++;
+	chartBuffer = {};
+}
+
+TEST(BigBuffer, ReclaimByPriority) {
+	chartEvictCount = 0;
+	chartBuffer = getBigBuffer(BigBufferUser::SensorChart, BIG_BUFFER_SIZE / 2, evictChart);
+	ASSERT_TRUE(chartBuffer);
+
+	// fits next to the sensor chart, nothing reclaimed
+	BigBufferHandle scope = getBigBuffer(BigBufferUser::TriggerScope, BIG_BUFFER_SIZE / 4);
+	ASSERT_TRUE(scope);
+	EXPECT_EQ(chartEvictCount, 0);
+
+	// needs the space held by the sensor chart
+	BigBufferHandle teeth = getBigBuffer(BigBufferUser::ToothLogger, BIG_BUFFER_SIZE / 2);
+	ASSERT_TRUE(teeth);
+	EXPECT_EQ(chartEvictCount, 1);
+	EXPECT_FALSE(chartBuffer);
+	EXPECT_FALSE(hasBigBufferLease(BigBufferUser::SensorChart));
+
+	// lower priority user can not take space from higher priority ones
+	chartBuffer = getBigBuffer(BigBufferUser::SensorChart, BIG_BUFFER_SIZE / 2, evictChart);
+	EXPECT_FALSE(chartBuffer);
+
+	// leases without eviction callback are never reclaimed
+	BigBufferHandle trace = getBigBuffer(BigBufferUser::PerfTrace, BIG_BUFFER_SIZE / 2);
+	EXPECT_FALSE(trace);
+	EXPECT_TRUE(scope);
+
+	teeth = {};
+	scope = {};
+	EXPECT_EQ(getBigBufferFreeSize(), (size_t)BIG_BUFFER_SIZE);
+}
+
+TEST(BigBuffer, ChurnDoesNotLeak) {
+	constexpr BigBufferUser users[] = {
+		BigBufferUser::ToothLogger,
+		BigBufferUser::PerfTrace,
+		BigBufferUser::TriggerScope,
+		BigBufferUser::SensorChart,
+		BigBufferUser::KnockSpectrogram,
+	};
+	BigBufferHandle handles[efi::size(users)];
+
+	// deterministic pseudo random sequence
+	uint32_t seed = 12345;
+	auto next = [&seed]() {
+		seed = seed * 1103515245 + 12345;
+		return (seed >> 16) & 0x7FFF;
+	};
+
+	int granted = 0;
+	for (int i = 0; i < 20000; i++) {
+		size_t idx = next() % efi::size(users);
+
+		if (handles[idx]) {
+			// every byte of the lease must still hold the owner's pattern
+			const uint8_t* data = handles[idx].get<uint8_t>();
+			for (size_t j = 0; j < handles[idx].size(); j++) {
+				ASSERT_EQ(data[j], idx + 1) << "iteration " << i;
+			}
+			handles[idx] = {};
+		} else {
+			size_t size = 1 + next() % (BIG_BUFFER_SIZE / 2);
+			handles[idx] = getBigBuffer(users[idx], size);
+			if (handles[idx]) {
+				granted++;
+				ASSERT_GE(handles[idx].size(), size);
+				memset(handles[idx].get<uint8_t>(), idx + 1, handles[idx].size());
+			}
+		}
+	}
+	EXPECT_GT(granted, 1000);
+
+	for (auto& handle : handles) {
+		handle = {};
+	}
+
+	EXPECT_EQ(getBigBufferFreeSize(), (size_t)BIG_BUFFER_SIZE);
+	BigBufferHandle all = getBigBuffer(BigBufferUser::ToothLogger);
+	EXPECT_TRUE(all);
+	EXPECT_EQ(all.size(), (size_t)BIG_BUFFER_SIZE);
 }
@@ -0,0 +1,127 @@
+#include "pch.h"
+
+#include "blend_evaluator.h"
+
+static void setupBlend(blend_table_s& cfg, gppwm_channel_e parameter) {
+	cfg.blendParameter = parameter;
+	cfg.yAxisOverride = GPPWM_Zero;
+
+	for (size_t i = 0; i < efi::size(cfg.rpmBins); i++) {
+		cfg.rpmBins[i] = 1000 * (i + 1);
+		cfg.loadBins[i] = 20 * (i + 1);
+		cfg.blendBins[i] = 10 * i;
+		cfg.blendValues[i] = 12.5f * i;
+	}
+
+	for (size_t i = 0; i < efi::size(cfg.table); i++) {
+		for (size_t j = 0; j < efi::size(cfg.table[0]); j++) {
+			cfg.table[i][j] = 0.5f * i + 1.5f * j;
+		}
+	}
+}
+
+static void expectSameAsCalculateBlend(BlendSet set, blend_table_s& cfg) {
+	auto& evaluator = engine->module<BlendEvaluator>().unmock();
+
+	for (float rpm = 500; rpm < 9000; rpm += 650) {
+		for (float load = 10; load < 180; load += 17) {
+			BlendResult expected = calculateBlend(cfg, rpm, load);
+			// twice: second one comes from the cache
+			for (int pass = 0; pass < 2; pass++) {
+				BlendResult actual = evaluator.get(set, 0, rpm, load);
+				EXPECT_EQ(expected.BlendParameter, actual.BlendParameter) << rpm << "/" << load;
+				EXPECT_EQ(expected.Bias, actual.Bias) << rpm << "/" << load;
+				EXPECT_EQ(expected.Value, actual.Value) << rpm << "/" << load;
+			}
+		}
+	}
+}
+
+TEST(BlendEvaluator, sameAsCalculateBlend) {
+	EngineTestHelper eth(engine_type_e::TEST_ENGINE);
+	setupBlend(config->veBlends[0], GPPWM_Tps);
+	setupBlend(config->ignBlends[0], GPPWM_Clt);
+	setupBlend(config->boostOpenLoopBlends[0], GPPWM_Iat);
+	setupBlend(config->boostClosedLoopBlends[0], GPPWM_Map);
+	// second closed loop slot reads its load from CLT
+	setupBlend(config->boostClosedLoopBlends[1], GPPWM_Map);
+	config->boostClosedLoopBlends[1].yAxisOverride = GPPWM_Clt;
+	incrementGlobalConfigurationVersion();
+
+	Sensor::setMockValue(SensorType::Tps1, 33);
+	Sensor::setMockValue(SensorType::Clt, 57);
+	Sensor::setMockValue(SensorType::Iat, 21);
+	Sensor::setMockValue(SensorType::Map, 140);
+	engine->module<BlendEvaluator>()->latchInputs();
+
+	expectSameAsCalculateBlend(BlendSet::Ve, config->veBlends[0]);
+	expectSameAsCalculateBlend(BlendSet::Ignition, config->ignBlends[0]);
+	expectSameAsCalculateBlend(BlendSet::BoostOpenLoop, config->boostOpenLoopBlends[0]);
+	expectSameAsCalculateBlend(BlendSet::BoostClosedLoop, config->boostClosedLoopBlends[0]);
+
+	BlendResult expected = calculateBlend(config->boostClosedLoopBlends[1], 3000, 80);
+	EXPECT_NE(0, expected.Value);
+	BlendResult actual = engine->module<BlendEvaluator>()->get(BlendSet::BoostClosedLoop, 1, 3000, 80);
+	EXPECT_EQ(expected.Value, actual.Value);
+	EXPECT_EQ(expected.Bias, actual.Bias);
+}
+
+TEST(BlendEvaluator, disabledAndInvalid) {
+	EngineTestHelper eth(engine_type_e::TEST_ENGINE);
+	setupBlend(config->veBlends[0], GPPWM_Tps);
+	setupBlend(config->veBlends[1], GPPWM_Zero);
+	incrementGlobalConfigurationVersion();
+
+	auto& evaluator = engine->module<BlendEvaluator>().unmock();
+
+	// no TPS sensor
+	Sensor::setInvalidMockValue(SensorType::Tps1);
+	evaluator.latchInputs();
+	EXPECT_EQ(0, evaluator.get(BlendSet::Ve, 0, 3000, 50).Value);
+	EXPECT_EQ(0, calculateBlend(config->veBlends[0], 3000, 50).Value);
+	EXPECT_EQ(0, evaluator.get(BlendSet::Ve, 1, 3000, 50).Value);
+
+	// out of range slot
+	EXPECT_EQ(0, evaluator.get(BlendSet::Ve, VE_BLEND_COUNT, 3000, 50).Value);
+}
+
+TEST(BlendEvaluator, inputsLatchedPerCycle) {
+	EngineTestHelper eth(engine_type_e::TEST_ENGINE);
+	setupBlend(config->veBlends[0], GPPWM_Tps);
+	incrementGlobalConfigurationVersion();
+
+	auto& evaluator = engine->module<BlendEvaluator>().unmock();
+
+	Sensor::setMockValue(SensorType::Tps1, 20);
+	evaluator.latchInputs();
+	float before = evaluator.get(BlendSet::Ve, 0, 3000, 50).Value;
+	EXPECT_EQ(calculateBlend(config->veBlends[0], 3000, 50).Value, before);
+
+	// sensor moves within the cycle: every consumer still sees the same blend
+	Sensor::setMockValue(SensorType::Tps1, 60);
+	EXPECT_EQ(before, evaluator.get(BlendSet::Ve, 0, 3000, 50).Value);
+	EXPECT_EQ(before, evaluator.get(BlendSet::Ve, 0, 3000, 50).Value);
+
+	// next cycle picks it up
+	evaluator.latchInputs();
+	float after = evaluator.get(BlendSet::Ve, 0, 3000, 50).Value;
+	EXPECT_NE(before, after);
+	EXPECT_EQ(calculateBlend(config->veBlends[0], 3000, 50).Value, after);
+}
+
+TEST(BlendEvaluator, enabledOnConfigurationChange) {
+	EngineTestHelper eth(engine_type_e::TEST_ENGINE);
+	Sensor::setMockValue(SensorType::Tps1, 40);
+
+	auto& evaluator = engine->module<BlendEvaluator>().unmock();
+	incrementGlobalConfigurationVersion();
+	setupBlend(config->veBlends[2], GPPWM_Tps);
+	evaluator.latchInputs();
+	// slot was disabled at the last configuration change
+	EXPECT_EQ(0, evaluator.get(BlendSet::Ve, 2, 3000, 50).Value);
+
+	incrementGlobalConfigurationVersion();
+	evaluator.latchInputs();
+	EXPECT_EQ(calculateBlend(config->veBlends[2], 3000, 50).Value, evaluator.get(BlendSet::Ve, 2, 3000, 50).Value);
+	EXPECT_NE(0, evaluator.get(BlendSet::Ve, 2, 3000, 50).Value);
+}
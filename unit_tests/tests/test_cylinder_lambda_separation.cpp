@@ -0,0 +1,153 @@
+#include "pch.h"
+
+#include "cylinder_lambda_separation.h"
+
+#define TEST_RPM 3000
+#define TEST_LOAD 50
+
+static void setupSeparation() {
+	engineConfiguration->cylindersCount = 4;
+	engineConfiguration->firingOrder = FO_1_3_4_2;
+	for (size_t i = 0; i < 4; i++) {
+		engineConfiguration->cylinderBankSelect[i] = 0;
+	}
+
+	engineConfiguration->fuelClosedLoopCorrectionEnabled = true;
+	engineConfiguration->cylinderLambdaSeparation = true;
+	engineConfiguration->stft.minClt = 60;
+
+	Sensor::setMockValue(SensorType::Clt, 90);
+	Sensor::setMockValue(SensorType::Lambda1, 1);
+	Sensor::setMockValue(SensorType::Rpm, TEST_RPM);
+	engine->rpmCalculator.setRpmValue(TEST_RPM);
+	engine->fuelComputer.running.timeSinceCrankingInSecs = 100;
+	engine->engineState.fuelingLoad = TEST_LOAD;
+
+	// Cam sync, we know which revolution we are on
+	engine->triggerCentral.triggerState.setNeedsDisambiguation(false);
+}
+
+/**
+ * One wideband downstream of all four cylinders: each cylinder's exhaust pulse arrives
+ * after the transport delay and the pulses blur into each other on the way
+ */
+static void runEngineCycles(const float (&cylinderLambda)[4], int cycles, bool applyTrims) {
+	auto separation = engine->module<CylinderLambdaSeparation>();
+	float delayAngle = getCylinderExhaustDelayMs(0, TEST_RPM, TEST_LOAD) / getOneDegreeTimeMs(TEST_RPM);
+	float mixedLambda = 1;
+
+	for (int cycle = 0; cycle < cycles; cycle++) {
+		separation->onFastCallback();
+
+		// 60-2 crank wheel, teeth every 6 degrees
+		for (int tooth = 0; tooth < 120; tooth++) {
+			angle_t phase = tooth * 6;
+
+			angle_t sinceFirstExhaustOpen = wrapAngleMethod(phase - delayAngle - LAMBDA_SEPARATION_EXHAUST_OPEN_ANGLE);
+			size_t cylinder = ID2INDEX(getFiringOrderCylinderId(sinceFirstExhaustOpen / 180));
+
+			float lambda = cylinderLambda[cylinder];
+			if (applyTrims) {
+				lambda /= separation->getTrimMultiplier(cylinder, TEST_RPM, TEST_LOAD);
+			}
+
+			mixedLambda += 0.2f * (lambda - mixedLambda);
+			Sensor::setMockValue(SensorType::Lambda1, mixedLambda);
+
+			separation->onEnginePhase(phase);
+		}
+	}
+}
+
+TEST(CylinderLambdaSeparation, separatesImbalancedCylinders) {
+	EngineTestHelper eth(engine_type_e::TEST_ENGINE);
+	setupSeparation();
+
+	// #2 is lean, #3 and #4 a bit rich
+	float cylinderLambda[4] = { 1.0f, 1.06f, 0.97f, 0.97f };
+	runEngineCycles(cylinderLambda, 100, false);
+
+	auto separation = engine->module<CylinderLambdaSeparation>();
+
+	// Mixing on the way to the sensor shrinks the differences, but they are still there
+	EXPECT_NEAR(1.0f, separation->getCylinderLambda(0), 0.015f);
+	EXPECT_NEAR(1.06f, separation->getCylinderLambda(1), 0.02f);
+	EXPECT_NEAR(0.97f, separation->getCylinderLambda(2), 0.015f);
+	EXPECT_NEAR(0.97f, separation->getCylinderLambda(3), 0.015f);
+
+	EXPECT_GT(separation->getCylinderLambda(1), separation->getCylinderLambda(0) + 0.03f);
+	EXPECT_LT(separation->getCylinderLambda(2), separation->getCylinderLambda(0) - 0.015f);
+
+	// Lean one gets more fuel, rich ones less
+	EXPECT_GT(separation->getTrimMultiplier(1, TEST_RPM, TEST_LOAD), 1);
+	EXPECT_LT(separation->getTrimMultiplier(2, TEST_RPM, TEST_LOAD), 1);
+	EXPECT_LT(separation->getTrimMultiplier(3, TEST_RPM, TEST_LOAD), 1);
+}
+
+TEST(CylinderLambdaSeparation, trimsTheRightCylinder) {
+	EngineTestHelper eth(engine_type_e::TEST_ENGINE);
+	setupSeparation();
+
+	// Only #3 is lean, second in the 1-3-4-2 firing order
+	float cylinderLambda[4] = { 1.0f, 1.0f, 1.06f, 1.0f };
+	runEngineCycles(cylinderLambda, 100, false);
+
+	auto separation = engine->module<CylinderLambdaSeparation>();
+
+	EXPECT_GT(separation->getCylinderLambda(2), separation->getCylinderLambda(0) + 0.03f);
+	EXPECT_GT(separation->getCylinderLambda(2), separation->getCylinderLambda(1) + 0.03f);
+	EXPECT_GT(separation->getCylinderLambda(2), separation->getCylinderLambda(3) + 0.03f);
+
+	EXPECT_GT(separation->getTrimMultiplier(2, TEST_RPM, TEST_LOAD), 1);
+	EXPECT_LT(separation->getTrimMultiplier(0, TEST_RPM, TEST_LOAD), 1);
+	EXPECT_LT(separation->getTrimMultiplier(1, TEST_RPM, TEST_LOAD), 1);
+	EXPECT_LT(separation->getTrimMultiplier(3, TEST_RPM, TEST_LOAD), 1);
+}
+
+TEST(CylinderLambdaSeparation, trimsBalanceCylinders) {
+	EngineTestHelper eth(engine_type_e::TEST_ENGINE);
+	setupSeparation();
+
+	float cylinderLambda[4] = { 1.0f, 1.06f, 0.97f, 0.97f };
+	runEngineCycles(cylinderLambda, 1000, true);
+
+	auto separation = engine->module<CylinderLambdaSeparation>();
+
+	float trimSum = 0;
+	for (size_t i = 0; i < 4; i++) {
+		float trim = separation->getTrimMultiplier(i, TEST_RPM, TEST_LOAD);
+		trimSum += trim;
+
+		// What each cylinder gets with its trim is now the same
+		EXPECT_NEAR(1, cylinderLambda[i] / trim, 0.005f) << i;
+	}
+
+	// Bank average is closed loop fuel's business
+	EXPECT_NEAR(4, trimSum, 1e-3);
+
+	// Learned in the cell we were running in, other cells are untouched
+	EXPECT_FLOAT_EQ(1, separation->getTrimMultiplier(1, 7000, 100));
+
+	// Disabling forgets
+	engineConfiguration->cylinderLambdaSeparation = false;
+	separation->onConfigurationChange(engineConfiguration);
+	engineConfiguration->cylinderLambdaSeparation = true;
+	EXPECT_FLOAT_EQ(1, separation->getTrimMultiplier(1, TEST_RPM, TEST_LOAD));
+}
+
+TEST(CylinderLambdaSeparation, needsPhaseSync) {
+	EngineTestHelper eth(engine_type_e::TEST_ENGINE);
+	setupSeparation();
+
+	// Crank only trigger: can't tell #1 from #4
+	engine->triggerCentral.triggerState.setNeedsDisambiguation(true);
+
+	float cylinderLambda[4] = { 1.0f, 1.06f, 0.97f, 0.97f };
+	runEngineCycles(cylinderLambda, 100, false);
+
+	auto separation = engine->module<CylinderLambdaSeparation>();
+	for (size_t i = 0; i < 4; i++) {
+		EXPECT_TRUE(std::isnan(separation->getCylinderLambda(i)));
+		EXPECT_FLOAT_EQ(1, separation->getTrimMultiplier(i, TEST_RPM, TEST_LOAD));
+	}
+}
@@ -9,7 +9,7 @@ float GetGearRatioFor(float revPerKm, float axle, float kph, float rpm) {
 	Sensor::setMockValue(SensorType::VehicleSpeed, kph);
 	Sensor::setMockValue(SensorType::Rpm, rpm);
 
-	engine->periodicSlowCallback();
+	engine->periodicFastCallback();
 
 	auto& dut = engine->module<GearDetector>().unmock();
 	return dut.getGearboxRatio();
@@ -232,3 +232,213 @@ TEST(GearDetector, ParameterValidation) {
 	engineConfiguration->totalGearsCount = 0;
 	EXPECT_NO_FATAL_ERROR(dut.onConfigurationChange(nullptr));
 }
+
+static void setVolvoGears() {
+	engineConfiguration->driveWheelRevPerKm = 507;
+	engineConfiguration->finalGearRatio = 4.10f;
+
+	// real gears from Volvo racecar
+	engineConfiguration->totalGearsCount = 5;
+	engineConfiguration->gearRatio[0] = 3.35f;
+	engineConfiguration->gearRatio[1] = 1.99f;
+	engineConfiguration->gearRatio[2] = 1.33f;
+	engineConfiguration->gearRatio[3] = 1.00f;
+	engineConfiguration->gearRatio[4] = 0.72f;
+}
+
+struct GearTraceSample {
+	float rpm;
+	float kph;
+};
+
+// 1-2 upshift at full throttle logged every 25 ms: clutch in at 300 ms, revs fall until the clutch
+// bites again around 575 ms
+static const GearTraceSample upshiftTrace[] = {
+	{ 4919, 42.5 },  // 0 ms
+	{ 4980, 42.9 },  // 25 ms
+	{ 5027, 43.4 },  // 50 ms
+	{ 5087, 43.8 },  // 75 ms
+	{ 5140, 44.3 },  // 100 ms
+	{ 5174, 44.7 },  // 125 ms
+	{ 5225, 45.2 },  // 150 ms
+	{ 5303, 45.6 },  // 175 ms
+	{ 5337, 46.1 },  // 200 ms
+	{ 5388, 46.5 },  // 225 ms
+	{ 5465, 47.0 },  // 250 ms
+	{ 5500, 47.4 },  // 275 ms
+	{ 5511, 47.4 },  // 300 ms
+	{ 5313, 47.3 },  // 325 ms
+	{ 5131, 47.3 },  // 350 ms
+	{ 4928, 47.2 },  // 375 ms
+	{ 4754, 47.2 },  // 400 ms
+	{ 4571, 47.1 },  // 425 ms
+	{ 4373, 47.1 },  // 450 ms
+	{ 4188, 47.0 },  // 475 ms
+	{ 3995, 47.0 },  // 500 ms
+	{ 3790, 46.9 },  // 525 ms
+	{ 3300, 46.9 },  // 550 ms
+	{ 3293, 46.8 },  // 575 ms
+	{ 3240, 47.1 },  // 600 ms
+	{ 3252, 47.3 },  // 625 ms
+	{ 3285, 47.6 },  // 650 ms
+	{ 3295, 47.8 },  // 675 ms
+	{ 3317, 48.1 },  // 700 ms
+	{ 3338, 48.3 },  // 725 ms
+	{ 3352, 48.6 },  // 750 ms
+	{ 3373, 48.8 },  // 775 ms
+	{ 3380, 49.1 },  // 800 ms
+	{ 3405, 49.3 },  // 825 ms
+	{ 3415, 49.6 },  // 850 ms
+	{ 3442, 49.8 },  // 875 ms
+	{ 3458, 50.1 },  // 900 ms
+	{ 3459, 50.3 },  // 925 ms
+	{ 3477, 50.6 },  // 950 ms
+	{ 3496, 50.8 },  // 975 ms
+	{ 3529, 51.1 },  // 1000 ms
+};
+
+#define TRACE_SAMPLE_MS 25
+
+TEST(GearDetector, UpshiftTrace) {
+	EngineTestHelper eth(engine_type_e::TEST_ENGINE);
+	setVolvoGears();
+
+	auto& dut = engine->module<GearDetector>().unmock();
+	dut.onConfigurationChange(nullptr);
+
+	int secondGearMs = -1;
+
+	for (size_t i = 0; i < efi::size(upshiftTrace); i++) {
+		Sensor::setMockValue(SensorType::Rpm, upshiftTrace[i].rpm);
+		Sensor::setMockValue(SensorType::VehicleSpeed, upshiftTrace[i].kph);
+
+		for (int ms = 0; ms < TRACE_SAMPLE_MS; ms += FAST_CALLBACK_PERIOD_MS) {
+			dut.onFastCallback();
+
+			int nowMs = i * TRACE_SAMPLE_MS + ms;
+			float gear = dut.get().value_or(-1);
+
+			if (nowMs >= 50 && nowMs < 550) {
+				// In 1st until the revs are where 2nd needs them, whatever the ratio passes through on the way
+				EXPECT_EQ(1, gear) << nowMs;
+			} else if (gear == 2 && secondGearMs < 0) {
+				secondGearMs = nowMs;
+			}
+		}
+	}
+
+	EXPECT_EQ(2, dut.get().value_or(-1));
+	// within a few tens of milliseconds of the clutch biting
+	EXPECT_GT(secondGearMs, 550);
+	EXPECT_LT(secondGearMs, 610);
+}
+
+TEST(GearDetector, ClutchDownHoldsGear) {
+	EngineTestHelper eth(engine_type_e::TEST_ENGINE);
+	setVolvoGears();
+
+	auto& dut = engine->module<GearDetector>().unmock();
+	dut.onConfigurationChange(nullptr);
+
+	// Cruising in 4th
+	Sensor::setMockValue(SensorType::VehicleSpeed, 98.65f / 0.6214f);
+	Sensor::setMockValue(SensorType::Rpm, 5500);
+	for (int i = 0; i < 20; i++) {
+		dut.onFastCallback();
+	}
+	EXPECT_EQ(4, dut.get().value_or(-1));
+
+	// Clutch in, engine back to idle: that's not 5th or neutral, we're about to shift
+	engine->engineState.clutchDownState = true;
+	Sensor::setMockValue(SensorType::Rpm, 1000);
+	for (int i = 0; i < 100; i++) {
+		dut.onFastCallback();
+	}
+	EXPECT_EQ(4, dut.get().value_or(-1));
+
+	// Into 5th
+	engine->engineState.clutchDownState = false;
+	Sensor::setMockValue(SensorType::Rpm, 5500 * 0.72f);
+	for (int i = 0; i < 20; i++) {
+		dut.onFastCallback();
+	}
+	EXPECT_EQ(5, dut.get().value_or(-1));
+}
+
+static void driveInGear(GearDetector& dut, size_t gear, float ratioError, float seconds) {
+	// Driveshaft at 1000 RPM
+	float kph = 1000 / (engineConfiguration->driveWheelRevPerKm * engineConfiguration->finalGearRatio / 60);
+	Sensor::setMockValue(SensorType::VehicleSpeed, kph);
+	Sensor::setMockValue(SensorType::Rpm, 1000 * engineConfiguration->gearRatio[gear - 1] * (1 + ratioError));
+
+	int slowCallbacks = seconds * 1000 / SLOW_CALLBACK_PERIOD_MS;
+
+	for (int i = 0; i < slowCallbacks; i++) {
+		for (int j = 0; j < SLOW_CALLBACK_PERIOD_MS / FAST_CALLBACK_PERIOD_MS; j++) {
+			dut.onFastCallback();
+		}
+
+		dut.onSlowCallback();
+	}
+}
+
+TEST(GearDetector, LearnsRatios) {
+	EngineTestHelper eth(engine_type_e::TEST_ENGINE);
+	setVolvoGears();
+	engineConfiguration->learnGearRatios = true;
+
+	auto& dut = engine->module<GearDetector>().unmock();
+	dut.onConfigurationChange(nullptr);
+
+	// Taller tires than configured, every gear reads 3% short
+	driveInGear(dut, 2, -0.03f, 30);
+	EXPECT_EQ(2, dut.get().value_or(-1));
+	EXPECT_NEAR(1.99f * 0.97f, dut.getGearRatio(2), 0.005f);
+
+	// Gears we haven't been in yet get the same correction
+	EXPECT_NEAR(1.33f * 0.97f, dut.getGearRatio(3), 0.005f);
+	EXPECT_NEAR(1000 * 1.99f * 0.97f, dut.getRpmInGear(2), 5);
+
+	// 4th is off by a bit more than the others
+	driveInGear(dut, 4, -0.04f, 30);
+	EXPECT_NEAR(1.00f * 0.96f, dut.getGearRatio(4), 0.005f);
+	EXPECT_NEAR(1.99f * 0.97f, dut.getGearRatio(2), 0.005f);
+
+	// Learned is used for detection: on the edge between 3rd and 4th by configured ratios
+	EXPECT_EQ(3, dut.determineGearFromRatio(1.13f));
+
+	// Something way off is not learned past the limit
+	driveInGear(dut, 4, -0.08f, 60);
+	EXPECT_NEAR(1 - GEAR_RATIO_LEARN_LIMIT, dut.getGearRatio(4), 1e-3);
+
+	// Not used with learning off
+	engineConfiguration->learnGearRatios = false;
+	EXPECT_FLOAT_EQ(1.99f, dut.getGearRatio(2));
+	engineConfiguration->learnGearRatios = true;
+
+	// Other gears, learned doesn't apply anymore
+	engine_configuration_s previousConfig = *engineConfiguration;
+	engineConfiguration->gearRatio[1] = 2.1f;
+	dut.onConfigurationChange(&previousConfig);
+	EXPECT_FLOAT_EQ(2.1f, dut.getGearRatio(2));
+	EXPECT_FLOAT_EQ(1.33f, dut.getGearRatio(3));
+}
+
+TEST(GearDetector, ShiftIsNotLearned) {
+	EngineTestHelper eth(engine_type_e::TEST_ENGINE);
+	setVolvoGears();
+	engineConfiguration->learnGearRatios = true;
+
+	auto& dut = engine->module<GearDetector>().unmock();
+	dut.onConfigurationChange(nullptr);
+
+	// Shifting over and over, never long enough in a gear to learn from
+	for (int i = 0; i < 50; i++) {
+		driveInGear(dut, 2, -0.03f, 0.5f);
+		driveInGear(dut, 3, -0.03f, 0.5f);
+	}
+
+	EXPECT_EQ(3, dut.get().value_or(-1));
+	EXPECT_FLOAT_EQ(1.99f, dut.getGearRatio(2));
+	EXPECT_FLOAT_EQ(1.33f, dut.getGearRatio(3));
+}
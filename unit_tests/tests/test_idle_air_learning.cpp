@@ -0,0 +1,83 @@
+#include "pch.h"
+
+#include "idle_air_learning.h"
+
+TEST(IdleAirLearning, startsEmpty) {
+	IdleAirLearning learning;
+
+	for (size_t state = 0; state < IDLE_AIR_LEARN_LOAD_STATES; state++) {
+		EXPECT_EQ(0, learning.getCorrection(-40, state));
+		EXPECT_EQ(0, learning.getCorrection(50, state));
+		EXPECT_EQ(0, learning.getCorrection(150, state));
+	}
+}
+
+TEST(IdleAirLearning, boundedLearningRate) {
+	IdleAirLearning learning;
+
+	// Small integrator: a fraction of it per update
+	float learned = learning.learn(80, 0, 1);
+	EXPECT_FLOAT_EQ(IDLE_AIR_LEARN_RATE * 1, learned);
+	EXPECT_FLOAT_EQ(learned, learning.getCorrection(80, 0));
+
+	// Huge one, for example right after a load step: still one small step
+	learned = learning.learn(80, 0, 500);
+	EXPECT_FLOAT_EQ(IDLE_AIR_LEARN_MAX_STEP, learned);
+	learned = learning.learn(80, 0, -500);
+	EXPECT_FLOAT_EQ(-IDLE_AIR_LEARN_MAX_STEP, learned);
+
+	// Right between two bins each gets half of the step
+	learned = learning.learn(70, 0, 500);
+	EXPECT_NEAR(0.5f * IDLE_AIR_LEARN_MAX_STEP, learned, 1e-6);
+
+	// And no more than the limit in total
+	for (int i = 0; i < 10000; i++) {
+		learning.learn(80, 0, 500);
+	}
+	EXPECT_FLOAT_EQ(IDLE_AIR_LEARN_LIMIT, learning.getCorrection(80, 0));
+	EXPECT_EQ(0, learning.learn(80, 0, 500));
+}
+
+TEST(IdleAirLearning, convergesToIntegrator) {
+	IdleAirLearning learning;
+
+	// Integrator holding 6%, giving away what is learned each time
+	float integrator = 6;
+	for (int i = 0; i < 2000; i++) {
+		integrator -= learning.learn(47, 0, integrator);
+	}
+
+	EXPECT_NEAR(6, learning.getCorrection(47, 0), 0.01f);
+	EXPECT_NEAR(0, integrator, 0.01f);
+
+	// Nearby temperatures share it, other load states don't
+	EXPECT_NEAR(6, learning.getCorrection(50, 0), 1);
+	EXPECT_EQ(0, learning.getCorrection(47, 1));
+	EXPECT_EQ(0, learning.getCorrection(120, 0));
+}
+
+TEST(IdleAirLearning, backup) {
+	IdleAirLearning learning;
+	for (int i = 0; i < 100; i++) {
+		learning.learn(20, 1, 10);
+		learning.learn(90, 3, -10);
+	}
+
+	IdleAirLearningBackup backup;
+	learning.save(backup);
+
+	IdleAirLearning restored;
+	EXPECT_TRUE(restored.restore(backup));
+	EXPECT_FLOAT_EQ(learning.getCorrection(20, 1), restored.getCorrection(20, 1));
+	EXPECT_FLOAT_EQ(learning.getCorrection(90, 3), restored.getCorrection(90, 3));
+
+	// Garbage from a cold boot is not taken
+	backup.learned[2][2] = NAN;
+	EXPECT_FALSE(restored.restore(backup));
+	EXPECT_EQ(0, restored.getCorrection(20, 1));
+
+	learning.save(backup);
+	backup.cookie = 0;
+	EXPECT_FALSE(restored.restore(backup));
+	EXPECT_EQ(0, restored.getCorrection(20, 1));
+}
@@ -358,6 +358,61 @@ TEST(idle_v2, closedLoopBasic) {
 	EXPECT_FLOAT_EQ(25, dut.getClosedLoop(ICP::Idling, 0, /*rpm*/ 850, /*tgt*/ 900));
 }
 
+TEST(idle_v2, closedLoopLearnsIdleAir) {
+	EngineTestHelper eth(engine_type_e::TEST_ENGINE);
+	IdleController dut;
+	dut.init();
+
+	engineConfiguration->idleMode = IM_AUTO;
+	engineConfiguration->idleAirLearning = true;
+	engineConfiguration->manIdlePosition = 30;
+	setArrayValues(config->cltIdleCorr, 1.0f);
+
+	engineConfiguration->idleRpmPid.pFactor = 0.02;
+	engineConfiguration->idleRpmPid.iFactor = 0.05;
+	engineConfiguration->idleRpmPid.dFactor = 0;
+	engineConfiguration->idleRpmPid.offset = 0;
+	engineConfiguration->idleRpmPid.periodMs = 0;
+	engineConfiguration->idleRpmPid.minValue = -50;
+	engineConfiguration->idleRpmPid.maxValue = 50;
+	engineConfiguration->idle_antiwindupFreq = 0;
+	engineConfiguration->idle_derivativeFilterLoss = 0;
+	engineConfiguration->pidExtraForLowRpm = 0;
+	engineConfiguration->idlePidRpmDeadZone = 0;
+
+	Sensor::setMockValue(SensorType::Clt, 90);
+
+	// Aging throttle body: it takes 8% more air than the tables say to idle at 900
+	float openLoop = dut.getRunningOpenLoop(ICP::Idling, 900, 90, 0);
+	float neededAir = openLoop + 8;
+	float rpm = 900;
+
+	// burn one update then advance time 5 seconds to avoid difficulty from wasResetPid
+	dut.getClosedLoop(ICP::Idling, 0, rpm, 900);
+	advanceTimeUs(5'000'000);
+
+	for (int i = 0; i < 60 * 20; i++) {
+		float position = dut.getRunningOpenLoop(ICP::Idling, rpm, 90, 0) + dut.getClosedLoop(ICP::Idling, 0, rpm, 900);
+		rpm = 900 + 40 * (position - neededAir);
+
+		advanceTimeUs(SLOW_CALLBACK_PERIOD_MS * 1000);
+	}
+
+	EXPECT_NEAR(900, rpm, 1);
+
+	// What the integrator had to hold is open loop now
+	EXPECT_NEAR(8, dut.getAirLearning().getCorrection(90, 0), 0.1f);
+	EXPECT_NEAR(0, dut.getIdlePid()->getIntegration(), 0.1f);
+	EXPECT_NEAR(neededAir, dut.getRunningOpenLoop(ICP::Idling, 900, 90, 0), 0.1f);
+
+	// Nothing learned for A/C on
+	EXPECT_EQ(0, dut.getAirLearning().getCorrection(90, 1));
+
+	// And not used when disabled
+	engineConfiguration->idleAirLearning = false;
+	EXPECT_FLOAT_EQ(openLoop, dut.getRunningOpenLoop(ICP::Idling, 900, 90, 0));
+}
+
 TEST(idle_v2, closedLoopDeadzone) {
 	EngineTestHelper eth(engine_type_e::TEST_ENGINE);
 	IdleController dut;
@@ -0,0 +1,360 @@
+#include "pch.h"
+
+#include "kline_protocols.h"
+#include "crc8hondak.h"
+
+#include <vector>
+
+namespace {
+
+/**
+ * Single wire: whatever we write shows up on our own RX once the test lets it through
+ */
+class FakeKLineBus final : public IKLinePort {
+public:
+	void write(const uint8_t* data, size_t size) override {
+		frames.emplace_back(data, data + size);
+		echo.insert(echo.end(), data, data + size);
+	}
+
+	void wakeup(uint32_t lowUs, uint32_t highUs) override {
+		wakeupCount++;
+		wakeupLowUs = lowUs;
+		wakeupHighUs = highUs;
+		// the real port blocks for the whole pattern
+		advanceTimeUs(lowUs + highUs);
+	}
+
+	void writeFiveBaud(uint8_t address) override {
+		fiveBaudAddresses.push_back(address);
+	}
+
+	void discardRx() override {
+		discardCount++;
+	}
+
+	efitick_t loopback(KLineTransport& transport, efitick_t nowNt) {
+		std::vector<uint8_t> bytes;
+		bytes.swap(echo);
+		return feed(transport, bytes, nowNt);
+	}
+
+	efitick_t feed(KLineTransport& transport, const std::vector<uint8_t>& bytes, efitick_t nowNt) {
+		for (uint8_t b : bytes) {
+			nowNt += characterTimeNt;
+			transport.onRx(&b, 1, nowNt);
+		}
+		return nowNt;
+	}
+
+	efidur_t characterTimeNt = US2NT(1000);
+
+	std::vector<std::vector<uint8_t>> frames;
+	std::vector<uint8_t> echo;
+	std::vector<uint8_t> fiveBaudAddresses;
+	int wakeupCount = 0;
+	uint32_t wakeupLowUs = 0;
+	uint32_t wakeupHighUs = 0;
+	int discardCount = 0;
+};
+
+/**
+ * Gap framed, last byte is the sum of the others
+ */
+class RecordingProtocol final : public KLineProtocol {
+public:
+	const char* getName() const override {
+		return "test";
+	}
+
+	uint32_t getFrameGapUs(uint32_t /*baudRate*/) const override {
+		return 3000;
+	}
+
+	bool isValidFrame(const uint8_t* frame, size_t size) const override {
+		return size >= 2 && getKLineChecksum(frame, size - 1) == frame[size - 1];
+	}
+
+	void onFrame(KLineTransport& /*transport*/, const uint8_t* frame, size_t size, efitick_t /*nowNt*/) override {
+		frames.emplace_back(frame, frame + size);
+	}
+
+	std::vector<std::vector<uint8_t>> frames;
+};
+
+class RecordingObdListener final : public IKLineObdListener {
+public:
+	void onObdResponse(uint8_t pid, const uint8_t* data, size_t size) override {
+		pids.push_back(pid);
+		values.emplace_back(data, data + size);
+	}
+
+	std::vector<uint8_t> pids;
+	std::vector<std::vector<uint8_t>> values;
+};
+
+static std::vector<uint8_t> withChecksum(std::vector<uint8_t> frame) {
+	frame.push_back(getKLineChecksum(frame.data(), frame.size()));
+	return frame;
+}
+
+}
+
+TEST(KLineTransport, gapFraming) {
+	FakeKLineBus bus;
+	RecordingProtocol protocol;
+	KLineTransport transport;
+	transport.init(&protocol, &bus, 10000);
+
+	auto first = withChecksum({ 0x10, 0x20, 0x30 });
+	auto second = withChecksum({ 0x01, 0x02 });
+
+	efitick_t nowNt = bus.feed(transport, first, 0);
+	EXPECT_TRUE(transport.isFrameInFlight());
+	// reader is told to come back once the gap has passed, not any sooner
+	EXPECT_EQ(US2NT(3000), transport.onIdle(nowNt));
+	EXPECT_EQ(US2NT(1000), transport.onIdle(nowNt + US2NT(2000)));
+	EXPECT_EQ(0u, protocol.frames.size());
+
+	transport.onIdle(nowNt + US2NT(3000));
+	ASSERT_EQ(1u, protocol.frames.size());
+	EXPECT_EQ(first, protocol.frames[0]);
+
+	// reader woke up late and found the next frame already waiting: the gap still splits them
+	nowNt = bus.feed(transport, first, nowNt + US2NT(10000));
+	nowNt = bus.feed(transport, second, nowNt + US2NT(5000));
+	transport.onIdle(nowNt + US2NT(5000));
+	ASSERT_EQ(3u, protocol.frames.size());
+	EXPECT_EQ(first, protocol.frames[1]);
+	EXPECT_EQ(second, protocol.frames[2]);
+
+	// slow peer: bytes further apart than a character time but within the gap are still one frame
+	bus.characterTimeNt = US2NT(2500);
+	nowNt = bus.feed(transport, first, nowNt + US2NT(10000));
+	transport.onIdle(nowNt + US2NT(3000));
+	ASSERT_EQ(4u, protocol.frames.size());
+	EXPECT_EQ(first, protocol.frames[3]);
+
+	EXPECT_EQ(4u, transport.getFrameCount());
+	EXPECT_EQ(0u, transport.getInvalidFrameCount());
+}
+
+TEST(KLineTransport, badFrames) {
+	FakeKLineBus bus;
+	RecordingProtocol protocol;
+	KLineTransport transport;
+	transport.init(&protocol, &bus, 10000);
+
+	efitick_t nowNt = bus.feed(transport, { 0x10, 0x20, 0x30, 0x61 }, 0);
+	transport.onIdle(nowNt + US2NT(3000));
+	EXPECT_EQ(1u, transport.getInvalidFrameCount());
+
+	// runaway frame is dropped as a whole, its tail is not taken for a new frame
+	std::vector<uint8_t> longFrame(KLINE_MAX_FRAME + 10, 0);
+	nowNt = bus.feed(transport, longFrame, nowNt + US2NT(10000));
+	transport.onIdle(nowNt + US2NT(3000));
+	EXPECT_EQ(1u, transport.getOverrunCount());
+	EXPECT_EQ(1u, transport.getInvalidFrameCount());
+
+	EXPECT_EQ(0u, protocol.frames.size());
+}
+
+TEST(KLineTransport, echoSuppression) {
+	FakeKLineBus bus;
+	RecordingProtocol protocol;
+	KLineTransport transport;
+	transport.init(&protocol, &bus, 10000);
+
+	auto request = withChecksum({ 0x68, 0x6A, 0xF1 });
+	transport.send(request.data(), request.size(), 0);
+	// sent in two parts, echo of both is expected
+	transport.send(request.data(), 2, 0);
+
+	efitick_t nowNt = bus.loopback(transport, 0);
+	transport.onIdle(nowNt + US2NT(5000));
+	EXPECT_EQ(6u, transport.getEchoByteCount());
+	EXPECT_EQ(0u, protocol.frames.size());
+	EXPECT_EQ(0u, transport.getCollisionCount());
+
+	// somebody else was talking at the same time: what we read is not our echo
+	transport.send(request.data(), request.size(), nowNt);
+	bus.echo[1] ^= 0xFF;
+	nowNt = bus.loopback(transport, nowNt);
+	transport.onIdle(nowNt + US2NT(5000));
+	EXPECT_EQ(1u, transport.getCollisionCount());
+	EXPECT_EQ(7u, transport.getEchoByteCount());
+	EXPECT_EQ(1u, transport.getInvalidFrameCount());
+
+	// echo which never came back does not eat the peer response
+	transport.send(request.data(), request.size(), nowNt);
+	bus.echo.clear();
+	nowNt = bus.feed(transport, request, nowNt + US2NT(100000));
+	transport.onIdle(nowNt + US2NT(5000));
+	ASSERT_EQ(1u, protocol.frames.size());
+	EXPECT_EQ(request, protocol.frames[0]);
+}
+
+TEST(KLineTransport, honda) {
+	EngineTestHelper eth(engine_type_e::TEST_ENGINE);
+	engineConfiguration->kLineDoHondaSend = true;
+	Sensor::setMockValue(SensorType::Clt, 90);
+
+	FakeKLineBus bus;
+	bus.characterTimeNt = US2NT(1042);
+	HondaKLineProtocol protocol;
+	KLineTransport transport;
+	transport.init(&protocol, &bus, 9600);
+
+	std::vector<uint8_t> status = { 0x00, 0x40, 0x86, 0x00 };
+	status.push_back(crc_hondak_calc(status.data(), status.size()));
+
+	kAcRequestState = false;
+	efitick_t nowNt = bus.feed(transport, status, 0);
+	transport.onIdle(nowNt + US2NT(2000));
+	EXPECT_TRUE(kAcRequestState);
+
+	// dash frame goes out right after the BCM frame
+	ASSERT_EQ(1u, bus.frames.size());
+	const auto& reply = bus.frames[0];
+	ASSERT_EQ(7u, reply.size());
+	EXPECT_EQ(0x2, reply[0]);
+	EXPECT_EQ(50 + 90, reply[3]);
+	EXPECT_EQ(crc_hondak_calc(reply.data(), 6), reply[6]);
+
+	// our own dash frame is CRC valid too but we must not answer it
+	nowNt = bus.loopback(transport, nowNt + US2NT(2000));
+	transport.onIdle(nowNt + US2NT(2000));
+	EXPECT_EQ(1u, bus.frames.size());
+	EXPECT_EQ(1u, transport.getFrameCount());
+
+	status[2] = 0x06;
+	status[4] = crc_hondak_calc(status.data(), 4);
+	nowNt = bus.feed(transport, status, nowNt + US2NT(5000));
+	transport.onIdle(nowNt + US2NT(2000));
+	EXPECT_FALSE(kAcRequestState);
+	EXPECT_EQ(2u, bus.frames.size());
+
+	engineConfiguration->kLineDoHondaSend = false;
+	nowNt = bus.feed(transport, status, nowNt + US2NT(5000));
+	transport.onIdle(nowNt + US2NT(2000));
+	EXPECT_EQ(2u, bus.frames.size());
+}
+
+TEST(KLineTransport, kwp2000) {
+	EngineTestHelper eth(engine_type_e::TEST_ENGINE);
+
+	FakeKLineBus bus;
+	Kwp2000Protocol protocol;
+	RecordingObdListener listener;
+	protocol.setListener(&listener);
+	const uint8_t pids[] = { 0x0C, 0x05 };
+	protocol.setPids(pids, efi::size(pids));
+
+	KLineTransport transport;
+	transport.init(&protocol, &bus, KLINE_BAUD_RATE);
+
+	// fast init: wake up pattern then StartCommunication
+	efitick_t startNt = getTimeNowNt();
+	transport.onIdle(startNt);
+	EXPECT_EQ(1, bus.wakeupCount);
+	EXPECT_EQ(25000u, bus.wakeupLowUs);
+	EXPECT_EQ(25000u, bus.wakeupHighUs);
+	ASSERT_EQ(1u, bus.frames.size());
+	EXPECT_EQ(std::vector<uint8_t>({ 0xC1, 0x33, 0xF1, 0x81, 0x66 }), bus.frames[0]);
+	EXPECT_EQ(KLineObdClient::State::Initializing, protocol.getState());
+	// whatever the pattern left on RX is gone before the request goes out
+	EXPECT_EQ(1, bus.discardCount);
+
+	// response timeout and echo are counted from the end of the pattern, not from when init started
+	efitick_t nowNt = getTimeNowNt();
+	EXPECT_EQ(startNt + US2NT(50000), nowNt);
+	EXPECT_EQ(MS2NT(KLINE_RESPONSE_TIMEOUT_MS), transport.onIdle(nowNt));
+
+	nowNt = bus.loopback(transport, nowNt);
+	// positive response with key bytes, length in the header completes the frame without waiting for the gap
+	nowNt = bus.feed(transport, withChecksum({ 0x83, 0xF1, 0x10, 0xC1, 0xEF, 0x8F }), nowNt + MS2NT(30));
+	EXPECT_EQ(KLineObdClient::State::Connected, protocol.getState());
+	EXPECT_FALSE(transport.isFrameInFlight());
+
+	// P3 min before the first request
+	EXPECT_EQ(MS2NT(KLINE_P3_MIN_MS), transport.onIdle(nowNt));
+	nowNt += MS2NT(KLINE_P3_MIN_MS);
+	transport.onIdle(nowNt);
+	ASSERT_EQ(2u, bus.frames.size());
+	EXPECT_EQ(withChecksum({ 0xC2, 0x33, 0xF1, 0x01, 0x0C }), bus.frames[1]);
+
+	nowNt = bus.loopback(transport, nowNt);
+	nowNt = bus.feed(transport, withChecksum({ 0x84, 0xF1, 0x10, 0x41, 0x0C, 0x1A, 0xF8 }), nowNt + MS2NT(30));
+	ASSERT_EQ(1u, listener.pids.size());
+	EXPECT_EQ(0x0C, listener.pids[0]);
+	EXPECT_EQ(std::vector<uint8_t>({ 0x1A, 0xF8 }), listener.values[0]);
+
+	// round robin
+	nowNt += MS2NT(KLINE_P3_MIN_MS);
+	transport.onIdle(nowNt);
+	ASSERT_EQ(3u, bus.frames.size());
+	EXPECT_EQ(withChecksum({ 0xC2, 0x33, 0xF1, 0x01, 0x05 }), bus.frames[2]);
+	nowNt = bus.loopback(transport, nowNt);
+
+	// peer goes away: session is dropped after a few unanswered requests, then init is retried
+	for (int i = 0; i < KLINE_MAX_MISSED_RESPONSES; i++) {
+		nowNt += MS2NT(KLINE_RESPONSE_TIMEOUT_MS);
+		transport.onIdle(nowNt);
+		nowNt = bus.loopback(transport, nowNt);
+	}
+	EXPECT_EQ(KLineObdClient::State::Disconnected, protocol.getState());
+	EXPECT_EQ((uint32_t)KLINE_MAX_MISSED_RESPONSES, protocol.getTimeoutCount());
+	EXPECT_EQ(1u, protocol.getResponseCount());
+
+	EXPECT_EQ(MS2NT(KLINE_INIT_RETRY_MS), transport.onIdle(nowNt));
+	transport.onIdle(nowNt + MS2NT(KLINE_INIT_RETRY_MS));
+	EXPECT_EQ(2, bus.wakeupCount);
+	EXPECT_EQ(0u, transport.getCollisionCount());
+}
+
+TEST(KLineTransport, iso9141) {
+	EngineTestHelper eth(engine_type_e::TEST_ENGINE);
+
+	FakeKLineBus bus;
+	Iso9141Protocol protocol;
+	RecordingObdListener listener;
+	protocol.setListener(&listener);
+
+	KLineTransport transport;
+	transport.init(&protocol, &bus, KLINE_BAUD_RATE);
+
+	efitick_t nowNt = 0;
+	transport.onIdle(nowNt);
+	ASSERT_EQ(1u, bus.fiveBaudAddresses.size());
+	EXPECT_EQ(0x33, bus.fiveBaudAddresses[0]);
+
+	// sync and key bytes with W2/W3 pauses, slower than the baud rate but still one frame
+	bus.characterTimeNt = MS2NT(10);
+	nowNt = bus.feed(transport, { 0x55, 0x08, 0x08 }, nowNt + MS2NT(2100));
+	EXPECT_TRUE(transport.isFrameInFlight());
+	transport.onIdle(nowNt + MS2NT(KLINE_P1_MAX_MS));
+	EXPECT_EQ(KLineObdClient::State::SendKeyComplement, protocol.getState());
+
+	nowNt += MS2NT(KLINE_P1_MAX_MS + 25);
+	transport.onIdle(nowNt);
+	ASSERT_EQ(1u, bus.frames.size());
+	EXPECT_EQ(std::vector<uint8_t>({ 0xF7 }), bus.frames[0]);
+
+	bus.characterTimeNt = US2NT(1000);
+	nowNt = bus.loopback(transport, nowNt);
+	nowNt = bus.feed(transport, { 0xCC }, nowNt + MS2NT(30));
+	transport.onIdle(nowNt + MS2NT(KLINE_P1_MAX_MS));
+	EXPECT_EQ(KLineObdClient::State::Connected, protocol.getState());
+
+	nowNt += MS2NT(KLINE_P1_MAX_MS + KLINE_P3_MIN_MS);
+	transport.onIdle(nowNt);
+	ASSERT_EQ(2u, bus.frames.size());
+	EXPECT_EQ(withChecksum({ 0x68, 0x6A, 0xF1, 0x01, 0x00 }), bus.frames[1]);
+
+	nowNt = bus.loopback(transport, nowNt);
+	nowNt = bus.feed(transport, withChecksum({ 0x48, 0x6B, 0x10, 0x41, 0x00, 0xBE, 0x3E, 0xB8, 0x13 }), nowNt + MS2NT(30));
+	transport.onIdle(nowNt + MS2NT(KLINE_P1_MAX_MS));
+	ASSERT_EQ(1u, listener.pids.size());
+	EXPECT_EQ(0x00, listener.pids[0]);
+	EXPECT_EQ(std::vector<uint8_t>({ 0xBE, 0x3E, 0xB8, 0x13 }), listener.values[0]);
+}
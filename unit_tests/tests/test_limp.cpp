@@ -322,3 +322,108 @@ TEST(limp, oilPressureRunning) {
 	dut.updateState(1000, getTimeNowNt());
 	ASSERT_TRUE(dut.allowInjection());
 }
+
+TEST(limp, overlappingCutReasons) {
+	EngineTestHelper eth(engine_type_e::TEST_ENGINE);
+
+	engineConfiguration->boostCutPressure = 100;
+	engineConfiguration->boostCutPressureHyst = 20;
+
+	LimpManager dut;
+	const uint32_t boostCut = clearReasonBit(ClearReason::BoostCut);
+	const uint32_t luaCut = clearReasonBit(ClearReason::Lua);
+
+	// Nothing cut
+	Sensor::setMockValue(SensorType::Map, 80);
+	dut.updateState(1000, MS2NT(1000));
+	EXPECT_EQ(0u, dut.getFuelCutReasons());
+	EXPECT_EQ(0u, dut.getCutTransitionCount());
+
+	// Boost cut
+	Sensor::setMockValue(SensorType::Map, 105);
+	dut.updateState(1000, MS2NT(1100));
+	EXPECT_EQ(ClearReason::BoostCut, dut.allowInjection().reason);
+	EXPECT_EQ(boostCut, dut.getFuelCutReasons());
+
+	// Lua cuts fuel on top of it, first reason is still the one reported
+	engine->engineState.lua.luaFuelCut = true;
+	dut.updateState(1100, MS2NT(1300));
+	EXPECT_EQ(ClearReason::BoostCut, dut.allowInjection().reason);
+	EXPECT_EQ(boostCut | luaCut, dut.getFuelCutReasons());
+	EXPECT_EQ(0u, dut.getSparkCutReasons());
+	EXPECT_EQ(boostCut | luaCut, engine->outputChannels.fuelCutReasonMask);
+
+	// Boost drops, fuel still cut by Lua
+	Sensor::setMockValue(SensorType::Map, 70);
+	dut.updateState(900, MS2NT(1600));
+	EXPECT_EQ(ClearReason::Lua, dut.allowInjection().reason);
+	EXPECT_EQ(luaCut, dut.getFuelCutReasons());
+
+	// Everything restored
+	engine->engineState.lua.luaFuelCut = false;
+	dut.updateState(800, MS2NT(2000));
+	EXPECT_TRUE(dut.allowInjection());
+	EXPECT_EQ(0u, dut.getFuelCutReasons());
+	dut.updateState(800, MS2NT(3000));
+
+	// boost cut from 1100 to 1600, Lua from 1300 to 2000
+	EXPECT_NEAR(0.5, dut.getCutTimeSeconds(ClearReason::BoostCut), 1e-6);
+	EXPECT_NEAR(0.7, dut.getCutTimeSeconds(ClearReason::Lua), 1e-6);
+	EXPECT_EQ(0, dut.getCutTimeSeconds(ClearReason::HardLimit));
+
+	// Timeline, most recent first
+	ASSERT_EQ(4u, dut.getCutTransitionCount());
+	const uint32_t expectedReasons[] = { 0, luaCut, boostCut | luaCut, boostCut };
+	const uint32_t expectedTimes[] = { 2000, 1600, 1300, 1100 };
+	const uint16_t expectedRpm[] = { 800, 900, 1100, 1000 };
+	for (size_t i = 0; i < 4; i++) {
+		auto transition = dut.getCutTransition(i);
+		ASSERT_NE(nullptr, transition) << i;
+		EXPECT_EQ(expectedReasons[i], transition->fuelReasons) << i;
+		EXPECT_EQ(0u, transition->sparkReasons) << i;
+		EXPECT_EQ(expectedTimes[i], transition->timestampMs) << i;
+		EXPECT_EQ(expectedRpm[i], transition->rpm) << i;
+	}
+	EXPECT_EQ(nullptr, dut.getCutTransition(4));
+
+	LimpCutHistory history;
+	dut.getCutHistory(history);
+	EXPECT_EQ(4u, history.transitionCount);
+	EXPECT_EQ(500u, history.cutTimeMs[(size_t)ClearReason::BoostCut]);
+	EXPECT_EQ(700u, history.cutTimeMs[(size_t)ClearReason::Lua]);
+	EXPECT_EQ(boostCut | luaCut, history.timeline[2].fuelReasons);
+	EXPECT_EQ(0u, history.timeline[4].timestampMs);
+}
+
+TEST(limp, cutTimelineWraps) {
+	EngineTestHelper eth(engine_type_e::TEST_ENGINE);
+
+	engineConfiguration->rpmHardLimit = 2500;
+	engineConfiguration->rpmHardLimitHyst = 100;
+	engineConfiguration->cutFuelOnHardLimit = true;
+	engineConfiguration->cutSparkOnHardLimit = true;
+
+	LimpManager dut;
+
+	// bounce off the limiter, every update is a transition
+	for (int i = 0; i < 2 * LIMP_CUT_TIMELINE_SIZE + 1; i++) {
+		dut.updateState(i % 2 ? 2000 : 3000, MS2NT(10 * i));
+	}
+
+	EXPECT_EQ(2u * LIMP_CUT_TIMELINE_SIZE + 1, dut.getCutTransitionCount());
+
+	// the oldest ones are gone
+	EXPECT_EQ(nullptr, dut.getCutTransition(LIMP_CUT_TIMELINE_SIZE));
+	auto newest = dut.getCutTransition(0);
+	ASSERT_NE(nullptr, newest);
+	EXPECT_EQ(20u * LIMP_CUT_TIMELINE_SIZE, newest->timestampMs);
+	EXPECT_EQ(clearReasonBit(ClearReason::HardLimit), newest->fuelReasons);
+	EXPECT_EQ(clearReasonBit(ClearReason::HardLimit), newest->sparkReasons);
+
+	auto oldest = dut.getCutTransition(LIMP_CUT_TIMELINE_SIZE - 1);
+	ASSERT_NE(nullptr, oldest);
+	EXPECT_EQ(10u * (LIMP_CUT_TIMELINE_SIZE + 1), oldest->timestampMs);
+
+	// half of the time on the limiter
+	EXPECT_NEAR(0.01 * LIMP_CUT_TIMELINE_SIZE, dut.getCutTimeSeconds(ClearReason::HardLimit), 1e-6);
+}
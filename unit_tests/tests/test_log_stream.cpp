@@ -0,0 +1,217 @@
+#include "pch.h"
+
+#include "log_stream.h"
+#include "log_field.h"
+#include "tunerstudio_io.h"
+
+#include <vector>
+
+namespace {
+
+class CaptureTsChannel final : public TsChannelBase {
+public:
+	CaptureTsChannel() : TsChannelBase("Capture") { }
+
+	void write(const uint8_t* buffer, size_t size, bool /*isEndOfPacket*/) override {
+		bytes.insert(bytes.end(), buffer, buffer + size);
+	}
+
+	size_t readTimeout(uint8_t* /*buffer*/, size_t /*size*/, int /*timeout*/) override {
+		return 0;
+	}
+
+	std::vector<uint8_t> bytes;
+};
+
+struct TsPacket {
+	uint8_t code;
+	std::vector<uint8_t> payload;
+};
+
+/**
+ * Host side test client: splits the byte stream into CRC framed packets and tracks record sequence numbers
+ */
+class LogStreamClient {
+public:
+	bool parse(const std::vector<uint8_t>& bytes) {
+		size_t pos = 0;
+		while (pos < bytes.size()) {
+			if (bytes.size() - pos < 3) {
+				return false;
+			}
+
+			size_t size = (bytes[pos] << 8) | bytes[pos + 1];
+			if (bytes.size() - pos < 2 + size + 4) {
+				return false;
+			}
+
+			const uint8_t* body = &bytes[pos + 2];
+			uint32_t expectedCrc = (body[size] << 24) | (body[size + 1] << 16) | (body[size + 2] << 8) | body[size + 3];
+			if (crc32(body, size) != expectedCrc) {
+				return false;
+			}
+
+			TsPacket packet;
+			packet.code = body[0];
+			packet.payload.assign(body + 1, body + size);
+			onPacket(packet);
+
+			pos += 2 + size + 4;
+		}
+
+		return true;
+	}
+
+	void onPacket(const TsPacket& packet) {
+		if (packet.code != TS_RESPONSE_LOG_STREAM_RECORD) {
+			packets.push_back(packet);
+			return;
+		}
+
+		const auto& p = packet.payload;
+		uint32_t sequence = (p[0] << 24) | (p[1] << 16) | (p[2] << 8) | p[3];
+		if (recordCount > 0 && sequence != lastSequence + 1) {
+			dropped += sequence - lastSequence - 1;
+		}
+		lastSequence = sequence;
+		recordCount++;
+		records.push_back(packet);
+	}
+
+	std::vector<TsPacket> packets;
+	std::vector<TsPacket> records;
+	uint32_t recordCount = 0;
+	uint32_t lastSequence = 0;
+	uint32_t dropped = 0;
+};
+
+}
+
+static uint16_t testRpm = 3000;
+static float testLambda = 0.95f;
+static scaled_channel<int16_t, 10> testClt = 85.5f;
+
+static const LogField testFields[] = {
+	{testRpm, "RPM", "RPM", 0},
+	{testLambda, "Lambda", "", 3},
+	{testClt, "CLT", "deg C", 1},
+};
+
+#define PERIOD_NT US2NT(10000)
+
+TEST(LogStream, headerAndRecords) {
+	CaptureTsChannel channel;
+	LogStream stream;
+
+	EXPECT_FALSE(stream.isActive());
+	stream.start(100, 0);
+	EXPECT_TRUE(stream.isActive());
+
+	stream.writeHeader(channel, testFields, efi::size(testFields));
+
+	for (int i = 0; i < 5; i++) {
+		efitick_t nowNt = i * PERIOD_NT;
+		ASSERT_TRUE(stream.isRecordDue(nowNt));
+		stream.writeRecord(channel, testFields, efi::size(testFields), nowNt);
+		EXPECT_FALSE(stream.isRecordDue(nowNt));
+	}
+
+	LogStreamClient client;
+	ASSERT_TRUE(client.parse(channel.bytes));
+
+	// header is a plain OK response
+	ASSERT_EQ(client.packets.size(), 1u);
+	EXPECT_EQ(client.packets[0].code, TS_RESPONSE_OK);
+	EXPECT_EQ(client.packets[0].payload.size(), getMlgHeaderSize(3));
+	EXPECT_EQ(0, memcmp(client.packets[0].payload.data(), "MLVLG", 6));
+
+	ASSERT_EQ(client.recordCount, 5u);
+	EXPECT_EQ(client.lastSequence, 4u);
+	EXPECT_EQ(client.dropped, 0u);
+
+	const auto& record = client.records[0].payload;
+	ASSERT_EQ(record.size(), 4 + getMlgDataBlockSize(testFields, 3));
+	// MLG block after the sequence number: type, roll counter, timestamp, then big endian RPM
+	EXPECT_EQ(record[4], 0);
+	EXPECT_EQ(record[8], 3000 >> 8);
+	EXPECT_EQ(record[9], 3000 & 0xFF);
+}
+
+TEST(LogStream, lateRecordsShowAsGaps) {
+	CaptureTsChannel channel;
+	LogStream stream;
+	stream.start(100, 0);
+
+	stream.writeRecord(channel, testFields, efi::size(testFields), 0);
+
+	// thread was busy for three and a half periods
+	efitick_t lateNt = 7 * PERIOD_NT / 2;
+	EXPECT_EQ(stream.getTimeToNextRecordNt(lateNt), 0);
+	stream.writeRecord(channel, testFields, efi::size(testFields), lateNt);
+	EXPECT_EQ(stream.getSkippedCount(), 2u);
+
+	// back on the original grid
+	EXPECT_EQ(stream.getTimeToNextRecordNt(lateNt), PERIOD_NT / 2);
+
+	LogStreamClient client;
+	ASSERT_TRUE(client.parse(channel.bytes));
+	EXPECT_EQ(client.recordCount, 2u);
+	EXPECT_EQ(client.lastSequence, 3u);
+	EXPECT_EQ(client.dropped, 2u);
+
+	stream.stop();
+	EXPECT_FALSE(stream.isActive());
+	EXPECT_FALSE(stream.isRecordDue(lateNt + PERIOD_NT));
+}
+
+TEST(LogStream, rateIsLimited) {
+	CaptureTsChannel channel;
+	LogStream stream;
+	stream.start(5000, 0);
+
+	stream.writeRecord(channel, testFields, efi::size(testFields), 0);
+	EXPECT_EQ(stream.getTimeToNextRecordNt(0), US2NT(1000));
+}
+
+TEST(LogStream, wideRecordsAtMaxRate) {
+	static float values[200];
+	std::vector<LogField> fields;
+	fields.reserve(efi::size(values));
+	for (size_t i = 0; i < efi::size(values); i++) {
+		values[i] = i * 0.5f;
+		fields.emplace_back(values[i], "value", "", 2);
+	}
+
+	CaptureTsChannel channel;
+	LogStream stream;
+	stream.start(LOG_STREAM_MAX_RATE_HZ, 0);
+
+	// one record per period, every one of them due and nothing in between
+	efidur_t periodNt = US2NT(US_PER_SECOND / LOG_STREAM_MAX_RATE_HZ);
+	constexpr int recordCount = 1000;
+	for (int i = 0; i < recordCount; i++) {
+		efitick_t nowNt = i * periodNt;
+		ASSERT_TRUE(stream.isRecordDue(nowNt)) << i;
+		stream.writeRecord(channel, fields.data(), fields.size(), nowNt);
+		ASSERT_FALSE(stream.isRecordDue(nowNt + periodNt / 2)) << i;
+	}
+
+	LogStreamClient client;
+	ASSERT_TRUE(client.parse(channel.bytes));
+	EXPECT_EQ(client.recordCount, (uint32_t)recordCount);
+	EXPECT_EQ(client.dropped, 0u);
+}
+
+TEST(LogStream, stopsWhenChannelIsReset) {
+	CaptureTsChannel channel;
+	channel.in_sync = true;
+	channel.logStream.start(100, 0);
+	ASSERT_TRUE(channel.logStream.isRecordDue(0));
+
+	// client went away
+	channel.resetSession();
+
+	EXPECT_FALSE(channel.in_sync);
+	EXPECT_FALSE(channel.logStream.isActive());
+	EXPECT_FALSE(channel.logStream.isRecordDue(PERIOD_NT));
+}
@@ -0,0 +1,187 @@
+#include "pch.h"
+
+#include "malfunction_central.h"
+
+static DtcFreezeFrame makeFrame(float rpm) {
+	DtcFreezeFrame frame;
+	frame.rpm = rpm;
+	return frame;
+}
+
+TEST(DtcStore, setClearIsSet) {
+	DtcStore store;
+
+	EXPECT_FALSE(store.isSet(ObdCode::OBD_TPS1_Correlation));
+	EXPECT_TRUE(store.set(ObdCode::OBD_TPS1_Correlation));
+	EXPECT_TRUE(store.isSet(ObdCode::OBD_TPS1_Correlation));
+	EXPECT_FALSE(store.isSet(ObdCode::OBD_TPS2_Correlation));
+	EXPECT_EQ(1, store.getCount());
+
+	// second time is not new
+	EXPECT_FALSE(store.set(ObdCode::OBD_TPS1_Correlation));
+	EXPECT_EQ(1, store.getCount());
+
+	EXPECT_FALSE(store.clear(ObdCode::OBD_TPS2_Correlation));
+	EXPECT_TRUE(store.clear(ObdCode::OBD_TPS1_Correlation));
+	EXPECT_FALSE(store.isSet(ObdCode::OBD_TPS1_Correlation));
+	EXPECT_EQ(0, store.getCount());
+
+	// not a code
+	EXPECT_FALSE(store.set(ObdCode::None));
+	EXPECT_FALSE(store.set((ObdCode)DTC_CODE_LIMIT));
+	EXPECT_EQ(0, store.getCount());
+}
+
+TEST(DtcStore, codesAscendingAndCapped) {
+	DtcStore store;
+
+	// highest possible, word boundaries and the lowest one
+	store.set((ObdCode)9999);
+	store.set((ObdCode)64);
+	store.set((ObdCode)63);
+	store.set((ObdCode)1);
+
+	error_codes_set_s codes;
+	store.getCodes(&codes);
+	ASSERT_EQ(4, codes.count);
+	EXPECT_EQ((ObdCode)1, codes.error_codes[0]);
+	EXPECT_EQ((ObdCode)63, codes.error_codes[1]);
+	EXPECT_EQ((ObdCode)64, codes.error_codes[2]);
+	EXPECT_EQ((ObdCode)9999, codes.error_codes[3]);
+
+	for (int code = 100; code < 200; code++) {
+		store.set((ObdCode)code);
+	}
+	EXPECT_EQ(MAX_ERROR_CODES_COUNT, store.getCount());
+	EXPECT_TRUE(store.isSet((ObdCode)105));
+	EXPECT_FALSE(store.isSet((ObdCode)106));
+
+	store.getCodes(&codes);
+	EXPECT_EQ(MAX_ERROR_CODES_COUNT, codes.count);
+	EXPECT_EQ((ObdCode)9999, codes.error_codes[MAX_ERROR_CODES_COUNT - 1]);
+
+	store.clearAll();
+	store.getCodes(&codes);
+	EXPECT_EQ(0, codes.count);
+	EXPECT_FALSE(store.isSet((ObdCode)9999));
+}
+
+TEST(DtcStore, freezeFrameRing) {
+	DtcStore store;
+	EXPECT_EQ(nullptr, store.getFreezeFrameByIndex(0));
+
+	DtcFreezeFrame frame = makeFrame(1000);
+	store.set((ObdCode)101, &frame);
+	frame = makeFrame(2000);
+	store.set((ObdCode)102, &frame);
+
+	// first occurrence wins
+	frame = makeFrame(3000);
+	store.set((ObdCode)101, &frame);
+
+	ASSERT_NE(nullptr, store.getFreezeFrame((ObdCode)101));
+	EXPECT_EQ((ObdCode)101, store.getFreezeFrame((ObdCode)101)->code);
+	EXPECT_EQ(1000, store.getFreezeFrame((ObdCode)101)->rpm);
+	EXPECT_EQ(2000, store.getFreezeFrame((ObdCode)102)->rpm);
+
+	// most recent first
+	EXPECT_EQ((ObdCode)102, store.getFreezeFrameByIndex(0)->code);
+	EXPECT_EQ((ObdCode)101, store.getFreezeFrameByIndex(1)->code);
+	EXPECT_EQ(nullptr, store.getFreezeFrameByIndex(2));
+
+	// cleared code takes its frame with it
+	store.clear((ObdCode)102);
+	EXPECT_EQ(nullptr, store.getFreezeFrame((ObdCode)102));
+	EXPECT_EQ((ObdCode)101, store.getFreezeFrameByIndex(0)->code);
+	EXPECT_EQ(nullptr, store.getFreezeFrameByIndex(1));
+
+	// ring is smaller than the code set, oldest frames are overwritten
+	for (int i = 0; i < DTC_FREEZE_FRAME_COUNT; i++) {
+		frame = makeFrame(i);
+		store.set((ObdCode)(200 + i), &frame);
+	}
+	EXPECT_TRUE(store.isSet((ObdCode)101));
+	EXPECT_EQ(nullptr, store.getFreezeFrame((ObdCode)101));
+	EXPECT_EQ((ObdCode)(200 + DTC_FREEZE_FRAME_COUNT - 1), store.getFreezeFrameByIndex(0)->code);
+	EXPECT_EQ((ObdCode)200, store.getFreezeFrameByIndex(DTC_FREEZE_FRAME_COUNT - 1)->code);
+}
+
+TEST(DtcStore, backupRoundTrip) {
+	DtcStore store;
+	for (int i = 0; i < DTC_FREEZE_FRAME_COUNT + 1; i++) {
+		DtcFreezeFrame frame = makeFrame(100 * i);
+		store.set((ObdCode)(300 + i), &frame);
+	}
+	// leave a hole in the ring
+	store.clear((ObdCode)303);
+
+	DtcBackup backup;
+	store.save(backup);
+
+	DtcStore restored;
+	ASSERT_TRUE(restored.restore(backup));
+	EXPECT_EQ(store.getCount(), restored.getCount());
+	EXPECT_TRUE(restored.isSet((ObdCode)300));
+	EXPECT_FALSE(restored.isSet((ObdCode)303));
+
+	for (size_t i = 0; i < DTC_FREEZE_FRAME_COUNT; i++) {
+		const DtcFreezeFrame* expected = store.getFreezeFrameByIndex(i);
+		const DtcFreezeFrame* actual = restored.getFreezeFrameByIndex(i);
+		if (!expected) {
+			EXPECT_EQ(nullptr, actual) << i;
+			continue;
+		}
+		ASSERT_NE(nullptr, actual) << i;
+		EXPECT_EQ(expected->code, actual->code) << i;
+		EXPECT_EQ(expected->rpm, actual->rpm) << i;
+	}
+
+	// garbage in backup RAM after power loss
+	backup.cookie = 0;
+	EXPECT_FALSE(restored.restore(backup));
+	EXPECT_EQ(0, restored.getCount());
+
+	store.save(backup);
+	backup.codes[0] = (ObdCode)DTC_CODE_LIMIT;
+	EXPECT_FALSE(restored.restore(backup));
+	EXPECT_EQ(0, restored.getCount());
+}
+
+TEST(DtcStore, addErrorCapturesFreezeFrame) {
+	EngineTestHelper eth(engine_type_e::TEST_ENGINE);
+	clearWarnings();
+
+	Sensor::setMockValue(SensorType::Rpm, 2500);
+	Sensor::setMockValue(SensorType::Clt, 95);
+	Sensor::setMockValue(SensorType::Lambda1, 0.9f);
+	engine->engineState.fuelingLoad = 45;
+
+	addError(ObdCode::OBD_TPS1_Correlation);
+	EXPECT_TRUE(hasErrorCodes());
+	EXPECT_TRUE(hasErrorCode(ObdCode::OBD_TPS1_Correlation));
+
+	// conditions change, frame stays
+	Sensor::setMockValue(SensorType::Rpm, 800);
+	addError(ObdCode::OBD_TPS1_Correlation);
+
+	const DtcFreezeFrame* frame = getFreezeFrame(ObdCode::OBD_TPS1_Correlation);
+	ASSERT_NE(nullptr, frame);
+	EXPECT_EQ(2500, frame->rpm);
+	EXPECT_EQ(45, frame->load);
+	EXPECT_EQ(95, frame->clt);
+	EXPECT_NEAR(0.9f, frame->lambda, 1e-6);
+	EXPECT_EQ(frame, getFreezeFrameByIndex(0));
+
+	clearWarnings();
+	EXPECT_FALSE(hasErrorCodes());
+	EXPECT_EQ(nullptr, getFreezeFrame(ObdCode::OBD_TPS1_Correlation));
+}
+
+TEST(DtcStore, obdDtcValue) {
+	EXPECT_EQ(0x2135, getObdDtcValue(ObdCode::OBD_TPS1_Correlation));
+	EXPECT_EQ(0x0117, getObdDtcValue((ObdCode)117));
+	EXPECT_EQ(0x3999, getObdDtcValue((ObdCode)3999));
+	// custom codes have no OBD representation
+	EXPECT_EQ(0, getObdDtcValue(ObdCode::CUSTOM_NAN_ENGINE_LOAD));
+	EXPECT_EQ(0, getObdDtcValue(ObdCode::None));
+}
@@ -0,0 +1,128 @@
+#include "pch.h"
+
+#include "mc33816_profile.h"
+
+/**
+ * Fake SPI device: records what the driver puts on the wire
+ */
+class FakePt2001 : public Pt2001ProfileBase {
+public:
+	std::vector<uint16_t> stream;
+	int selectCount = 0;
+	int busDepth = 0;
+	int largeTransferCount = 0;
+	int resetCount = 0;
+
+protected:
+	void acquireBus() override {
+		busDepth++;
+	}
+
+	void releaseBus() override {
+		busDepth--;
+	}
+
+	void select() override {
+		EXPECT_EQ(1, busDepth) << "select without the bus";
+		selectCount++;
+	}
+
+	void deselect() override {
+	}
+
+	uint16_t sendRecv(uint16_t tx) override {
+		stream.push_back(tx);
+		return 0;
+	}
+
+	void sendLarge(const uint16_t* data, size_t count) override {
+		largeTransferCount++;
+		stream.insert(stream.end(), data, data + count);
+	}
+
+	void setResetB(bool) override {
+		resetCount++;
+	}
+
+	void setDriveEN(bool) override {
+	}
+
+	bool readFlag0() const override {
+		return false;
+	}
+
+	float getVbatt() const override {
+		return 14;
+	}
+
+	void onError(const char* why) override {
+		FAIL() << why;
+	}
+
+	bool errorOnUnexpectedFlag() override {
+		return false;
+	}
+
+	void sleepMs(size_t) override {
+	}
+};
+
+static void setTestProfile() {
+	engineConfiguration->mc33_hvolt = 65;
+	engineConfiguration->mc33_i_boost = 13000;
+	engineConfiguration->mc33_i_peak = 9400;
+	engineConfiguration->mc33_i_hold = 3700;
+	engineConfiguration->mc33_t_peak_off = 10;
+	engineConfiguration->mc33_t_peak_tot = 700;
+	engineConfiguration->mc33_t_bypass = 10;
+	engineConfiguration->mc33_t_hold_off = 60;
+	engineConfiguration->mc33_t_hold_tot = 10000;
+	engineConfiguration->mc33_t_min_boost = 100;
+	engineConfiguration->mc33_t_max_boost = 400;
+}
+
+TEST(Mc33816, profileFromConfig) {
+	EngineTestHelper eth(engine_type_e::TEST_ENGINE);
+	setTestProfile();
+
+	Pt2001Profile profile = Pt2001Profile::fromConfig();
+	EXPECT_EQ(65, profile.boostVoltage);
+	EXPECT_EQ(9400, profile.peakCurrent);
+	EXPECT_EQ(3700, profile.holdCurrent);
+	EXPECT_EQ(700, profile.tPeakTot);
+	EXPECT_EQ(400, profile.tBoostMax);
+
+	EXPECT_TRUE(profile == Pt2001Profile::fromConfig());
+
+	engineConfiguration->mc33_i_peak = 9000;
+	Pt2001Profile retuned = Pt2001Profile::fromConfig();
+	EXPECT_NE(profile.getCrc(), retuned.getCrc());
+	EXPECT_TRUE(profile != retuned);
+}
+
+TEST(Mc33816, liveProfileUpdate) {
+	EngineTestHelper eth(engine_type_e::TEST_ENGINE);
+	setTestProfile();
+
+	FakePt2001 chip;
+	chip.applyProfile(Pt2001Profile::fromConfig());
+	EXPECT_EQ(0, chip.busDepth);
+	EXPECT_GT(chip.selectCount, 0);
+	// no microcode download and no reset, that is what makes it live
+	EXPECT_EQ(0, chip.largeTransferCount);
+	EXPECT_EQ(0, chip.resetCount);
+	ASSERT_FALSE(chip.stream.empty());
+	std::vector<uint16_t> original = chip.stream;
+
+	// same profile, same register stream
+	chip.stream.clear();
+	chip.applyProfile(Pt2001Profile::fromConfig());
+	EXPECT_EQ(original, chip.stream);
+
+	engineConfiguration->mc33_i_peak = 9000;
+	chip.stream.clear();
+	chip.applyProfile(Pt2001Profile::fromConfig());
+	EXPECT_EQ(original.size(), chip.stream.size());
+	EXPECT_NE(original, chip.stream);
+	EXPECT_EQ(9000, chip.getProfile().peakCurrent);
+}
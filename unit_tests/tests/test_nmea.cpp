@@ -0,0 +1,157 @@
+#include "pch.h"
+
+#include "nmea.h"
+
+#include <string>
+
+static nmea_message_type feedSentence(NmeaParser& parser, loc_t& location, const char* sentence) {
+	nmea_message_type result = NMEA_UNKNOWN;
+	for (const char* p = sentence; *p; p++) {
+		nmea_message_type type = parser.feed(*p, location);
+		if (type != NMEA_UNKNOWN) {
+			result = type;
+		}
+	}
+	return result;
+}
+
+TEST(Nmea, realSentences) {
+	NmeaParser parser;
+	loc_t location = {};
+
+	EXPECT_EQ(NMEA_GPGGA, feedSentence(parser, location, "$GPGGA,092750.000,5321.6802,N,00630.3372,W,1,8,1.03,61.7,M,55.2,M,,*76\r\n"));
+	EXPECT_EQ(1, location.quality);
+	EXPECT_EQ(8, location.satellites);
+	EXPECT_EQ(533613367, location.latitudeE7);
+	EXPECT_EQ(-65056200, location.longitudeE7);
+	EXPECT_NEAR(53.361337, location.latitude, 1e-5);
+	EXPECT_NEAR(-6.505620, location.longitude, 1e-5);
+	EXPECT_NEAR(61.7, location.altitude, EPS4D);
+
+	EXPECT_EQ(NMEA_GPRMC, feedSentence(parser, location, "$GPRMC,092750.000,A,5321.6802,N,00630.3372,W,0.02,31.66,280511,,,A*43\r\n"));
+	EXPECT_EQ(4, location.quality);
+	EXPECT_EQ(533613367, location.latitudeE7);
+	EXPECT_NEAR(0.02, location.speed, EPS4D);
+	EXPECT_NEAR(0.02 * 1.852, location.speedKph, EPS4D);
+	EXPECT_NEAR(31.66, location.course, EPS4D);
+	EXPECT_EQ(2011u, location.time.year + 1900);
+	EXPECT_EQ(5, location.time.month);
+	EXPECT_EQ(28, location.time.day);
+	EXPECT_EQ(9, location.time.hour);
+	EXPECT_EQ(27, location.time.minute);
+	EXPECT_EQ(50, location.time.second);
+
+	EXPECT_EQ(NMEA_GPVTG, feedSentence(parser, location, "$GPVTG,054.7,T,034.4,M,005.5,N,010.2,K*48\r\n"));
+	EXPECT_NEAR(54.7, location.course, EPS4D);
+	EXPECT_NEAR(5.5, location.speed, EPS4D);
+	EXPECT_NEAR(10.2, location.speedKph, EPS4D);
+
+	// multi constellation receivers use GN talker, more decimals and negative altitude
+	EXPECT_EQ(NMEA_GPRMC, feedSentence(parser, location, "$GNRMC,134509.00,A,4807.03812,N,01131.00034,E,54.321,87.50,150924,,,A*7C\r\n"));
+	EXPECT_EQ(481173020, location.latitudeE7);
+	EXPECT_EQ(115166723, location.longitudeE7);
+	EXPECT_NEAR(54.321, location.speed, EPS4D);
+
+	EXPECT_EQ(NMEA_GPGGA, feedSentence(parser, location, "$GNGGA,134509.00,4807.03812,N,01131.00034,E,1,12,0.80,-12.3,M,47.1,M,,*5A\r\n"));
+	EXPECT_EQ(12, location.satellites);
+	EXPECT_NEAR(-12.3, location.altitude, EPS4D);
+
+	// other sentences are checked but ignored
+	EXPECT_EQ(NMEA_UNKNOWN, feedSentence(parser, location, "$GPGSV,3,1,11,03,03,111,00,04,15,270,00,06,01,010,00,13,06,292,00*74\r\n"));
+
+	EXPECT_EQ(5u, parser.getSentenceCount());
+	EXPECT_EQ(0u, parser.getChecksumErrorCount());
+	EXPECT_EQ(0u, parser.getMessageErrorCount());
+}
+
+TEST(Nmea, noFix) {
+	NmeaParser parser;
+	loc_t location = {};
+
+	ASSERT_EQ(NMEA_GPRMC, feedSentence(parser, location, "$GPRMC,092750.000,A,5321.6802,N,00630.3372,W,0.02,31.66,280511,,,A*43\r\n"));
+
+	// invalid fix does not touch the last known position
+	EXPECT_EQ(NMEA_GPRMC, feedSentence(parser, location, "$GPRMC,235959.00,V,,,,,,,010100,,,N*7C\r\n"));
+	EXPECT_EQ(0, location.quality);
+	EXPECT_EQ(533613367, location.latitudeE7);
+	EXPECT_EQ(28, location.time.day);
+
+	EXPECT_EQ(NMEA_GPGGA, feedSentence(parser, location, "$GPGGA,000000.00,,,,,0,00,99.99,,,,,,*66\r\n"));
+	EXPECT_EQ(0, location.quality);
+	EXPECT_EQ(0, location.satellites);
+	EXPECT_EQ(533613367, location.latitudeE7);
+}
+
+TEST(Nmea, malformedSentences) {
+	NmeaParser parser;
+	loc_t location = {};
+
+	// one flipped digit
+	EXPECT_EQ(NMEA_CHECKSUM_ERR, feedSentence(parser, location, "$GPRMC,092750.000,A,5321.6802,N,00630.3372,W,0.02,31.66,280511,,,A*42\r\n"));
+	EXPECT_EQ(NMEA_CHECKSUM_ERR, feedSentence(parser, location, "$GPRMC,092750.000,A,5321.6812,N,00630.3372,W,0.02,31.66,280511,,,A*43\r\n"));
+	// no checksum at all
+	EXPECT_EQ(NMEA_MESSAGE_ERR, feedSentence(parser, location, "$GPRMC,092750.000,A,5321.6802,N,00630.3372,W,0.02,31.66,280511,,,A\r\n"));
+	// checksum is not hex
+	EXPECT_EQ(NMEA_MESSAGE_ERR, feedSentence(parser, location, "$GPRMC,092750.000,A,5321.6802,N,00630.3372,W,0.02,31.66,280511,,,A*4G\r\n"));
+	// checksum matches but latitude is not a number
+	EXPECT_EQ(NMEA_MESSAGE_ERR, feedSentence(parser, location, "$GPRMC,092750.000,A,53X1.6802,N,00630.3372,W,0.02,31.66,280511,,,A*29\r\n"));
+	// runaway sentence without end
+	std::string garbage = "$GPRMC," + std::string(GPS_MAX_STRING, '1');
+	EXPECT_EQ(NMEA_MESSAGE_ERR, feedSentence(parser, location, garbage.c_str()));
+
+	EXPECT_EQ(0u, parser.getSentenceCount());
+	EXPECT_EQ(2u, parser.getChecksumErrorCount());
+	EXPECT_EQ(4u, parser.getMessageErrorCount());
+	EXPECT_EQ(0, location.latitudeE7);
+	EXPECT_EQ(0, location.quality);
+
+	// sentence cut short by a new one: the parser resyncs on '$'
+	EXPECT_EQ(NMEA_GPVTG, feedSentence(parser, location, "$GPRMC,0927$GPVTG,054.7,T,034.4,M,005.5,N,010.2,K*48\r\n"));
+	// line noise between sentences
+	EXPECT_EQ(NMEA_GPVTG, feedSentence(parser, location, "\x01\xff junk\r\n$GPVTG,054.7,T,034.4,M,005.5,N,010.2,K*48\r\n"));
+	EXPECT_EQ(2u, parser.getSentenceCount());
+}
+
+TEST(Nmea, chunkedInput) {
+	const char* stream =
+		"$GPGGA,092750.000,5321.6802,N,00630.3372,W,1,8,1.03,61.7,M,55.2,M,,*76\r\n"
+		"$GPRMC,092750.000,A,5321.6802,N,00630.3372,W,0.02,31.66,280511,,,A*43\r\n"
+		"$GPVTG,054.7,T,034.4,M,005.5,N,010.2,K*48\r\n";
+	size_t length = strlen(stream);
+
+	// DMA chunk boundaries fall anywhere, results must not depend on them
+	for (size_t chunk = 1; chunk < 20; chunk++) {
+		NmeaParser parser;
+		loc_t location = {};
+
+		size_t sentences = 0;
+		for (size_t offset = 0; offset < length; offset += chunk) {
+			sentences += parser.feed(stream + offset, std::min(chunk, length - offset), location);
+		}
+
+		EXPECT_EQ(3u, sentences) << chunk;
+		EXPECT_EQ(533613367, location.latitudeE7);
+		EXPECT_NEAR(10.2, location.speedKph, EPS4D);
+	}
+}
+
+TEST(Nmea, repeatedEpochs) {
+	const char* epoch =
+		"$GNRMC,134509.00,A,4807.03812,N,01131.00034,E,54.321,87.50,150924,,,A*7C\r\n"
+		"$GPVTG,054.7,T,034.4,M,005.5,N,010.2,K*48\r\n"
+		"$GNGGA,134509.00,4807.03812,N,01131.00034,E,1,12,0.80,-12.3,M,47.1,M,,*5A\r\n";
+	size_t length = strlen(epoch);
+
+	NmeaParser parser;
+	loc_t location = {};
+
+	// Parser state carries over from one chunk to the next without losing sentences
+	constexpr int epochCount = 1000;
+	size_t sentences = 0;
+	for (int i = 0; i < epochCount; i++) {
+		sentences += parser.feed(epoch, length, location);
+	}
+
+	EXPECT_EQ(3u * epochCount, sentences);
+	EXPECT_NEAR(10.2, location.speedKph, EPS4D);
+}
@@ -0,0 +1,86 @@
+#include "pch.h"
+
+#include "sensor_chart.h"
+
+static void feedCycle(float value, float startAngle = 0) {
+	for (float angle = startAngle; angle < 720; angle += 0.5f) {
+		scAddData(angle, value + angle / 10);
+	}
+}
+
+TEST(SensorChart, averagesCyclesPerBin) {
+	EngineTestHelper eth(engine_type_e::TEST_ENGINE);
+	initSensorChart();
+
+	getEngineState()->sensorChartMode = SC_TRIGGER;
+	updateSensorChart();
+	ASSERT_TRUE(hasBigBufferLease(BigBufferUser::SensorChart));
+
+	auto capture = sensorChartGetCapture();
+	ASSERT_NE(capture, nullptr);
+	EXPECT_EQ(capture->mode, SC_TRIGGER);
+	EXPECT_EQ(capture->binCount, SC_BIN_COUNT);
+
+	// partial cycle before the phase wraps is not captured
+	feedCycle(1000, 600);
+	EXPECT_EQ(capture->bins[650].sampleCount, 0);
+
+	for (int cycle = 0; cycle < SC_CYCLE_COUNT; cycle++) {
+		EXPECT_FALSE(capture->isComplete);
+		// alternate between two levels so that the average is in between
+		feedCycle(cycle % 2 ? 2 : 0);
+	}
+	// first sample of the next cycle completes the capture
+	scAddData(0, 1000);
+	EXPECT_TRUE(capture->isComplete);
+	EXPECT_EQ(capture->cycleCount, SC_CYCLE_COUNT);
+
+	for (int bin : {0, 100, 719}) {
+		// two samples per one degree bin per cycle
+		EXPECT_EQ(capture->bins[bin].sampleCount, 2 * SC_CYCLE_COUNT);
+		EXPECT_NEAR(capture->bins[bin].value, 1 + (bin + 0.25f) / 10, 1e-3);
+	}
+
+	// nothing is added until the host reads the capture
+	feedCycle(1000);
+	EXPECT_EQ(capture->bins[100].sampleCount, 2 * SC_CYCLE_COUNT);
+
+	sensorChartReturnCapture();
+	EXPECT_FALSE(capture->isComplete);
+	EXPECT_EQ(capture->bins[100].sampleCount, 0);
+
+	getEngineState()->sensorChartMode = SC_OFF;
+	updateSensorChart();
+	EXPECT_EQ(sensorChartGetCapture(), nullptr);
+	EXPECT_FALSE(hasBigBufferLease(BigBufferUser::SensorChart));
+}
+
+TEST(SensorChart, keepsBufferWhileReadOut) {
+	EngineTestHelper eth(engine_type_e::TEST_ENGINE);
+	initSensorChart();
+
+	getEngineState()->sensorChartMode = SC_TRIGGER;
+	updateSensorChart();
+
+	// TS is sending the capture
+	auto capture = sensorChartGetCapture();
+	ASSERT_NE(capture, nullptr);
+
+	// somebody who needs the space has to wait for the read out to finish
+	BigBufferHandle teeth = getBigBuffer(BigBufferUser::ToothLogger, BIG_BUFFER_SIZE / 2);
+	EXPECT_FALSE(teeth);
+	EXPECT_TRUE(hasBigBufferLease(BigBufferUser::SensorChart));
+	EXPECT_EQ(sensorChartGetCapture(), capture);
+
+	// and the buffer is handed over once it is returned
+	sensorChartReturnCapture();
+	EXPECT_FALSE(hasBigBufferLease(BigBufferUser::SensorChart));
+	EXPECT_EQ(sensorChartGetCapture(), nullptr);
+
+	teeth = getBigBuffer(BigBufferUser::ToothLogger, BIG_BUFFER_SIZE / 2);
+	EXPECT_TRUE(teeth);
+
+	teeth = {};
+	getEngineState()->sensorChartMode = SC_OFF;
+	updateSensorChart();
+}
@@ -117,3 +117,81 @@ TEST(ThrottleModel, BigEngineSmallThrottle) {
 	EXPECT_NEAR(343.4, model.estimateThrottleFlow(100, 100, 95, 0), 1e-1);
 	// ^   part throttle model   ^
 }
+
+TEST(ThrottleModel, InverseFlowMatchesSolver) {
+	MockThrottleModel model;
+
+	for (float pr : { 0.3f, 0.7f, 0.9f, 0.95f }) {
+		for (float p_up : { 60.0f, 100.0f, 250.0f }) {
+			for (float iat : { -20.0f, 40.0f }) {
+				float wideOpenFlow = model.partThrottleFlow(100, pr, p_up, iat);
+
+				for (int step = 1; step < 200; step++) {
+					// stay below the area table flat spot: past it any position flows the same
+					float flow = wideOpenFlow * 0.99f * step / 200;
+					float tps = model.throttlePositionForFlow(flow, pr, p_up, iat);
+
+					EXPECT_NEAR(model.solveThrottlePositionForFlow(flow, pr, p_up, iat), tps, 2e-2) << pr << " " << p_up << " " << iat << " " << flow;
+					// and the position found flows what was asked for
+					EXPECT_NEAR(flow, model.partThrottleFlow(tps, pr, p_up, iat), 1e-3 * wideOpenFlow) << pr << " " << p_up << " " << iat << " " << flow;
+				}
+			}
+		}
+	}
+
+	EXPECT_EQ(0, model.throttlePositionForFlow(0, 0.5, 100, 20));
+	EXPECT_EQ(100, model.throttlePositionForFlow(1e4, 0.5, 100, 20));
+}
+
+class CountingThrottleModel : public MockThrottleModel {
+public:
+	float effectiveArea(float tps) const override {
+		areaCalls++;
+		return scale * MockThrottleModel::effectiveArea(tps);
+	}
+
+	mutable int areaCalls = 0;
+	float scale = 1;
+};
+
+TEST(ThrottleModel, InverseFlowTableUpdate) {
+	CountingThrottleModel model;
+
+	EXPECT_NEAR(29.711, model.throttlePositionForFlow(100, 0.3, 100, 0), 1e-2);
+	int tableCalls = model.areaCalls;
+	EXPECT_EQ(THROTTLE_MODEL_AREA_POINTS + 1, tableCalls);
+
+	// table is built once, after that only the wide open check looks at the area
+	model.throttlePositionForFlow(200, 0.3, 100, 0);
+	EXPECT_EQ(tableCalls + 1, model.areaCalls);
+
+	// twice the area: same flow at a smaller opening, once the table is rebuilt
+	model.scale = 2;
+	EXPECT_NEAR(29.711, model.throttlePositionForFlow(100, 0.3, 100, 0), 1e-2);
+	model.onConfigurationChange(nullptr);
+	EXPECT_NEAR(model.solveThrottlePositionForFlow(100, 0.3, 100, 0), model.throttlePositionForFlow(100, 0.3, 100, 0), 2e-2);
+	EXPECT_NEAR(29.711, model.throttlePositionForFlow(200, 0.3, 100, 0), 1e-2);
+}
+
+TEST(ThrottleModel, InverseFlowCost) {
+	CountingThrottleModel model;
+
+	// build the table outside of the counted loop
+	model.throttlePositionForFlow(1, 0.7, 100, 20);
+
+	constexpr int count = 400;
+	auto run = [&](bool useSolver) {
+		int before = model.areaCalls;
+		for (int i = 0; i < count; i++) {
+			float flow = 1 + i;
+			useSolver
+				? model.solveThrottlePositionForFlow(flow, 0.7, 100, 20)
+				: model.throttlePositionForFlow(flow, 0.7, 100, 20);
+		}
+		return model.areaCalls - before;
+	};
+
+	// every solver iteration looks at the area three times, the table only needs the wide open check
+	EXPECT_GT(run(true), 3 * count);
+	EXPECT_EQ(count, run(false));
+}
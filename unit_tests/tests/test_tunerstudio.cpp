@@ -1,6 +1,7 @@
 #include "pch.h"
 #include "tunerstudio.h"
 #include "tunerstudio_io.h"
+#include "ts_arbiter.h"
 
 static uint8_t st5TestBuffer[16000];
 
@@ -84,3 +85,88 @@ TEST(TunerstudioCommands, writeChunkEngineConfig) {
 
 	EXPECT_EQ(configBytes[100], 50);
 }
+
+TEST(TunerstudioCommands, scatterListIsPerChannel) {
+	EngineTestHelper eth(engine_type_e::TEST_ENGINE);
+	::testing::NiceMock<MockTsChannel> dash;
+	::testing::NiceMock<MockTsChannel> laptop;
+
+	size_t listOffset = offsetof(engine_configuration_s, highSpeedOffsets);
+	uint16_t subscription[2] = { 0x2004, 0x4010 };
+
+	TunerStudio instance;
+	// write only the second and third entries
+	instance.handleWriteChunkCommand(&dash, listOffset + 2, sizeof(subscription), subscription);
+
+	EXPECT_EQ(dash.highSpeedOffsets[0], 0);
+	EXPECT_EQ(dash.highSpeedOffsets[1], 0x2004);
+	EXPECT_EQ(dash.highSpeedOffsets[2], 0x4010);
+	EXPECT_EQ(dash.highSpeedOffsets[3], 0);
+
+	// other client is not affected
+	for (int i = 0; i < HIGH_SPEED_COUNT; i++) {
+		EXPECT_EQ(laptop.highSpeedOffsets[i], 0);
+	}
+
+	// a chunk which only overlaps the head of the list
+	uint8_t chunk[4] = { 1, 2, 3, 4 };
+	instance.handleWriteChunkCommand(&laptop, listOffset - 2, sizeof(chunk), chunk);
+	EXPECT_EQ(laptop.highSpeedOffsets[0], 3 | (4 << 8));
+	EXPECT_EQ(laptop.highSpeedOffsets[1], 0);
+	EXPECT_EQ(dash.highSpeedOffsets[0], 0);
+}
+
+TEST(TunerstudioCommands, commandAccess) {
+	EXPECT_EQ(getTsCommandAccess(TS_OUTPUT_COMMAND), TsCommandAccess::LiveData);
+	EXPECT_EQ(getTsCommandAccess(TS_GET_SCATTERED_GET_COMMAND), TsCommandAccess::LiveData);
+	EXPECT_EQ(getTsCommandAccess(TS_HELLO_COMMAND), TsCommandAccess::LiveData);
+	EXPECT_EQ(getTsCommandAccess(TS_READ_COMMAND), TsCommandAccess::ConfigRead);
+	EXPECT_EQ(getTsCommandAccess(TS_CRC_CHECK_COMMAND), TsCommandAccess::ConfigRead);
+	EXPECT_EQ(getTsCommandAccess(TS_CHUNK_WRITE_COMMAND), TsCommandAccess::ConfigWrite);
+	EXPECT_EQ(getTsCommandAccess(TS_BURN_COMMAND), TsCommandAccess::ConfigWrite);
+	EXPECT_EQ(getTsCommandAccess(TS_EXECUTE), TsCommandAccess::ConfigWrite);
+	// swaps the text log buffers which all channels share
+	EXPECT_EQ(getTsCommandAccess(TS_GET_TEXT), TsCommandAccess::SharedBuffer);
+	EXPECT_EQ(getTsCommandAccess(TS_GET_COMPOSITE_BUFFER_DONE_DIFFERENTLY), TsCommandAccess::SharedBuffer);
+	EXPECT_EQ(getTsCommandAccess(TS_PERF_TRACE_GET_BUFFER), TsCommandAccess::SharedBuffer);
+}
+
+TEST(TunerstudioCommands, commandGuard) {
+	TsConfigLock lock;
+
+	{
+		TsCommandGuard live(lock, TsCommandAccess::LiveData);
+		EXPECT_EQ(lock.getReaderCount(), 0);
+		EXPECT_FALSE(lock.isWriterActive());
+	}
+
+	{
+		TsCommandGuard first(lock, TsCommandAccess::ConfigRead);
+		TsCommandGuard second(lock, TsCommandAccess::ConfigRead);
+		EXPECT_EQ(lock.getReaderCount(), 2);
+		EXPECT_FALSE(lock.isWriterActive());
+	}
+	EXPECT_EQ(lock.getReaderCount(), 0);
+
+	{
+		TsCommandGuard write(lock, TsCommandAccess::ConfigWrite);
+		EXPECT_TRUE(lock.isWriterActive());
+
+		// response goes out without the lock
+		write.release();
+		EXPECT_FALSE(lock.isWriterActive());
+	}
+	EXPECT_FALSE(lock.isWriterActive());
+
+	{
+		// log readers do not keep tune readers out
+		TsCommandGuard log(lock, TsCommandAccess::SharedBuffer);
+		EXPECT_TRUE(lock.isBufferOwned());
+		EXPECT_FALSE(lock.isWriterActive());
+
+		TsCommandGuard read(lock, TsCommandAccess::ConfigRead);
+		EXPECT_EQ(lock.getReaderCount(), 1);
+	}
+	EXPECT_FALSE(lock.isBufferOwned());
+	EXPECT_EQ(lock.getReaderCount(), 0);
+}
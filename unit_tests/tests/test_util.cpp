@@ -225,8 +225,8 @@ TEST(misc, testGpsParser) {
 	strcpy(nmeaMessage, "$GPRMC,173843,A,3349.896,N,11808.521,W,000.0,360.0,230108,013.4,E*69");
 	gps_location(&GPSdata, nmeaMessage);
 	ASSERT_EQ( 4,  GPSdata.quality) << "1 valid";
-	assertEqualsM("1 latitude", 3349.896, GPSdata.latitude);
-	assertEqualsM("1 longitude", 11808.521, GPSdata.longitude);
+	assertEqualsM("1 latitude", 33.8316, GPSdata.latitude);
+	assertEqualsM("1 longitude", -118.1420, GPSdata.longitude);
 	ASSERT_EQ( 0,  GPSdata.speed) << "1 speed";
 // 	ASSERT_EQ( 0,  GPSdata.altitude) << "1 altitude";	// GPRMC not overwrite altitude
 	ASSERT_EQ( 360,  GPSdata.course) << "1 course";
@@ -243,8 +243,8 @@ TEST(misc, testGpsParser) {
 	strcpy(nmeaMessage, "$GPRMC,111609.14,A,5001.27,N,3613.06,E,11.2,0.0,261206,0.0,E*50");
 	gps_location(&GPSdata, nmeaMessage);
 	ASSERT_EQ( 4,  GPSdata.quality) << "3 valid";
-	assertEqualsM("3 latitude", 5001.27, GPSdata.latitude);
-	assertEqualsM("3 longitude", 3613.06, GPSdata.longitude);
+	assertEqualsM("3 latitude", 50.0212, GPSdata.latitude);
+	assertEqualsM("3 longitude", 36.2177, GPSdata.longitude);
 	assertEqualsM("3 speed", 11.2, GPSdata.speed);
 //	ASSERT_EQ( 0,  GPSdata.altitude) << "3 altitude";  // GPRMC not overwrite altitude
 	ASSERT_EQ( 0,  GPSdata.course) << "3 course";
@@ -260,8 +260,8 @@ TEST(misc, testGpsParser) {
 	strcpy(nmeaMessage, "$GPRMC,173843,A,3349.896,N,11808.521,W,000.0,360.0,230108,013.4,E*69");
 	gps_location(&GPSdata, nmeaMessage);
 	ASSERT_EQ( 4,  GPSdata.quality) << "4 valid";
-	assertEqualsM("4 latitude", 3349.896, GPSdata.latitude);
-	assertEqualsM("4 longitude", 11808.521, GPSdata.longitude);
+	assertEqualsM("4 latitude", 33.8316, GPSdata.latitude);
+	assertEqualsM("4 longitude", -118.1420, GPSdata.longitude);
 	ASSERT_EQ( 0,  GPSdata.speed) << "4 speed";
 	ASSERT_EQ( 360,  GPSdata.course) << "4 course";
 }
@@ -343,6 +343,65 @@ TEST(misc, testConsoleLogic) {
 	//addConsoleActionSSS("GPS", testGpsParser);
 }
 
+static void testCountI(int value, void *param) {
+	*(int *)param += value;
+}
+
+TEST(misc, testConsoleLogicManyCommands) {
+	resetConsoleActions();
+
+	constexpr int actionCount = 200;
+	static char tokens[actionCount][16];
+	static int sums[actionCount];
+	for (int i = 0; i < actionCount; i++) {
+		snprintf(tokens[i], sizeof(tokens[i]), "set_cmd_%d", i);
+		sums[i] = 0;
+		addConsoleActionIP(tokens[i], testCountI, &sums[i]);
+	}
+
+	// duplicates are still rejected and do not take a slot
+	addConsoleActionIP(tokens[7], testCountI, &sums[0]);
+	strcpy(buffer, "set_cmd_7 5");
+	handleConsoleLine(buffer);
+	ASSERT_EQ(5, sums[7]);
+	ASSERT_EQ(0, sums[0]);
+	sums[7] = 0;
+
+	// reset clears the lookup as well
+	resetConsoleActions();
+	strcpy(buffer, "set_cmd_3 1");
+	handleConsoleLine(buffer);
+	ASSERT_EQ(0, sums[3]);
+
+	for (int i = 0; i < actionCount; i++) {
+		addConsoleActionIP(tokens[i], testCountI, &sums[i]);
+	}
+
+	constexpr int lineCount = 2000;
+	for (int i = 0; i < lineCount; i++) {
+		// walk the registry back to front so that late registrations are exercised as much as early ones
+		snprintf(buffer, sizeof(buffer), "%s %d", tokens[actionCount - 1 - (i % actionCount)], 2);
+		handleConsoleLine(buffer);
+	}
+
+	for (int i = 0; i < actionCount; i++) {
+		ASSERT_EQ(2 * lineCount / actionCount, sums[i]) << tokens[i];
+	}
+
+	// near misses of registered tokens find nothing, even with an argument the real action would take
+	const char* nearMisses[] = { "set_cmd_200 2", "set_cmd_ 2", "set_cmd_1x 2", "set_cmd_01 2", "set_cmd_1_ 2", "et_cmd_1 2" };
+	for (const char* line : nearMisses) {
+		strcpy(buffer, line);
+		handleConsoleLine(buffer);
+	}
+
+	for (int i = 0; i < actionCount; i++) {
+		ASSERT_EQ(2 * lineCount / actionCount, sums[i]) << tokens[i];
+	}
+
+	resetConsoleActions();
+}
+
 TEST(misc, testFLStack) {
 	FLStack<int, 4> stack;
 	ASSERT_EQ(0, stack.size());
@@ -40,6 +40,7 @@ TESTS_SRC_CPP = \
 	tests/trigger/test_injection_scheduling.cpp \
 	tests/sent/test_sent.cpp \
 	tests/ignition_injection/injection_mode_transition.cpp \
+	tests/ignition_injection/test_injection_topology.cpp \
 	tests/ignition_injection/test_startOfCrankingPrimingPulse.cpp \
 	tests/ignition_injection/test_multispark.cpp \
 	tests/ignition_injection/test_ignition_scheduling.cpp \
@@ -86,18 +87,25 @@ TESTS_SRC_CPP = \
 	tests/lua/test_lua_vin.cpp \
 	tests/test_change_engine_type.cpp \
 	tests/test_big_buffer.cpp \
+	tests/test_sensor_chart.cpp \
 	tests/system/test_periodic_thread_controller.cpp \
 	tests/test_util.cpp \
+	tests/test_malfunction_central.cpp \
+	tests/test_nmea.cpp \
 	tests/test_start_stop.cpp \
 	tests/test_hardware_reinit.cpp \
 	tests/test_ion.cpp \
 	tests/test_kline_bytes_aggregator.cpp \
+	tests/test_kline_transport.cpp \
+	tests/test_mc33816_profile.cpp \
 	tests/test_hip9011.cpp \
 	tests/test_engine_math.cpp \
+	tests/test_blend_evaluator.cpp \
 	tests/test_throttle_model.cpp \
 	tests/test_fasterEngineSpinningUp.cpp \
 	tests/test_dwell_corner_case_issue_796.cpp \
 	tests/test_idle_controller.cpp \
+	tests/test_idle_air_learning.cpp \
 	tests/test_launch.cpp \
 	tests/test_fuel_map.cpp \
 	tests/test_gear_detector.cpp \
@@ -128,10 +136,12 @@ TESTS_SRC_CPP = \
 	tests/sensor/test_sensor_init.cpp \
 	tests/sensor/table_func.cpp \
 	tests/test_stft.cpp \
+	tests/test_cylinder_lambda_separation.cpp \
 	tests/test_hpfp.cpp \
 	tests/test_hpfp_integrated.cpp \
 	tests/test_fuel_math.cpp \
 	tests/test_binary_log.cpp \
+	tests/test_log_stream.cpp \
 	tests/test_dynoview.cpp \
 	tests/test_gpio.cpp \
 	tests/test_limp.cpp \
@@ -142,12 +152,15 @@ TESTS_SRC_CPP = \
 	tests/sensor/test_frequency_sensor.cpp \
 	tests/sensor/test_turbocharger_speed_converter.cpp \
 	tests/sensor/test_vehicle_speed_converter.cpp \
+	tests/sensor/test_max3185x.cpp \
 	tests/actuators/test_aux_valves.cpp \
 	tests/actuators/test_antilag.cpp \
 	tests/actuators/test_boost.cpp \
+	tests/actuators/test_boost_spool_model.cpp \
 	tests/actuators/test_dc_motor.cpp \
 	tests/actuators/test_etb.cpp \
 	tests/actuators/test_etb_integrated.cpp \
+	tests/actuators/test_etb_plant_estimator.cpp \
 	tests/actuators/test_fan_control.cpp \
 	tests/actuators/test_fuel_pump.cpp \
 	tests/actuators/test_gppwm.cpp \
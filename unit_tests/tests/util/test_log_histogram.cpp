@@ -0,0 +1,100 @@
+#include "pch.h"
+
+#include "log_histogram.h"
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+TEST(LogHistogram, bucketIndex) {
+	// small values are exact
+	for (uint32_t value = 0; value < LOG_HISTOGRAM_SUB_BUCKETS; value++) {
+		EXPECT_EQ(LogHistogram::getBucketIndex(value), value);
+	}
+
+	EXPECT_EQ(LogHistogram::getBucketIndex(UINT32_MAX), (size_t)LOG_HISTOGRAM_BUCKET_COUNT - 1);
+
+	size_t previous = 0;
+	for (uint64_t value = 1; value <= UINT32_MAX; value = value * 9 / 8 + 1) {
+		size_t index = LogHistogram::getBucketIndex(value);
+		ASSERT_LT(index, (size_t)LOG_HISTOGRAM_BUCKET_COUNT);
+		ASSERT_GE(index, previous) << value;
+		previous = index;
+
+		uint32_t lower = LogHistogram::getBucketLowerBound(index);
+		uint32_t upper = LogHistogram::getBucketUpperBound(index);
+		ASSERT_LE(lower, value);
+		ASSERT_GE(upper, value);
+		// relative error bound
+		ASSERT_LE(upper - lower, lower / LOG_HISTOGRAM_SUB_BUCKETS) << value;
+	}
+}
+
+static uint32_t getReferencePercentile(const std::vector<uint32_t>& sorted, float percentile) {
+	size_t rank = std::max<size_t>(1, std::ceil(percentile / 100 * sorted.size()));
+	return sorted[rank - 1];
+}
+
+TEST(LogHistogram, percentilesMatchSortedReference) {
+	std::mt19937 rng(239);
+	// latency like distribution: mostly fast with a long tail
+	std::lognormal_distribution<double> distribution(7, 1.2);
+
+	LogHistogram histogram;
+	std::vector<uint32_t> values;
+	for (int i = 0; i < 20000; i++) {
+		uint32_t value = std::min<double>(distribution(rng), UINT32_MAX);
+		values.push_back(value);
+		histogram.add(value);
+	}
+	std::sort(values.begin(), values.end());
+
+	EXPECT_EQ(histogram.getCount(), values.size());
+	EXPECT_EQ(histogram.getMax(), values.back());
+
+	for (float percentile : {1.0f, 25.0f, 50.0f, 90.0f, 99.0f, 99.9f, 100.0f}) {
+		uint32_t expected = getReferencePercentile(values, percentile);
+		uint32_t actual = histogram.getPercentile(percentile);
+		EXPECT_GE(actual, expected) << percentile;
+		EXPECT_LE(actual, expected + expected / LOG_HISTOGRAM_SUB_BUCKETS) << percentile;
+	}
+	EXPECT_EQ(histogram.getPercentile(100), values.back());
+
+	histogram.reset();
+	EXPECT_EQ(histogram.getCount(), 0u);
+	EXPECT_EQ(histogram.getPercentile(50), 0u);
+}
+
+TEST(LogHistogram, countersSaturate) {
+	LogHistogram histogram;
+	for (int i = 0; i < 70000; i++) {
+		histogram.add(100);
+	}
+	histogram.add(5000);
+
+	EXPECT_EQ(histogram.getBucket(LogHistogram::getBucketIndex(100)), UINT16_MAX);
+	EXPECT_EQ(histogram.getCount(), 70001u);
+	EXPECT_EQ(histogram.getPercentile(50), LogHistogram::getBucketUpperBound(LogHistogram::getBucketIndex(100)));
+	EXPECT_EQ(histogram.getPercentile(100), 5000u);
+}
+
+TEST(LogHistogram, report) {
+	LogHistogram& histogram = getLatencyHistogram(LatencyHistogram::CanRx);
+	histogram.reset();
+	for (uint32_t value = 1; value <= 100; value++) {
+		histogram.add(value);
+	}
+
+	LatencyHistogramReport report;
+	fillLatencyHistogramReport(LatencyHistogram::CanRx, report);
+
+	EXPECT_STREQ(report.name, "can rx");
+	EXPECT_EQ(report.count, 100u);
+	EXPECT_EQ(report.max, 100u);
+	EXPECT_EQ(report.p50, LogHistogram::getBucketUpperBound(LogHistogram::getBucketIndex(50)));
+	EXPECT_EQ(report.p99, 100u);
+	EXPECT_EQ(report.bucketCount, LOG_HISTOGRAM_BUCKET_COUNT);
+	EXPECT_EQ(report.buckets[3], 1);
+
+	histogram.reset();
+}
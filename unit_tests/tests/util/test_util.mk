@@ -10,5 +10,6 @@ CPPSRC += 	$(PROJECT_DIR)/../unit_tests/tests/util/test_buffered_writer.cpp \
 	$(PROJECT_DIR)/../unit_tests/tests/util/test_averaging.cpp \
 	$(PROJECT_DIR)/../unit_tests/tests/util/test_lua_biquad.cpp \
 	$(PROJECT_DIR)/../unit_tests/tests/util/test_hash.cpp \
+	$(PROJECT_DIR)/../unit_tests/tests/util/test_log_histogram.cpp \
 
 INCDIR += $(PROJECT_DIR)/controllers/system